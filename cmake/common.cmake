@@ -2,6 +2,7 @@ list(APPEND CMAKE_MODULE_PATH "${CMAKE_CURRENT_LIST_DIR}")
 
 if (CMAKE_MAJOR_VERSION GREATER 2)
   set(CMAKE_CXX_STANDARD 11)
+  set(CMAKE_C_STANDARD 11)
   set(HYMLS_HAVE_CXX11 ON)
 endif()
 
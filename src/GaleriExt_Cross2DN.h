@@ -49,6 +49,8 @@
 #include "Epetra_Vector.h"
 #include "Epetra_CrsMatrix.h"
 
+#include "GaleriExt_RowAssembly.h"
+
 namespace GaleriExt {
 namespace Matrices {
 
@@ -61,31 +63,21 @@ Cross2DN(const Epetra_Map* Map,
         const double a, const double b, const double c,
         const double d, const double e)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  5);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int left, right, lower, upper;
-  std::vector<double> Values(4);
-  std::vector<int_type> Indices(4);
-
   //    e
   //  b a c
   //    d
-  for (int i = 0 ; i < NumMyElements ; ++i) 
+  return AssembleRows<int_type>(Map, 5,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
+    int left, right, lower, upper;
+
     double diag = a;
-    int NumEntries = 0;
-    Galeri::GetNeighboursCartesian2d(MyGlobalElements[i], nx, ny, 
+    Galeri::GetNeighboursCartesian2d(row, nx, ny, 
 			     left, right, lower, upper);
 
     if (left != -1) 
     {
-      Indices[NumEntries] = left;
-      Values[NumEntries] = b;
-      ++NumEntries;
+      Entries.Append(left, b);
     }
     else
     {
@@ -93,9 +85,7 @@ Cross2DN(const Epetra_Map* Map,
     }
     if (right != -1) 
     {
-      Indices[NumEntries] = right;
-      Values[NumEntries] = c;
-      ++NumEntries;
+      Entries.Append(right, c);
     }
     else
     {
@@ -103,9 +93,7 @@ Cross2DN(const Epetra_Map* Map,
     }
     if (lower != -1) 
     {
-      Indices[NumEntries] = lower;
-      Values[NumEntries] = d;
-      ++NumEntries;
+      Entries.Append(lower, d);
     }
     else
     {
@@ -113,27 +101,16 @@ Cross2DN(const Epetra_Map* Map,
     }
     if (upper != -1) 
     {
-      Indices[NumEntries] = upper;
-      Values[NumEntries] = e;
-      ++NumEntries;
+      Entries.Append(upper, e);
     }
     else
     {
     diag += e;
     }
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries, 
-                               &Values[0], &Indices[0]);
 
     // Put in the diagonal entry
-	
-    Matrix->InsertGlobalValues(MyGlobalElements[i], 1, 
-                               &diag, MyGlobalElements + i);
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+    Entries.Append(row, diag);
+  });
 }
 
 inline
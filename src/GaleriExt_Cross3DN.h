@@ -48,6 +48,8 @@
 #include "Epetra_BlockMap.h"
 #include "Epetra_CrsMatrix.h"
 
+#include "GaleriExt_RowAssembly.h"
+
 namespace GaleriExt {
 namespace Matrices {
 
@@ -60,89 +62,59 @@ Cross3DN(const Epetra_Map* Map,
         const double d, const double e, const double f,
         const double g)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  7);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int left, right, lower, upper, below, above;
-  std::vector<double> Values(6);
-  std::vector<int_type> Indices(6);
-
   //    e
   //  b a c
   //    d
   // + f below and g above
-  
-  for (int i = 0 ; i < NumMyElements ; ++i) 
+  return AssembleRows<int_type>(Map, 7,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
-    Galeri::GetNeighboursCartesian3d(MyGlobalElements[i], nx, ny, nz,
+    int left, right, lower, upper, below, above;
+
+    Galeri::GetNeighboursCartesian3d(row, nx, ny, nz,
 			     left, right, lower, upper, below, above);
 
     double diag = a;
     if (left != -1) 
     {
-      Indices[NumEntries] = left;
-      Values[NumEntries] = b;
-      ++NumEntries;
+      Entries.Append(left, b);
     }
     else
       diag += b;
     if (right != -1) 
     {
-      Indices[NumEntries] = right;
-      Values[NumEntries] = c;
-      ++NumEntries;
+      Entries.Append(right, c);
     }
     else
       diag += c;
     if (lower != -1) 
     {
-      Indices[NumEntries] = lower;
-      Values[NumEntries] = d;
-      ++NumEntries;
+      Entries.Append(lower, d);
     }
     else
       diag += d;
     if (upper != -1) 
     {
-      Indices[NumEntries] = upper;
-      Values[NumEntries] = e;
-      ++NumEntries;
+      Entries.Append(upper, e);
     }
     else
       diag += e;
     if (below != -1) 
     {
-      Indices[NumEntries] = below;
-      Values[NumEntries] = f;
-      ++NumEntries;
+      Entries.Append(below, f);
     }
     else
       diag += f;
     if (above != -1) 
     {
-      Indices[NumEntries] = above;
-      Values[NumEntries] = g;
-      ++NumEntries;
+      Entries.Append(above, g);
     }
     else
       diag += g;
 
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries, 
-                               &Values[0], &Indices[0]);
-
     // Put in the diagonal entry
-    Matrix->InsertGlobalValues(MyGlobalElements[i], 1, 
-                               &diag, MyGlobalElements + i);
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+    Entries.Append(row, diag);
+  });
 }
 
 inline
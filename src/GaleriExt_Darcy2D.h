@@ -36,6 +36,8 @@
 #include "Epetra_BlockMap.h"
 #include "Epetra_CrsMatrix.h"
 
+#include "GaleriExt_RowAssembly.h"
+
 #include "GaleriExt_Periodic.h"
 
 namespace GaleriExt {
@@ -50,17 +52,6 @@ Darcy2D(const Epetra_Map* Map,
         const double a, const double b,
         PERIO_Flag perio=NO_PERIO)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  4);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int left, right, lower, upper;
-
-  std::vector<double> Values(4);
-  std::vector<int_type> Indices(4);
-
   double c = -b; // c==b => [A B'; B 0]. c==-b => A B'; -B 0]
 
   int dof = 3;
@@ -70,12 +61,13 @@ Darcy2D(const Epetra_Map* Map,
     throw("bad input map for GaleriExt::Darcy2D. Should have 3 dof/node");
   }
 
-  for (int i = 0 ; i < NumMyElements ; i++)
+  return AssembleRows<int_type>(Map, 4,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
+    int left, right, lower, upper;
 
-    int_type ibase = std::floor(MyGlobalElements[i]/dof);
-    int_type ivar   = MyGlobalElements[i]-ibase*dof;
+    int_type ibase = std::floor(row/dof);
+    int_type ivar   = row-ibase*dof;
     // first the regular 7-point stencil
     GetNeighboursCartesian2d(ibase, nx, ny,
                              left, right, lower, upper,
@@ -83,26 +75,16 @@ Darcy2D(const Epetra_Map* Map,
 
     if (ivar!=2)
     {
-      NumEntries=1;
-      Values[0]=a;
-      Indices[0]=MyGlobalElements[i];
+      Entries.Append(row, a);
       if (right != -1 && ivar==0)
       {
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+2, -b);
+        Entries.Append(right*dof+2, b);
       }
       if (upper != -1 && ivar==1)
       {
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+2, -b);
+        Entries.Append(upper*dof+2, b);
       }
     }
     else // P
@@ -110,48 +92,31 @@ Darcy2D(const Epetra_Map* Map,
       // div-rows
       if (right!=-1)
       {
-        Indices[NumEntries]=ibase*dof+0;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+0, -c);
       }
       if (upper!=-1)
       {
-        Indices[NumEntries]=ibase*dof+1;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+1, -c);
       }
       if (left!=-1)
       {
-        Indices[NumEntries]=left*dof+0;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(left*dof+0, c);
       }
       if (lower!=-1)
       {
-        Indices[NumEntries]=lower*dof+1;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(lower*dof+1, c);
       }
     }
 
 #ifdef DEBUGGING_
-    std::cerr << i << " " << MyGlobalElements[i] << " " << ibase << " " << ivar << std::endl;
-    for (int jj=0;jj<NumEntries;jj++)
+    std::cerr << row << " " << ibase << " " << ivar << std::endl;
+    for (int jj=0;jj<Entries.NumEntries();jj++)
     {
-      std::cerr << Indices[jj] << " ";
+      std::cerr << Entries.Index(jj) << " ";
     }
     std::cerr << std::endl;
 #endif
-
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries,
-                               &Values[0], &Indices[0]);
-
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+  });
 }
 
 //! generate an B-grid discretization with A = diag(a) and +b -b in the B part
@@ -163,19 +128,6 @@ DarcyB2D(const Epetra_Map* Map,
         const double a, const double b,
         PERIO_Flag perio=NO_PERIO)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  8);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int left, right, lower, upper;
-  int top_left, top_right, top_lower, top_upper;
-  int bottom_left, bottom_right, bottom_lower, bottom_upper;
-
-  std::vector<double> Values(8);
-  std::vector<int_type> Indices(8);
-
   double c = -b; // c==b => [A B'; B 0]. c==-b => A B'; -B 0]
 
   int dof = 3;
@@ -185,12 +137,15 @@ DarcyB2D(const Epetra_Map* Map,
     throw("bad input map for GaleriExt::Darcy2D. Should have 4 dof/node");
   }
 
-  for (int i = 0 ; i < NumMyElements ; i++)
+  return AssembleRows<int_type>(Map, 8,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
+    int left, right, lower, upper;
+    int top_left, top_right, top_lower, top_upper;
+    int bottom_left, bottom_right, bottom_lower, bottom_upper;
 
-    int_type ibase = std::floor(MyGlobalElements[i]/dof);
-    int_type ivar   = MyGlobalElements[i]-ibase*dof;
+    int_type ibase = std::floor(row/dof);
+    int_type ivar   = row-ibase*dof;
     // first the regular 7-point stencil
     GetNeighboursCartesian2d(ibase, nx, ny,
                              left, right, lower, upper,
@@ -206,39 +161,21 @@ DarcyB2D(const Epetra_Map* Map,
 
     if (ivar!=2)
     {
-      NumEntries=1;
-      Values[0]=a;
-      Indices[0]=MyGlobalElements[i];
+      Entries.Append(row, a);
 
       if (right != -1 && upper != -1 && ivar == 0)
       {
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = top_right*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+2, -b);
+        Entries.Append(right*dof+2, b);
+        Entries.Append(upper*dof+2, -b);
+        Entries.Append(top_right*dof+2, b);
       }
       else if (right != -1 && upper != -1 && ivar == 1)
       {
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+2;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = top_right*dof+2;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+2, -b);
+        Entries.Append(right*dof+2, -b);
+        Entries.Append(upper*dof+2, b);
+        Entries.Append(top_right*dof+2, b);
       }
     }
     else // P
@@ -246,60 +183,35 @@ DarcyB2D(const Epetra_Map* Map,
       // div-rows
       if (right != -1 && upper != -1)
       {
-        Indices[NumEntries]=ibase*dof+0;
-        Values[NumEntries]=-c;
-        NumEntries++;
-        Indices[NumEntries]=ibase*dof+1;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+0, -c);
+        Entries.Append(ibase*dof+1, -c);
       }
       if (left != -1 && upper != -1)
       {
-        Indices[NumEntries]=left*dof+0;
-        Values[NumEntries]=c;
-        NumEntries++;
-        Indices[NumEntries]=left*dof+1;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(left*dof+0, c);
+        Entries.Append(left*dof+1, -c);
       }
       if (lower != -1 && right != -1)
       {
-        Indices[NumEntries]=lower*dof+0;
-        Values[NumEntries]=-c;
-        NumEntries++;
-        Indices[NumEntries]=lower*dof+1;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(lower*dof+0, -c);
+        Entries.Append(lower*dof+1, c);
       }
       if (lower != -1 && left != -1)
       {
-        Indices[NumEntries]=bottom_left*dof+0;
-        Values[NumEntries]=c;
-        NumEntries++;
-        Indices[NumEntries]=bottom_left*dof+1;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(bottom_left*dof+0, c);
+        Entries.Append(bottom_left*dof+1, c);
       }
     }
 
 #ifdef DEBUGGING_
-    std::cerr << i << " " << MyGlobalElements[i] << " " << ibase << " " << ivar << std::endl;
-    for (int jj=0;jj<NumEntries;jj++)
+    std::cerr << row << " " << ibase << " " << ivar << std::endl;
+    for (int jj=0;jj<Entries.NumEntries();jj++)
     {
-      std::cerr << Indices[jj] << " ";
+      std::cerr << Entries.Index(jj) << " ";
     }
     std::cerr << std::endl;
 #endif
-
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries,
-                               &Values[0], &Indices[0]);
-
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+  });
 }
 
 inline
@@ -36,6 +36,8 @@
 #include "Epetra_BlockMap.h"
 #include "Epetra_CrsMatrix.h"
 
+#include "GaleriExt_RowAssembly.h"
+
 #include "GaleriExt_Periodic.h"
 
 namespace GaleriExt {
@@ -50,17 +52,6 @@ Darcy3D(const Epetra_Map* Map,
         const double a, const double b,
         PERIO_Flag perio=NO_PERIO)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  6);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int left, right, lower, upper, below, above;
-
-  std::vector<double> Values(6);
-  std::vector<int_type> Indices(6);
-
   double c = -b; // c==b => [A B'; B 0]. c==-b => A B'; -B 0]
 
   int dof = 4;
@@ -70,12 +61,13 @@ Darcy3D(const Epetra_Map* Map,
     throw("bad input map for GaleriExt::Darcy3D. Should have 4 dof/node");
   }
 
-  for (int i = 0 ; i < NumMyElements ; i++)
+  return AssembleRows<int_type>(Map, 6,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
+    int left, right, lower, upper, below, above;
 
-    int_type ibase = std::floor(MyGlobalElements[i]/dof);
-    int_type ivar   = MyGlobalElements[i]-ibase*dof;
+    int_type ibase = std::floor(row/dof);
+    int_type ivar   = row-ibase*dof;
     // first the regular 7-point stencil
     GetNeighboursCartesian3d(ibase, nx, ny, nz,
                              left, right, lower, upper, below, above,
@@ -83,35 +75,21 @@ Darcy3D(const Epetra_Map* Map,
 
     if (ivar!=3)
     {
-      NumEntries=1;
-      Values[0]=a;
-      Indices[0]=MyGlobalElements[i];
+      Entries.Append(row, a);
       if (right != -1 && ivar==0)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(right*dof+3, b);
       }
       if (upper != -1 && ivar==1)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, b);
       }
       if (above != -1 && ivar==2)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(above*dof+3, b);
       }
     }
     else // P
@@ -119,60 +97,39 @@ Darcy3D(const Epetra_Map* Map,
       // div-rows
       if (right!=-1)
       {
-        Indices[NumEntries]=ibase*dof+0;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+0, -c);
       }
       if (upper!=-1)
       {
-        Indices[NumEntries]=ibase*dof+1;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+1, -c);
       }
       if (above!=-1)
       {
-        Indices[NumEntries]=ibase*dof+2;
-        Values[NumEntries]=-c;
-        NumEntries++;
+        Entries.Append(ibase*dof+2, -c);
       }
       if (left!=-1)
       {
-        Indices[NumEntries]=left*dof+0;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(left*dof+0, c);
       }
       if (lower!=-1)
       {
-        Indices[NumEntries]=lower*dof+1;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(lower*dof+1, c);
       }
       if (below!=-1)
       {
-        Indices[NumEntries]=below*dof+2;
-        Values[NumEntries]=c;
-        NumEntries++;
+        Entries.Append(below*dof+2, c);
       }
     }
 
 #ifdef DEBUGGING_
-    std::cerr << i << " " << MyGlobalElements[i] << " " << ibase << " " << ivar << std::endl;
-    for (int jj=0;jj<NumEntries;jj++)
+    std::cerr << row << " " << ibase << " " << ivar << std::endl;
+    for (int jj=0;jj<Entries.NumEntries();jj++)
     {
-      std::cerr << Indices[jj] << " ";
+      std::cerr << Entries.Index(jj) << " ";
     }
     std::cerr << std::endl;
 #endif
-
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries,
-                               &Values[0], &Indices[0]);
-
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+  });
 }
 
 //! generate an B-grid discretization with A = diag(a) and +b -b in the B part
@@ -184,25 +141,6 @@ DarcyB3D(const Epetra_Map* Map,
         const double a, const double b,
         PERIO_Flag perio=NO_PERIO)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  24);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int above_upper_left, above_upper, above_upper_right,
-    above_left, above, above_right,
-    above_lower_left, above_lower, above_lower_right,
-    upper_left, upper, upper_right,
-    left, base, right,
-    lower_left, lower, lower_right,
-    below_upper_left, below_upper, below_upper_right,
-    below_left, below, below_right,
-    below_lower_left, below_lower, below_lower_right;
-
-  std::vector<double> Values(24);
-  std::vector<int_type> Indices(24);
-
   double c = -b; // c==b => [A B'; B 0]. c==-b => A B'; -B 0]
 
   int dof = 4;
@@ -212,12 +150,21 @@ DarcyB3D(const Epetra_Map* Map,
     throw("bad input map for GaleriExt::Darcy3D. Should have 4 dof/node");
   }
 
-  for (int i = 0 ; i < NumMyElements ; i++)
+  return AssembleRows<int_type>(Map, 24,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
-
-    int_type ibase = std::floor(MyGlobalElements[i]/dof);
-    int_type ivar   = MyGlobalElements[i]-ibase*dof;
+    int above_upper_left, above_upper, above_upper_right,
+      above_left, above, above_right,
+      above_lower_left, above_lower, above_lower_right,
+      upper_left, upper, upper_right,
+      left, base, right,
+      lower_left, lower, lower_right,
+      below_upper_left, below_upper, below_upper_right,
+      below_left, below, below_right,
+      below_lower_left, below_lower, below_lower_right;
+
+    int_type ibase = std::floor(row/dof);
+    int_type ivar   = row-ibase*dof;
     // first the regular 27-point stencil
     GetNeighboursCartesian3d(ibase, nx, ny, nz,
                              above_upper_left, above_upper, above_upper_right,
@@ -233,89 +180,39 @@ DarcyB3D(const Epetra_Map* Map,
 
     if (ivar!=3)
     {
-      NumEntries=1;
-      Values[0]=a;
-      Indices[0]=MyGlobalElements[i];
+      Entries.Append(row, a);
       if (above_upper_right != -1 && ivar == 0)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, -b);
+        Entries.Append(right*dof+3, b);
+        Entries.Append(upper_right*dof+3, b);
+        Entries.Append(above*dof+3, -b);
+        Entries.Append(above_upper*dof+3, -b);
+        Entries.Append(above_right*dof+3, b);
+        Entries.Append(above_upper_right*dof+3, b);
       }
       else if (above_upper_right != -1 && ivar == 1)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above_right*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, b);
+        Entries.Append(right*dof+3, -b);
+        Entries.Append(upper_right*dof+3, b);
+        Entries.Append(above*dof+3, -b);
+        Entries.Append(above_upper*dof+3, b);
+        Entries.Append(above_right*dof+3, -b);
+        Entries.Append(above_upper_right*dof+3, b);
       }
       else if (above_upper_right != -1 && ivar == 2)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper_right*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = above_upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, -b);
+        Entries.Append(right*dof+3, -b);
+        Entries.Append(upper_right*dof+3, -b);
+        Entries.Append(above*dof+3, b);
+        Entries.Append(above_upper*dof+3, b);
+        Entries.Append(above_right*dof+3, b);
+        Entries.Append(above_upper_right*dof+3, b);
       }
     }
     else // P
@@ -323,120 +220,63 @@ DarcyB3D(const Epetra_Map* Map,
       // div-rows
       if (above_upper_right != -1)
       {
-        Indices[NumEntries] = ibase*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = ibase*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(ibase*dof+0, -c);
+        Entries.Append(ibase*dof+1, -c);
+        Entries.Append(ibase*dof+2, -c);
       }
       if (above_upper_left != -1)
       {
-        Indices[NumEntries] = left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = left*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = left*dof+2;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(left*dof+0, c);
+        Entries.Append(left*dof+1, -c);
+        Entries.Append(left*dof+2, -c);
       }
       if (above_lower_right != -1)
       {
-        Indices[NumEntries] = lower*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = lower*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = lower*dof+2;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(lower*dof+0, -c);
+        Entries.Append(lower*dof+1, c);
+        Entries.Append(lower*dof+2, -c);
       }
       if (above_lower_left != -1)
       {
-        Indices[NumEntries] = lower_left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = lower_left*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = lower_left*dof+2;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(lower_left*dof+0, c);
+        Entries.Append(lower_left*dof+1, c);
+        Entries.Append(lower_left*dof+2, -c);
       }
       if (below_upper_right != -1)
       {
-        Indices[NumEntries] = below*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = below*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = below*dof+2;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(below*dof+0, -c);
+        Entries.Append(below*dof+1, -c);
+        Entries.Append(below*dof+2, c);
       }
       if (below_upper_left != -1)
       {
-        Indices[NumEntries] = below_left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = below_left*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = below_left*dof+2;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(below_left*dof+0, c);
+        Entries.Append(below_left*dof+1, -c);
+        Entries.Append(below_left*dof+2, c);
       }
       if (below_lower_right != -1)
       {
-        Indices[NumEntries] = below_lower*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = below_lower*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = below_lower*dof+2;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(below_lower*dof+0, -c);
+        Entries.Append(below_lower*dof+1, c);
+        Entries.Append(below_lower*dof+2, c);
       }
       if (below_lower_left != -1)
       {
-        Indices[NumEntries] = below_lower_left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = below_lower_left*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = below_lower_left*dof+2;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(below_lower_left*dof+0, c);
+        Entries.Append(below_lower_left*dof+1, c);
+        Entries.Append(below_lower_left*dof+2, c);
       }
     }
 
 #ifdef DEBUGGING_
-    std::cerr << i << " " << MyGlobalElements[i] << " " << ibase << " " << ivar << std::endl;
-    for (int jj=0;jj<NumEntries;jj++)
+    std::cerr << row << " " << ibase << " " << ivar << std::endl;
+    for (int jj=0;jj<Entries.NumEntries();jj++)
     {
-      std::cerr << Indices[jj] << " ";
+      std::cerr << Entries.Index(jj) << " ";
     }
     std::cerr << std::endl;
 #endif
-
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries,
-                               &Values[0], &Indices[0]);
-
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+  });
 }
 
 //! generate an THCM grid discretization with A = diag(a) and +b -b in the B part
@@ -448,25 +288,6 @@ DarcyTHCM3D(const Epetra_Map* Map,
             const double a, const double b,
             PERIO_Flag perio=NO_PERIO)
 {
-  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map,  24);
-
-  int NumMyElements = Map->NumMyElements();
-  int_type* MyGlobalElements = 0;
-  Map->MyGlobalElementsPtr(MyGlobalElements);
-
-  int above_upper_left, above_upper, above_upper_right,
-    above_left, above, above_right,
-    above_lower_left, above_lower, above_lower_right,
-    upper_left, upper, upper_right,
-    left, base, right,
-    lower_left, lower, lower_right,
-    below_upper_left, below_upper, below_upper_right,
-    below_left, below, below_right,
-    below_lower_left, below_lower, below_lower_right;
-
-  std::vector<double> Values(24);
-  std::vector<int_type> Indices(24);
-
   double c = -b; // c==b => [A B'; B 0]. c==-b => A B'; -B 0]
 
   int dof = 4;
@@ -476,12 +297,21 @@ DarcyTHCM3D(const Epetra_Map* Map,
     throw("bad input map for GaleriExt::Darcy3D. Should have 4 dof/node");
   }
 
-  for (int i = 0 ; i < NumMyElements ; i++)
+  return AssembleRows<int_type>(Map, 24,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int NumEntries = 0;
-
-    int_type ibase = std::floor(MyGlobalElements[i]/dof);
-    int_type ivar   = MyGlobalElements[i]-ibase*dof;
+    int above_upper_left, above_upper, above_upper_right,
+      above_left, above, above_right,
+      above_lower_left, above_lower, above_lower_right,
+      upper_left, upper, upper_right,
+      left, base, right,
+      lower_left, lower, lower_right,
+      below_upper_left, below_upper, below_upper_right,
+      below_left, below, below_right,
+      below_lower_left, below_lower, below_lower_right;
+
+    int_type ibase = std::floor(row/dof);
+    int_type ivar   = row-ibase*dof;
     // first the regular 27-point stencil
     GetNeighboursCartesian3d(ibase, nx, ny, nz,
                              above_upper_left, above_upper, above_upper_right,
@@ -497,47 +327,25 @@ DarcyTHCM3D(const Epetra_Map* Map,
 
     if (ivar!=3)
     {
-      NumEntries=1;
-      Values[0]=a;
-      Indices[0]=MyGlobalElements[i];
+      Entries.Append(row, a);
       if (upper_right != -1 && ivar == 0)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, -b);
+        Entries.Append(right*dof+3, b);
+        Entries.Append(upper_right*dof+3, b);
       }
       else if (upper_right != -1 && ivar == 1)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
-        Indices[NumEntries] = right*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = upper_right*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(upper*dof+3, b);
+        Entries.Append(right*dof+3, -b);
+        Entries.Append(upper_right*dof+3, b);
       }
       else if (above != -1 && ivar == 2)
       {
-        Indices[NumEntries] = ibase*dof+3;
-        Values[NumEntries] = -b;
-        ++NumEntries;
-        Indices[NumEntries] = above*dof+3;
-        Values[NumEntries] = b;
-        ++NumEntries;
+        Entries.Append(ibase*dof+3, -b);
+        Entries.Append(above*dof+3, b);
       }
     }
     else // P
@@ -545,72 +353,43 @@ DarcyTHCM3D(const Epetra_Map* Map,
       // div-rows
       if (upper_right != -1)
       {
-        Indices[NumEntries] = ibase*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = ibase*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(ibase*dof+0, -c);
+        Entries.Append(ibase*dof+1, -c);
       }
       if (above != -1)
       {
-        Indices[NumEntries] = ibase*dof+2;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(ibase*dof+2, -c);
       }
       if (upper_left != -1)
       {
-        Indices[NumEntries] = left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = left*dof+1;
-        Values[NumEntries] = -c;
-        NumEntries++;
+        Entries.Append(left*dof+0, c);
+        Entries.Append(left*dof+1, -c);
       }
       if (lower_right != -1)
       {
-        Indices[NumEntries] = lower*dof+0;
-        Values[NumEntries] = -c;
-        NumEntries++;
-        Indices[NumEntries] = lower*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(lower*dof+0, -c);
+        Entries.Append(lower*dof+1, c);
       }
       if (lower_left != -1)
       {
-        Indices[NumEntries] = lower_left*dof+0;
-        Values[NumEntries] = c;
-        NumEntries++;
-        Indices[NumEntries] = lower_left*dof+1;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(lower_left*dof+0, c);
+        Entries.Append(lower_left*dof+1, c);
       }
       if (below != -1)
       {
-        Indices[NumEntries] = below*dof+2;
-        Values[NumEntries] = c;
-        NumEntries++;
+        Entries.Append(below*dof+2, c);
       }
     }
 
 #ifdef DEBUGGING_
-    std::cerr << i << " " << MyGlobalElements[i] << " " << ibase << " " << ivar << std::endl;
-    for (int jj=0;jj<NumEntries;jj++)
+    std::cerr << row << " " << ibase << " " << ivar << std::endl;
+    for (int jj=0;jj<Entries.NumEntries();jj++)
     {
-      std::cerr << Indices[jj] << " ";
+      std::cerr << Entries.Index(jj) << " ";
     }
     std::cerr << std::endl;
 #endif
-
-    // put the off-diagonal entries
-    Matrix->InsertGlobalValues(MyGlobalElements[i], NumEntries,
-                               &Values[0], &Indices[0]);
-
-  }
-  Matrix->FillComplete();
-  Matrix->OptimizeStorage();
-
-  return(Matrix);
+  });
 }
 
 inline
@@ -0,0 +1,238 @@
+#ifndef GALERIEXT_ROWASSEMBLY_H
+#define GALERIEXT_ROWASSEMBLY_H
+
+#include "HYMLS_config.h"
+
+#include "Epetra_Map.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_IntSerialDenseVector.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace GaleriExt {
+namespace Matrices {
+
+//! The entries of one row of the matrix created by AssembleRows().
+//! They are stored in space for a fixed number of entries. Entries
+//! that do not fit are not stored but are still counted, so that
+//! AssembleRows() can report rows that are too long without anything
+//! being written past the end of the space of the row.
+template<typename int_type>
+class RowEntries
+{
+public:
+
+  RowEntries(int_type* Indices, double* Values, int Capacity)
+    :
+    Indices_(Indices), Values_(Values), Capacity_(Capacity), NumEntries_(0)
+  {}
+
+  //! Add an entry at the end of the row
+  void Append(int_type Index, double Value)
+  {
+    if (NumEntries_ < Capacity_)
+    {
+      Indices_[NumEntries_] = Index;
+      Values_[NumEntries_] = Value;
+    }
+    NumEntries_++;
+  }
+
+  //! Replace the entries by a copy of row Row of A. If the row
+  //! does not fit, nothing is copied but the number of entries
+  //! is still set to its length.
+  int ExtractGlobalRowCopy(const Epetra_CrsMatrix& A, int_type Row)
+  {
+    int ierr = A.ExtractGlobalRowCopy(Row, Capacity_, NumEntries_, Values_, Indices_);
+    if (ierr == -2)
+      NumEntries_ = A.NumGlobalEntries(Row);
+    return ierr;
+  }
+
+  //! Number of entries that were added, including the ones that
+  //! did not fit
+  int NumEntries() const {return NumEntries_;}
+
+  //! Number of entries that can be stored
+  int Capacity() const {return Capacity_;}
+
+  //! Column index of entry j < Capacity()
+  int_type Index(int j) const {return Indices_[j];}
+
+  //! Value of entry j < Capacity()
+  double& Value(int j) {return Values_[j];}
+
+private:
+
+  int_type* Indices_;
+  double* Values_;
+  int Capacity_;
+  int NumEntries_;
+};
+
+//! Create a matrix with the rows of Map. For every row GID,
+//! Row(gid, Entries) appends the global column indices and values of
+//! the row to Entries, which is a RowEntries object with space for
+//! MaxNumEntries entries. If a row has more entries than that, an
+//! exception is thrown after all rows have been computed. The rows
+//! are computed in parallel if OpenMP is enabled, so Row should not
+//! modify anything but its entries. Entries with the same column are
+//! added. The rows are sorted and translated to local column indices
+//! in the same loop and written directly into the CSR arrays of the
+//! matrix, which is then completed with ExpertStaticFillComplete(), so
+//! Epetra does not insert or translate any entry itself. Map is used
+//! as domain and range map.
+template<typename int_type, typename RowFunction>
+inline
+Epetra_CrsMatrix*
+AssembleRows(const Epetra_Map* Map, const int MaxNumEntries, RowFunction Row)
+{
+  int NumMyElements = Map->NumMyElements();
+  int_type* MyGlobalElements = 0;
+  Map->MyGlobalElementsPtr(MyGlobalElements);
+
+  std::vector<int> NumEntries(NumMyElements, 0);
+  std::vector<int_type> Indices((size_t)NumMyElements * MaxNumEntries);
+  std::vector<double> Values((size_t)NumMyElements * MaxNumEntries);
+
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    size_t offset = (size_t)i * MaxNumEntries;
+    RowEntries<int_type> Entries(&Indices[offset], &Values[offset], MaxNumEntries);
+    Row(MyGlobalElements[i], Entries);
+    NumEntries[i] = Entries.NumEntries();
+  }
+
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    if (NumEntries[i] > MaxNumEntries)
+      throw "GaleriExt::Matrices::AssembleRows: too many entries in a row";
+  }
+
+  // The column map has the columns of Map first, in the order of Map,
+  // followed by the other columns sorted by the process that owns them,
+  // like the column map that FillComplete() would create.
+  std::vector<char> LocalColumn(NumMyElements, 0);
+  std::vector<int_type> RemoteColumns;
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    size_t offset = (size_t)i * MaxNumEntries;
+    for (int j = 0 ; j < NumEntries[i] ; j++)
+    {
+      int lid = Map->LID(Indices[offset + j]);
+      if (lid >= 0)
+        LocalColumn[lid] = 1;
+      else
+        RemoteColumns.push_back(Indices[offset + j]);
+    }
+  }
+  std::sort(RemoteColumns.begin(), RemoteColumns.end());
+  RemoteColumns.erase(std::unique(RemoteColumns.begin(), RemoteColumns.end()),
+                      RemoteColumns.end());
+
+  int NumRemote = RemoteColumns.size();
+  std::vector<int> RemotePIDs(NumRemote + 1);
+  std::vector<int> RemoteLIDs(NumRemote + 1);
+  if (Map->RemoteIDList(NumRemote, NumRemote ? &RemoteColumns[0] : 0,
+                        &RemotePIDs[0], &RemoteLIDs[0]))
+    throw "GaleriExt::Matrices::AssembleRows: column not found in the map";
+
+  std::vector<std::pair<int, int_type> > SortedRemote(NumRemote);
+  for (int k = 0 ; k < NumRemote ; k++)
+  {
+    if (RemotePIDs[k] < 0)
+      throw "GaleriExt::Matrices::AssembleRows: column not found in the map";
+    SortedRemote[k] = std::make_pair(RemotePIDs[k], RemoteColumns[k]);
+  }
+  std::sort(SortedRemote.begin(), SortedRemote.end());
+
+  std::vector<int_type> ColumnGIDs;
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    if (LocalColumn[i])
+      ColumnGIDs.push_back(MyGlobalElements[i]);
+  }
+  for (int k = 0 ; k < NumRemote ; k++)
+    ColumnGIDs.push_back(SortedRemote[k].second);
+
+  Epetra_Map ColMap((int_type)-1, (int)ColumnGIDs.size(),
+                    ColumnGIDs.size() ? &ColumnGIDs[0] : 0,
+                    (int_type)Map->IndexBase64(), Map->Comm());
+
+  // translate to local columns, sort the rows and merge duplicate
+  // columns
+  std::vector<int> LocalIndices((size_t)NumMyElements * MaxNumEntries);
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    size_t offset = (size_t)i * MaxNumEntries;
+    std::vector<std::pair<int, double> > Entries(NumEntries[i]);
+    for (int j = 0 ; j < NumEntries[i] ; j++)
+      Entries[j] = std::make_pair(ColMap.LID(Indices[offset + j]),
+                                  Values[offset + j]);
+    std::sort(Entries.begin(), Entries.end(),
+              [](std::pair<int, double> const &a, std::pair<int, double> const &b)
+              {return a.first < b.first;});
+
+    int len = 0;
+    for (int j = 0 ; j < NumEntries[i] ; j++)
+    {
+      if (len > 0 && LocalIndices[offset + len - 1] == Entries[j].first)
+      {
+        Values[offset + len - 1] += Entries[j].second;
+        continue;
+      }
+      LocalIndices[offset + len] = Entries[j].first;
+      Values[offset + len] = Entries[j].second;
+      len++;
+    }
+    NumEntries[i] = len;
+  }
+
+  Epetra_CrsMatrix* Matrix = new Epetra_CrsMatrix(Copy, *Map, ColMap, 0);
+
+  Epetra_IntSerialDenseVector& RowPtr = Matrix->ExpertExtractIndexOffset();
+  Epetra_IntSerialDenseVector& ColInd = Matrix->ExpertExtractIndices();
+  double*& Vals = Matrix->ExpertExtractValues();
+
+  RowPtr.Resize(NumMyElements + 1);
+  RowPtr[0] = 0;
+  for (int i = 0 ; i < NumMyElements ; i++)
+    RowPtr[i + 1] = RowPtr[i] + NumEntries[i];
+
+  int nnz = RowPtr[NumMyElements];
+  ColInd.Resize(nnz);
+  delete [] Vals;
+  Vals = new double[nnz];
+
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0 ; i < NumMyElements ; i++)
+  {
+    size_t offset = (size_t)i * MaxNumEntries;
+    std::copy(&LocalIndices[offset], &LocalIndices[offset] + NumEntries[i],
+              &ColInd[RowPtr[i]]);
+    std::copy(&Values[offset], &Values[offset] + NumEntries[i],
+              &Vals[RowPtr[i]]);
+  }
+
+  if (Matrix->ExpertStaticFillComplete(*Map, *Map))
+  {
+    delete Matrix;
+    throw "GaleriExt::Matrices::AssembleRows: ExpertStaticFillComplete failed";
+  }
+
+  return(Matrix);
+}
+
+} // namespace Matrices
+} // namespace GaleriExt
+#endif
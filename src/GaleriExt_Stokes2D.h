@@ -41,6 +41,7 @@
 #include "Galeri_Cross2D.h"
 #include "GaleriExt_Cross2DN.h"
 #include "GaleriExt_Darcy2D.h"
+#include "GaleriExt_RowAssembly.h"
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_Array.hpp>
@@ -95,7 +96,6 @@ Stokes2D(const Epetra_Map* Map,
 {
   int dof = 3;
 
-  Teuchos::RCP<Epetra_CrsMatrix> Matrix = Teuchos::rcp(new Epetra_CrsMatrix(Copy, *Map, 8));
   Teuchos::RCP<Epetra_CrsMatrix> Darcy  = Teuchos::rcp(Darcy2D(Map,nx,ny,0.0,-b,perio,grid_type));
   Teuchos::Array<Teuchos::RCP<Epetra_CrsMatrix> > Laplace(2);
   Laplace[0] = get2DLaplaceMatrixForVar<int_type>(Map, nx, ny, 0, perio);
@@ -106,20 +106,20 @@ Stokes2D(const Epetra_Map* Map,
     CENTERED_X = 1,
     CENTERED_Y = 2
   };
-  int staggering = CENTERED_NONE;
+  const int MaxNumEntries = 16;
 
   // now create the combined Stokes matrix [A B'; B 0] from A=[Laplace 0; 0 Laplace] and Darcy=[I B'; B 0];
-  for (int i=0; i<Map->NumMyElements(); i++)
+  return AssembleRows<int_type>(Map, MaxNumEntries,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int_type row = Map->GID64(i);
+    int staggering = CENTERED_NONE;
     const int max_len = 50;
-    int_type cols[max_len], cols_laplace[max_len];
-    double vals[max_len],vals_laplace[max_len];
-    int lenDarcy=0;
+    int_type cols_laplace[max_len];
+    double vals_laplace[max_len];
     int lenLaplace=0;
-    Darcy->ExtractGlobalRowCopy(row,max_len,lenDarcy,vals,cols);
+    Entries.ExtractGlobalRowCopy(*Darcy, row);
+    int lenDarcy=Entries.NumEntries();
     // u or v node? add Laplace row entries
-    int lenTotal=lenDarcy;
     int ivar = row % dof;
     if (ivar != 2)
     {
@@ -197,24 +197,19 @@ Stokes2D(const Epetra_Map* Map,
         if (c==row)
         {
           // find entry in existing values and replace it
-          for (int k=0; k<lenDarcy; k++)
+          for (int k=0; k<lenDarcy && k<MaxNumEntries; k++)
           {
-            if (cols[k]==c) vals[k]=-(vals_laplace[j]*a + add_to_diag);
+            if (Entries.Index(k)==c) Entries.Value(k)=-(vals_laplace[j]*a + add_to_diag);
           }
         }
         else
         {
           // add entry at the end of the row
-          cols[lenTotal]=c;
-          vals[lenTotal]=-vals_laplace[j]*a;
-          lenTotal++;
+          Entries.Append(c, -vals_laplace[j]*a);
         }
       }
     }
-    Matrix->InsertGlobalValues(row,lenTotal,vals,cols);
-  }
-  Matrix->FillComplete();
-  return Matrix.release().get();
+  });
 }
 
 inline
@@ -41,6 +41,7 @@
 #include "Galeri_Cross3D.h"
 #include "GaleriExt_Cross3DN.h"
 #include "GaleriExt_Darcy3D.h"
+#include "GaleriExt_RowAssembly.h"
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_Array.hpp>
@@ -97,7 +98,6 @@ Stokes3D(const Epetra_Map* Map,
 {
   int dof = 4;
 
-  Teuchos::RCP<Epetra_CrsMatrix> Matrix = Teuchos::rcp(new Epetra_CrsMatrix(Copy, *Map, 24));
   Teuchos::RCP<Epetra_CrsMatrix> Darcy  = Teuchos::rcp(Darcy3D(Map,nx,ny,nz,0.0,-b,perio,grid_type));
   Teuchos::Array<Teuchos::RCP<Epetra_CrsMatrix> > Laplace(3);
   Laplace[0] = get3DLaplaceMatrixForVar<int_type>(Map, nx, ny, nz, 0, perio);
@@ -110,20 +110,20 @@ Stokes3D(const Epetra_Map* Map,
     CENTERED_Y = 2,
     CENTERED_Z = 4
   };
-  int staggering = CENTERED_NONE;
+  const int MaxNumEntries = 32;
 
   // now create the combined Stokes matrix [A B'; B 0] from A=[Laplace 0; 0 Laplace] and Darcy=[I B'; B 0];
-  for (int i=0; i<Map->NumMyElements(); i++)
+  return AssembleRows<int_type>(Map, MaxNumEntries,
+    [&](int_type row, RowEntries<int_type>& Entries)
   {
-    int_type row = Map->GID64(i);
+    int staggering = CENTERED_NONE;
     const int max_len = 50;
-    int_type cols[max_len], cols_laplace[max_len];
-    double vals[max_len],vals_laplace[max_len];
-    int lenDarcy=0;
+    int_type cols_laplace[max_len];
+    double vals_laplace[max_len];
     int lenLaplace=0;
-    Darcy->ExtractGlobalRowCopy(row,max_len,lenDarcy,vals,cols);
+    Entries.ExtractGlobalRowCopy(*Darcy, row);
+    int lenDarcy=Entries.NumEntries();
     // u or v node? add Laplace row entries
-    int lenTotal=lenDarcy;
     int ivar = row % dof;
     if (ivar != 3)
     {
@@ -263,25 +263,20 @@ Stokes3D(const Epetra_Map* Map,
         if (cols_laplace[j] == row)
         {
           // find entry in existing values and replace it
-          for (int k=0; k<lenDarcy; k++)
+          for (int k=0; k<lenDarcy && k<MaxNumEntries; k++)
           {
-            if (cols[k] == cols_laplace[j])
-              vals[k] = -(vals_laplace[j]*a + add_to_diag);
+            if (Entries.Index(k) == cols_laplace[j])
+              Entries.Value(k) = -(vals_laplace[j]*a + add_to_diag);
           }
         }
         else
         {
           // add entry at the end of the row
-          cols[lenTotal] = cols_laplace[j];
-          vals[lenTotal] = -vals_laplace[j]*a;
-          lenTotal++;
+          Entries.Append(cols_laplace[j], -vals_laplace[j]*a);
         }
       }
     }
-    Matrix->InsertGlobalValues(row,lenTotal,vals,cols);
-  }
-  Matrix->FillComplete();
-  return Matrix.release().get();
+  });
 }
 
 inline
@@ -0,0 +1,524 @@
+#include "HYMLS_AgglomeratedSolver.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_MatrixUtils.hpp"
+#include "HYMLS_HyperCube.hpp"
+#include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_OverlappingPartitioner.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Export.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Vector.h"
+#include "Epetra_SerialDenseMatrix.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_ParameterList.hpp"
+#include "Teuchos_toString.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace HYMLS
+  {
+
+AgglomeratedSolver::AgglomeratedSolver(
+  Teuchos::RCP<const Epetra_Map> map,
+  int numActiveProcs, int level)
+  :
+  PLA("Preconditioner"),
+  comm_(Teuchos::rcp(map->Comm().Clone())),
+  myLevel_(level),
+  map_(map),
+  haveBorder_(false),
+  label_("AgglomeratedSolver"),
+  initialized_(false), computed_(false)
+  {
+  HYMLS_LPROF2(label_, "Constructor");
+
+  Teuchos::RCP<const Epetra_MpiComm> mpiComm =
+    Teuchos::rcp_dynamic_cast<const Epetra_MpiComm>(comm_);
+  if (mpiComm == Teuchos::null)
+    Tools::Error("Agglomeration requires an Epetra_MpiComm", __FILE__, __LINE__);
+
+  numActiveProcs = std::max(1, std::min(numActiveProcs, comm_->NumProc()));
+
+  // In the node-aware ordering the first ranks are on different compute
+  // nodes. The ranks that are assigned to the same active rank are on the
+  // same compute node if the number of active ranks is a multiple of the
+  // number of compute nodes.
+  int rank;
+    {
+    HyperCube topology(mpiComm);
+    rank = topology.Comm().MyPID();
+    }
+  int leader = rank % numActiveProcs;
+  bool active = rank < numActiveProcs;
+
+  // Gather the rows of every group on its leader like in
+  // BasePartitioner::MoveMap
+  MPI_Comm groupComm;
+  CHECK_ZERO(MPI_Comm_split(mpiComm->Comm(), leader,
+      rank == leader ? 0 : rank + 1, &groupComm));
+
+  hymls_gidx *myGlobalElements;
+#ifdef HYMLS_LONG_LONG
+  myGlobalElements = map_->MyGlobalElements64();
+#else
+  myGlobalElements = map_->MyGlobalElements();
+#endif
+
+  Teuchos::Array<hymls_gidx> gids;
+    {
+    Epetra_MpiComm groupEpetraComm(groupComm);
+    Epetra_Map groupMap((hymls_gidx)-1, map_->NumMyElements(), myGlobalElements,
+      (hymls_gidx)map_->IndexBase64(), groupEpetraComm);
+    Teuchos::RCP<Epetra_Map> gatheredMap = MatrixUtils::Gather(groupMap, 0);
+    for (int i = 0; i < gatheredMap->NumMyElements(); i++)
+      gids.append(gatheredMap->GID64(i));
+    }
+  CHECK_ZERO(MPI_Comm_free(&groupComm));
+
+  std::sort(gids.begin(), gids.end());
+
+  aggMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, gids.size(),
+      gids.getRawPtr(), (hymls_gidx)map_->IndexBase64(), *comm_));
+
+  MPI_Comm activeComm;
+  CHECK_ZERO(MPI_Comm_split(mpiComm->Comm(), active ? 0 : MPI_UNDEFINED,
+      rank, &activeComm));
+
+  if (active)
+    {
+    activeComm_ = CreateOwningMpiComm(activeComm);
+    activeMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, gids.size(),
+        gids.getRawPtr(), (hymls_gidx)map_->IndexBase64(), *activeComm_));
+    }
+
+  exporter_ = Teuchos::rcp(new Epetra_Export(*map_, *aggMap_));
+
+  Tools::Out("Agglomerate level " + Teuchos::toString(myLevel_) + " onto " +
+    Teuchos::toString(numActiveProcs) + " processes");
+  }
+
+AgglomeratedSolver::~AgglomeratedSolver()
+  {
+  HYMLS_LPROF3(label_, "Destructor");
+
+  solver_ = Teuchos::null;
+  hid_ = Teuchos::null;
+  activeMatrix_ = Teuchos::null;
+  activeTestVector_ = Teuchos::null;
+  activeMap_ = Teuchos::null;
+  }
+
+int AgglomeratedSolver::NumActiveProcs(Epetra_Map const &map, int threshold)
+  {
+  int numProc = map.Comm().NumProc();
+  if (threshold <= 0)
+    return numProc;
+
+  hymls_gidx numActive = map.NumGlobalElements64() / threshold;
+  return (int)std::max((hymls_gidx)1, std::min((hymls_gidx)numProc, numActive));
+  }
+
+int AgglomeratedSolver::SetMatrix(Teuchos::RCP<const Epetra_CrsMatrix> matrix)
+  {
+  HYMLS_LPROF2(label_, "SetMatrix");
+
+  matrix_ = matrix;
+
+  Epetra_CrsMatrix aggMatrix(Copy, *aggMap_, matrix_->MaxNumEntries());
+  CHECK_ZERO(aggMatrix.Export(*matrix_, *exporter_, Insert));
+
+  initialized_ = false;
+  computed_ = false;
+
+  if (!IsActive())
+    return 0;
+
+  activeMatrix_ = Teuchos::rcp(new Epetra_CrsMatrix(Copy, *activeMap_,
+      aggMatrix.MaxNumEntries()));
+
+  int len;
+  Teuchos::Array<hymls_gidx> indices(aggMatrix.MaxNumEntries());
+  Teuchos::Array<double> values(aggMatrix.MaxNumEntries());
+  for (int i = 0; i < aggMatrix.NumMyRows(); i++)
+    {
+    hymls_gidx row = aggMap_->GID64(i);
+    CHECK_ZERO(aggMatrix.ExtractGlobalRowCopy(row, indices.size(), len,
+        values.getRawPtr(), indices.getRawPtr()));
+    CHECK_ZERO(activeMatrix_->InsertGlobalValues(row, len,
+        values.getRawPtr(), indices.getRawPtr()));
+    }
+  CHECK_ZERO(activeMatrix_->FillComplete());
+  activeMatrix_->SetLabel(matrix_->Label());
+
+  if (solver_ != Teuchos::null)
+    solver_->SetMatrix(activeMatrix_);
+
+  return 0;
+  }
+
+int AgglomeratedSolver::SetNextLevel(Teuchos::RCP<const Epetra_Vector> testVector,
+  Teuchos::RCP<const OverlappingPartitioner> hid)
+  {
+  hid_ = hid;
+
+  if (testVector == Teuchos::null)
+    return 0;
+
+  Epetra_Vector aggTestVector(*aggMap_);
+  CHECK_ZERO(aggTestVector.Export(*testVector, *exporter_, Insert));
+
+  if (IsActive())
+    activeTestVector_ = Teuchos::rcp(new Epetra_Vector(Copy, *activeMap_,
+        aggTestVector.Values()));
+
+  return 0;
+  }
+
+Teuchos::RCP<Epetra_MultiVector> AgglomeratedSolver::ActiveView(
+  Epetra_MultiVector &aggX) const
+  {
+  if (!IsActive())
+    return Teuchos::null;
+
+  return Teuchos::rcp(new Epetra_MultiVector(View, *activeMap_,
+      aggX.Values(), aggX.Stride(), aggX.NumVectors()));
+  }
+
+Teuchos::RCP<Epetra_MultiVector> AgglomeratedSolver::Agglomerate(
+  const Epetra_MultiVector &X, Epetra_MultiVector &aggX) const
+  {
+  CHECK_ZERO(aggX.Export(X, *exporter_, Insert));
+  return ActiveView(aggX);
+  }
+
+void AgglomeratedSolver::setParameterList(
+  const Teuchos::RCP<Teuchos::ParameterList>& list)
+  {
+  HYMLS_LPROF3(label_, "setParameterList");
+  setMyParamList(list);
+  SetParameters(*list);
+  }
+
+int AgglomeratedSolver::SetParameters(Teuchos::ParameterList& List)
+  {
+  HYMLS_LPROF3(label_, "SetParameters");
+  Teuchos::RCP<Teuchos::ParameterList> myPL = getMyNonconstParamList();
+
+  if (myPL.get() != &List)
+    {
+    setMyParamList(Teuchos::rcp(&List, false));
+    }
+
+  if (solver_ != Teuchos::null)
+    {
+    CHECK_ZERO(solver_->SetParameters(List));
+    }
+
+  return 0;
+  }
+
+int AgglomeratedSolver::Initialize()
+  {
+  HYMLS_LPROF2(label_, "Initialize");
+
+  if (IsActive())
+    {
+    if (activeMatrix_ == Teuchos::null)
+      Tools::Error("SetMatrix() not yet called!", __FILE__, __LINE__);
+
+    if (solver_ == Teuchos::null)
+      solver_ = Teuchos::rcp(new Preconditioner(activeMatrix_,
+          getMyNonconstParamList(), activeTestVector_, myLevel_, hid_));
+
+    CHECK_ZERO(solver_->Initialize());
+    }
+
+  initialized_ = true;
+  computed_ = false;
+
+  return 0;
+  }
+
+bool AgglomeratedSolver::IsInitialized() const
+  {
+  return initialized_;
+  }
+
+int AgglomeratedSolver::Compute()
+  {
+  HYMLS_LPROF(label_, "Compute");
+
+  int ierr = 0;
+  if (IsActive())
+    ierr = solver_->Compute();
+
+  // make sure that the idle processes also see the error
+  int failed = ierr != 0;
+  int globalFailed = 0;
+  CHECK_ZERO(comm_->MaxAll(&failed, &globalFailed, 1));
+
+  computed_ = !globalFailed;
+
+  if (globalFailed)
+    return ierr != 0 ? ierr : -1;
+  return 0;
+  }
+
+bool AgglomeratedSolver::IsComputed() const
+  {
+  return computed_;
+  }
+
+double AgglomeratedSolver::Condest(const Ifpack_CondestType CT,
+  const int MaxIters,
+  const double Tol,
+  Epetra_RowMatrix* Matrix)
+  {
+  return -1.0;
+  }
+
+double AgglomeratedSolver::Condest() const
+  {
+  return -1.0;
+  }
+
+int AgglomeratedSolver::ApplyInverse(const Epetra_MultiVector &X,
+  Epetra_MultiVector &Y) const
+  {
+  HYMLS_LPROF(label_, "ApplyInverse");
+
+  bool realloc_vectors = (aggX_ == Teuchos::null);
+  if (!realloc_vectors) realloc_vectors = (aggX_->NumVectors() != X.NumVectors());
+  if (realloc_vectors)
+    {
+    aggX_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, X.NumVectors()));
+    aggY_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, X.NumVectors()));
+    }
+
+  Teuchos::RCP<Epetra_MultiVector> activeX = Agglomerate(X, *aggX_);
+  Teuchos::RCP<Epetra_MultiVector> activeY = ActiveView(*aggY_);
+
+  if (IsActive())
+    {
+    CHECK_ZERO(solver_->ApplyInverse(*activeX, *activeY));
+    }
+
+  CHECK_ZERO(Y.Import(*aggY_, *exporter_, Insert));
+
+  return 0;
+  }
+
+const Epetra_RowMatrix& AgglomeratedSolver::Matrix() const
+  {
+  return *matrix_;
+  }
+
+int AgglomeratedSolver::NumInitialize() const
+  {
+  return IsActive() ? solver_->NumInitialize() : 0;
+  }
+
+int AgglomeratedSolver::NumCompute() const
+  {
+  return IsActive() ? solver_->NumCompute() : 0;
+  }
+
+int AgglomeratedSolver::NumApplyInverse() const
+  {
+  return IsActive() ? solver_->NumApplyInverse() : 0;
+  }
+
+double AgglomeratedSolver::InitializeTime() const
+  {
+  return IsActive() ? solver_->InitializeTime() : 0.0;
+  }
+
+double AgglomeratedSolver::ComputeTime() const
+  {
+  return IsActive() ? solver_->ComputeTime() : 0.0;
+  }
+
+double AgglomeratedSolver::ApplyInverseTime() const
+  {
+  return IsActive() ? solver_->ApplyInverseTime() : 0.0;
+  }
+
+double AgglomeratedSolver::InitializeFlops() const
+  {
+  return IsActive() ? solver_->InitializeFlops() : 0.0;
+  }
+
+double AgglomeratedSolver::ComputeFlops() const
+  {
+  return IsActive() ? solver_->ComputeFlops() : 0.0;
+  }
+
+double AgglomeratedSolver::ApplyInverseFlops() const
+  {
+  return IsActive() ? solver_->ApplyInverseFlops() : 0.0;
+  }
+
+std::ostream& AgglomeratedSolver::Print(std::ostream& os) const
+  {
+  os << label_ << " on level " << myLevel_ << ": "
+     << (IsActive() ? "active" : "idle") << std::endl;
+  if (IsActive())
+    solver_->Print(os);
+  return os;
+  }
+
+int AgglomeratedSolver::SetUseTranspose(bool UseTranspose)
+  {
+  return -1;
+  }
+
+int AgglomeratedSolver::Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const
+  {
+  return matrix_->Apply(X, Y);
+  }
+
+double AgglomeratedSolver::NormInf() const
+  {
+  return -1.0;
+  }
+
+const char * AgglomeratedSolver::Label() const
+  {
+  return label_.c_str();
+  }
+
+bool AgglomeratedSolver::UseTranspose() const
+  {
+  return false;
+  }
+
+bool AgglomeratedSolver::HasNormInf() const
+  {
+  return false;
+  }
+
+const Epetra_Comm & AgglomeratedSolver::Comm() const
+  {
+  return *comm_;
+  }
+
+const Epetra_Map & AgglomeratedSolver::OperatorDomainMap() const
+  {
+  return *map_;
+  }
+
+const Epetra_Map & AgglomeratedSolver::OperatorRangeMap() const
+  {
+  return *map_;
+  }
+
+int AgglomeratedSolver::SetBorder(Teuchos::RCP<const Epetra_MultiVector> V,
+  Teuchos::RCP<const Epetra_MultiVector> W,
+  Teuchos::RCP<const Epetra_SerialDenseMatrix> C)
+  {
+  HYMLS_LPROF(label_, "SetBorder");
+
+  if (V == Teuchos::null)
+    {
+    // unset
+    haveBorder_ = false;
+    aggV_ = Teuchos::null;
+    aggW_ = Teuchos::null;
+    if (IsActive() && solver_ != Teuchos::null)
+      CHECK_ZERO(solver_->SetBorder(Teuchos::null));
+    return 0;
+    }
+
+  if (W == Teuchos::null)
+    W = V;
+
+  aggV_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, V->NumVectors()));
+  aggW_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, W->NumVectors()));
+
+  Teuchos::RCP<Epetra_MultiVector> activeV = Agglomerate(*V, *aggV_);
+  Teuchos::RCP<Epetra_MultiVector> activeW = Agglomerate(*W, *aggW_);
+
+  if (IsActive())
+    {
+    if (solver_ == Teuchos::null)
+      Tools::Error("Initialize() not yet called!", __FILE__, __LINE__);
+    CHECK_ZERO(solver_->SetBorder(activeV, activeW, C));
+    }
+
+  computed_ = false;
+  haveBorder_ = true;
+  return 0;
+  }
+
+int AgglomeratedSolver::Apply(const Epetra_MultiVector & B, const Epetra_SerialDenseMatrix & C,
+  Epetra_MultiVector& X, Epetra_SerialDenseMatrix & Y) const
+  {
+  return -1;
+  }
+
+// compute [X S]' = [K V;W' C]\[Y T]'
+int AgglomeratedSolver::ApplyInverse(const Epetra_MultiVector &X,
+  const Epetra_SerialDenseMatrix &T,
+  Epetra_MultiVector &Y,
+  Epetra_SerialDenseMatrix &S) const
+  {
+  HYMLS_LPROF2(label_, "ApplyInverse (bordered)");
+
+  if (!IsComputed())
+    {
+    return -1;
+    }
+
+  if (!HaveBorder())
+    {
+    HYMLS_DEBUG("border not set!");
+    return ApplyInverse(X, Y);
+    }
+
+  bool realloc_vectors = (aggX_ == Teuchos::null);
+  if (!realloc_vectors) realloc_vectors = (aggX_->NumVectors() != X.NumVectors());
+  if (realloc_vectors)
+    {
+    aggX_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, X.NumVectors()));
+    aggY_ = Teuchos::rcp(new Epetra_MultiVector(*aggMap_, X.NumVectors()));
+    }
+
+  Teuchos::RCP<Epetra_MultiVector> activeX = Agglomerate(X, *aggX_);
+  Teuchos::RCP<Epetra_MultiVector> activeY = ActiveView(*aggY_);
+
+  // S is replicated on the active processes, so we take the one of the
+  // first active process and communicate it to all processes.
+  Epetra_SerialDenseMatrix S_local(S.M(), S.N());
+  if (IsActive())
+    {
+    CHECK_ZERO(solver_->ApplyInverse(*activeX, T, *activeY, S_local));
+    if (activeComm_->MyPID() != 0)
+      CHECK_ZERO(S_local.Scale(0.0));
+    }
+
+  CHECK_ZERO(Y.Import(*aggY_, *exporter_, Insert));
+
+  if (S.LDA() != S.M())
+      Tools::Error("Unsupported communication: " + Teuchos::toString(S.M()) + " "
+                   + Teuchos::toString(S.LDA()), __FILE__, __LINE__);
+
+  CHECK_ZERO(S.Scale(0.0));
+  CHECK_ZERO(comm_->SumAll(S_local.A(), S.A(), S.M() * S.N()));
+
+  return 0;
+  }
+
+  }
@@ -0,0 +1,288 @@
+#ifndef HYMLS_AGGLOMERATED_SOLVER_H
+#define HYMLS_AGGLOMERATED_SOLVER_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+
+#include "Ifpack_CondestType.h"
+#include "Ifpack_Preconditioner.h"
+
+#include "HYMLS_BorderedOperator.hpp"
+#include "HYMLS_PLA.hpp"
+
+#include <string>
+
+// forward declarations
+class Epetra_Comm;
+class Epetra_MpiComm;
+class Epetra_Map;
+class Epetra_Export;
+class Epetra_RowMatrix;
+class Epetra_CrsMatrix;
+class Epetra_SerialDenseMatrix;
+class Epetra_MultiVector;
+class Epetra_Vector;
+
+namespace Teuchos
+  {
+class ParameterList;
+  }
+
+namespace HYMLS {
+
+class Preconditioner;
+class OverlappingPartitioner;
+
+/*! Solver for a coarse level that has too few nodes per process to make
+  good use of all processes. The matrix is moved onto a subset of the
+  processes (a subcommunicator) and a HYMLS::Preconditioner is applied
+  there, so the collectives of this level and all coarser levels only
+  involve the active processes.
+
+  The active processes are the first ranks of a HyperCube ordering of the
+  communicator, which spreads them over as many compute nodes as possible.
+  Every process sends its part of the matrix and vectors to the active
+  process on the same compute node if possible, in the same way as
+  BasePartitioner::MoveMap gathers the nodes of a group of processes.
+
+  The processes that are not active only take part in moving the vectors
+  to and from the active processes.
+*/
+class AgglomeratedSolver: public Ifpack_Preconditioner,
+                          public BorderedOperator,
+                          public PLA
+  {
+public:
+  AgglomeratedSolver() = delete;
+
+  //! Constructor. map is the map of the matrix on this level, which is
+  //! moved onto numActiveProcs processes. level is the level of the
+  //! Preconditioner that will be created on the active processes.
+  AgglomeratedSolver(Teuchos::RCP<const Epetra_Map> map,
+    int numActiveProcs, int level);
+
+  //! destructor
+  virtual ~AgglomeratedSolver();
+
+  //! Number of processes that should be active for a problem with the
+  //! given map if every process should have at least threshold rows.
+  //! Returns map.Comm().NumProc() if no agglomeration is needed.
+  static int NumActiveProcs(Epetra_Map const &map, int threshold);
+
+  //! Map with the rows that are owned by this process after agglomeration.
+  //! This map lives on the subcommunicator and is null on processes that
+  //! are not active.
+  Teuchos::RCP<const Epetra_Map> ActiveMap() const {return activeMap_;}
+
+  //! true if this process is active
+  bool IsActive() const {return activeMap_ != Teuchos::null;}
+
+  //! Set the matrix (with the map passed to the constructor) and move it
+  //! to the active processes.
+  int SetMatrix(Teuchos::RCP<const Epetra_CrsMatrix> matrix);
+
+  //! Set the test vector and the partitioner for the Preconditioner on the
+  //! active processes. The partitioner should be constructed on ActiveMap().
+  int SetNextLevel(Teuchos::RCP<const Epetra_Vector> testVector,
+    Teuchos::RCP<const OverlappingPartitioner> hid);
+
+  //! \name ParameterListAcceptor interface
+  //@{
+
+  //! Set the ParameterList RCP directly
+  void setParameterList(const Teuchos::RCP<Teuchos::ParameterList>& list);
+
+  //@}
+
+  //! \name Ifpack_Preconditioner interface
+  //@{
+
+  //! Sets all parameters for the preconditioner.
+  int SetParameters(Teuchos::ParameterList& List);
+
+  //! Computes all it is necessary to initialize the preconditioner.
+  int Initialize();
+
+  //! Returns true if the  preconditioner has been successfully initialized, false otherwise.
+  bool IsInitialized() const;
+
+  //! Computes all it is necessary to apply the preconditioner.
+  int Compute();
+
+  //! Returns true if the  preconditioner has been successfully computed, false otherwise.
+  bool IsComputed() const;
+
+  //! Computes the condition number estimate, returns its value.
+  double Condest(const Ifpack_CondestType CT = Ifpack_Cheap,
+    const int MaxIters = 1550,
+    const double Tol = 1e-9,
+    Epetra_RowMatrix* Matrix = 0);
+
+  //! Returns the computed condition number estimate, or -1.0 if not computed.
+  double Condest() const;
+
+  //! Applies the preconditioner to vector X, returns the result in Y.
+  int ApplyInverse(const Epetra_MultiVector& X,
+    Epetra_MultiVector& Y) const;
+
+  //! Returns a pointer to the matrix to be preconditioned.
+  const Epetra_RowMatrix& Matrix() const;
+
+  //! Returns the number of calls to Initialize().
+  int NumInitialize() const;
+
+  //! Returns the number of calls to Compute().
+  int NumCompute() const;
+
+  //! Returns the number of calls to ApplyInverse().
+  int NumApplyInverse() const;
+
+  //! Returns the time spent in Initialize().
+  double InitializeTime() const;
+
+  //! Returns the time spent in Compute().
+  double ComputeTime() const;
+
+  //! Returns the time spent in ApplyInverse().
+  double ApplyInverseTime() const;
+
+  //! Returns the number of flops in the initialization phase.
+  double InitializeFlops() const;
+
+  //! Returns the number of flops in the computation phase.
+  double ComputeFlops() const;
+
+  //! Returns the number of flops in the application of the preconditioner.
+  double ApplyInverseFlops() const;
+
+  //! Prints basic information on iostream. This function is used by operator<<.
+  std::ostream& Print(std::ostream& os) const;
+
+  //@}
+
+  //! \name Epetra_Operator interface
+  //@{
+
+  //! If set true, transpose of this operator will be applied.
+  int SetUseTranspose(bool UseTranspose);
+
+  //! Returns the result of a Epetra_Operator applied to a Epetra_MultiVector X in Y.
+  int Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const;
+
+  //! Returns the infinity norm of the global matrix.
+  double NormInf() const;
+
+  //! Returns a character string describing the operator
+  const char * Label() const;
+
+  //! Returns the current UseTranspose setting.
+  bool UseTranspose() const;
+
+  //! Returns true if the \e this object can provide an approximate Inf-norm, false otherwise.
+  bool HasNormInf() const;
+
+  //! Returns a pointer to the Epetra_Comm communicator associated with this operator.
+  const Epetra_Comm & Comm() const;
+
+  //! Returns the Epetra_Map object associated with the domain of this operator.
+  const Epetra_Map & OperatorDomainMap() const;
+
+  //! Returns the Epetra_Map object associated with the range of this operator.
+  const Epetra_Map & OperatorRangeMap() const;
+
+  //@}
+
+  //! \name HYMLS BorderedOperator interface
+  //@{
+
+  //!
+  int SetBorder(Teuchos::RCP<const Epetra_MultiVector> V,
+    Teuchos::RCP<const Epetra_MultiVector> W,
+    Teuchos::RCP<const Epetra_SerialDenseMatrix> C);
+
+  //!
+  bool HaveBorder() const {return haveBorder_;}
+
+  //!
+  int Apply(const Epetra_MultiVector & B, const Epetra_SerialDenseMatrix & C,
+    Epetra_MultiVector& X, Epetra_SerialDenseMatrix & Y) const;
+
+  //! Compute [X S]' = [K V;W' C] \ [Y T]'
+  int ApplyInverse(const Epetra_MultiVector& X,
+    const Epetra_SerialDenseMatrix& T,
+    Epetra_MultiVector& Y,
+    Epetra_SerialDenseMatrix& S) const;
+
+  //@}
+
+protected:
+
+  //! Move a vector to the active processes. aggX is a vector on aggMap_
+  //! and the returned vector is a view of it on activeMap_, which is
+  //! null if this process is not active.
+  Teuchos::RCP<Epetra_MultiVector> Agglomerate(const Epetra_MultiVector &X,
+    Epetra_MultiVector &aggX) const;
+
+  //! View of a vector on aggMap_ as a vector on activeMap_
+  Teuchos::RCP<Epetra_MultiVector> ActiveView(Epetra_MultiVector &aggX) const;
+
+  //! communicator
+  Teuchos::RCP<const Epetra_Comm> comm_;
+
+  //! my level ID
+  int myLevel_;
+
+  //! map of the matrix on all processes
+  Teuchos::RCP<const Epetra_Map> map_;
+
+  //! map on all processes in which only the active processes own rows
+  Teuchos::RCP<const Epetra_Map> aggMap_;
+
+  //! communicator of the active processes, null if not active. The
+  //! MPI communicator is freed together with the last RCP to it.
+  Teuchos::RCP<Epetra_MpiComm> activeComm_;
+
+  //! aggMap_ on activeComm_
+  Teuchos::RCP<const Epetra_Map> activeMap_;
+
+  //! moves map_ to aggMap_
+  Teuchos::RCP<Epetra_Export> exporter_;
+
+  //! input matrix
+  Teuchos::RCP<const Epetra_CrsMatrix> matrix_;
+
+  //! matrix on the active processes
+  Teuchos::RCP<Epetra_CrsMatrix> activeMatrix_;
+
+  //! test vector on the active processes
+  Teuchos::RCP<Epetra_Vector> activeTestVector_;
+
+  //! partitioner for the solver on the active processes
+  Teuchos::RCP<const OverlappingPartitioner> hid_;
+
+  //! solver on the active processes
+  Teuchos::RCP<Preconditioner> solver_;
+
+  //! border on aggMap_, of which the active processes get a view
+  Teuchos::RCP<Epetra_MultiVector> aggV_, aggW_;
+
+  //! mutable temporary vectors used in ApplyInverse()
+  mutable Teuchos::RCP<Epetra_MultiVector> aggX_, aggY_;
+
+  //! true if SetBorder() has been called with non-null args
+  bool haveBorder_;
+
+  //! label
+  std::string label_;
+
+  //! has Initialize() been called?
+  bool initialized_;
+
+  //! has Compute() been called?
+  bool computed_;
+  };
+
+  }
+
+#endif
@@ -135,6 +135,8 @@ AugmentedMatrix::AugmentedMatrix(Teuchos::RCP<Epetra_RowMatrix> A,
   HYMLS_DEBVAR(*colMap_);
   rangeMap_ = rowMap_;
   domainMap_ = rowMap_;
+  // colMap_ is only used by this object, so there is no point in putting
+  // the importer in the ImportRegistry
   import_ = Teuchos::rcp(new Epetra_Import(*colMap_, *domainMap_));
   }
 
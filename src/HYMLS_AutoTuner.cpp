@@ -0,0 +1,363 @@
+#include "HYMLS_AutoTuner.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_Solver.hpp"
+#include "HYMLS_Epetra_Time.h"
+
+#include "Epetra_Comm.h"
+#include "Epetra_RowMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Vector.h"
+
+#include "Teuchos_ParameterList.hpp"
+#include "Teuchos_XMLParameterListHelpers.hpp"
+#include "Teuchos_StandardCatchMacros.hpp"
+#include "Teuchos_Utils.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace HYMLS {
+
+// constructor
+AutoTuner::AutoTuner(Teuchos::RCP<const Epetra_RowMatrix> K,
+  Teuchos::RCP<Teuchos::ParameterList> params,
+  Teuchos::RCP<Epetra_Vector> testVector)
+  : PLA("Autotuner"),
+    matrix_(K), testVector_(testVector),
+    bestCost_(std::numeric_limits<double>::infinity()),
+    numTrials_(0), label_("AutoTuner")
+  {
+  HYMLS_PROF3(label_, "Constructor");
+  setParameterList(params);
+
+  baseParams_ = Teuchos::rcp(new Teuchos::ParameterList(*params));
+  baseParams_->remove("Autotuner", false);
+  baseParams_->sublist("Preconditioner");
+  bestParams_ = Teuchos::rcp(new Teuchos::ParameterList(*baseParams_));
+  }
+
+// destructor
+AutoTuner::~AutoTuner()
+  {
+  HYMLS_PROF3(label_, "Destructor");
+  }
+
+//
+void AutoTuner::setParameterList(const Teuchos::RCP<Teuchos::ParameterList>& list)
+  {
+  HYMLS_PROF3(label_, "setParameterList");
+  setMyParamList(list);
+
+  if (validateParameters_)
+    {
+    getValidParameters();
+    PL().validateParameters(VPL());
+    }
+  HYMLS_DEBVAR(PL());
+
+  numSweeps_ = PL().get("Number of Sweeps", 1);
+  numTrialSolves_ = PL().get("Number of Trial Solves", 1);
+  expectedNumSolves_ = PL().get("Expected Number of Solves", 10);
+  maxTrialIterations_ = PL().get("Maximum Trial Iterations", 500);
+  outputFile_ = PL().get("Output File", "hymls_tuned.xml");
+
+  candidates_.clear();
+  std::string intNames[5] = {"Separator Length", "Coarsening Factor",
+                             "Number of Levels", "Dense Solvers on Level",
+                             "Retain Nodes"};
+  for (std::string const &name : intNames)
+    {
+    Teuchos::Array<int> values =
+      PL().get(name + " Candidates", Teuchos::Array<int>());
+    for (int value : values)
+      candidates_[name].append(Teuchos::toString(value));
+    }
+
+  Teuchos::Array<std::string> solverTypes =
+    PL().get("Subdomain Solver Type Candidates", Teuchos::Array<std::string>());
+  if (solverTypes.size())
+    candidates_["Subdomain Solver Type"] = solverTypes;
+  }
+
+//
+Teuchos::RCP<const Teuchos::ParameterList>
+AutoTuner::getValidParameters() const
+  {
+  if (validParams_ != Teuchos::null) return validParams_;
+  HYMLS_PROF3(label_, "getValidParameters");
+
+  validParams_ = Teuchos::rcp(new Teuchos::ParameterList());
+
+  std::string doc = "Candidate values for the 'Preconditioner' parameter ";
+
+  VPL().set("Separator Length Candidates", Teuchos::Array<int>(),
+    doc + "'Separator Length'");
+  VPL().set("Coarsening Factor Candidates", Teuchos::Array<int>(),
+    doc + "'Coarsening Factor'");
+  VPL().set("Number of Levels Candidates", Teuchos::Array<int>(),
+    doc + "'Number of Levels'");
+  VPL().set("Subdomain Solver Type Candidates", Teuchos::Array<std::string>(),
+    doc + "'Subdomain Solver Type'");
+  VPL().set("Dense Solvers on Level Candidates", Teuchos::Array<int>(),
+    doc + "'Dense Solvers on Level'");
+  VPL().set("Retain Nodes Candidates", Teuchos::Array<int>(),
+    doc + "'Retain Nodes at Level N', tried for every level separately");
+
+  VPL().set("Number of Sweeps", 1,
+    "Number of times all parameters are visited by the coordinate descent.\n"
+    "The search stops earlier if a sweep does not improve the cost");
+
+  VPL().set("Number of Trial Solves", 1,
+    "Number of solves performed in every trial to measure the iteration count\n"
+    "and the time per iteration");
+
+  VPL().set("Expected Number of Solves", 10,
+    "Number of solves per factorization that is assumed in the cost model");
+
+  VPL().set("Maximum Trial Iterations", 500,
+    "Maximum number of Krylov iterations in a trial. Trials that do not\n"
+    "converge are discarded");
+
+  VPL().set("Output File", "hymls_tuned.xml",
+    "XML file to which the best parameter list is written, '' means none");
+
+  return validParams_;
+  }
+
+//
+double AutoTuner::Cost(double setupTime, double iterTime, double numIter) const
+  {
+  return setupTime + expectedNumSolves_ * numIter * iterTime;
+  }
+
+//
+void AutoTuner::SetCandidate(Teuchos::ParameterList& list,
+  std::string const &name, std::string const &value)
+  {
+  Teuchos::ParameterList &precList = list.sublist("Preconditioner");
+
+  if (name == "Subdomain Solver Type")
+    {
+    precList.set(name, value);
+    return;
+    }
+
+  const int intValue = std::atoi(value.c_str());
+  precList.set(name, intValue);
+
+  // The directional variants take precedence over the plain parameter, so
+  // they have to be replaced as well. A value of 1 means that the direction
+  // is not partitioned (e.g. z in 2D problems), which we keep.
+  std::string extensions[3] = {" (x)", " (y)", " (z)"};
+  for (std::string const &extension : extensions)
+    {
+    if (precList.isParameter(name + extension) &&
+      precList.get(name + extension, 1) != 1)
+      {
+      precList.set(name + extension, intValue);
+      }
+    }
+  }
+
+//
+Teuchos::Array<std::pair<std::string, Teuchos::Array<std::string> > >
+AutoTuner::Dimensions(Teuchos::ParameterList const &current) const
+  {
+  Teuchos::Array<std::pair<std::string, Teuchos::Array<std::string> > > dims;
+
+  // the structure of the hierarchy is fixed first, then the solvers
+  std::string names[5] = {"Separator Length", "Coarsening Factor",
+                          "Number of Levels", "Subdomain Solver Type",
+                          "Dense Solvers on Level"};
+  for (std::string const &name : names)
+    {
+    std::map<std::string, Teuchos::Array<std::string> >::const_iterator it =
+      candidates_.find(name);
+    if (it != candidates_.end())
+      dims.append(*it);
+    }
+
+  std::map<std::string, Teuchos::Array<std::string> >::const_iterator retain =
+    candidates_.find("Retain Nodes");
+  if (retain != candidates_.end())
+    {
+    Teuchos::ParameterList const &precList = current.sublist("Preconditioner");
+    int numLevels = 1;
+    if (precList.isParameter("Number of Levels"))
+      numLevels = precList.get<int>("Number of Levels");
+
+    // only levels 0-9 are valid parameters of the Preconditioner
+    for (int lev = 0; lev < std::min(numLevels, 10); lev++)
+      dims.append(std::make_pair(
+          "Retain Nodes at Level " + Teuchos::toString(lev), retain->second));
+    }
+
+  return dims;
+  }
+
+//
+std::string AutoTuner::TrialKey(Teuchos::ParameterList const &list) const
+  {
+  std::ostringstream ss;
+  list.sublist("Preconditioner").print(ss);
+  return ss.str();
+  }
+
+//
+double AutoTuner::RunTrial(Teuchos::ParameterList const &trialList,
+  const Epetra_MultiVector& B)
+  {
+  HYMLS_PROF(label_, "RunTrial");
+
+  std::string key = TrialKey(trialList);
+  std::map<std::string, double>::const_iterator it = trialCache_.find(key);
+  if (it != trialCache_.end())
+    return it->second;
+
+  numTrials_++;
+
+  // the trial gets its own copy because the Preconditioner adjusts the
+  // "Problem" sublist
+  Teuchos::RCP<Teuchos::ParameterList> params =
+    Teuchos::rcp(new Teuchos::ParameterList(trialList));
+  params->sublist("Solver").sublist("Iterative Solver").set(
+    "Maximum Iterations", maxTrialIterations_);
+
+  const Epetra_Comm &comm = matrix_->Comm();
+  Epetra_Time time(comm);
+
+  double setupTime = 0.0;
+  double solveTime = 0.0;
+  int numIter = 0;
+  int converged = 1;
+
+  bool status = true;
+  try
+    {
+    Teuchos::RCP<Epetra_Vector> testVector = Teuchos::null;
+    if (testVector_ != Teuchos::null)
+      testVector = Teuchos::rcp(new Epetra_Vector(*testVector_));
+
+    Teuchos::RCP<Preconditioner> prec =
+      Teuchos::rcp(new Preconditioner(matrix_, params, testVector));
+
+    time.ResetStartTime();
+    CHECK_ZERO(prec->Initialize());
+    CHECK_ZERO(prec->Compute());
+    setupTime = time.ElapsedTime();
+
+    Teuchos::RCP<Solver> solver =
+      Teuchos::rcp(new Solver(matrix_, prec, params, B.NumVectors()));
+
+    Epetra_MultiVector X(B.Map(), B.NumVectors());
+    time.ResetStartTime();
+    for (int i = 0; i < numTrialSolves_; i++)
+      {
+      if (solver->ApplyInverse(B, X))
+        converged = 0;
+      numIter += solver->getNumIter();
+      }
+    solveTime = time.ElapsedTime();
+    } TEUCHOS_STANDARD_CATCH_STATEMENTS(true, std::cerr, status);
+
+  // make sure all processes agree on the outcome
+  int success = (status && converged) ? 1 : 0;
+  int globalSuccess = 0;
+  CHECK_ZERO(comm.MinAll(&success, &globalSuccess, 1));
+
+  double times[2] = {setupTime, solveTime};
+  double maxTimes[2];
+  CHECK_ZERO(comm.MaxAll(times, maxTimes, 2));
+
+  double cost = std::numeric_limits<double>::infinity();
+  if (globalSuccess)
+    {
+    const double iterations = (double)numIter / numTrialSolves_;
+    const double iterTime = numIter > 0 ? maxTimes[1] / numIter : 0.0;
+    cost = Cost(maxTimes[0], iterTime, iterations);
+
+    Tools::Out("Autotuner trial " + Teuchos::toString(numTrials_) +
+      ": setup " + Teuchos::toString(maxTimes[0]) +
+      " s, " + Teuchos::toString(iterations) +
+      " iterations of " + Teuchos::toString(iterTime) +
+      " s, cost " + Teuchos::toString(cost));
+    }
+  else
+    {
+    Tools::Out("Autotuner trial " + Teuchos::toString(numTrials_) +
+      " failed or did not converge");
+    }
+
+  trialCache_[key] = cost;
+  return cost;
+  }
+
+//
+int AutoTuner::Tune(const Epetra_MultiVector& B)
+  {
+  HYMLS_PROF(label_, "Tune");
+
+  bestParams_ = Teuchos::rcp(new Teuchos::ParameterList(*baseParams_));
+  bestCost_ = RunTrial(*bestParams_, B);
+
+  for (int sweep = 0; sweep < numSweeps_; sweep++)
+    {
+    bool improved = false;
+
+    // The dimensions are recomputed after every parameter because the
+    // number of retained node parameters depends on the number of levels.
+    for (int d = 0; ; d++)
+      {
+      Teuchos::Array<std::pair<std::string, Teuchos::Array<std::string> > >
+        dims = Dimensions(*bestParams_);
+      if (d >= dims.size())
+        break;
+
+      std::string const &name = dims[d].first;
+      for (std::string const &value : dims[d].second)
+        {
+        Teuchos::ParameterList trialList(*bestParams_);
+        SetCandidate(trialList, name, value);
+
+        Tools::Out("Autotuner: trying '" + name + "' = " + value);
+        double cost = RunTrial(trialList, B);
+        if (cost < bestCost_)
+          {
+          bestCost_ = cost;
+          *bestParams_ = trialList;
+          improved = true;
+          }
+        }
+      }
+
+    if (!improved)
+      break;
+    }
+
+  if (bestCost_ == std::numeric_limits<double>::infinity())
+    {
+    Tools::Warning("Autotuner did not find a set of parameters that converges",
+      __FILE__, __LINE__);
+    return -1;
+    }
+
+  Tools::Out("Autotuner: best cost " + Teuchos::toString(bestCost_) +
+    " after " + Teuchos::toString(numTrials_) + " trials");
+
+  if (outputFile_ != "" && matrix_->Comm().MyPID() == 0)
+    {
+    Tools::Out("Autotuner: best parameters are written to '" + outputFile_ + "'");
+    Teuchos::writeParameterListToXmlFile(*bestParams_, outputFile_);
+    }
+
+  return 0;
+  }
+
+  }
@@ -0,0 +1,159 @@
+#ifndef HYMLS_AUTOTUNER_H
+#define HYMLS_AUTOTUNER_H
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_PLA.hpp"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <map>
+#include <utility>
+#include <string>
+
+// forward declarations
+class Epetra_MultiVector;
+class Epetra_RowMatrix;
+class Epetra_Vector;
+
+namespace Teuchos
+  {
+class ParameterList;
+  }
+
+namespace HYMLS {
+
+/*! Automatic selection of the cost-determining parameters of the
+  HYMLS::Preconditioner. For each of the parameters
+
+  - "Separator Length"
+  - "Coarsening Factor"
+  - "Number of Levels"
+  - "Subdomain Solver Type"
+  - "Dense Solvers on Level"
+  - "Retain Nodes at Level N" (N = 0 .. "Number of Levels"-1)
+
+  a list of candidate values can be given in the "Autotuner" sublist. For
+  every candidate a complete trial run (Initialize, Compute and a number of
+  solves with HYMLS::Solver) is performed on the actual matrix. The trial is
+  rated by the cost model
+
+  cost = T_setup + "Expected Number of Solves" * iter * T_iter,
+
+  where T_setup is the time spent in Initialize() and Compute(), iter the
+  average number of Krylov iterations and T_iter the measured time per
+  iteration. Trials that fail or do not converge get an infinite cost.
+
+  The search is a coordinate descent: one parameter at a time is varied while
+  the others are kept at their best value so far. This is repeated
+  "Number of Sweeps" times. All timings are maximized over the processes so
+  that every process makes the same decisions.
+*/
+class AutoTuner : public PLA
+  {
+public:
+
+  //! Constructor. params is the complete parameter list as it would be
+  //! passed to the Preconditioner and Solver, the "Autotuner" sublist
+  //! contains the settings of this class.
+  AutoTuner(Teuchos::RCP<const Epetra_RowMatrix> K,
+    Teuchos::RCP<Teuchos::ParameterList> params,
+    Teuchos::RCP<Epetra_Vector> testVector=Teuchos::null);
+
+  //! destructor
+  virtual ~AutoTuner();
+
+  //! set parameters (the complete list, we only look at "Autotuner")
+  void setParameterList(const Teuchos::RCP<Teuchos::ParameterList>& list);
+
+  //! get a list of valid parameters for this object
+  Teuchos::RCP<const Teuchos::ParameterList> getValidParameters() const;
+
+  //! Run the trials with right-hand side B. Afterwards the best parameters
+  //! can be obtained with BestParameters() and are written to "Output File"
+  //! by the first process if that is not empty.
+  int Tune(const Epetra_MultiVector& B);
+
+  //! Get the best parameter list found by Tune(). The "Autotuner" sublist
+  //! is not part of it.
+  Teuchos::RCP<const Teuchos::ParameterList> BestParameters() const
+    {
+    return bestParams_;
+    }
+
+  //! Get the cost of the best parameter list
+  double BestCost() const {return bestCost_;}
+
+  //! Number of trials that were actually run (cached trials excluded)
+  int NumTrials() const {return numTrials_;}
+
+  //! Evaluate the cost model
+  double Cost(double setupTime, double iterTime, double numIter) const;
+
+  //! Set the value of one of the tunable parameters in the "Preconditioner"
+  //! sublist of list. Directional variants (x), (y) and (z) of the parameter
+  //! that are already present are overwritten as well.
+  static void SetCandidate(Teuchos::ParameterList& list,
+    std::string const &name, std::string const &value);
+
+protected:
+
+  //! Do a single trial run with the given list and return its cost
+  double RunTrial(Teuchos::ParameterList const &trialList,
+    const Epetra_MultiVector& B);
+
+  //! Get the names of the tunable parameters with their candidates,
+  //! in the order in which they are visited.
+  Teuchos::Array<std::pair<std::string, Teuchos::Array<std::string> > >
+  Dimensions(Teuchos::ParameterList const &current) const;
+
+  //! Create a key that identifies the trial in the cache
+  std::string TrialKey(Teuchos::ParameterList const &list) const;
+
+  //! matrix to tune for
+  Teuchos::RCP<const Epetra_RowMatrix> matrix_;
+
+  //! test vector passed to the trial preconditioners
+  Teuchos::RCP<Epetra_Vector> testVector_;
+
+  //! copy of the parameter list without the "Autotuner" sublist
+  Teuchos::RCP<Teuchos::ParameterList> baseParams_;
+
+  //! best parameter list found so far
+  Teuchos::RCP<Teuchos::ParameterList> bestParams_;
+
+  //! cost of bestParams_
+  double bestCost_;
+
+  //! number of trials that were run
+  int numTrials_;
+
+  //! costs of trials that were already run
+  std::map<std::string, double> trialCache_;
+
+  //! candidate values per parameter
+  std::map<std::string, Teuchos::Array<std::string> > candidates_;
+
+  //! number of coordinate descent sweeps
+  int numSweeps_;
+
+  //! number of solves per trial
+  int numTrialSolves_;
+
+  //! number of solves per factorization in the cost model
+  int expectedNumSolves_;
+
+  //! maximum number of Krylov iterations in a trial
+  int maxTrialIterations_;
+
+  //! file to which the best parameters are written
+  std::string outputFile_;
+
+  //! label
+  std::string label_;
+  };
+
+  }
+
+#endif
@@ -16,6 +16,9 @@
 #include "Epetra_MpiComm.h"
 #include "Epetra_Distributor.h"
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef HYMLS_TESTING
 #include "HYMLS_Tester.hpp"
 #endif
@@ -25,7 +28,9 @@ namespace HYMLS {
 BasePartitioner::BasePartitioner(Epetra_Comm const &comm, int level)
   :
   comm_(comm.Clone()),
-  myLevel_(level)
+  myLevel_(level),
+  loadBalancing_(false),
+  rebalanced_(false)
   {}
 
 void BasePartitioner::SetParameters(Teuchos::ParameterList& params)
@@ -38,11 +43,17 @@ void BasePartitioner::SetParameters(Teuchos::ParameterList& params)
   dim_ = probList.get("Dimension", 3);
   int pvar = -1;
 
-  nx_ = probList.get("nx", -1);
-  ny_ = probList.get("ny", nx_);
-  nz_ = probList.get("nz", dim_ > 2 ? nx_ : 1);
+  nx_ = -1;
+  ny_ = -1;
+  nz_ = -1;
+  if (NeedsGrid() || probList.isParameter("nx"))
+    {
+    nx_ = probList.get("nx", -1);
+    ny_ = probList.get("ny", nx_);
+    nz_ = probList.get("nz", dim_ > 2 ? nx_ : 1);
+    }
 
-  if (nx_ == -1)
+  if (nx_ == -1 && NeedsGrid())
     Tools::Error("You must presently specify nx, ny (and possibly nz) in the 'Problem' sublist",
       __FILE__, __LINE__);
 
@@ -140,6 +151,8 @@ void BasePartitioner::SetParameters(Teuchos::ParameterList& params)
 
   link_velocities_ = precList.get("Eliminate Velocities Together", false);
 
+  loadBalancing_ = precList.get("Load Balancing", false);
+
   if (probList.isParameter("Equations"))
     {
     std::string eqn = probList.get("Equations", "Undefined Problem");
@@ -366,6 +379,8 @@ int BasePartitioner::CreatePIDMap()
   int sy = sy_;
   int sz = sz_;
 
+  rebalanced_ = false;
+
   // If there is only 1 processor everyone is on PID 0.
   int nparts = NumGlobalParts(sx, sy, sz);
   if (comm_->NumProc() == 1 || nparts == 1)
@@ -582,9 +597,229 @@ int BasePartitioner::CreatePIDMap()
   auto end = std::unique(pidMap.begin(), pidMap.end());
   nprocs_ = std::distance(pidMap.begin(), end);
 
+  if (loadBalancing_)
+    CHECK_ZERO(BalancePIDMap());
+
+  return 0;
+  }
+
+// Wrap position x into [0, n) in periodic directions. Returns false if
+// the position is outside of the domain.
+static bool WrapCoordinate(int &x, int n, bool perio)
+  {
+  if (x >= 0 && x < n)
+    return true;
+  if (!perio)
+    return false;
+  x = (x % n + n) % n;
+  return true;
+  }
+
+bool BasePartitioner::WrapPosition(int &x, int &y, int &z) const
+  {
+  return WrapCoordinate(x, nx_, perio_ & GaleriExt::X_PERIO) &&
+    WrapCoordinate(y, ny_, perio_ & GaleriExt::Y_PERIO) &&
+    WrapCoordinate(z, nz_, perio_ & GaleriExt::Z_PERIO);
+  }
+
+int BasePartitioner::GetSubdomainNeighbors(int sd, Teuchos::Array<int> &neighbors) const
+  {
+  neighbors.resize(0);
+
+  int x, y, z;
+  if (GetSubdomainPosition(sd, sx_, sy_, sz_, x, y, z))
+    return 0;
+
+  x = (x % nx_ + nx_) % nx_;
+  y = (y % ny_ + ny_) % ny_;
+  z = (z % nz_ + nz_) % nz_;
+
+  const int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                             {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+  const int numNeighbors = nz_ > 1 ? 6 : 4;
+
+  int nparts = NumGlobalParts(sx_, sy_, sz_);
+  for (int i = 0; i < numNeighbors; i++)
+    {
+    int xn = x + offsets[i][0] * sx_;
+    int yn = y + offsets[i][1] * sy_;
+    int zn = z + offsets[i][2] * sz_;
+    if (!WrapPosition(xn, yn, zn))
+      continue;
+
+    int nb = GetSubdomainID(sx_, sy_, sz_, xn, yn, zn);
+    if (nb >= 0 && nb < nparts && nb != sd)
+      neighbors.append(nb);
+    }
+  return 0;
+  }
+
+int BasePartitioner::BalancePIDMap()
+  {
+  HYMLS_PROF2("BasePartitioner", "BalancePIDMap");
+
+  // If some processors are inactive or there is only one subdomain
+  // per processor there is nothing to balance.
+  int nparts = NumGlobalParts(sx_, sy_, sz_);
+  if (nprocs_ != comm_->NumProc() || nparts <= nprocs_)
+    return 0;
+
+  // With periodic boundaries several subdomain IDs may describe the same
+  // subdomain, see CreatePIDMap(). Only the first one is balanced and the
+  // others are moved along with it.
+  Teuchos::Array<int> positionID(nparts);
+  for (int sd = 0; sd < nparts; sd++)
+    {
+    int x, y, z;
+    GetSubdomainPosition(sd, sx_, sy_, sz_, x, y, z);
+    x = (x % nx_ + nx_) % nx_;
+    y = (y % ny_ + ny_) % ny_;
+    z = (z % nz_ + nz_) % nz_;
+    positionID[sd] = GetSubdomainID(sx_, sy_, sz_, x, y, z);
+    }
+
+  Teuchos::Array<int> canonical(nparts);
+  for (int sd = 0; sd < nparts; sd++)
+    {
+    int other = positionID[sd];
+    canonical[sd] = sd;
+    if (other >= 0 && other < nparts && other != sd &&
+      positionID[other] == other && (*pidMap_)[other] == (*pidMap_)[sd])
+      canonical[sd] = other;
+    }
+
+  Teuchos::Array<Teuchos::Array<int> > aliases(nparts);
+  for (int sd = 0; sd < nparts; sd++)
+    if (canonical[sd] != sd)
+      aliases[canonical[sd]].append(sd);
+
+  // Every processor has the complete pidMap_, so every processor can
+  // do the balancing by itself and arrives at the same result.
+  Teuchos::Array<double> cost(nparts, 0.0);
+  Teuchos::Array<double> load(nprocs_, 0.0);
+  Teuchos::Array<int> count(nprocs_, 0);
+  Teuchos::Array<Teuchos::Array<int> > neighbors(nparts);
+  for (int sd = 0; sd < nparts; sd++)
+    {
+    int pid = (*pidMap_)[sd];
+    if (pid < 0 || pid >= nprocs_ || canonical[sd] != sd)
+      continue;
+
+    cost[sd] = SubdomainCost(sd);
+    load[pid] += cost[sd];
+    count[pid]++;
+
+    CHECK_ZERO(GetSubdomainNeighbors(sd, neighbors[sd]));
+    for (int &nb: neighbors[sd])
+      nb = canonical[nb];
+    }
+
+  double totalLoad = 0.0;
+  for (double l: load)
+    totalLoad += l;
+  double averageLoad = totalLoad / nprocs_;
+  if (averageLoad <= 0.0)
+    return 0;
+
+  double initialImbalance = *std::max_element(load.begin(), load.end()) / averageLoad;
+
+  // Repeatedly move a subdomain to the least loaded neighboring processor
+  // if the new load of that processor stays below the load of the current
+  // processor. Every move decreases the sum of squares of the loads, so
+  // this terminates, but it may take long, so the number of sweeps is
+  // limited.
+  const int maxSweeps = 100;
+  int numMoved = 0;
+  int movedInSweep = 0;
+  for (int sweep = 0; sweep < maxSweeps; sweep++)
+    {
+    movedInSweep = 0;
+    for (int sd = 0; sd < nparts; sd++)
+      {
+      int pid = (*pidMap_)[sd];
+      if (pid < 0 || pid >= nprocs_ || count[pid] < 2 || cost[sd] <= 0.0 ||
+        canonical[sd] != sd)
+        continue;
+
+      int target = -1;
+      for (int nb: neighbors[sd])
+        {
+        int q = (*pidMap_)[nb];
+        if (q == pid || q < 0 || q >= nprocs_)
+          continue;
+
+        if (load[q] + cost[sd] < load[pid] &&
+          (target == -1 || load[q] < load[target]))
+          target = q;
+        }
+
+      if (target == -1)
+        continue;
+
+      load[pid] -= cost[sd];
+      load[target] += cost[sd];
+      count[pid]--;
+      count[target]++;
+      (*pidMap_)[sd] = target;
+      for (int alias: aliases[sd])
+        (*pidMap_)[alias] = target;
+      movedInSweep++;
+      }
+
+    numMoved += movedInSweep;
+    if (!movedInSweep)
+      break;
+    }
+
+  if (movedInSweep)
+    Tools::Warning("Load balancing stopped after " + Teuchos::toString(maxSweeps) +
+      " sweeps before the load was balanced", __FILE__, __LINE__);
+
+  rebalanced_ = numMoved > 0;
+
+  double finalImbalance = *std::max_element(load.begin(), load.end()) / averageLoad;
+  Tools::Out("Load balancing moved " + Teuchos::toString(numMoved) +
+    " subdomains, imbalance (max/average cost) " +
+    Teuchos::toString(initialImbalance) + " -> " +
+    Teuchos::toString(finalImbalance));
+
   return 0;
   }
 
+double BasePartitioner::SubdomainCost(int sd) const
+  {
+  int x, y, z;
+  if (GetSubdomainPosition(sd, sx_, sy_, sz_, x, y, z))
+    return 0.0;
+
+  x = (x % nx_ + nx_) % nx_;
+  y = (y % ny_ + ny_) % ny_;
+  z = (z % nz_ + nz_) % nz_;
+
+  bool xperio = perio_ & GaleriExt::X_PERIO;
+  bool yperio = perio_ & GaleriExt::Y_PERIO;
+  bool zperio = perio_ & GaleriExt::Z_PERIO;
+
+  // Part of the subdomain that is inside the domain
+  int ex = xperio ? sx_ : std::max(std::min(sx_, nx_ - x), 1);
+  int ey = yperio ? sy_ : std::max(std::min(sy_, ny_ - y), 1);
+  int ez = zperio ? sz_ : std::max(std::min(sz_, nz_ - z), 1);
+
+  // The last layer in every direction consists of separators, unless
+  // the subdomain touches a non-periodic boundary.
+  int ix = (xperio || x + sx_ < nx_) ? std::max(ex - 1, 1) : ex;
+  int iy = (yperio || y + sy_ < ny_) ? std::max(ey - 1, 1) : ey;
+  int iz = nz_ > 1 && (zperio || z + sz_ < nz_) ? std::max(ez - 1, 1) : ez;
+
+  double numInterior = (double)dof_ * ix * iy * iz;
+  double numSeparator = (double)dof_ * ex * ey * ez - numInterior;
+
+  // Fill of a nested dissection factorization of the interior plus the
+  // dense coupling between the interior and the separators.
+  double fill = std::pow(numInterior, dim_ > 2 ? 2.0 : 1.5);
+  return fill + numInterior * numSeparator;
+  }
+
 Teuchos::RCP<const Epetra_Map> BasePartitioner::MoveMap(
   Teuchos::RCP<const Epetra_Map> baseMap) const
   {
@@ -96,9 +96,31 @@ protected:
   //! Get the subdomain id from the position of a node in the subdomain
   virtual int GetSubdomainID(int sx, int sy, int sz, int x, int y, int z) const = 0;
 
+  //! Returns true if the partitioner needs the grid size "nx", "ny"
+  //! and "nz" in the "Problem" sublist
+  virtual bool NeedsGrid() const {return true;}
+
   //! Create a map of what processor a subdomain belongs to
   virtual int CreatePIDMap();
 
+  //! Move whole subdomains to neighboring processors such that the
+  //! estimated cost per processor is balanced. Only subdomains at the
+  //! boundary of a processor partition are moved to preserve locality.
+  virtual int BalancePIDMap();
+
+  //! Get the IDs of the subdomains that contain nodes adjacent to the
+  //! nodes of subdomain sd. The default assumes that the subdomains form
+  //! a Cartesian grid.
+  virtual int GetSubdomainNeighbors(int sd, Teuchos::Array<int> &neighbors) const;
+
+  //! Wrap a position into the domain in periodic directions. Returns
+  //! false if the position is outside of the domain.
+  bool WrapPosition(int &x, int &y, int &z) const;
+
+  //! Estimated cost of subdomain sd, based on the size of the interior
+  //! (fill of the factorization) and the size of its separators.
+  virtual double SubdomainCost(int sd) const;
+
   //! Repartitioning may occur for two reasons, typically on coarser levels:
   //! a) the number of subdomains becomes smaller than the number of processes,
   //! b) the subdomains can't be nicely distributed among the processes.
@@ -152,6 +174,12 @@ protected:
   //! Eliminate velocities together
   bool link_velocities_;
 
+  //! Balance the estimated cost per processor after creating the pidMap_
+  bool loadBalancing_;
+
+  //! true if BalancePIDMap() moved subdomains to other processors
+  bool rebalanced_;
+
   //! type of periodicity in the problem
   GaleriExt::PERIO_Flag perio_;
 
@@ -0,0 +1,368 @@
+#include "HYMLS_BinaryIO.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Vector.h"
+#include "Epetra_Import.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_toString.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace HYMLS
+  {
+
+namespace
+  {
+const char binaryMagic[8] = {'H', 'Y', 'M', 'L', 'S', 'B', 'I', 'N'};
+
+struct BinaryHeader
+  {
+  char magic[8];
+  long long version;
+  long long type;
+  long long numRows;
+  long long numCols;
+  long long numNonzeros;
+  long long indexBase;
+  long long numChunks;
+  };
+
+// the MPI communicator of an Epetra communicator
+MPI_Comm BinaryMpiComm(const Epetra_Comm &comm)
+  {
+  const Epetra_MpiComm *mpiComm = dynamic_cast<const Epetra_MpiComm *>(&comm);
+  if (mpiComm != NULL)
+    return mpiComm->Comm();
+  return MPI_COMM_SELF;
+  }
+
+// open the file on all processes of the map and read the header
+void OpenBinaryFile(const std::string &filename, const Epetra_Map &map,
+  long long type, MPI_File &fh, BinaryHeader &header)
+  {
+  if (MPI_File_open(BinaryMpiComm(map.Comm()), const_cast<char *>(filename.c_str()), MPI_MODE_RDONLY,
+      MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+    {
+    Tools::Error("Could not open '" + filename + "'", __FILE__, __LINE__);
+    }
+
+  CHECK_ZERO(MPI_File_read_at_all(fh, 0, &header, sizeof(BinaryHeader),
+      MPI_BYTE, MPI_STATUS_IGNORE));
+
+  if (std::memcmp(header.magic, binaryMagic, 8) != 0 || header.version != 1)
+    {
+    Tools::Error("'" + filename + "' is not a HYMLS binary file", __FILE__, __LINE__);
+    }
+  if (header.type != type)
+    {
+    Tools::Error("'" + filename + "' contains the wrong type of data", __FILE__, __LINE__);
+    }
+  if (header.numRows != (long long)map.NumGlobalElements64())
+    {
+    Tools::Error("'" + filename + "' has " + Teuchos::toString(header.numRows) +
+      " rows, but the map has " + Teuchos::toString(map.NumGlobalElements64()) +
+      " elements", __FILE__, __LINE__);
+    }
+  }
+
+// determine the rows this process reads, returns the offset of the data
+// after the chunks
+MPI_Offset BinaryRowRange(MPI_File fh, const BinaryHeader &header,
+  const Epetra_Comm &comm, long long &first, long long &last)
+  {
+  int numProc = comm.NumProc();
+  int myPID = comm.MyPID();
+  MPI_Offset offset = sizeof(BinaryHeader);
+
+  if (header.numChunks == numProc)
+    {
+    long long range[2];
+    CHECK_ZERO(MPI_File_read_at_all(fh, offset + myPID * sizeof(long long),
+        range, 2, MPI_LONG_LONG, MPI_STATUS_IGNORE));
+    first = range[0];
+    last = range[1];
+    }
+  else
+    {
+    // the same distribution as a linear Epetra_Map
+    long long n = header.numRows / numProc;
+    long long rest = header.numRows % numProc;
+    first = myPID * n + std::min((long long)myPID, rest);
+    last = first + n + (myPID < rest ? 1 : 0);
+    }
+
+  if (header.numChunks > 0)
+    offset += (header.numChunks + 1) * sizeof(long long);
+  return offset;
+  }
+  }
+
+Teuchos::RCP<Epetra_CrsMatrix> BinaryIO::ReadMatrix(
+  const std::string &filename, const Epetra_Map &map)
+  {
+  HYMLS_PROF2("BinaryIO", "ReadMatrix");
+
+  MPI_File fh;
+  BinaryHeader header;
+  OpenBinaryFile(filename, map, Matrix, fh, header);
+
+  if (header.numCols != header.numRows)
+    {
+    Tools::Error("Only square matrices are supported", __FILE__, __LINE__);
+    }
+
+  long long first, last;
+  MPI_Offset offset = BinaryRowRange(fh, header, map.Comm(), first, last);
+  int numMyRows = last - first;
+
+  Teuchos::Array<long long> rowPtr(numMyRows + 1);
+  CHECK_ZERO(MPI_File_read_at_all(fh, offset + first * sizeof(long long),
+      rowPtr.getRawPtr(), numMyRows + 1, MPI_LONG_LONG, MPI_STATUS_IGNORE));
+  offset += (header.numRows + 1) * sizeof(long long);
+
+  int numMyNonzeros = rowPtr[numMyRows] - rowPtr[0];
+  Teuchos::Array<long long> colInd(numMyNonzeros);
+  Teuchos::Array<double> values(numMyNonzeros);
+  CHECK_ZERO(MPI_File_read_at_all(fh, offset + rowPtr[0] * sizeof(long long),
+      colInd.getRawPtr(), numMyNonzeros, MPI_LONG_LONG, MPI_STATUS_IGNORE));
+  offset += header.numNonzeros * sizeof(long long);
+  CHECK_ZERO(MPI_File_read_at_all(fh, offset + rowPtr[0] * sizeof(double),
+      values.getRawPtr(), numMyNonzeros, MPI_DOUBLE, MPI_STATUS_IGNORE));
+
+  CHECK_ZERO(MPI_File_close(&fh));
+
+  // put the rows in a matrix with a linear map. The column indices in the
+  // file start at header.indexBase, the ones of the map at indexBase.
+  hymls_gidx indexBase = (hymls_gidx)map.IndexBase64();
+  Epetra_Map linearMap((hymls_gidx)header.numRows, numMyRows, indexBase, map.Comm());
+
+  Teuchos::Array<int> rowLengths(numMyRows);
+  for (int i = 0; i < numMyRows; i++)
+    rowLengths[i] = rowPtr[i + 1] - rowPtr[i];
+
+  Epetra_CrsMatrix linearMatrix(Copy, linearMap, rowLengths.getRawPtr());
+  Teuchos::Array<hymls_gidx> indices(numMyNonzeros);
+  for (int j = 0; j < numMyNonzeros; j++)
+    indices[j] = (hymls_gidx)(colInd[j] - header.indexBase) + indexBase;
+
+  for (int i = 0; i < numMyRows; i++)
+    {
+    int pos = rowPtr[i] - rowPtr[0];
+    hymls_gidx row = (hymls_gidx)(first + i) + indexBase;
+    CHECK_NONNEG(linearMatrix.InsertGlobalValues(row, rowLengths[i],
+        values.getRawPtr() + pos, indices.getRawPtr() + pos));
+    }
+
+  // and move them to the requested map
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(new Epetra_CrsMatrix(Copy, map, 0));
+  Epetra_Import import(map, linearMap);
+  CHECK_ZERO(A->Import(linearMatrix, import, Insert));
+  CHECK_ZERO(A->FillComplete());
+  return A;
+  }
+
+Teuchos::RCP<Epetra_Vector> BinaryIO::ReadVector(
+  const std::string &filename, const Epetra_Map &map)
+  {
+  HYMLS_PROF2("BinaryIO", "ReadVector");
+
+  MPI_File fh;
+  BinaryHeader header;
+  OpenBinaryFile(filename, map, Vector, fh, header);
+
+  long long first, last;
+  MPI_Offset offset = BinaryRowRange(fh, header, map.Comm(), first, last);
+  int numMyRows = last - first;
+
+  hymls_gidx indexBase = (hymls_gidx)map.IndexBase64();
+  Epetra_Map linearMap((hymls_gidx)header.numRows, numMyRows, indexBase, map.Comm());
+  Epetra_Vector linearVector(linearMap);
+
+  CHECK_ZERO(MPI_File_read_at_all(fh, offset + first * sizeof(double),
+      linearVector.Values(), numMyRows, MPI_DOUBLE, MPI_STATUS_IGNORE));
+  CHECK_ZERO(MPI_File_close(&fh));
+
+  Teuchos::RCP<Epetra_Vector> v = Teuchos::rcp(new Epetra_Vector(map));
+  Epetra_Import import(map, linearMap);
+  CHECK_ZERO(v->Import(linearVector, import, Insert));
+  return v;
+  }
+
+int BinaryIO::WriteMatrix(const std::string &filename,
+  long long numRows, long long numCols,
+  const Teuchos::Array<long long> &rowPtr,
+  const Teuchos::Array<long long> &colInd,
+  const Teuchos::Array<double> &values,
+  const Teuchos::Array<long long> &chunks)
+  {
+  HYMLS_PROF2("BinaryIO", "WriteMatrix");
+
+  if (rowPtr.size() != numRows + 1 || colInd.size() != rowPtr[numRows] ||
+    values.size() != colInd.size())
+    {
+    Tools::Warning("Inconsistent compressed row storage", __FILE__, __LINE__);
+    return -1;
+    }
+
+  BinaryHeader header;
+  std::memcpy(header.magic, binaryMagic, 8);
+  header.version = 1;
+  header.type = Matrix;
+  header.numRows = numRows;
+  header.numCols = numCols;
+  header.numNonzeros = colInd.size();
+  header.indexBase = 0;
+  header.numChunks = chunks.size() > 1 ? chunks.size() - 1 : 0;
+
+  std::ofstream ofs(filename.c_str(), std::ios::binary);
+  if (!ofs)
+    {
+    Tools::Warning("Could not open '" + filename + "'", __FILE__, __LINE__);
+    return -2;
+    }
+
+  ofs.write((const char *)&header, sizeof(BinaryHeader));
+  if (header.numChunks > 0)
+    ofs.write((const char *)chunks.getRawPtr(), chunks.size() * sizeof(long long));
+  ofs.write((const char *)rowPtr.getRawPtr(), rowPtr.size() * sizeof(long long));
+  ofs.write((const char *)colInd.getRawPtr(), colInd.size() * sizeof(long long));
+  ofs.write((const char *)values.getRawPtr(), values.size() * sizeof(double));
+
+  return ofs.good() ? 0 : -3;
+  }
+
+int BinaryIO::WriteVector(const std::string &filename,
+  const Teuchos::Array<double> &values,
+  const Teuchos::Array<long long> &chunks)
+  {
+  HYMLS_PROF2("BinaryIO", "WriteVector");
+
+  BinaryHeader header;
+  std::memcpy(header.magic, binaryMagic, 8);
+  header.version = 1;
+  header.type = Vector;
+  header.numRows = values.size();
+  header.numCols = 1;
+  header.numNonzeros = values.size();
+  header.indexBase = 0;
+  header.numChunks = chunks.size() > 1 ? chunks.size() - 1 : 0;
+
+  std::ofstream ofs(filename.c_str(), std::ios::binary);
+  if (!ofs)
+    {
+    Tools::Warning("Could not open '" + filename + "'", __FILE__, __LINE__);
+    return -2;
+    }
+
+  ofs.write((const char *)&header, sizeof(BinaryHeader));
+  if (header.numChunks > 0)
+    ofs.write((const char *)chunks.getRawPtr(), chunks.size() * sizeof(long long));
+  ofs.write((const char *)values.getRawPtr(), values.size() * sizeof(double));
+
+  return ofs.good() ? 0 : -3;
+  }
+
+int BinaryIO::WriteVector(const std::string &filename, const Epetra_Vector &v)
+  {
+  HYMLS_PROF2("BinaryIO", "WriteVector");
+
+  const Epetra_Comm &comm = v.Comm();
+  int numProc = comm.NumProc();
+
+  // move the values to a linear map in which every process has as many
+  // rows as in v, so every process writes one contiguous block of rows
+  hymls_gidx indexBase = (hymls_gidx)v.Map().IndexBase64();
+  Epetra_Map linearMap((hymls_gidx)v.GlobalLength64(), v.MyLength(), indexBase, comm);
+  Epetra_Vector linearVector(linearMap);
+  Epetra_Import import(linearMap, v.Map());
+  CHECK_ZERO(linearVector.Import(v, import, Insert));
+
+  long long numMyRows = v.MyLength();
+  long long last;
+  CHECK_ZERO(comm.ScanSum(&numMyRows, &last, 1));
+  long long first = last - numMyRows;
+
+  Teuchos::Array<long long> chunks(numProc + 1);
+  CHECK_ZERO(comm.GatherAll(&first, chunks.getRawPtr(), 1));
+  chunks[numProc] = v.GlobalLength64();
+
+  MPI_File fh;
+  if (MPI_File_open(BinaryMpiComm(comm), const_cast<char *>(filename.c_str()),
+      MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+    {
+    Tools::Warning("Could not open '" + filename + "'", __FILE__, __LINE__);
+    return -2;
+    }
+
+  // remove the contents of an existing file
+  int ierr = MPI_File_set_size(fh, 0);
+
+  if (comm.MyPID() == 0 && ierr == MPI_SUCCESS)
+    {
+    BinaryHeader header;
+    std::memcpy(header.magic, binaryMagic, 8);
+    header.version = 1;
+    header.type = Vector;
+    header.numRows = v.GlobalLength64();
+    header.numCols = 1;
+    header.numNonzeros = header.numRows;
+    header.indexBase = 0;
+    header.numChunks = numProc;
+
+    ierr = MPI_File_write_at(fh, 0, &header, sizeof(BinaryHeader),
+      MPI_BYTE, MPI_STATUS_IGNORE);
+    if (ierr == MPI_SUCCESS)
+      ierr = MPI_File_write_at(fh, sizeof(BinaryHeader), chunks.getRawPtr(),
+        numProc + 1, MPI_LONG_LONG, MPI_STATUS_IGNORE);
+    }
+
+  MPI_Offset offset = sizeof(BinaryHeader) + (numProc + 1) * sizeof(long long);
+  int ierr2 = MPI_File_write_at_all(fh, offset + first * sizeof(double),
+    linearVector.Values(), numMyRows, MPI_DOUBLE, MPI_STATUS_IGNORE);
+  int ierr3 = MPI_File_close(&fh);
+
+  int failed = (ierr != MPI_SUCCESS || ierr2 != MPI_SUCCESS || ierr3 != MPI_SUCCESS);
+  int anyFailed;
+  CHECK_ZERO(comm.MaxAll(&failed, &anyFailed, 1));
+  if (anyFailed)
+    {
+    Tools::Warning("Could not write '" + filename + "'", __FILE__, __LINE__);
+    return -3;
+    }
+  return 0;
+  }
+
+Teuchos::Array<long long> BinaryIO::BalancedChunks(
+  const Teuchos::Array<long long> &rowPtr, int numChunks)
+  {
+  long long numRows = rowPtr.size() - 1;
+  long long numNonzeros = rowPtr[numRows];
+
+  Teuchos::Array<long long> chunks(numChunks + 1);
+  long long row = 0;
+  for (int c = 0; c < numChunks; c++)
+    {
+    chunks[c] = row;
+    long long target = (numNonzeros * (c + 1)) / numChunks;
+    while (row < numRows && rowPtr[row + 1] <= target)
+      row++;
+    }
+  chunks[numChunks] = numRows;
+  return chunks;
+  }
+
+  }
@@ -0,0 +1,83 @@
+#ifndef HYMLS_BINARY_IO_H
+#define HYMLS_BINARY_IO_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <string>
+
+class Epetra_Map;
+class Epetra_CrsMatrix;
+class Epetra_Vector;
+
+namespace HYMLS {
+
+/*! Reading and writing of matrices and vectors in a simple binary format
+  that can be read in parallel. A file consists of
+
+  - a header: the 8 characters "HYMLSBIN" followed by 7 64-bit integers:
+    the version (1), the type (Matrix or Vector), the number of rows,
+    the number of columns, the number of nonzeros, the index base and
+    the number of chunks,
+  - if the number of chunks is larger than 0, the first row of every
+    chunk and the number of rows (numChunks+1 64-bit integers),
+  - for a matrix: the row pointer (numRows+1 64-bit integers), the
+    column indices (numNonzeros 64-bit integers) and the values
+    (numNonzeros doubles) in compressed row storage,
+  - for a vector: the values (numRows doubles).
+
+  All data is stored in the byte order of the machine that wrote it. The
+  rows are numbered from 0 and the column indices from the index base in
+  the header, which is 0 for files written by this class. When read,
+  they are shifted to the index base of the map. When the file is read with
+  as many processes as it has chunks, process p reads the rows of chunk
+  p, otherwise the rows are divided evenly. Every process reads its own
+  rows with MPI-IO, after which they are moved to the requested map.
+*/
+class BinaryIO
+  {
+public:
+
+  //! types of data that can be stored
+  enum FileType {Matrix = 1, Vector = 2};
+
+  //! read a square matrix with the given row map. Collective.
+  static Teuchos::RCP<Epetra_CrsMatrix> ReadMatrix(
+    const std::string &filename, const Epetra_Map &map);
+
+  //! read a vector with the given map. Collective.
+  static Teuchos::RCP<Epetra_Vector> ReadVector(
+    const std::string &filename, const Epetra_Map &map);
+
+  //! write a matrix in compressed row storage from a single process.
+  //! chunks may be empty, or contain the first row of every chunk
+  //! followed by numRows.
+  static int WriteMatrix(const std::string &filename,
+    long long numRows, long long numCols,
+    const Teuchos::Array<long long> &rowPtr,
+    const Teuchos::Array<long long> &colInd,
+    const Teuchos::Array<double> &values,
+    const Teuchos::Array<long long> &chunks = Teuchos::Array<long long>());
+
+  //! write a vector from a single process
+  static int WriteVector(const std::string &filename,
+    const Teuchos::Array<double> &values,
+    const Teuchos::Array<long long> &chunks = Teuchos::Array<long long>());
+
+  //! write a distributed vector ordered by GID. Every process writes
+  //! its own rows with MPI-IO, and these rows are stored as the chunk of
+  //! the process. Collective.
+  static int WriteVector(const std::string &filename, const Epetra_Vector &v);
+
+  //! divide the rows of a matrix into numChunks chunks with about the
+  //! same number of nonzeros. Returns the first row of every chunk
+  //! followed by the number of rows.
+  static Teuchos::Array<long long> BalancedChunks(
+    const Teuchos::Array<long long> &rowPtr, int numChunks);
+  };
+
+  }
+
+#endif
@@ -0,0 +1,93 @@
+#include "HYMLS_CacheUtils.hpp"
+
+#include "HYMLS_config.h"
+
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+
+#include "Teuchos_ParameterList.hpp"
+#include "Teuchos_toString.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace HYMLS {
+namespace CacheUtils {
+
+void HashBytes(std::uint64_t &hash, const void *data, std::size_t size)
+  {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; i++)
+    {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+    }
+  }
+
+void HashMap(std::uint64_t &hash, const Epetra_Map &map)
+  {
+  for (int lid = 0; lid < map.NumMyElements(); lid++)
+    {
+    hymls_gidx gid = map.GID64(lid);
+    HashBytes(hash, &gid, sizeof(gid));
+    }
+  }
+
+bool IsPartitioningParameter(std::string const &name)
+  {
+  const char *prefixes[] = {"Partitioner", "Separator Length",
+    "Coarsening Factor", "Retain Nodes", "Eliminate ", "Load Balancing",
+    "Fix ", "B-Grid Transform", "Number of Subdomains", "Subdivide "};
+  for (const char *prefix: prefixes)
+    if (name.compare(0, std::strlen(prefix), prefix) == 0)
+      return true;
+  return false;
+  }
+
+bool IsSchurParameter(std::string const &name)
+  {
+  const char *names[] = {"Number of Levels", "Preconditioner Variant",
+    "Apply Dropping", "Apply Orthogonal Transformation"};
+  for (const char *schurName: names)
+    if (name == schurName)
+      return true;
+  return IsPartitioningParameter(name);
+  }
+
+void HashParameters(std::uint64_t &hash, Teuchos::ParameterList const &list,
+  bool (*filter)(std::string const &name))
+  {
+  std::vector<std::string> names;
+  for (auto it = list.begin(); it != list.end(); ++it)
+    if (filter == nullptr || filter(list.name(it)))
+      names.push_back(list.name(it));
+  std::sort(names.begin(), names.end());
+
+  for (std::string const &name: names)
+    {
+    HashBytes(hash, name.c_str(), name.size() + 1);
+    Teuchos::ParameterEntry const &entry = *list.getEntryPtr(name);
+    if (entry.isList())
+      {
+      HashParameters(hash, list.sublist(name));
+      continue;
+      }
+    std::ostringstream value;
+    value << entry.getAny();
+    std::string str = value.str();
+    HashBytes(hash, str.c_str(), str.size() + 1);
+    }
+  }
+
+std::string FileName(std::string const &prefix, int level,
+  const Epetra_Comm &comm)
+  {
+  return prefix + "_L" + Teuchos::toString(level) +
+    "_np" + Teuchos::toString(comm.NumProc()) +
+    "_p" + Teuchos::toString(comm.MyPID()) + ".bin";
+  }
+
+  }
+  }
@@ -0,0 +1,93 @@
+#ifndef HYMLS_CACHE_UTILS_H
+#define HYMLS_CACHE_UTILS_H
+
+#include "HYMLS_config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "Teuchos_Array.hpp"
+
+class Epetra_Comm;
+class Epetra_Map;
+
+namespace Teuchos {
+class ParameterList;
+}
+
+namespace HYMLS {
+namespace CacheUtils {
+
+// Helpers for the binary caches of the partitioning and of the Schur
+// complements: hashes that identify the inputs and the per-process files.
+
+// initial value of an FNV-1a hash
+const std::uint64_t HashSeed = 14695981039346656037ULL;
+
+// add size bytes to an FNV-1a hash
+void HashBytes(std::uint64_t &hash, const void *data, std::size_t size);
+
+// add the local GIDs of a map to a hash
+void HashMap(std::uint64_t &hash, const Epetra_Map &map);
+
+// true for the entries of the "Preconditioner" sublist that are read by
+// the partitioners
+bool IsPartitioningParameter(std::string const &name);
+
+// true for the entries of the "Preconditioner" sublist that change the
+// approximate Schur complements: those of the partitioning and those
+// that select the variant, the dropping and the number of levels. The
+// solver sublists are not included, the solvers write their defaults
+// into them and only change the rounding errors.
+bool IsSchurParameter(std::string const &name);
+
+// add the names and values of the entries of a parameter list to a hash
+// in alphabetical order, so the order in which they were set does not
+// matter. If a filter is given, only the entries for which it is true
+// are used, sublists are then used completely.
+void HashParameters(std::uint64_t &hash, Teuchos::ParameterList const &list,
+  bool (*filter)(std::string const &name) = nullptr);
+
+// the file of this process for a cache of the given level:
+// prefix_L<level>_np<procs>_p<pid>.bin
+std::string FileName(std::string const &prefix, int level,
+  const Epetra_Comm &comm);
+
+template<typename T>
+void Write(std::ostream &os, T const &value)
+  {
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+template<typename T>
+void Write(std::ostream &os, Teuchos::Array<T> const &values)
+  {
+  Write(os, (std::int64_t)values.size());
+  if (values.size())
+    os.write(reinterpret_cast<const char *>(values.getRawPtr()), values.size() * sizeof(T));
+  }
+
+template<typename T>
+bool Read(std::istream &is, T &value)
+  {
+  return (bool)is.read(reinterpret_cast<char *>(&value), sizeof(T));
+  }
+
+template<typename T>
+bool Read(std::istream &is, Teuchos::Array<T> &values)
+  {
+  std::int64_t size;
+  if (!Read(is, size) || size < 0)
+    return false;
+  values.resize(size);
+  if (size)
+    is.read(reinterpret_cast<char *>(values.getRawPtr()), size * sizeof(T));
+  return (bool)is;
+  }
+
+  }
+  }
+
+#endif
@@ -178,7 +178,7 @@ int CartesianPartitioner::Partition(bool repart)
 
   CHECK_ZERO(CreatePIDMap());
 
-  if (nprocs_ != comm_->NumProc())
+  if (nprocs_ != comm_->NumProc() || rebalanced_)
     repart = true;
 
   CHECK_ZERO(CreateSubdomainMap());
@@ -0,0 +1,369 @@
+#include "HYMLS_Checkpoint.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_HierarchicalMap.hpp"
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_SerialDenseMatrix.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_toString.hpp"
+
+#ifdef HAVE_HDF5
+#include "EpetraExt_HDF5.h"
+#include "EpetraExt_Exception.h"
+
+#ifdef HYMLS_LONG_LONG
+#define HYMLS_H5T_GIDX H5T_NATIVE_LLONG
+#else
+#define HYMLS_H5T_GIDX H5T_NATIVE_INT
+#endif
+
+// EpetraExt reports HDF5 errors with exceptions, turn them into our own
+#define HYMLS_HDF5_CALL(call) \
+  try {call;} catch (EpetraExt::Exception &e) \
+    { \
+    e.Print(); \
+    HYMLS::Tools::Error("HDF5 error in checkpoint '" + filename_ + "'", \
+      __FILE__, __LINE__); \
+    }
+#endif
+
+namespace HYMLS
+  {
+
+#ifndef HAVE_HDF5
+
+Checkpoint::Checkpoint(const Epetra_Comm &comm, const std::string &filename,
+  bool create)
+  :
+  comm_(comm),
+  filename_(filename)
+  {
+  Tools::Error("HDF checkpoints are not available, recompile with -DHAVE_HDF5",
+    __FILE__, __LINE__);
+  }
+
+Checkpoint::~Checkpoint() {}
+
+bool Checkpoint::IsContained(const std::string &group) const {return false;}
+void Checkpoint::Write(const std::string &group, const Epetra_CrsMatrix &A) {}
+void Checkpoint::Write(const std::string &group, const Epetra_MultiVector &x) {}
+void Checkpoint::Write(const std::string &group, const Epetra_SerialDenseMatrix &C) {}
+void Checkpoint::Write(const std::string &group, const std::string &name, double value) {}
+void Checkpoint::Write(const std::string &group, const HierarchicalMap &hmap) {}
+
+Teuchos::RCP<Epetra_CrsMatrix> Checkpoint::ReadMatrix(const std::string &group,
+  const Epetra_Map &map) {return Teuchos::null;}
+
+Teuchos::RCP<Epetra_MultiVector> Checkpoint::ReadMultiVector(const std::string &group,
+  const Epetra_Map &map) {return Teuchos::null;}
+
+Teuchos::RCP<Epetra_SerialDenseMatrix> Checkpoint::ReadSerialDenseMatrix(
+  const std::string &group) {return Teuchos::null;}
+
+double Checkpoint::ReadScalar(const std::string &group, const std::string &name) {return 0.0;}
+
+int Checkpoint::Read(const std::string &group, HierarchicalMap &hmap) {return -1;}
+
+Teuchos::Array<hymls_gidx> Checkpoint::ReadGIDs(const std::string &group,
+  const std::string &name) {return Teuchos::Array<hymls_gidx>();}
+
+void Checkpoint::WriteGIDs(const std::string &group, const std::string &name,
+  const Teuchos::Array<hymls_gidx> &gids) {}
+
+#else
+
+namespace
+  {
+Teuchos::Array<hymls_gidx> MyGIDs(const Epetra_Map &map)
+  {
+  Teuchos::Array<hymls_gidx> gids(map.NumMyElements());
+  for (int lid = 0; lid < map.NumMyElements(); lid++)
+    gids[lid] = map.GID64(lid);
+  return gids;
+  }
+  }
+
+Checkpoint::Checkpoint(const Epetra_Comm &comm, const std::string &filename,
+  bool create)
+  :
+  comm_(comm),
+  filename_(filename),
+  hdf5_(Teuchos::rcp(new EpetraExt::HDF5(comm)))
+  {
+  HYMLS_PROF2("Checkpoint", "Constructor");
+  if (create)
+    {
+    HYMLS_HDF5_CALL(hdf5_->Create(filename_));
+    }
+  else
+    {
+    HYMLS_HDF5_CALL(hdf5_->Open(filename_));
+    }
+  }
+
+Checkpoint::~Checkpoint()
+  {
+  if (hdf5_->IsOpen())
+    hdf5_->Close();
+  }
+
+bool Checkpoint::IsContained(const std::string &group) const
+  {
+  return hdf5_->IsContained(group);
+  }
+
+void Checkpoint::Write(const std::string &group, const Epetra_CrsMatrix &A)
+  {
+  HYMLS_PROF2("Checkpoint", "Write (1)");
+  HYMLS_HDF5_CALL(hdf5_->Write(group, A));
+  }
+
+void Checkpoint::Write(const std::string &group, const Epetra_MultiVector &x)
+  {
+  HYMLS_PROF2("Checkpoint", "Write (2)");
+  HYMLS_HDF5_CALL(hdf5_->Write(group, x));
+  }
+
+void Checkpoint::Write(const std::string &group, const Epetra_SerialDenseMatrix &C)
+  {
+  HYMLS_PROF2("Checkpoint", "Write (3)");
+
+  // store the columns without the leading dimension
+  int m = C.M();
+  int n = C.N();
+  Teuchos::Array<double> values(m * n);
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      values[j * m + i] = C(i, j);
+
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumRows", m));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumCols", n));
+  if (m * n > 0)
+    {
+    HYMLS_HDF5_CALL(hdf5_->Write(group, "Values", H5T_NATIVE_DOUBLE,
+        m * n, values.getRawPtr()));
+    }
+  }
+
+void Checkpoint::Write(const std::string &group, const std::string &name, double value)
+  {
+  HYMLS_HDF5_CALL(hdf5_->Write(group, name, value));
+  }
+
+void Checkpoint::Write(const std::string &group, const HierarchicalMap &hmap)
+  {
+  HYMLS_PROF2("Checkpoint", "Write (4)");
+
+  int numMySubdomains = hmap.NumMySubdomains();
+  Teuchos::Array<int> numGroups(numMySubdomains);
+  Teuchos::Array<int> types, lengths;
+  Teuchos::Array<hymls_gidx> nodes;
+  for (int sd = 0; sd < numMySubdomains; sd++)
+    {
+    Teuchos::Array<hymls_gidx> const &interior = hmap.GetInteriorGroup(sd).nodes();
+    numGroups[sd] = 1 + hmap.GetSeparatorGroups(sd).size();
+    types.append(0);
+    lengths.append(interior.size());
+    nodes.insert(nodes.end(), interior.begin(), interior.end());
+    for (SeparatorGroup const &sep: hmap.GetSeparatorGroups(sd))
+      {
+      types.append(sep.type());
+      lengths.append(sep.length());
+      nodes.insert(nodes.end(), sep.nodes().begin(), sep.nodes().end());
+      }
+    }
+
+  int myCounts[2] = {numMySubdomains, (int)types.size()};
+  int counts[2];
+  CHECK_ZERO(comm_.SumAll(myCounts, counts, 2));
+  int numProc = comm_.NumProc();
+
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumProc", numProc));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumMySubdomains", 1, numProc,
+      H5T_NATIVE_INT, &myCounts[0]));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumMyGroups", 1, numProc,
+      H5T_NATIVE_INT, &myCounts[1]));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "NumGroups", numMySubdomains, counts[0],
+      H5T_NATIVE_INT, numGroups.getRawPtr()));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "GroupTypes", types.size(), counts[1],
+      H5T_NATIVE_INT, types.getRawPtr()));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "GroupLengths", lengths.size(), counts[1],
+      H5T_NATIVE_INT, lengths.getRawPtr()));
+  WriteGIDs(group, "Nodes", nodes);
+
+  // the base maps, which may differ from the ones that were passed to
+  // the partitioner
+  Teuchos::RCP<const Epetra_Map> baseMap = hmap.baseMap_;
+  Teuchos::RCP<const Epetra_Map> overlappingMap = hmap.baseOverlappingMap_;
+  WriteGIDs(group, "BaseMap", MyGIDs(*baseMap));
+  HYMLS_HDF5_CALL(hdf5_->Write(group, "HasOverlappingMap",
+      overlappingMap != Teuchos::null ? 1 : 0));
+  if (overlappingMap != Teuchos::null)
+    {
+    WriteGIDs(group, "OverlappingMap", MyGIDs(*overlappingMap));
+    }
+  }
+
+Teuchos::RCP<Epetra_CrsMatrix> Checkpoint::ReadMatrix(const std::string &group,
+  const Epetra_Map &map)
+  {
+  HYMLS_PROF2("Checkpoint", "ReadMatrix");
+  Epetra_CrsMatrix *A = NULL;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, map, map, A));
+  return Teuchos::rcp(A);
+  }
+
+Teuchos::RCP<Epetra_MultiVector> Checkpoint::ReadMultiVector(const std::string &group,
+  const Epetra_Map &map)
+  {
+  HYMLS_PROF2("Checkpoint", "ReadMultiVector");
+  Epetra_MultiVector *x = NULL;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, map, x));
+  return Teuchos::rcp(x);
+  }
+
+Teuchos::RCP<Epetra_SerialDenseMatrix> Checkpoint::ReadSerialDenseMatrix(
+  const std::string &group)
+  {
+  HYMLS_PROF2("Checkpoint", "ReadSerialDenseMatrix");
+  int m = 0, n = 0;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumRows", m));
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumCols", n));
+
+  Teuchos::RCP<Epetra_SerialDenseMatrix> C =
+    Teuchos::rcp(new Epetra_SerialDenseMatrix(m, n));
+  if (m * n > 0)
+    {
+    Teuchos::Array<double> values(m * n);
+    HYMLS_HDF5_CALL(hdf5_->Read(group, "Values", H5T_NATIVE_DOUBLE,
+        m * n, values.getRawPtr()));
+    for (int j = 0; j < n; j++)
+      for (int i = 0; i < m; i++)
+        (*C)(i, j) = values[j * m + i];
+    }
+  return C;
+  }
+
+double Checkpoint::ReadScalar(const std::string &group, const std::string &name)
+  {
+  double value = 0.0;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, name, value));
+  return value;
+  }
+
+int Checkpoint::Read(const std::string &group, HierarchicalMap &hmap)
+  {
+  HYMLS_PROF2("Checkpoint", "Read");
+
+  int numProc = 0;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumProc", numProc));
+  if (numProc != comm_.NumProc())
+    {
+    Tools::Warning("The partitioning in '" + filename_ + "' was made for " +
+      Teuchos::toString(numProc) + " processes", __FILE__, __LINE__);
+    return 1;
+    }
+
+  int myCounts[2];
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumMySubdomains", 1, numProc,
+      H5T_NATIVE_INT, &myCounts[0]));
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumMyGroups", 1, numProc,
+      H5T_NATIVE_INT, &myCounts[1]));
+  int counts[2];
+  CHECK_ZERO(comm_.SumAll(myCounts, counts, 2));
+
+  int numMySubdomains = myCounts[0];
+  Teuchos::Array<int> numGroups(numMySubdomains);
+  Teuchos::Array<int> types(myCounts[1]), lengths(myCounts[1]);
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "NumGroups", numMySubdomains, counts[0],
+      H5T_NATIVE_INT, numGroups.getRawPtr()));
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "GroupTypes", types.size(), counts[1],
+      H5T_NATIVE_INT, types.getRawPtr()));
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "GroupLengths", lengths.size(), counts[1],
+      H5T_NATIVE_INT, lengths.getRawPtr()));
+  Teuchos::Array<hymls_gidx> nodes = ReadGIDs(group, "Nodes");
+
+  // the base maps have the same distribution as when they were written
+  Teuchos::Array<hymls_gidx> gids = ReadGIDs(group, "BaseMap");
+  hymls_gidx indexBase = (hymls_gidx)hmap.baseMap_->IndexBase64();
+  hmap.baseMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, gids.size(),
+      gids.getRawPtr(), indexBase, comm_));
+
+  int hasOverlappingMap = 0;
+  HYMLS_HDF5_CALL(hdf5_->Read(group, "HasOverlappingMap", hasOverlappingMap));
+  hmap.baseOverlappingMap_ = Teuchos::null;
+  if (hasOverlappingMap)
+    {
+    gids = ReadGIDs(group, "OverlappingMap");
+    hmap.baseOverlappingMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1,
+        gids.size(), gids.getRawPtr(), indexBase, comm_));
+    }
+
+  CHECK_ZERO(hmap.Reset(numMySubdomains));
+  int grp = 0;
+  int pos = 0;
+  for (int sd = 0; sd < numMySubdomains; sd++)
+    {
+    for (int i = 0; i < numGroups[sd]; i++, grp++)
+      {
+      Teuchos::Array<hymls_gidx>::iterator first = nodes.begin() + pos;
+      pos += lengths[grp];
+      if (i == 0)
+        {
+        InteriorGroup interior;
+        interior.nodes().assign(first, first + lengths[grp]);
+        CHECK_ZERO(hmap.AddInteriorGroup(sd, interior));
+        }
+      else
+        {
+        SeparatorGroup sep;
+        sep.set_type(types[grp]);
+        sep.nodes().assign(first, first + lengths[grp]);
+        CHECK_ZERO(hmap.AddSeparatorGroup(sd, sep));
+        }
+      }
+    }
+  CHECK_ZERO(hmap.FillComplete());
+  return 0;
+  }
+
+Teuchos::Array<hymls_gidx> Checkpoint::ReadGIDs(const std::string &group,
+  const std::string &name)
+  {
+  int myLength = 0;
+  HYMLS_HDF5_CALL(hdf5_->Read(group + "/" + name, "NumMyElements", 1,
+      comm_.NumProc(), H5T_NATIVE_INT, &myLength));
+  int length;
+  CHECK_ZERO(comm_.SumAll(&myLength, &length, 1));
+  Teuchos::Array<hymls_gidx> gids(myLength);
+  HYMLS_HDF5_CALL(hdf5_->Read(group + "/" + name, "GIDs", myLength, length,
+      HYMLS_H5T_GIDX, gids.getRawPtr()));
+  return gids;
+  }
+
+void Checkpoint::WriteGIDs(const std::string &group, const std::string &name,
+  const Teuchos::Array<hymls_gidx> &gids)
+  {
+  int myLength = gids.size();
+  int length;
+  CHECK_ZERO(comm_.SumAll(&myLength, &length, 1));
+  HYMLS_HDF5_CALL(hdf5_->Write(group + "/" + name, "NumMyElements", 1,
+      comm_.NumProc(), H5T_NATIVE_INT, &myLength));
+  HYMLS_HDF5_CALL(hdf5_->Write(group + "/" + name, "GIDs", myLength, length,
+      HYMLS_H5T_GIDX, gids.getRawPtr()));
+  }
+
+#endif
+
+  }
@@ -0,0 +1,117 @@
+#ifndef HYMLS_CHECKPOINT_H
+#define HYMLS_CHECKPOINT_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <string>
+
+// forward declarations
+class Epetra_Comm;
+class Epetra_Map;
+class Epetra_CrsMatrix;
+class Epetra_MultiVector;
+class Epetra_SerialDenseMatrix;
+
+namespace EpetraExt {
+class HDF5;
+  }
+
+namespace HYMLS {
+
+class HierarchicalMap;
+
+/*! Collective reading and writing of checkpoints in a parallel HDF5
+  file, so a long run can be restarted from them. Every object is
+  stored in its own group of the file.
+
+  Matrices and vectors are written as global datasets in which every
+  process writes its own rows. When they are read, every process reads a
+  contiguous part of the rows, after which they are moved to the map that
+  is passed in, so they can be read with any number of processes.
+
+  A HierarchicalMap is stored as the GIDs of its base maps together with
+  the groups of every subdomain. The subdomains belong to the process
+  that created them, so it can only be read with the same number of
+  processes. Read() returns 1 in that case, after which the caller
+  should partition again.
+
+  All of this requires HYMLS to be compiled with -DHAVE_HDF5.
+*/
+class Checkpoint
+  {
+public:
+
+  //! Open a checkpoint file. If create is true, a new file is created,
+  //! otherwise an existing file is opened. Collective.
+  Checkpoint(const Epetra_Comm &comm, const std::string &filename,
+    bool create = false);
+
+  //! destructor, closes the file
+  virtual ~Checkpoint();
+
+  //! true if the file contains the group
+  bool IsContained(const std::string &group) const;
+
+  //! write a square matrix
+  void Write(const std::string &group, const Epetra_CrsMatrix &A);
+
+  //! write a (multi-)vector
+  void Write(const std::string &group, const Epetra_MultiVector &x);
+
+  //! write a dense matrix that is the same on all processes, like the
+  //! C part of a bordered system
+  void Write(const std::string &group, const Epetra_SerialDenseMatrix &C);
+
+  //! write a scalar, e.g. a continuation parameter
+  void Write(const std::string &group, const std::string &name, double value);
+
+  //! write the partitioning of a HierarchicalMap
+  void Write(const std::string &group, const HierarchicalMap &hmap);
+
+  //! read a square matrix and distribute its rows according to map
+  Teuchos::RCP<Epetra_CrsMatrix> ReadMatrix(const std::string &group,
+    const Epetra_Map &map);
+
+  //! read a (multi-)vector and distribute it according to map
+  Teuchos::RCP<Epetra_MultiVector> ReadMultiVector(const std::string &group,
+    const Epetra_Map &map);
+
+  //! read a dense matrix on all processes
+  Teuchos::RCP<Epetra_SerialDenseMatrix> ReadSerialDenseMatrix(
+    const std::string &group);
+
+  //! read a scalar
+  double ReadScalar(const std::string &group, const std::string &name);
+
+  //! Replace the partitioning of hmap by the one that is stored. The
+  //! base maps of hmap are replaced as well. Returns 1 if the file was
+  //! written with a different number of processes, in which case hmap
+  //! is not changed.
+  int Read(const std::string &group, HierarchicalMap &hmap);
+
+protected:
+
+  //! communicator
+  const Epetra_Comm &comm_;
+
+  //! name of the file
+  std::string filename_;
+
+  //! the HDF5 file
+  Teuchos::RCP<EpetraExt::HDF5> hdf5_;
+
+  //! read a distributed array of GIDs with the distribution it was written with
+  Teuchos::Array<hymls_gidx> ReadGIDs(const std::string &group,
+    const std::string &name);
+
+  //! write a distributed array of GIDs and the number of GIDs per process
+  void WriteGIDs(const std::string &group, const std::string &name,
+    const Teuchos::Array<hymls_gidx> &gids);
+  };
+
+  }
+
+#endif
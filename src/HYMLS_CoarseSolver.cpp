@@ -7,6 +7,9 @@
 #include "HYMLS_Macros.hpp"
 #include "HYMLS_Tools.hpp"
 #include "HYMLS_MatrixUtils.hpp"
+#include "HYMLS_CoreLending.hpp"
+#include "HYMLS_NodeGather.hpp"
+#include "HYMLS_ImportRegistry.hpp"
 
 #include "Epetra_Comm.h"
 #include "Epetra_Map.h"
@@ -16,6 +19,7 @@
 #include "Epetra_SerialDenseMatrix.h"
 #include "Epetra_CrsMatrix.h"
 #include "Epetra_MpiComm.h"
+#include "Epetra_SerialComm.h"
 #include "Epetra_Operator.h"
 #include "Epetra_Vector.h"
 
@@ -48,6 +52,10 @@ CoarseSolver::CoarseSolver(
   comm_(Teuchos::rcp(matrix->Comm().Clone())),
   myLevel_(level),
   amActive_(true),
+  lendIdleCores_(false),
+  numThreads_(-1),
+  nodeGather_(false),
+  replicated_(false),
   matrix_(matrix),
   linearRhs_(Teuchos::null), linearSol_(Teuchos::null),
   haveBorder_(false),
@@ -76,6 +84,10 @@ int CoarseSolver::SetParameters(Teuchos::ParameterList& List)
     setMyParamList(Teuchos::rcp(&List, false));
     }
 
+  lendIdleCores_ = List.get("Lend Idle Cores", false);
+  nodeGather_ = List.get("Coarse Node Gather", false);
+  replicated_ = List.get("Replicated Coarse Solve", false);
+
   fix_gid_.resize(0);
 
   int pos = 1;
@@ -116,6 +128,9 @@ int CoarseSolver::Initialize()
   restrictX_ = Teuchos::rcp(new ::HYMLS::EpetraExt::RestrictedMultiVectorWrapper());
   restrictB_ = Teuchos::rcp(new ::HYMLS::EpetraExt::RestrictedMultiVectorWrapper());
 
+  gather_ = Teuchos::null;
+  replicatedMatrix_ = Teuchos::null;
+
   initialized_ = true;
   computed_ = false;
   haveBorder_ = false;
@@ -154,6 +169,14 @@ int CoarseSolver::Compute()
   HYMLS_DEBUG("reindex matrix to linear indexing");
   linearMatrix_ = Teuchos::rcp(&((*reindexA_)(*reducedSchur_)), false);
 
+  replicatedMatrix_ = Teuchos::null;
+  if (replicated_ && !HaveBorder())
+    {
+    CHECK_ZERO(ComputeReplicated());
+    computed_ = true;
+    return 0;
+    }
+
   // passed to direct solver - depends on what exactly we do
   Teuchos::RCP<Epetra_RowMatrix> S2 = Teuchos::null;
 
@@ -161,10 +184,35 @@ int CoarseSolver::Compute()
   int reducedNumProc = -1;
   if (Teuchos::rcp_dynamic_cast<const Epetra_MpiComm>(comm_) != Teuchos::null)
     {
+    Teuchos::RCP<Epetra_CrsMatrix> activeMatrix = linearMatrix_;
+    if (nodeGather_ && !HaveBorder())
+      {
+      // Put the whole matrix on process 0. The right-hand side is then
+      // gathered there via the node leaders in ApplyInverse().
+      if (gather_ == Teuchos::null)
+        gather_ = Teuchos::rcp(new NodeGather(*linearMap_));
+
+      const Epetra_Map &rootMap = gather_->RootMap();
+      rootMatrix_ = Teuchos::rcp(new Epetra_CrsMatrix(Copy, rootMap, 0));
+      Teuchos::RCP<const Epetra_Import> import =
+        ImportRegistry::GetImport(rootMap, *linearMap_);
+      CHECK_ZERO(rootMatrix_->Import(*linearMatrix_, *import, Insert));
+      CHECK_ZERO(rootMatrix_->FillComplete(rootMap, rootMap));
+      activeMatrix = rootMatrix_;
+
+      // make sure the vectors are restricted again
+      linearRhs_ = Teuchos::null;
+      }
+    else
+      {
+      gather_ = Teuchos::null;
+      rootMatrix_ = Teuchos::null;
+      }
+
     // restrict the matrix to the active processors
     // we have to restrict_comm again because the pointer is no longer
     // valid, it seems
-    CHECK_ZERO(restrictA_->restrict_comm(linearMatrix_));
+    CHECK_ZERO(restrictA_->restrict_comm(activeMatrix));
     amActive_ = restrictA_->RestrictedProcIsActive();
     restrictX_->SetMPISubComm(restrictA_->GetMPISubComm());
     restrictB_->SetMPISubComm(restrictA_->GetMPISubComm());
@@ -227,9 +275,19 @@ int CoarseSolver::Compute()
   // end bordered case section                                              //
   ////////////////////////////////////////////////////////////////////////////
 
+  // Usually only a few processes take part in the direct solve, so the
+  // others can hand over their cores.
+  numThreads_ = -1;
+  if (lendIdleCores_)
+    {
+    CoreLending lending(*comm_, amActive_, CoreLending::MaxThreads());
+    numThreads_ = lending.NumThreads();
+    }
+
   Teuchos::ParameterList &amesosList = PL().sublist("Coarse Solver");
   if (amActive_)
     {
+    ThreadGuard threads(numThreads_);
     if (S2 == Teuchos::null)
       {
       Tools::Error("failed to select matrix for coarsest level", __FILE__, __LINE__);
@@ -247,6 +305,71 @@ int CoarseSolver::Compute()
   return 0;
   }
 
+int CoarseSolver::ComputeReplicated()
+  {
+  HYMLS_LPROF2(label_, "ComputeReplicated");
+
+  // The coarsest matrix is small, so every process gets all of its rows.
+  // allMap is new every time, so the importer is not put in the
+  // ImportRegistry.
+  Teuchos::RCP<Epetra_Map> allMap = MatrixUtils::AllGather(*linearMap_);
+  Epetra_Import import(*allMap, *linearMap_);
+  Epetra_CrsMatrix allMatrix(Copy, *allMap, linearMatrix_->MaxNumEntries());
+  CHECK_ZERO(allMatrix.Import(*linearMatrix_, import, Insert));
+
+  // Copy it into a matrix that only lives on this process. The linear map
+  // has the GIDs 0 to n-1, so the GIDs stay the same.
+  int n = allMap->NumMyElements();
+  serialComm_ = Teuchos::rcp(new Epetra_SerialComm());
+  Epetra_Map serialMap((hymls_gidx)n, 0, *serialComm_);
+  replicatedMatrix_ = Teuchos::rcp(new Epetra_CrsMatrix(Copy, serialMap,
+      linearMatrix_->MaxNumEntries()));
+
+  Teuchos::Array<hymls_gidx> indices;
+  Teuchos::Array<double> values;
+  for (int i = 0; i < n; i++)
+    {
+    hymls_gidx row = allMap->GID64(i);
+    int len = allMatrix.NumMyEntries(i);
+    indices.resize(len);
+    values.resize(len);
+    CHECK_ZERO(allMatrix.ExtractGlobalRowCopy(row, len, len,
+        values.getRawPtr(), indices.getRawPtr()));
+    CHECK_NONNEG(replicatedMatrix_->InsertGlobalValues(row, len,
+        values.getRawPtr(), indices.getRawPtr()));
+    }
+  CHECK_ZERO(replicatedMatrix_->FillComplete());
+
+  // the rows of process p are at position replicatedOffsets_[p]
+  int numProc = comm_->NumProc();
+  int myLength = linearMap_->NumMyElements();
+  replicatedCounts_.resize(numProc);
+  replicatedOffsets_.resize(numProc + 1);
+  CHECK_ZERO(comm_->GatherAll(&myLength, replicatedCounts_.getRawPtr(), 1));
+  replicatedOffsets_[0] = 0;
+  for (int p = 0; p < numProc; p++)
+    {
+    replicatedOffsets_[p + 1] = replicatedOffsets_[p] + replicatedCounts_[p];
+    }
+
+  replicatedRhs_ = Teuchos::null;
+  replicatedSol_ = Teuchos::null;
+
+  // every process takes part in the solve
+  amActive_ = true;
+  numThreads_ = -1;
+
+  Teuchos::ParameterList &amesosList = PL().sublist("Coarse Solver");
+  reducedSchurSolver_ = Teuchos::rcp(new Ifpack_Amesos(replicatedMatrix_.get()));
+  CHECK_ZERO(reducedSchurSolver_->SetParameters(amesosList));
+  HYMLS_DEBUG("Initialize replicated direct solver");
+  CHECK_ZERO(reducedSchurSolver_->Initialize());
+  HYMLS_DEBUG("Compute replicated direct solver");
+  CHECK_ZERO(reducedSchurSolver_->Compute());
+
+  return 0;
+  }
+
 bool CoarseSolver::IsComputed() const
   {
   return computed_;
@@ -295,13 +418,28 @@ int CoarseSolver::ApplyInverse(const Epetra_MultiVector &X,
       }
     }
 
+  if (replicatedMatrix_ != Teuchos::null)
+    {
+    CHECK_ZERO(ApplyInverseReplicated(*linearRhs_, Y));
+    return 0;
+    }
+
   if (realloc_vectors)
     {
 #ifdef RESTRICT_ON_COARSE_LEVEL
     if (Teuchos::rcp_dynamic_cast<const Epetra_MpiComm>(comm_) != Teuchos::null)
       {
-      CHECK_ZERO(restrictB_->restrict_comm(linearRhs_));
-      CHECK_ZERO(restrictX_->restrict_comm(linearSol_));
+      Teuchos::RCP<Epetra_MultiVector> rhs = linearRhs_;
+      Teuchos::RCP<Epetra_MultiVector> sol = linearSol_;
+      if (gather_ != Teuchos::null)
+        {
+        rootRhs_ = Teuchos::rcp(new Epetra_MultiVector(gather_->RootMap(), X.NumVectors()));
+        rootSol_ = Teuchos::rcp(new Epetra_MultiVector(gather_->RootMap(), X.NumVectors()));
+        rhs = rootRhs_;
+        sol = rootSol_;
+        }
+      CHECK_ZERO(restrictB_->restrict_comm(rhs));
+      CHECK_ZERO(restrictX_->restrict_comm(sol));
       restrictedRhs_ = restrictB_->RestrictedMultiVector();
       restrictedSol_ = restrictX_->RestrictedMultiVector();
       }
@@ -312,16 +450,74 @@ int CoarseSolver::ApplyInverse(const Epetra_MultiVector &X,
       restrictedSol_ = linearSol_;
       }
     }
+
+  if (gather_ != Teuchos::null)
+    {
+    CHECK_ZERO(gather_->Gather(*linearRhs_, *rootRhs_));
+    }
+
   if (amActive_)
     {
+    ThreadGuard threads(numThreads_);
     CHECK_ZERO(reducedSchurSolver_->ApplyInverse(*restrictedRhs_, *restrictedSol_));
     }
+
+  if (gather_ != Teuchos::null)
+    {
+    CHECK_ZERO(gather_->Scatter(*rootSol_, *linearSol_));
+    }
+
   // Put the solution back into the vector with the original map
   Y = *linearSol_;
 
   return 0;
   }
 
+int CoarseSolver::ApplyInverseReplicated(const Epetra_MultiVector &X,
+  Epetra_MultiVector &Y) const
+  {
+  HYMLS_LPROF3(label_, "ApplyInverseReplicated");
+
+  int numVectors = X.NumVectors();
+  if (replicatedRhs_ == Teuchos::null || replicatedRhs_->NumVectors() != numVectors)
+    {
+    replicatedRhs_ = Teuchos::rcp(new Epetra_MultiVector(replicatedMatrix_->RowMap(), numVectors));
+    replicatedSol_ = Teuchos::rcp(new Epetra_MultiVector(replicatedMatrix_->RowMap(), numVectors));
+    }
+
+  // collect the complete right-hand side on every process
+  Teuchos::RCP<const Epetra_MpiComm> mpiComm =
+    Teuchos::rcp_dynamic_cast<const Epetra_MpiComm>(comm_);
+  for (int k = 0; k < numVectors; k++)
+    {
+    if (mpiComm != Teuchos::null)
+      {
+      CHECK_ZERO(MPI_Allgatherv(X[k], X.MyLength(), MPI_DOUBLE,
+          (*replicatedRhs_)[k], replicatedCounts_.getRawPtr(),
+          replicatedOffsets_.getRawPtr(), MPI_DOUBLE, mpiComm->Comm()));
+      }
+    else
+      {
+      for (int i = 0; i < X.MyLength(); i++)
+        {
+        (*replicatedRhs_)[k][i] = X[k][i];
+        }
+      }
+    }
+
+  CHECK_ZERO(reducedSchurSolver_->ApplyInverse(*replicatedRhs_, *replicatedSol_));
+
+  int offset = replicatedOffsets_[comm_->MyPID()];
+  for (int k = 0; k < numVectors; k++)
+    {
+    for (int i = 0; i < Y.MyLength(); i++)
+      {
+      Y[k][i] = (*replicatedSol_)[k][offset + i];
+      }
+    }
+  return 0;
+  }
+
 const Epetra_RowMatrix& CoarseSolver::Matrix() const
   {
   return *matrix_;
@@ -530,7 +726,10 @@ int CoarseSolver::ApplyInverse(const Epetra_MultiVector &X,
         }
       }
     HYMLS_DEBUG("coarse level solve");
-    CHECK_ZERO(reducedSchurSolver_->ApplyInverse(*restrictedRhs_, *restrictedSol_));
+      {
+      ThreadGuard threads(numThreads_);
+      CHECK_ZERO(reducedSchurSolver_->ApplyInverse(*restrictedRhs_, *restrictedSol_));
+      }
 
     // unscale the solution and split into X and S
     for (int j = 0; j < X.NumVectors(); j++)
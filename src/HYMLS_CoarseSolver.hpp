@@ -41,6 +41,8 @@ class RestrictedCrsMatrixWrapper;
 class RestrictedMultiVectorWrapper;
   }
 
+class NodeGather;
+
 class CoarseSolver: public Ifpack_Preconditioner,
                     public BorderedOperator,
                     public PLA
@@ -185,6 +187,15 @@ public:
 
 protected:
 
+  //! Compute() for the replicated solve: gather the matrix on all
+  //! processes and factor it on every process
+  int ComputeReplicated();
+
+  //! ApplyInverse() for the replicated solve: gather the right-hand side
+  //! on all processes and solve locally
+  int ApplyInverseReplicated(const Epetra_MultiVector& X,
+    Epetra_MultiVector& Y) const;
+
   //! communicator
   Teuchos::RCP<const Epetra_Comm> comm_;
 
@@ -194,6 +205,38 @@ protected:
   //! if the processor has no rows in the present SC, this is false.
   bool amActive_;
 
+  //! obtained from user parameter "Lend Idle Cores": let the direct
+  //! solver use the cores of inactive processes on the same node
+  bool lendIdleCores_;
+
+  //! number of threads the direct solver may use, -1 to leave it as is
+  int numThreads_;
+
+  //! obtained from user parameter "Coarse Node Gather": solve on
+  //! process 0 and gather the right-hand side via the node leaders
+  bool nodeGather_;
+
+  //! two-stage gather onto process 0, null if it is not used
+  Teuchos::RCP<NodeGather> gather_;
+
+  //! obtained from user parameter "Replicated Coarse Solve": factor the
+  //! matrix on every process
+  bool replicated_;
+
+  //! communicator of the replicated matrix
+  Teuchos::RCP<Epetra_Comm> serialComm_;
+
+  //! copy of the complete matrix on this process for the replicated
+  //! solve, null if it is not used
+  Teuchos::RCP<Epetra_CrsMatrix> replicatedMatrix_;
+
+  //! number of rows of every process and the offset of its rows in
+  //! the replicated matrix
+  Teuchos::Array<int> replicatedCounts_, replicatedOffsets_;
+
+  //! replicated vectors used in ApplyInverse()
+  mutable Teuchos::RCP<Epetra_MultiVector> replicatedRhs_, replicatedSol_;
+
   //! input matrix
   Teuchos::RCP<const Epetra_CrsMatrix> matrix_;
 
@@ -224,9 +267,15 @@ protected:
   // View of SC2 with linear map and no empty partitions (restricted Comm)
   Teuchos::RCP<Epetra_CrsMatrix> restrictedMatrix_;
 
+  // Copy of SC2 with all rows on process 0, only used with gather_
+  Teuchos::RCP<Epetra_CrsMatrix> rootMatrix_;
+
   //! Views and copies of vectors used in ApplyInverse(), mutable temporary data
   mutable Teuchos::RCP<Epetra_MultiVector> linearRhs_, linearSol_, restrictedRhs_, restrictedSol_;
 
+  //! gathered vectors on process 0, only used with gather_
+  mutable Teuchos::RCP<Epetra_MultiVector> rootRhs_, rootSol_;
+
   //! solver for the reduced Schur complement. Note that Ifpack_Preconditioner
   //! is implemented by both Amesos (direct solver) and our HYMLS::Solver,
   //! so we don't have to make a choice at this point.
@@ -0,0 +1,105 @@
+#include "HYMLS_CoreLending.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_MpiComm.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+
+#ifdef HYMLS_USE_OPENMP
+#include <omp.h>
+#endif
+
+#ifdef HYMLS_USE_MKL
+#include <mkl.h>
+#endif
+
+namespace HYMLS
+  {
+
+CoreLending::CoreLending(const Epetra_Comm &comm, bool active, int baseThreads)
+  :
+  numThreads_(std::max(baseThreads, 1)),
+  numProcsOnNode_(1),
+  numActiveOnNode_(active ? 1 : 0)
+  {
+  HYMLS_PROF3("CoreLending", "Constructor");
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+  const Epetra_MpiComm *mpiComm = dynamic_cast<const Epetra_MpiComm *>(&comm);
+  if (mpiComm == NULL)
+    return;
+
+  MPI_Comm nodeComm;
+  CHECK_ZERO(MPI_Comm_split_type(mpiComm->Comm(), MPI_COMM_TYPE_SHARED,
+      comm.MyPID(), MPI_INFO_NULL, &nodeComm));
+
+  int myActive = active ? 1 : 0;
+  int activeBefore = 0;
+  CHECK_ZERO(MPI_Comm_size(nodeComm, &numProcsOnNode_));
+  CHECK_ZERO(MPI_Allreduce(&myActive, &numActiveOnNode_, 1, MPI_INT, MPI_SUM, nodeComm));
+  CHECK_ZERO(MPI_Scan(&myActive, &activeBefore, 1, MPI_INT, MPI_SUM, nodeComm));
+  activeBefore -= myActive;
+  CHECK_ZERO(MPI_Comm_free(&nodeComm));
+
+  if (!active)
+    return;
+
+  // divide all cores of the node over the active processes, the
+  // first ones get the remainder
+  int numCores = numThreads_ * numProcsOnNode_;
+  numThreads_ = numCores / numActiveOnNode_;
+  if (activeBefore < numCores % numActiveOnNode_)
+    numThreads_++;
+#endif
+  }
+
+int CoreLending::MaxThreads()
+  {
+  int maxThreads = 1;
+#ifdef HYMLS_USE_OPENMP
+  maxThreads = std::max(maxThreads, omp_get_max_threads());
+#endif
+#ifdef HYMLS_USE_MKL
+  maxThreads = std::max(maxThreads, mkl_get_max_threads());
+#endif
+  return maxThreads;
+  }
+
+ThreadGuard::ThreadGuard(int numThreads)
+  :
+  numThreads_(numThreads),
+  previousOMPThreads_(-1),
+  previousMKLThreads_(-1)
+  {
+  if (numThreads_ < 1)
+    return;
+
+#ifdef HYMLS_USE_MKL
+  previousMKLThreads_ = mkl_set_num_threads_local(numThreads_);
+#endif
+#ifdef HYMLS_USE_OPENMP
+  previousOMPThreads_ = omp_get_max_threads();
+  omp_set_num_threads(numThreads_);
+#endif
+  }
+
+ThreadGuard::~ThreadGuard()
+  {
+#ifdef HYMLS_USE_MKL
+  if (previousMKLThreads_ >= 0)
+    mkl_set_num_threads_local(previousMKLThreads_);
+#endif
+#ifdef HYMLS_USE_OPENMP
+  if (previousOMPThreads_ > 0)
+    omp_set_num_threads(previousOMPThreads_);
+#endif
+  }
+
+  }
@@ -0,0 +1,83 @@
+#ifndef HYMLS_CORE_LENDING_H
+#define HYMLS_CORE_LENDING_H
+
+#include "HYMLS_config.h"
+
+class Epetra_Comm;
+
+namespace HYMLS {
+
+/*! On coarser levels, and in the direct solver on the coarsest level,
+  only some of the processes do any work. This class determines how many
+  threads the active processes on a compute node can use if the cores of
+  the idle processes on that node are handed to them.
+
+  The cores are divided evenly over the active processes of the node.
+  Idle processes keep their own number of threads. Note that idle
+  processes that wait in an MPI call may still occupy their core if the
+  MPI library polls actively.
+*/
+class CoreLending
+  {
+public:
+
+  //! Constructor. Collective on comm. active indicates whether this
+  //! process does any work, and baseThreads is the number of threads
+  //! that every process uses if all processes are active.
+  CoreLending(const Epetra_Comm &comm, bool active, int baseThreads);
+
+  //! number of threads this process may use
+  int NumThreads() const {return numThreads_;}
+
+  //! number of processes on this compute node
+  int NumProcsOnNode() const {return numProcsOnNode_;}
+
+  //! number of active processes on this compute node
+  int NumActiveOnNode() const {return numActiveOnNode_;}
+
+  //! the maximum number of threads OpenMP or MKL currently uses
+  static int MaxThreads();
+
+protected:
+
+  //! number of threads this process may use
+  int numThreads_;
+
+  //! number of processes on this compute node
+  int numProcsOnNode_;
+
+  //! number of active processes on this compute node
+  int numActiveOnNode_;
+  };
+
+/*! Sets the number of threads of OpenMP and MKL and restores the previous
+  values when it goes out of scope. If numThreads is smaller than 1,
+  nothing is changed. Both settings only apply to the calling thread, so
+  a background thread does not change them for the other threads.
+*/
+class ThreadGuard
+  {
+public:
+
+  //! constructor
+  ThreadGuard(int numThreads);
+
+  //! destructor, restores the previous number of threads
+  ~ThreadGuard();
+
+protected:
+
+  //! number of threads that we set
+  int numThreads_;
+
+  //! previous number of OpenMP threads
+  int previousOMPThreads_;
+
+  //! previous number of MKL threads of this thread, 0 if it used the
+  //! global setting
+  int previousMKLThreads_;
+  };
+
+  }
+
+#endif
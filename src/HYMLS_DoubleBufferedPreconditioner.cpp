@@ -0,0 +1,332 @@
+#include "HYMLS_DoubleBufferedPreconditioner.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+#include "Epetra_RowMatrix.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Vector.h"
+
+#include "Teuchos_ParameterList.hpp"
+
+#include <mpi.h>
+#include <vector>
+
+namespace HYMLS
+  {
+
+struct DoubleBufferedPreconditioner::BufferData
+  {
+  hymls_gidx numGlobalRows;
+  hymls_gidx indexBase;
+  std::vector<hymls_gidx> rowGIDs;
+  std::vector<int> rowLengths;
+  std::vector<hymls_gidx> colGIDs;
+  std::vector<double> values;
+  std::vector<double> testValues;
+  Teuchos::RCP<Teuchos::ParameterList> params;
+  };
+
+DoubleBufferedPreconditioner::DoubleBufferedPreconditioner(
+  Teuchos::RCP<const Epetra_RowMatrix> K,
+  Teuchos::RCP<Teuchos::ParameterList> params,
+  Teuchos::RCP<const Epetra_Vector> testVector,
+  bool background)
+  :
+  label_("DoubleBufferedPreconditioner"),
+  comm_(Teuchos::rcp(K->Comm().Clone())),
+  rangeMap_(Teuchos::rcp(new Epetra_Map(K->OperatorRangeMap()))),
+  params_(params),
+  testVector_(testVector),
+  front_(0),
+  background_(background && BackgroundSupported()),
+  preparing_(false),
+  ready_(false),
+  backError_(0)
+  {
+  HYMLS_PROF3(label_, "Constructor");
+
+  if (!K->RowMatrixRowMap().SameAs(*rangeMap_))
+    Tools::Error("the row map of the matrix should be its range map",
+      __FILE__, __LINE__);
+
+  if (testVector_ != Teuchos::null && !testVector_->Map().SameAs(*rangeMap_))
+    Tools::Error("the test vector should have the range map of the matrix",
+      __FILE__, __LINE__);
+
+  // every buffer communicates on its own communicator, so the background
+  // thread never uses the same communicator as the solver
+  const Epetra_MpiComm *mpiComm = dynamic_cast<const Epetra_MpiComm *>(&K->Comm());
+  for (int b = 0; b < 2; b++)
+    {
+    if (mpiComm)
+      {
+      MPI_Comm comm;
+      CHECK_ZERO(MPI_Comm_dup(mpiComm->Comm(), &comm));
+      bufferComm_[b] = Teuchos::rcp(new Epetra_MpiComm(comm));
+      }
+    else
+      {
+      bufferComm_[b] = Teuchos::rcp(K->Comm().Clone());
+      }
+    }
+
+  bufferSource_[front_] = K;
+  }
+
+DoubleBufferedPreconditioner::~DoubleBufferedPreconditioner()
+  {
+  HYMLS_PROF3(label_, "Destructor");
+
+  if (thread_.joinable())
+    thread_.join();
+
+  for (int b = 0; b < 2; b++)
+    {
+    bufferPrec_[b] = Teuchos::null;
+    bufferMatrix_[b] = Teuchos::null;
+    bufferMap_[b] = Teuchos::null;
+    bufferSource_[b] = Teuchos::null;
+
+    Teuchos::RCP<Epetra_MpiComm> mpiComm =
+      Teuchos::rcp_dynamic_cast<Epetra_MpiComm>(bufferComm_[b]);
+    bufferComm_[b] = Teuchos::null;
+    if (mpiComm != Teuchos::null)
+      {
+      MPI_Comm comm = mpiComm->Comm();
+      mpiComm = Teuchos::null;
+
+      int finalized;
+      MPI_Finalized(&finalized);
+      if (!finalized)
+        MPI_Comm_free(&comm);
+      }
+    }
+  }
+
+bool DoubleBufferedPreconditioner::BackgroundSupported()
+  {
+#if defined(HYMLS_FUNCTION_TRACING) || defined(HYMLS_MEMORY_PROFILING)
+  return false;
+#else
+  int initialized;
+  MPI_Initialized(&initialized);
+  if (!initialized)
+    return false;
+
+  int provided;
+  MPI_Query_thread(&provided);
+  return provided == MPI_THREAD_MULTIPLE;
+#endif
+  }
+
+int DoubleBufferedPreconditioner::Compute()
+  {
+  HYMLS_PROF(label_, "Compute");
+  return ComputeBuffer(front_, CopyData(*bufferSource_[front_]));
+  }
+
+int DoubleBufferedPreconditioner::Prepare(Teuchos::RCP<const Epetra_RowMatrix> K)
+  {
+  HYMLS_PROF(label_, "Prepare");
+
+  if (!K->RowMatrixRowMap().SameAs(*rangeMap_))
+    Tools::Error("the maps of the matrix have changed", __FILE__, __LINE__);
+
+  // discard what was prepared before
+  if (preparing_)
+    Wait();
+  preparing_ = false;
+
+  int back = 1 - front_;
+  std::shared_ptr<BufferData> data = CopyData(*K);
+  bufferSource_[back] = K;
+  ready_ = false;
+  backError_ = 0;
+
+  if (background_)
+    {
+    preparing_ = true;
+    thread_ = std::thread([this, back, data]()
+      {
+      ThreadOutput output;
+      try
+        {
+        backError_ = ComputeBuffer(back, data);
+        }
+      catch (...)
+        {
+        backException_ = std::current_exception();
+        }
+      backOutput_ = output.Str();
+      ready_ = true;
+      });
+    return 0;
+    }
+
+  backError_ = ComputeBuffer(back, data);
+  preparing_ = true;
+  ready_ = true;
+  return backError_;
+  }
+
+int DoubleBufferedPreconditioner::Swap()
+  {
+  HYMLS_PROF(label_, "Swap");
+
+  if (!preparing_)
+    Tools::Error("Prepare() not yet called!", __FILE__, __LINE__);
+
+  int back = 1 - front_;
+  int ierr = Wait();
+  preparing_ = false;
+
+  // all processes have to agree on which preconditioner is used
+  int failed = ierr != 0;
+  int anyFailed;
+  CHECK_ZERO(comm_->MaxAll(&failed, &anyFailed, 1));
+
+  int old = anyFailed ? back : front_;
+  if (!anyFailed)
+    front_ = back;
+
+  bufferPrec_[old] = Teuchos::null;
+  bufferMatrix_[old] = Teuchos::null;
+  bufferMap_[old] = Teuchos::null;
+  if (anyFailed)
+    bufferSource_[old] = Teuchos::null;
+
+  return anyFailed ? (ierr ? ierr : -1) : 0;
+  }
+
+int DoubleBufferedPreconditioner::Wait()
+  {
+  HYMLS_PROF3(label_, "Wait");
+
+  if (thread_.joinable())
+    thread_.join();
+
+  if (!backOutput_.empty())
+    {
+    Tools::out() << backOutput_ << std::flush;
+    backOutput_.clear();
+    }
+
+  if (backException_)
+    {
+    std::exception_ptr e = backException_;
+    backException_ = nullptr;
+    preparing_ = false;
+    std::rethrow_exception(e);
+    }
+  return backError_;
+  }
+
+Teuchos::RCP<const Preconditioner> DoubleBufferedPreconditioner::Front() const
+  {
+  return bufferPrec_[front_];
+  }
+
+int DoubleBufferedPreconditioner::ApplyInverse(
+  const Epetra_MultiVector& X, Epetra_MultiVector& Y) const
+  {
+  HYMLS_PROF3(label_, "ApplyInverse");
+
+  Teuchos::RCP<const Preconditioner> prec = bufferPrec_[front_];
+  if (prec == Teuchos::null || !prec->IsComputed())
+    Tools::Error("Compute() not yet called!", __FILE__, __LINE__);
+
+  // the preconditioner has the same local layout, but lives on the
+  // communicator of its buffer
+  const Epetra_Map &map = *bufferMap_[front_];
+  Epetra_MultiVector Xb(View, map, X.Pointers(), X.NumVectors());
+  Epetra_MultiVector Yb(View, map, Y.Pointers(), Y.NumVectors());
+  return prec->ApplyInverse(Xb, Yb);
+  }
+
+std::shared_ptr<DoubleBufferedPreconditioner::BufferData>
+DoubleBufferedPreconditioner::CopyData(const Epetra_RowMatrix &K) const
+  {
+  HYMLS_PROF3(label_, "CopyData");
+
+  std::shared_ptr<BufferData> data = std::make_shared<BufferData>();
+
+  const Epetra_Map &rowMap = K.RowMatrixRowMap();
+  const Epetra_Map &colMap = K.RowMatrixColMap();
+  int numMyRows = K.NumMyRows();
+
+  data->numGlobalRows = rowMap.NumGlobalElements64();
+  data->indexBase = rowMap.IndexBase64();
+  data->rowGIDs.resize(numMyRows);
+  data->rowLengths.resize(numMyRows);
+  data->colGIDs.reserve(K.NumMyNonzeros());
+  data->values.reserve(K.NumMyNonzeros());
+
+  int len;
+  std::vector<int> indices(K.MaxNumEntries());
+  std::vector<double> values(K.MaxNumEntries());
+  for (int i = 0; i < numMyRows; i++)
+    {
+    CHECK_ZERO(K.ExtractMyRowCopy(i, indices.size(), len,
+        values.data(), indices.data()));
+    data->rowGIDs[i] = rowMap.GID64(i);
+    data->rowLengths[i] = len;
+    for (int j = 0; j < len; j++)
+      {
+      data->colGIDs.push_back(colMap.GID64(indices[j]));
+      data->values.push_back(values[j]);
+      }
+    }
+
+  if (testVector_ != Teuchos::null)
+    data->testValues.assign(testVector_->Values(),
+      testVector_->Values() + testVector_->MyLength());
+
+  data->params = Teuchos::rcp(new Teuchos::ParameterList(*params_));
+  return data;
+  }
+
+int DoubleBufferedPreconditioner::ComputeBuffer(int b, std::shared_ptr<BufferData> data)
+  {
+  HYMLS_PROF(label_, "ComputeBuffer");
+
+  bufferPrec_[b] = Teuchos::null;
+  bufferMatrix_[b] = Teuchos::null;
+
+  bufferMap_[b] = Teuchos::rcp(new Epetra_Map(data->numGlobalRows,
+      data->rowGIDs.size(), data->rowGIDs.data(), data->indexBase,
+      *bufferComm_[b]));
+
+  bufferMatrix_[b] = Teuchos::rcp(new Epetra_CrsMatrix(Copy, *bufferMap_[b],
+      data->rowLengths.data(), true));
+
+  int pos = 0;
+  for (size_t i = 0; i < data->rowGIDs.size(); i++)
+    {
+    if (data->rowLengths[i] == 0)
+      continue;
+    CHECK_ZERO(bufferMatrix_[b]->InsertGlobalValues(data->rowGIDs[i],
+        data->rowLengths[i], &data->values[pos], &data->colGIDs[pos]));
+    pos += data->rowLengths[i];
+    }
+  CHECK_ZERO(bufferMatrix_[b]->FillComplete());
+
+  Teuchos::RCP<Epetra_Vector> testVector = Teuchos::null;
+  if (!data->testValues.empty())
+    testVector = Teuchos::rcp(new Epetra_Vector(Copy, *bufferMap_[b],
+        data->testValues.data()));
+
+  bufferPrec_[b] = Teuchos::rcp(new Preconditioner(bufferMatrix_[b],
+      data->params, testVector));
+  CHECK_ZERO(bufferPrec_[b]->Initialize());
+  return bufferPrec_[b]->Compute();
+  }
+
+  }
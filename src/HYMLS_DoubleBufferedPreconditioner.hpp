@@ -0,0 +1,211 @@
+#ifndef HYMLS_DOUBLE_BUFFERED_PRECONDITIONER_H
+#define HYMLS_DOUBLE_BUFFERED_PRECONDITIONER_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+
+#include "Epetra_Operator.h"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+
+class Epetra_Comm;
+class Epetra_Map;
+class Epetra_RowMatrix;
+class Epetra_CrsMatrix;
+class Epetra_MultiVector;
+class Epetra_Vector;
+
+namespace Teuchos
+  {
+class ParameterList;
+  }
+
+namespace HYMLS {
+
+class Preconditioner;
+
+/*! Keeps two HYMLS::Preconditioner objects, so that the preconditioner
+  for the next matrix can be computed while the current one is used. In
+  a continuation, for instance, the Jacobian of the next step is known
+  before the linear solves of the current step are done:
+
+  \code
+  prec.Prepare(nextJacobian);  // returns immediately
+  ... solves that use prec ...
+  prec.Swap();                 // waits and switches to nextJacobian
+  \endcode
+
+  Every preconditioner gets a copy of its matrix on a duplicate of the
+  communicator of the matrix, so its communication can not be mixed up
+  with that of the solver. The matrix that is passed to Prepare() is
+  copied before Prepare() returns and may be changed afterwards.
+
+  The next preconditioner is computed by a background thread if that was
+  requested and if MPI was initialized with MPI_THREAD_MULTIPLE. Function
+  tracing and memory profiling are not thread safe, so they also disable
+  it. The output of the background thread is collected with a
+  ThreadOutput and written when the thread is waited for. Otherwise
+  Prepare() computes it right away, which takes as long as a normal
+  Compute(). The threads of both computations share the cores, so it
+  pays off when the solver waits for communication a lot or when there
+  are idle cores.
+
+  Both preconditioners, and the copies of their matrices, exist at the
+  same time between Prepare() and Swap(), which doubles the memory usage.
+*/
+class DoubleBufferedPreconditioner : public Epetra_Operator
+  {
+public:
+
+  //! Constructor. Collective. The row map of K must be the same as its
+  //! range map. The parameters are copied for every preconditioner that
+  //! is computed. Call Compute() before using the preconditioner.
+  DoubleBufferedPreconditioner(Teuchos::RCP<const Epetra_RowMatrix> K,
+    Teuchos::RCP<Teuchos::ParameterList> params,
+    Teuchos::RCP<const Epetra_Vector> testVector=Teuchos::null,
+    bool background=true);
+
+  //! Destructor. Waits for a computation that is still running.
+  virtual ~DoubleBufferedPreconditioner();
+
+  //! (Re)compute the current preconditioner from the matrix it was
+  //! created from, which is the one that was passed to the constructor
+  //! or to the last Prepare() that was swapped in. Collective.
+  int Compute();
+
+  //! Start computing the preconditioner for K, which must have the same
+  //! maps as the matrix that was passed to the constructor. A
+  //! preconditioner that was prepared before but not swapped in is
+  //! discarded. Collective.
+  int Prepare(Teuchos::RCP<const Epetra_RowMatrix> K);
+
+  //! Wait for the preconditioner of the last Prepare() call and use it
+  //! from now on. The previous one is deleted. Returns the error code
+  //! of its computation. Exceptions that were thrown in the background
+  //! are thrown here. Collective.
+  int Swap();
+
+  //! whether a preconditioner was prepared but not swapped in yet
+  bool IsPreparing() const {return preparing_;}
+
+  //! whether the prepared preconditioner is ready, so Swap() would not
+  //! have to wait
+  bool IsReady() const {return ready_;}
+
+  //! whether the background thread is used
+  bool Background() const {return background_;}
+
+  //! whether a background thread can be used at all
+  static bool BackgroundSupported();
+
+  //! the preconditioner that is currently used
+  Teuchos::RCP<const Preconditioner> Front() const;
+
+  //!\name Epetra_Operator interface
+  //@{
+
+  //! not implemented
+  int SetUseTranspose(bool UseTranspose) {return -1;}
+
+  //! not implemented
+  int Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {return -1;}
+
+  //! apply the current preconditioner
+  int ApplyInverse(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const;
+
+  //! not implemented
+  double NormInf() const {return -1.0;}
+
+  //! label
+  const char * Label() const {return label_.c_str();}
+
+  //! use transpose?
+  bool UseTranspose() const {return false;}
+
+  //! not implemented
+  bool HasNormInf() const {return false;}
+
+  //! communicator of the matrix that was passed to the constructor
+  const Epetra_Comm & Comm() const {return *comm_;}
+
+  //! domain map of the matrix that was passed to the constructor
+  const Epetra_Map & OperatorDomainMap() const {return *rangeMap_;}
+
+  //! range map of the matrix that was passed to the constructor
+  const Epetra_Map & OperatorRangeMap() const {return *rangeMap_;}
+
+  //@}
+
+protected:
+
+  //! everything a buffer is computed from: the local rows of the matrix
+  //! with global column indices, the test vector and the parameters
+  struct BufferData;
+
+  //! copy the local part of K, the test vector and the parameters
+  std::shared_ptr<BufferData> CopyData(const Epetra_RowMatrix &K) const;
+
+  //! create a preconditioner for the data in buffer b and compute it.
+  //! Only uses the communicator of the buffer.
+  int ComputeBuffer(int b, std::shared_ptr<BufferData> data);
+
+  //! wait for the background thread and rethrow its exception
+  int Wait();
+
+  //! label
+  std::string label_;
+
+  //! communicator of the original matrix
+  Teuchos::RCP<const Epetra_Comm> comm_;
+
+  //! range map of the original matrix
+  Teuchos::RCP<const Epetra_Map> rangeMap_;
+
+  //! parameters that are copied for every preconditioner
+  Teuchos::RCP<const Teuchos::ParameterList> params_;
+
+  //! test vector that is copied for every preconditioner
+  Teuchos::RCP<const Epetra_Vector> testVector_;
+
+  //! communicators, maps, matrices and preconditioners of both buffers
+  Teuchos::RCP<Epetra_Comm> bufferComm_[2];
+  Teuchos::RCP<Epetra_Map> bufferMap_[2];
+  Teuchos::RCP<Epetra_CrsMatrix> bufferMatrix_[2];
+  Teuchos::RCP<Preconditioner> bufferPrec_[2];
+
+  //! matrices from which the buffers were computed
+  Teuchos::RCP<const Epetra_RowMatrix> bufferSource_[2];
+
+  //! buffer that is currently used
+  int front_;
+
+  //! use a background thread for Prepare()
+  bool background_;
+
+  //! whether a preconditioner is being prepared
+  bool preparing_;
+
+  //! set by the background thread when it is done
+  std::atomic<bool> ready_;
+
+  //! error code of the last computation in the back buffer
+  int backError_;
+
+  //! exception that was thrown in the background thread
+  std::exception_ptr backException_;
+
+  //! output of the background thread
+  std::string backOutput_;
+
+  //! background thread
+  std::thread thread_;
+  };
+
+  }
+
+#endif
@@ -0,0 +1,282 @@
+#include "HYMLS_DumpWriter.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace HYMLS
+  {
+
+namespace
+  {
+struct DumpJob
+  {
+  std::string filename;
+  std::vector<char> data;
+  };
+
+// The queue of buffers and the thread that writes them. The thread is
+// started when the first buffer is queued and stopped when the program
+// exits, after the queue is empty.
+struct DumpQueue
+  {
+  DumpQueue(): maxBytes(256 << 20), queuedBytes(0), numWritten(0),
+               busy(false), stop(false) {}
+
+  ~DumpQueue()
+    {
+      {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+      }
+    changed.notify_all();
+    if (worker.joinable())
+      worker.join();
+    }
+
+  void Run()
+    {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+      {
+      changed.wait(lock, [this]{return stop || !jobs.empty();});
+      if (jobs.empty())
+        return;
+
+      DumpJob job;
+      job.filename.swap(jobs.front().filename);
+      job.data.swap(jobs.front().data);
+      jobs.pop_front();
+      busy = true;
+      lock.unlock();
+
+      std::ofstream ofs(job.filename.c_str(), std::ios::binary | std::ios::trunc);
+      ofs.write(job.data.data(), job.data.size());
+      ofs.close();
+
+      lock.lock();
+      if (!ofs)
+        failed.push_back(job.filename);
+      queuedBytes -= job.data.size();
+      numWritten++;
+      busy = false;
+      changed.notify_all();
+      }
+    }
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::thread worker;
+  std::deque<DumpJob> jobs;
+  std::vector<std::string> failed;
+  std::size_t maxBytes;
+  std::size_t queuedBytes;
+  long long numWritten;
+  bool busy;
+  bool stop;
+  };
+
+DumpQueue &Queue()
+  {
+  static DumpQueue queue;
+  return queue;
+  }
+
+// report files that the thread could not write. Must be called with
+// the lock held.
+void ReportFailures(DumpQueue &queue)
+  {
+  for (std::string const &filename: queue.failed)
+    Tools::Warning("could not write " + filename, __FILE__, __LINE__);
+  queue.failed.clear();
+  }
+
+void Enqueue(DumpJob &job)
+  {
+  DumpQueue &queue = Queue();
+  std::unique_lock<std::mutex> lock(queue.mutex);
+  ReportFailures(queue);
+
+  if (!queue.worker.joinable())
+    queue.worker = std::thread(&DumpQueue::Run, &queue);
+
+  // wait for space, but never for a buffer that is larger than the
+  // maximum by itself
+  queue.changed.wait(lock, [&queue, &job]{
+      return queue.jobs.empty() ||
+        queue.queuedBytes + job.data.size() <= queue.maxBytes;});
+
+  queue.queuedBytes += job.data.size();
+  queue.jobs.push_back(DumpJob());
+  queue.jobs.back().filename.swap(job.filename);
+  queue.jobs.back().data.swap(job.data);
+  lock.unlock();
+  queue.changed.notify_all();
+  }
+
+template<typename T>
+void Append(std::vector<char> &buf, const T *data, std::size_t n)
+  {
+  if (n == 0)
+    return;
+  std::size_t pos = buf.size();
+  buf.resize(pos + n * sizeof(T));
+  std::memcpy(&buf[pos], data, n * sizeof(T));
+  }
+
+void AppendHeader(std::vector<char> &buf, DumpWriter::DumpType type,
+  const Epetra_BlockMap &map, long long numGlobalCols,
+  long long numMyCols)
+  {
+  Append(buf, "HYMLSDMP", 8);
+  std::int64_t header[10] = {1, type, (std::int64_t)sizeof(hymls_gidx),
+                             map.Comm().MyPID(), map.Comm().NumProc(),
+                             map.IndexBase64(), map.NumGlobalElements64(),
+                             numGlobalCols, map.NumMyElements(), numMyCols};
+  Append(buf, header, 10);
+  }
+
+void AppendGIDs(std::vector<char> &buf, const Epetra_BlockMap &map)
+  {
+  std::vector<hymls_gidx> gids(map.NumMyElements());
+  for (int i = 0; i < map.NumMyElements(); i++)
+    gids[i] = map.GID64(i);
+  Append(buf, gids.data(), gids.size());
+  }
+
+  }
+
+void DumpWriter::Write(const Epetra_CrsMatrix &A, const std::string &filename)
+  {
+  HYMLS_LPROF3("DumpWriter", "Write (1)");
+
+  if (!A.Filled())
+    Tools::Error("the matrix has to be filled", __FILE__, __LINE__);
+
+  DumpJob job;
+  job.filename = FileName(filename, A.Comm().MyPID());
+
+  const Epetra_BlockMap &rowMap = A.RowMap();
+  const Epetra_BlockMap &colMap = A.ColMap();
+  int numMyRows = A.NumMyRows();
+  int nnz = A.NumMyNonzeros();
+
+  job.data.reserve(8 + 10 * sizeof(std::int64_t)
+    + (numMyRows + colMap.NumMyElements()) * sizeof(hymls_gidx)
+    + (numMyRows + 1 + nnz) * sizeof(int) + nnz * sizeof(double));
+
+  AppendHeader(job.data, Matrix, rowMap, A.NumGlobalCols64(),
+    colMap.NumMyElements());
+  AppendGIDs(job.data, rowMap);
+  AppendGIDs(job.data, colMap);
+
+  if (A.StorageOptimized())
+    {
+    int *rowPtr, *colInd;
+    double *values;
+    CHECK_ZERO(A.ExtractCrsDataPointers(rowPtr, colInd, values));
+    Append(job.data, rowPtr, numMyRows + 1);
+    Append(job.data, colInd, nnz);
+    Append(job.data, values, nnz);
+    }
+  else
+    {
+    std::vector<int> rowPtr(numMyRows + 1, 0);
+    std::vector<int> colInd;
+    std::vector<double> values;
+    colInd.reserve(nnz);
+    values.reserve(nnz);
+    for (int i = 0; i < numMyRows; i++)
+      {
+      int len;
+      int *inds;
+      double *vals;
+      CHECK_ZERO(A.ExtractMyRowView(i, len, vals, inds));
+      colInd.insert(colInd.end(), inds, inds + len);
+      values.insert(values.end(), vals, vals + len);
+      rowPtr[i + 1] = rowPtr[i] + len;
+      }
+    Append(job.data, rowPtr.data(), rowPtr.size());
+    Append(job.data, colInd.data(), colInd.size());
+    Append(job.data, values.data(), values.size());
+    }
+
+  Enqueue(job);
+  }
+
+void DumpWriter::Write(const Epetra_MultiVector &x, const std::string &filename)
+  {
+  HYMLS_LPROF3("DumpWriter", "Write (2)");
+
+  DumpJob job;
+  job.filename = FileName(filename, x.Comm().MyPID());
+
+  int numVectors = x.NumVectors();
+  job.data.reserve(8 + 10 * sizeof(std::int64_t)
+    + x.MyLength() * (sizeof(hymls_gidx) + numVectors * sizeof(double)));
+
+  AppendHeader(job.data, MultiVector, x.Map(), numVectors, numVectors);
+  AppendGIDs(job.data, x.Map());
+  for (int k = 0; k < numVectors; k++)
+    Append(job.data, x[k], x.MyLength());
+
+  Enqueue(job);
+  }
+
+void DumpWriter::Flush()
+  {
+  HYMLS_LPROF3("DumpWriter", "Flush");
+  DumpQueue &queue = Queue();
+  std::unique_lock<std::mutex> lock(queue.mutex);
+  queue.changed.wait(lock, [&queue]{
+      return queue.jobs.empty() && !queue.busy;});
+  ReportFailures(queue);
+  }
+
+void DumpWriter::SetMaxBufferSize(std::size_t bytes)
+  {
+  DumpQueue &queue = Queue();
+  std::unique_lock<std::mutex> lock(queue.mutex);
+  queue.maxBytes = bytes;
+  lock.unlock();
+  queue.changed.notify_all();
+  }
+
+std::size_t DumpWriter::MaxBufferSize()
+  {
+  DumpQueue &queue = Queue();
+  std::unique_lock<std::mutex> lock(queue.mutex);
+  return queue.maxBytes;
+  }
+
+std::string DumpWriter::FileName(const std::string &filename, int pid)
+  {
+  std::ostringstream ss;
+  ss << filename << "." << pid << ".hbd";
+  return ss.str();
+  }
+
+long long DumpWriter::NumWritten()
+  {
+  DumpQueue &queue = Queue();
+  std::unique_lock<std::mutex> lock(queue.mutex);
+  return queue.numWritten;
+  }
+
+  }
@@ -0,0 +1,73 @@
+#ifndef HYMLS_DUMP_WRITER_H
+#define HYMLS_DUMP_WRITER_H
+
+#include "HYMLS_config.h"
+
+#include <cstddef>
+#include <string>
+
+class Epetra_BlockMap;
+class Epetra_CrsMatrix;
+class Epetra_MultiVector;
+
+namespace HYMLS {
+
+/*! Writes matrices and vectors for debugging without stopping the
+  computation. The local part of the object is copied into a buffer,
+  which a background thread writes to its own file on every process,
+  FileName(filename, pid). Writing a dump therefore costs little more
+  than copying the data. The buffers together take at most
+  MaxBufferSize() bytes, if they are full, Write() waits until the
+  thread has written enough of them.
+
+  A file consists of
+  - a header: the 8 characters "HYMLSDMP" followed by 10 64-bit
+    integers: the version (1), the type (Matrix or MultiVector), the
+    size of a GID in bytes, the process, the number of processes, the
+    index base, the global number of rows, the global number of columns,
+    the local number of rows and the local number of columns (both the
+    number of vectors for a MultiVector),
+  - the GIDs of the local rows,
+  - for a matrix: the GIDs of the column map, the row pointer and the
+    local column indices (32-bit integers, numMyRows+1 and nonzeros)
+    and the values,
+  - for a MultiVector: the values of every vector after each other.
+
+  All data is stored in the byte order of the machine that wrote it.
+  hymls_dump2mtx collects the files of all processes into a single
+  MatrixMarket file. MatrixUtils::Dump uses this class if the print
+  method is BINARY, which is the default if HYMLS is configured with
+  HYMLS_BINARY_DUMPS.
+*/
+class DumpWriter
+  {
+public:
+
+  //! types of data that can be written
+  enum DumpType {Matrix = 1, MultiVector = 2};
+
+  //! queue the local part of A to be written in the background
+  static void Write(const Epetra_CrsMatrix &A, const std::string &filename);
+
+  //! queue the local part of x to be written in the background
+  static void Write(const Epetra_MultiVector &x, const std::string &filename);
+
+  //! wait until everything that was queued has been written
+  static void Flush();
+
+  //! set the maximum number of bytes that may wait to be written
+  static void SetMaxBufferSize(std::size_t bytes);
+
+  //! maximum number of bytes that may wait to be written
+  static std::size_t MaxBufferSize();
+
+  //! name of the file of process pid
+  static std::string FileName(const std::string &filename, int pid);
+
+  //! number of dumps that have been written
+  static long long NumWritten();
+  };
+
+  }
+
+#endif
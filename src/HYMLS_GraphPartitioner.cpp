@@ -0,0 +1,467 @@
+#include "HYMLS_GraphPartitioner.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+#include "HYMLS_CacheUtils.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsGraph.h"
+#include "Epetra_IntVector.h"
+#include "Epetra_Import.h"
+
+#include "Teuchos_Array.hpp"
+#include "Teuchos_ParameterList.hpp"
+#include "Teuchos_toString.hpp"
+
+#include <map>
+#include <tuple>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace HYMLS {
+
+namespace {
+
+//! Compute a key for the sorted set of subdomains a separator node is
+//! adjacent to. The key is a 64 bit FNV-1a hash that is split in two
+//! integers so it can be communicated with an Epetra_IntVector.
+//! (0, 0) is reserved for interior nodes.
+void SignatureKey(Teuchos::Array<int> const &signature, int &hi, int &lo)
+  {
+  std::uint64_t hash = CacheUtils::HashSeed;
+  for (int sd: signature)
+    CacheUtils::HashBytes(hash, &sd, sizeof(sd));
+  hi = (int)(std::uint32_t)(hash >> 32);
+  lo = (int)(std::uint32_t)(hash & 0xffffffffULL);
+  if (hi == 0 && lo == 0)
+    lo = 1;
+  }
+
+  }
+
+// constructor
+GraphPartitioner::GraphPartitioner(
+  Teuchos::RCP<const Epetra_Map> map,
+  Teuchos::RCP<const Epetra_CrsGraph> graph,
+  Teuchos::RCP<Teuchos::ParameterList> const &params,
+  Epetra_Comm const &comm, int level)
+  : BasePartitioner(comm, level), label_("GraphPartitioner"),
+    baseMap_(map), graph_(graph),
+    numSubdomainsParam_(-1), numGlobalSubdomains_(0)
+  {
+  HYMLS_PROF3(label_, "Constructor");
+
+  SetParameters(*params);
+  }
+
+// destructor
+GraphPartitioner::~GraphPartitioner()
+  {
+  HYMLS_PROF3(label_, "Destructor");
+  }
+
+void GraphPartitioner::SetParameters(Teuchos::ParameterList& params)
+  {
+  BasePartitioner::SetParameters(params);
+
+  Teuchos::ParameterList& precList = params.sublist("Preconditioner");
+  numSubdomainsParam_ = precList.get("Number of Subdomains", -1);
+  }
+
+void GraphPartitioner::SetNextLevelParameters(Teuchos::ParameterList& params) const
+  {
+  BasePartitioner::SetNextLevelParameters(params);
+
+  int factor = 1;
+  for (int i = 0; i < dim_; i++)
+    factor *= cx_;
+
+  Teuchos::ParameterList& precList = params.sublist("Preconditioner");
+  precList.set("Number of Subdomains", std::max(numGlobalSubdomains_ / factor, 1));
+  }
+
+// get non-overlapping subdomain id
+int GraphPartitioner::operator()(hymls_gidx gid) const
+  {
+#ifdef HYMLS_TESTING
+  if (!Partitioned())
+    {
+    Tools::Error("Partition() not yet called!", __FILE__, __LINE__);
+    }
+#endif
+  int lid = baseMap_->LID(gid);
+  if (lid < 0)
+    return -1;
+  return sdOfLID_[lid];
+  }
+
+int GraphPartitioner::GetSubdomainPosition(
+  int sd, int sx, int sy, int sz, int &x, int &y, int &z) const
+  {
+  x = -1;
+  y = -1;
+  z = -1;
+  return 1;
+  }
+
+int GraphPartitioner::GetSubdomainID(
+  int sx, int sy, int sz, int x, int y, int z) const
+  {
+  return -1;
+  }
+
+int GraphPartitioner::PID(hymls_gidx gid) const
+  {
+  return baseMap_->MyGID(gid) ? comm_->MyPID() : -1;
+  }
+
+bool GraphPartitioner::IsInteriorVariable(hymls_gidx gid) const
+  {
+  int var = (int)(gid % dof_);
+  return variableType_[var] == VariableType::Pressure ||
+    variableType_[var] == VariableType::Interior;
+  }
+
+int GraphPartitioner::Bisect(Teuchos::Array<int> &vertices,
+  int numParts, int firstPart,
+  Teuchos::Array<Teuchos::Array<int> > const &adjacency,
+  Teuchos::Array<int> &marker, int &stamp, Teuchos::Array<int> &part) const
+  {
+  if (numParts == 1)
+    {
+    for (int v: vertices)
+      part[v] = firstPart;
+    return 0;
+    }
+
+  // Order the vertices by a breadth first search. The second pass starts
+  // from the last vertex of the first pass, which is far away from the
+  // start, so the cut that splits the ordering is roughly perpendicular to
+  // the longest direction of the graph. Components that are not reached
+  // from the start vertex are appended.
+  Teuchos::Array<int> order;
+  int start = vertices[0];
+  for (int pass = 0; pass < 2; pass++)
+    {
+    int member = ++stamp;
+    int visited = ++stamp;
+    for (int v: vertices)
+      marker[v] = member;
+
+    order.clear();
+    order.append(start);
+    marker[start] = visited;
+
+    int head = 0;
+    int next = 0;
+    while (order.size() < vertices.size())
+      {
+      if (head == order.size())
+        {
+        while (marker[vertices[next]] != member)
+          next++;
+        order.append(vertices[next]);
+        marker[vertices[next]] = visited;
+        }
+
+      int v = order[head++];
+      for (int w: adjacency[v])
+        if (marker[w] == member)
+          {
+          order.append(w);
+          marker[w] = visited;
+          }
+      }
+    start = order.back();
+    }
+
+  int numParts1 = numParts / 2;
+  int n1 = (int)((long long)vertices.size() * numParts1 / numParts);
+
+  Teuchos::Array<int> vertices1(order.begin(), order.begin() + n1);
+  Teuchos::Array<int> vertices2(order.begin() + n1, order.end());
+  order.clear();
+  vertices.clear();
+
+  CHECK_ZERO(Bisect(vertices1, numParts1, firstPart,
+      adjacency, marker, stamp, part));
+  CHECK_ZERO(Bisect(vertices2, numParts - numParts1, firstPart + numParts1,
+      adjacency, marker, stamp, part));
+
+  return 0;
+  }
+
+int GraphPartitioner::Partition(bool repart)
+  {
+  HYMLS_PROF3(label_, "Partition");
+
+  if (baseMap_ == Teuchos::null)
+    Tools::Error("The graph partitioner needs the map of the matrix",
+      __FILE__, __LINE__);
+  if (graph_ == Teuchos::null)
+    Tools::Error("The graph partitioner needs the graph of the matrix",
+      __FILE__, __LINE__);
+  if (!graph_->Filled())
+    Tools::Error("The graph should be filled", __FILE__, __LINE__);
+
+  // nodes are never moved
+  nprocs_ = comm_->NumProc();
+  destinationPID_ = -1;
+
+  int numMyElements = baseMap_->NumMyElements();
+
+  // Group the GIDs into nodes of dof_ consecutive GIDs
+  std::map<hymls_gidx, int> nodeIndex;
+  Teuchos::Array<int> nodeOfLID(numMyElements);
+  for (int lid = 0; lid < numMyElements; lid++)
+    {
+    hymls_gidx node = baseMap_->GID64(lid) / dof_;
+    auto it = nodeIndex.find(node);
+    if (it == nodeIndex.end())
+      it = nodeIndex.emplace(node, (int)nodeIndex.size()).first;
+    nodeOfLID[lid] = it->second;
+    }
+  int numMyNodes = nodeIndex.size();
+
+  // Adjacency of the local nodes. Couplings to other processes are ignored
+  // here since we only partition the local nodes.
+  Teuchos::Array<Teuchos::Array<int> > adjacency(numMyNodes);
+  for (int lid = 0; lid < numMyElements; lid++)
+    {
+    int row = graph_->RowMap().LID(baseMap_->GID64(lid));
+    if (row < 0)
+      Tools::Error("Row " + Teuchos::toString(baseMap_->GID64(lid)) +
+        " is not in the graph", __FILE__, __LINE__);
+
+    int len;
+    int *indices;
+    CHECK_ZERO(graph_->ExtractMyRowView(row, len, indices));
+
+    int node = nodeOfLID[lid];
+    for (int j = 0; j < len; j++)
+      {
+      int colLID = baseMap_->LID(graph_->ColMap().GID64(indices[j]));
+      if (colLID < 0 || nodeOfLID[colLID] == node)
+        continue;
+      adjacency[node].append(nodeOfLID[colLID]);
+      }
+    }
+
+  for (auto &adj: adjacency)
+    {
+    std::sort(adj.begin(), adj.end());
+    adj.erase(std::unique(adj.begin(), adj.end()), adj.end());
+    }
+
+  // Determine the number of subdomains on this process
+  int numGlobalNodes = 0;
+  CHECK_ZERO(comm_->SumAll(&numMyNodes, &numGlobalNodes, 1));
+
+  int numParts = numSubdomainsParam_;
+  if (numParts < 1)
+    numParts = (int)std::round(numGlobalNodes / std::pow((double)sx_, dim_));
+  numParts = std::max(numParts, 1);
+
+  int numMyParts = 0;
+  if (numMyNodes > 0)
+    {
+    numMyParts = (int)std::round((double)numParts * numMyNodes / numGlobalNodes);
+    numMyParts = std::min(std::max(numMyParts, 1), numMyNodes);
+    }
+
+  Teuchos::Array<int> part(numMyNodes, -1);
+  if (numMyParts > 0)
+    {
+    Teuchos::Array<int> vertices(numMyNodes);
+    for (int i = 0; i < numMyNodes; i++)
+      vertices[i] = i;
+
+    Teuchos::Array<int> marker(numMyNodes, 0);
+    int stamp = 0;
+    CHECK_ZERO(Bisect(vertices, numMyParts, 0, adjacency, marker, stamp, part));
+    }
+
+  // Number the subdomains contiguously over the processes
+  int offset = 0;
+  CHECK_ZERO(comm_->ScanSum(&numMyParts, &offset, 1));
+  offset -= numMyParts;
+  CHECK_ZERO(comm_->SumAll(&numMyParts, &numGlobalSubdomains_, 1));
+
+  Teuchos::Array<int> sdGIDs(numMyParts);
+  for (int i = 0; i < numMyParts; i++)
+    sdGIDs[i] = offset + i;
+
+  sdMap_ = Teuchos::rcp(new Epetra_Map(-1, numMyParts,
+      sdGIDs.getRawPtr(), 0, *comm_));
+
+  sdOfLID_.resize(numMyElements);
+  sdLIDs_.clear();
+  sdLIDs_.resize(numMyParts);
+  for (int lid = 0; lid < numMyElements; lid++)
+    {
+    int p = part[nodeOfLID[lid]];
+    sdOfLID_[lid] = offset + p;
+    sdLIDs_[p].append(lid);
+    }
+
+  Tools::Out("Number of Subdomains: " + Teuchos::toString(numGlobalSubdomains_));
+
+  // Subdomain of all columns of the graph
+  Epetra_Import importer(graph_->ColMap(), *baseMap_);
+
+  Epetra_IntVector mySd(*baseMap_);
+  for (int lid = 0; lid < numMyElements; lid++)
+    mySd[lid] = sdOfLID_[lid];
+
+  Epetra_IntVector colSd(graph_->ColMap());
+  CHECK_ZERO(colSd.Import(mySd, importer, Insert));
+
+  // Of every coupling between two subdomains one of the two GIDs becomes
+  // a separator node. The GID that is on the other process makes the same
+  // decision, so no communication is needed for this.
+  myKeyHi_ = Teuchos::rcp(new Epetra_IntVector(*baseMap_));
+  myKeyLo_ = Teuchos::rcp(new Epetra_IntVector(*baseMap_));
+  for (int lid = 0; lid < numMyElements; lid++)
+    {
+    hymls_gidx gid = baseMap_->GID64(lid);
+    int row = graph_->RowMap().LID(gid);
+
+    int len;
+    int *indices;
+    CHECK_ZERO(graph_->ExtractMyRowView(row, len, indices));
+
+    int sd = sdOfLID_[lid];
+    bool interior = IsInteriorVariable(gid);
+    bool separator = false;
+
+    Teuchos::Array<int> signature(1, sd);
+    for (int j = 0; j < len; j++)
+      {
+      int otherSd = colSd[indices[j]];
+      if (otherSd == sd)
+        continue;
+
+      signature.append(otherSd);
+
+      bool otherInterior = IsInteriorVariable(graph_->ColMap().GID64(indices[j]));
+      if (interior != otherInterior)
+        separator = separator || otherInterior;
+      else
+        separator = separator || sd < otherSd;
+      }
+
+    if (!separator)
+      continue;
+
+    std::sort(signature.begin(), signature.end());
+    signature.erase(std::unique(signature.begin(), signature.end()), signature.end());
+    SignatureKey(signature, (*myKeyHi_)[lid], (*myKeyLo_)[lid]);
+    }
+
+  colKeyHi_ = Teuchos::rcp(new Epetra_IntVector(graph_->ColMap()));
+  colKeyLo_ = Teuchos::rcp(new Epetra_IntVector(graph_->ColMap()));
+  CHECK_ZERO(colKeyHi_->Import(*myKeyHi_, importer, Insert));
+  CHECK_ZERO(colKeyLo_->Import(*myKeyLo_, importer, Insert));
+
+  return 0;
+  }
+
+int GraphPartitioner::GetGroups(int sd, InteriorGroup &interior_group,
+  Teuchos::Array<SeparatorGroup> &separator_groups) const
+  {
+  HYMLS_PROF3(label_, "GetGroups");
+
+  interior_group.nodes().clear();
+  separator_groups.clear();
+
+  // pressure nodes that need to be retained
+  Teuchos::Array<hymls_gidx> retained_nodes;
+
+  // separator nodes by key and variable
+  std::map<std::tuple<int, int, int>, Teuchos::Array<hymls_gidx> > groups;
+
+  int gsd = sdMap_->GID(sd);
+
+  auto addSeparatorNode = [&](hymls_gidx gid, int hi, int lo)
+    {
+    int var = (int)(gid % dof_);
+    if (link_velocities_ && !IsInteriorVariable(gid))
+      var = -1;
+    groups[std::make_tuple(hi, lo, var)].append(gid);
+    };
+
+  for (int lid: sdLIDs_[sd])
+    {
+    hymls_gidx gid = baseMap_->GID64(lid);
+
+    int hi = (*myKeyHi_)[lid];
+    int lo = (*myKeyLo_)[lid];
+    if (hi != 0 || lo != 0)
+      addSeparatorNode(gid, hi, lo);
+    else if (variableType_[gid % dof_] == VariableType::Pressure &&
+      retained_nodes.length() < retainPressures_)
+      retained_nodes.append(gid);
+    else
+      interior_group.append(gid);
+
+    // separator nodes of the neighbouring subdomains
+    int row = graph_->RowMap().LID(gid);
+    int len;
+    int *indices;
+    CHECK_ZERO(graph_->ExtractMyRowView(row, len, indices));
+    for (int j = 0; j < len; j++)
+      {
+      hi = (*colKeyHi_)[indices[j]];
+      lo = (*colKeyLo_)[indices[j]];
+      if (hi == 0 && lo == 0)
+        continue;
+
+      hymls_gidx colGID = graph_->ColMap().GID64(indices[j]);
+      int colLID = baseMap_->LID(colGID);
+      if (colLID >= 0 && sdOfLID_[colLID] == gsd)
+        continue;
+
+      addSeparatorNode(colGID, hi, lo);
+      }
+    }
+
+  for (auto &group: groups)
+    {
+    Teuchos::Array<hymls_gidx> &nodes = group.second;
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+    SeparatorGroup separator_group;
+    separator_group.nodes() = nodes;
+    separator_groups.append(separator_group);
+    }
+
+  for (hymls_gidx gid: retained_nodes)
+    {
+    SeparatorGroup group;
+    group.append(gid);
+    separator_groups.append(group);
+    }
+
+  return 0;
+  }
+
+int GraphPartitioner::NumLocalParts() const
+  {
+  if (!Partitioned())
+    Tools::Error("Partition() not yet called!", __FILE__, __LINE__);
+  return sdMap_->NumMyElements();
+  }
+
+int GraphPartitioner::NumGlobalParts(int sx, int sy, int sz) const
+  {
+  return numGlobalSubdomains_;
+  }
+
+  }
@@ -0,0 +1,156 @@
+#ifndef HYMLS_GRAPH_PARTITONER_H
+#define HYMLS_GRAPH_PARTITONER_H
+
+#include "HYMLS_BasePartitioner.hpp"
+
+#include "HYMLS_config.h"
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+class Epetra_Comm;
+class Epetra_Map;
+class Epetra_CrsGraph;
+class Epetra_IntVector;
+
+namespace Teuchos {
+class ParameterList;
+  }
+
+namespace HYMLS {
+
+class InteriorGroup;
+class SeparatorGroup;
+
+/*! Partitioner that builds the subdomains from the graph of the matrix
+  instead of from a structured grid, so it can be used for matrices from
+  unstructured meshes or grids with holes or masks.
+
+  The owned nodes of every process (a node consists of "Degrees of Freedom"
+  consecutive GIDs) are split into subdomains of roughly equal size by
+  recursive graph bisection. Nodes are never moved between processes.
+
+  A vertex separator is then formed from the edges between subdomains:
+  of every coupled pair of GIDs in different subdomains one becomes a
+  separator node. Velocity type variables are preferred over pressure type
+  variables here, so pressures end up in the interior like with the
+  Cartesian partitioner. Separator nodes are grouped by the set of subdomains
+  they are adjacent to and by their variable, which is the analogue of the
+  faces, edges and corners of the Cartesian partitioner. The structure of
+  the graph is assumed to be symmetric.
+
+  The target number of nodes per subdomain is "Separator Length" to the power
+  "Dimension", unless "Number of Subdomains" is set. On the next level the
+  number of subdomains is reduced by "Coarsening Factor" to the power
+  "Dimension".
+*/
+class GraphPartitioner : public BasePartitioner
+  {
+public:
+
+  //! constructor
+  GraphPartitioner(Teuchos::RCP<const Epetra_Map> map,
+    Teuchos::RCP<const Epetra_CrsGraph> graph,
+    Teuchos::RCP<Teuchos::ParameterList> const &params,
+    Epetra_Comm const &comm, int level=-1);
+
+  //! destructor
+  virtual ~GraphPartitioner();
+
+  //! set parameters for the partitioner like separator length
+  void SetParameters(Teuchos::ParameterList& params);
+
+  //! get a parameterlist with fewer subdomains for the next level
+  void SetNextLevelParameters(Teuchos::ParameterList& params) const;
+
+  //! get non-overlapping subdomain id
+  int operator()(hymls_gidx gid) const;
+
+  //! partition the owned nodes into subdomains. Nodes are never
+  //! moved to another process, so repart is ignored.
+  int Partition(bool repart=false);
+
+  //! Get interior and separator groups of the subdomain sd
+  int GetGroups(int sd, InteriorGroup &interior_group,
+    Teuchos::Array<SeparatorGroup> &separator_groups) const;
+
+  //! is this class fully set up?
+  inline bool Partitioned() const
+    {
+    return sdMap_ != Teuchos::null;
+    }
+
+  //! return the map (this partitioner does not move nodes)
+  inline Teuchos::RCP<const Epetra_Map> GetMap() const
+    {
+    return baseMap_;
+    }
+
+  //! return the map with global IDs of the subdomains
+  inline const Epetra_Map& SubdomainMap() const
+    {
+    return *sdMap_;
+    }
+
+  //! return the number of subdomains in this proc partition
+  int NumLocalParts() const;
+
+  //! return the global number of subdomains (the arguments are ignored)
+  int NumGlobalParts(int sx, int sy, int sz) const;
+
+protected:
+
+  //! the grid size is not needed
+  bool NeedsGrid() const {return false;}
+
+  //! not available for a graph partitioner, returns 1
+  int GetSubdomainPosition(int sd, int sx, int sy, int sz, int &x, int &y, int &z) const;
+
+  //! not available for a graph partitioner, returns -1
+  int GetSubdomainID(int sx, int sy, int sz, int x, int y, int z) const;
+
+  //! get processor on which a grid point is located
+  int PID(hymls_gidx gid) const;
+
+  //! Recursively bisect the local nodes in vertices into numParts parts,
+  //! numbered from firstPart. marker and stamp are work space.
+  int Bisect(Teuchos::Array<int> &vertices, int numParts, int firstPart,
+    Teuchos::Array<Teuchos::Array<int> > const &adjacency,
+    Teuchos::Array<int> &marker, int &stamp, Teuchos::Array<int> &part) const;
+
+  //! true if the variable of the gid should preferably not be on a separator
+  bool IsInteriorVariable(hymls_gidx gid) const;
+
+  //! label
+  std::string label_;
+
+  //! original non-overlapping map
+  Teuchos::RCP<const Epetra_Map> baseMap_;
+
+  //! graph of the matrix
+  Teuchos::RCP<const Epetra_CrsGraph> graph_;
+
+  //! number of subdomains set by the user or the previous level
+  int numSubdomainsParam_;
+
+  //! global number of subdomains
+  int numGlobalSubdomains_;
+
+  //! maps global to local subdomain ID
+  Teuchos::RCP<Epetra_Map> sdMap_;
+
+  //! local IDs (in baseMap_) of the GIDs in every local subdomain
+  Teuchos::Array<Teuchos::Array<int> > sdLIDs_;
+
+  //! global subdomain ID of every GID in baseMap_
+  Teuchos::Array<int> sdOfLID_;
+
+  //! separator group keys of the GIDs in baseMap_, (0, 0) for interior
+  //! nodes
+  Teuchos::RCP<Epetra_IntVector> myKeyHi_, myKeyLo_;
+
+  //! separator group keys of the columns of graph_
+  Teuchos::RCP<Epetra_IntVector> colKeyHi_, colKeyLo_;
+  };
+
+  }
+#endif
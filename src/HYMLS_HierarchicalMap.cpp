@@ -17,6 +17,8 @@
 
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace HYMLS {
 
@@ -121,26 +123,62 @@ int HierarchicalMap::LinkSeparators(
   Teuchos::RCP<Teuchos::Array<Teuchos::Array<SeparatorGroup> > > separator_groups,
   Teuchos::RCP<Teuchos::Array<Teuchos::Array<Teuchos::Array<SeparatorGroup> > > > linked_separator_groups) const
   {
+  // position of the linked groups of every type in the current subdomain
+  std::unordered_map<int, int> type_index;
   for (int sd = 0; sd < NumMySubdomains(); sd++)
+    {
+    Teuchos::Array<Teuchos::Array<SeparatorGroup> > &linked_groups =
+      (*linked_separator_groups)[sd];
+    type_index.clear();
     for (SeparatorGroup const &group: (*separator_groups)[sd])
       {
-      bool found = false;
       if (group.type() >= 0)
         {
-        for (auto &linked_groups: (*linked_separator_groups)[sd])
-          if (group.type() == linked_groups[0].type())
-            {
-            linked_groups.append(group);
-            found = true;
-            break;
-            }
+        auto it = type_index.find(group.type());
+        if (it != type_index.end())
+          {
+          linked_groups[it->second].append(group);
+          continue;
+          }
+        type_index[group.type()] = linked_groups.size();
         }
-      if (!found)
-        (*linked_separator_groups)[sd].append(Teuchos::Array<SeparatorGroup>(1, group));
+      linked_groups.append(Teuchos::Array<SeparatorGroup>(1, group));
       }
+    }
   return 0;
   }
 
+int HierarchicalMap::FilterNodes(Teuchos::Array<hymls_gidx> &nodes,
+  Epetra_BlockMap const &map, Epetra_IntVector const *present)
+  {
+  // This is called from multiple threads, so we work on the raw data
+  // to avoid (debug mode) reference counting in Teuchos, and leave the
+  // resizing to the caller
+  hymls_gidx *first = nodes.getRawPtr();
+  hymls_gidx *last = std::remove_if(first, first + nodes.size(),
+    [&map, present](hymls_gidx gid) {
+      int lid = map.LID(gid);
+      return lid < 0 || (present && !(*present)[lid]);
+    });
+  return last - first;
+  }
+
+void HierarchicalMap::ResizeFilteredNodes(
+  Teuchos::Array<Teuchos::Array<int> > const &sizes)
+  {
+  for (int sd = 0; sd < sizes.size(); sd++)
+    {
+    // the first entry is the interior group, a negative size means that
+    // the group was not filtered
+    if (sizes[sd][0] >= 0)
+      (*interior_groups_)[sd].nodes().resize(sizes[sd][0]);
+    Teuchos::Array<SeparatorGroup> &groups = (*separator_groups_)[sd];
+    for (int i = 0; i < groups.size(); i++)
+      if (sizes[sd][i + 1] >= 0)
+        groups[i].nodes().resize(sizes[sd][i + 1]);
+    }
+  }
+
 int HierarchicalMap::FillComplete()
   {
   HYMLS_LPROF2(label_,"FillComplete");
@@ -160,36 +198,42 @@ int HierarchicalMap::FillComplete()
   if (baseOverlappingMap_ != Teuchos::null)
     map = baseOverlappingMap_;
 
+  // Interior nodes don't need communication. Just keep those that are
+  // present in the baseMap_. The same holds for the separator groups if
+  // the baseOverlappingMap_ is present. The subdomains are independent,
+  // so this can be done in parallel.
+  bool filterSeparators = baseOverlappingMap_ != Teuchos::null;
+  int numMySubdomains = NumMySubdomains();
+
+  // New sizes of the interior group and the separator groups of every
+  // subdomain. This is allocated here so that no memory is allocated
+  // inside the parallel loops.
+  Teuchos::Array<Teuchos::Array<int> > sizes(numMySubdomains);
+  for (int sd = 0; sd < numMySubdomains; sd++)
+    sizes[sd].resize((*separator_groups_)[sd].size() + 1, -1);
+
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int sd = 0; sd < numMySubdomains; sd++)
+    {
+    int *mySizes = sizes[sd].getRawPtr();
+    mySizes[0] = FilterNodes((*interior_groups_)[sd].nodes(), *map);
+    Teuchos::Array<SeparatorGroup> &groups = (*separator_groups_)[sd];
+    if (filterSeparators)
+      for (int i = 0; i < groups.size(); i++)
+        mySizes[i + 1] = FilterNodes(groups[i].nodes(), *map);
+    }
+  ResizeFilteredNodes(sizes);
+
   // Merge all separator GIDs on this processor into one list.
-  // Put all interior GIDs that are present in the baseMap_ in the
-  // newGidList.
   Teuchos::Array<hymls_gidx> separatorGIDs;
-  for (int sd = 0; sd < NumMySubdomains(); sd++)
+  if (!filterSeparators)
     {
-    // Interior nodes don't need communication. Just add those
-    // that are present in the baseMap_
-    InteriorGroup new_group;
-    for (hymls_gidx gid: GetInteriorGroup(sd).nodes())
-      if (map->MyGID(gid))
-        new_group.append(gid);
-    (*interior_groups_)[sd].nodes() = new_group.nodes();
-
-    // Now add the separator groups. We can avoid communication
-    // if the baseOverlappingMap_ is present.
-    for (SeparatorGroup &group: (*separator_groups_)[sd])
-      {
-      if (baseOverlappingMap_ != Teuchos::null)
-        {
-        SeparatorGroup new_group;
-        for (hymls_gidx gid: group.nodes())
-          if (map->MyGID(gid))
-            new_group.append(gid);
-        group.nodes() = new_group.nodes();
-        }
-      else
+    for (int sd = 0; sd < numMySubdomains; sd++)
+      for (SeparatorGroup const &group: (*separator_groups_)[sd])
         std::copy(group.nodes().begin(), group.nodes().end(),
           std::back_inserter(separatorGIDs));
-      }
     }
 
   // Communication is only required if there is no overlapping map
@@ -226,28 +270,32 @@ int HierarchicalMap::FillComplete()
     Epetra_IntVector overlappingVec(*tmpOverlappingMap);
     overlappingVec.Import(vec, imp, Insert);
 
-    for (int sd = 0; sd < NumMySubdomains(); sd++)
+    // If it is present in the overlappingVec the element actually belongs
+    // to the baseMap_ on some processor
+    for (int sd = 0; sd < numMySubdomains; sd++)
+      std::fill(sizes[sd].begin(), sizes[sd].end(), -1);
+
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int sd = 0; sd < numMySubdomains; sd++)
       {
-      for (SeparatorGroup &group: (*separator_groups_)[sd])
-        {
-        SeparatorGroup new_group;
-        for (hymls_gidx gid: group.nodes())
-          {
-          // If it is present in the overlappingVec the element actually belongs
-          // to the baseMap_ on some processor
-          if (overlappingVec[tmpOverlappingMap->LID(gid)])
-            new_group.append(gid);
-          }
-        group.nodes() = new_group.nodes();
-        }
+      int *mySizes = sizes[sd].getRawPtr();
+      Teuchos::Array<SeparatorGroup> &groups = (*separator_groups_)[sd];
+      for (int i = 0; i < groups.size(); i++)
+        mySizes[i + 1] = FilterNodes(groups[i].nodes(), *tmpOverlappingMap,
+          &overlappingVec);
       }
+    ResizeFilteredNodes(sizes);
     }
 
   unique_separator_groups_ = Teuchos::rcp(new Teuchos::Array<Teuchos::Array<SeparatorGroup> >(NumMySubdomains()));
 
+  // Groups are identified by their first node. A hash set keeps this
+  // linear in the number of groups.
   Teuchos::Array<hymls_gidx> all_gids;
-  Teuchos::Array<hymls_gidx> unique_group_ids;
-  for (int sd = 0; sd < NumMySubdomains(); sd++)
+  std::unordered_set<hymls_gidx> unique_group_ids;
+  for (int sd = 0; sd < numMySubdomains; sd++)
     {
     // Remove empty separator groups
     (*separator_groups_)[sd].erase(std::remove_if(
@@ -261,11 +309,9 @@ int HierarchicalMap::FillComplete()
     for (SeparatorGroup const &group: GetSeparatorGroups(sd))
       {
       // Only copy unique groups and cache those
-      if (std::find_if(unique_group_ids.begin(), unique_group_ids.end(), [group](
-            hymls_gidx gid) {return gid == group[0];}) == unique_group_ids.end())
+      if (unique_group_ids.insert(group[0]).second)
         {
         (*unique_separator_groups_)[sd].append(group);
-        unique_group_ids.append(group[0]);
         std::copy(group.nodes().begin(), group.nodes().end(), std::back_inserter(all_gids));
         }
       }
@@ -12,6 +12,7 @@
 
 // forward declarations
 class Epetra_Comm;
+class Epetra_IntVector;
 class Epetra_IntSerialDenseVector;
 class Epetra_LongLongSerialDenseVector;
 
@@ -167,6 +168,9 @@ public:
     return overlappingMap_;
     }
 
+  //! checkpoints store and restore the groups and base maps
+  friend class Checkpoint;
+
 protected:
 
   //@}
@@ -242,6 +246,19 @@ private:
     Teuchos::RCP<Teuchos::Array<Teuchos::Array<SeparatorGroup> > > separator_groups,
     Teuchos::RCP<Teuchos::Array<Teuchos::Array<Teuchos::Array<SeparatorGroup> > > > linked_separator_groups) const;
 
+  //! move the nodes that are in map, and for which the entry in present
+  //! (which lives on map) is nonzero, to the front of nodes and return
+  //! how many there are. The array is not resized, so this can be called
+  //! from multiple threads on different arrays. The caller should resize
+  //! it afterwards.
+  static int FilterNodes(Teuchos::Array<hymls_gidx> &nodes,
+    Epetra_BlockMap const &map, Epetra_IntVector const *present = NULL);
+
+  //! shrink the interior and separator groups of all subdomains to the
+  //! sizes that were returned by FilterNodes()
+  void ResizeFilteredNodes(
+    Teuchos::Array<Teuchos::Array<int> > const &sizes);
+
   //!
   Teuchos::RCP<const HierarchicalMap> SpawnInterior() const;
   //!
@@ -11,9 +11,25 @@
 namespace HYMLS {
 
 HyperCube::HyperCube()
+  :
+  nodeComm_(MPI_COMM_NULL)
   {
   HYMLS_PROF3("HyperCube","HyperCube");
   commWorld_ = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  Reorder(true);
+  }
+
+HyperCube::HyperCube(Teuchos::RCP<const Epetra_MpiComm> comm, bool print)
+  :
+  commWorld_(comm),
+  nodeComm_(MPI_COMM_NULL)
+  {
+  HYMLS_PROF3("HyperCube","HyperCube");
+  Reorder(print);
+  }
+
+void HyperCube::Reorder(bool print)
+  {
   // figure out on which node we are:
   char* procname=new char[MPI_MAX_PROCESSOR_NAME];
   int procname_len=0; 
@@ -55,6 +71,8 @@ HyperCube::HyperCube()
     all_nodes[i]=0;
     }
   CHECK_ZERO(commWorld_->SumAll(&my_node[0],&all_nodes[0],numNodes_));  
+  numProcOnNode_=all_nodes[nodeNumber_];
+  HYMLS_DEBVAR(numProcOnNode_);
   
   maxProcPerNode_=0;
   for (int i=0;i<numNodes_;i++) 
@@ -83,7 +101,9 @@ HyperCube::HyperCube()
   MPI_Comm NewComm;
   MPI_Comm_split(commWorld_->Comm(),color,newRank,&NewComm);
   
-  reorderedComm_=Teuchos::rcp(new Epetra_MpiComm(NewComm));
+  reorderedComm_=CreateOwningMpiComm(NewComm);
+
+  if (!print) return;
 
 //#ifdef HYMLS_TESTING  
   for (int i=0;i<reorderedComm_->NumProc();i++)
@@ -100,8 +120,26 @@ HyperCube::HyperCube()
   return;    
   }
   
+MPI_Comm HyperCube::NodeComm() const
+  {
+  // communicator with the processes on our node, the process with the
+  // lowest rank becomes rank 0
+  if (nodeComm_ == MPI_COMM_NULL)
+    {
+    CHECK_ZERO(MPI_Comm_split(commWorld_->Comm(), nodeNumber_,
+        commWorld_->MyPID(), &nodeComm_));
+    }
+  return nodeComm_;
+  }
+
 HyperCube::~HyperCube()
   {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized && nodeComm_ != MPI_COMM_NULL)
+    {
+    MPI_Comm_free(&nodeComm_);
+    }
   }
 
 std::ostream& HyperCube::Print(std::ostream& os) const
@@ -116,6 +154,35 @@ std::ostream& HyperCube::Print(std::ostream& os) const
   return os;
   }
 
+namespace
+  {
+//! deallocation policy for the RCP returned by CreateOwningMpiComm()
+class MpiCommDeallocator
+  {
+public:
+  typedef Epetra_MpiComm ptr_t;
+
+  void free(Epetra_MpiComm *comm)
+    {
+    MPI_Comm mpiComm = comm->Comm();
+    delete comm;
+
+    // Communicators of objects that live until the end of main() are
+    // destroyed after MPI_Finalize
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (!finalized && mpiComm != MPI_COMM_NULL)
+      MPI_Comm_free(&mpiComm);
+    }
+  };
+  }
+
+Teuchos::RCP<Epetra_MpiComm> CreateOwningMpiComm(MPI_Comm comm)
+  {
+  return Teuchos::rcpWithDealloc(new Epetra_MpiComm(comm),
+    MpiCommDeallocator());
+  }
+
 }//namespace
 
 std::ostream& operator<<(std::ostream& os, const HYMLS::HyperCube& C)
@@ -2,6 +2,7 @@
 #define HYMLS_HYPERCUBE_H
 
 #include <iostream>
+#include <mpi.h>
 #include "Teuchos_RCP.hpp"
 
 class Epetra_MpiComm;
@@ -39,9 +40,12 @@ class HyperCube
 
 public: 
 
-//!
+//! Create a reordered version of MPI_COMM_WORLD and print the new ranks
 HyperCube();
 
+//! Create a reordered version of comm
+HyperCube(Teuchos::RCP<const Epetra_MpiComm> comm, bool print=false);
+
 //!
 virtual ~HyperCube();
 
@@ -60,8 +64,26 @@ Teuchos::RCP<Epetra_MpiComm> GetComm() {return reorderedComm_;}
 //!
 std::ostream& Print(std::ostream& os) const;
 
+//! number of compute nodes
+int NumNodes() const {return numNodes_;}
+
+//! communicator with the processes on the same compute node as
+//! this process, ordered by their rank in the original communicator.
+//! It is created on the first call, which is therefore collective, and
+//! freed when this object is destroyed.
+MPI_Comm NodeComm() const;
+
+//! rank of this process on its compute node
+int RankOnNode() const {return rankOnNode_;}
+
+//! number of processes on the compute node of this process
+int NumProcOnNode() const {return numProcOnNode_;}
+
 protected:
 
+//!
+void Reorder(bool print);
+
 //!
 int numNodes_;
 //!
@@ -73,11 +95,19 @@ int rankOnNode_;
 //!
 int maxProcPerNode_;
 //!
-Teuchos::RCP<Epetra_MpiComm> commWorld_;
-//!
+Teuchos::RCP<const Epetra_MpiComm> commWorld_;
+//! owns the reordered communicator, see CreateOwningMpiComm()
 Teuchos::RCP<Epetra_MpiComm> reorderedComm_;
+//! created by NodeComm()
+mutable MPI_Comm nodeComm_;
 };
 
+//! Wrap comm in an Epetra_MpiComm that calls MPI_Comm_free on it when
+//! the last RCP to the wrapper is destroyed. Epetra_MpiComm itself never
+//! frees its communicator, so objects that keep using the communicator
+//! should hold on to this RCP.
+Teuchos::RCP<Epetra_MpiComm> CreateOwningMpiComm(MPI_Comm comm);
+
 }//namespace
 
 std::ostream& operator<<(std::ostream& os,const HYMLS::HyperCube& C);
@@ -0,0 +1,125 @@
+#include "HYMLS_ImportRegistry.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Import.h"
+
+#include "Teuchos_RCP.hpp"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace HYMLS
+  {
+
+namespace
+  {
+typedef std::pair<const void *, const void *> RegistryKey;
+
+struct RegistryData
+  {
+  RegistryData(): numHits(0) {}
+
+  std::map<RegistryKey, Teuchos::RCP<const Epetra_Import> > entries;
+  long long numHits;
+  };
+
+// Every thread has its own registry, so another thread (like the one of
+// the DoubleBufferedPreconditioner) does not change what this thread
+// finds.
+RegistryData &Registry()
+  {
+  thread_local RegistryData data;
+  return data;
+  }
+
+// Remove the importers of which a map is only used by the importers in
+// the registry. The map data counts the copies of the map, and every
+// importer holds a copy of its target and source map. Removing an
+// importer can make the maps of other importers unused, so this is
+// repeated until nothing changes.
+void RemoveUnusedMaps(RegistryData &data)
+  {
+  bool removed = true;
+  while (removed)
+    {
+    std::map<const void *, int> registryCopies;
+    for (auto const &entry: data.entries)
+      {
+      registryCopies[entry.first.first]++;
+      registryCopies[entry.first.second]++;
+      }
+
+    std::vector<RegistryKey> unused;
+    for (auto const &entry: data.entries)
+      {
+      const Epetra_Import &import = *entry.second;
+      if (import.TargetMap().ReferenceCount() <= registryCopies[entry.first.first] ||
+        import.SourceMap().ReferenceCount() <= registryCopies[entry.first.second])
+        unused.push_back(entry.first);
+      }
+
+    for (RegistryKey const &key: unused)
+      data.entries.erase(key);
+    removed = !unused.empty();
+    }
+  }
+  }
+
+Teuchos::RCP<const Epetra_Import> ImportRegistry::GetImport(
+  const Epetra_BlockMap &target, const Epetra_BlockMap &source)
+  {
+  HYMLS_PROF3("ImportRegistry", "GetImport");
+
+  RegistryData &data = Registry();
+  RemoveUnusedMaps(data);
+
+  RegistryKey key(target.DataPtr(), source.DataPtr());
+
+  auto it = data.entries.find(key);
+  int found = it != data.entries.end();
+
+#ifdef HYMLS_TESTING
+  // all processes should make the same decision, since constructing an
+  // importer is collective
+  int allFound;
+  CHECK_ZERO(source.Comm().MinAll(&found, &allFound, 1));
+  if (allFound != found)
+    Tools::Error("Inconsistent use of the ImportRegistry", __FILE__, __LINE__);
+#endif
+
+  if (found)
+    {
+    data.numHits++;
+    return it->second;
+    }
+
+  // The importer holds copies of the maps, which keeps their data alive
+  Teuchos::RCP<const Epetra_Import> import =
+    Teuchos::rcp(new Epetra_Import(target, source));
+  data.entries[key] = import;
+  return import;
+  }
+
+void ImportRegistry::Clear()
+  {
+  Registry().entries.clear();
+  }
+
+int ImportRegistry::Size()
+  {
+  return Registry().entries.size();
+  }
+
+long long ImportRegistry::NumHits()
+  {
+  return Registry().numHits;
+  }
+
+  }
@@ -0,0 +1,56 @@
+#ifndef HYMLS_IMPORT_REGISTRY_H
+#define HYMLS_IMPORT_REGISTRY_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+
+class Epetra_BlockMap;
+class Epetra_Import;
+
+namespace HYMLS {
+
+/*! Registry of Epetra_Import objects so that the communication plan
+  between two maps is only computed once, even if it is needed by
+  different objects or in every Compute() call.
+
+  Importers are identified by the data of the target and source map.
+  Copies of a map share their data, so they give the same importer, but
+  two maps that were constructed separately do not, even if they are the
+  same. The registry keeps the maps alive, so the identity can not be
+  reused by another map.
+
+  The returned importers are shared, so they are const. GetImport() is
+  collective and has to be called in the same order on all processes,
+  like the Epetra_Import constructor. An importer is only removed when
+  one of its maps is no longer used outside of the registry, so whether
+  an importer is found only depends on the maps, not on the other calls
+  a process made, and all processes make the same decision. Every
+  thread has its own registry. The registry is cleared when a top-level
+  Preconditioner is destroyed.
+
+  Importers between maps that are created for a single use, like the
+  ones in CoarseSolver::ComputeReplicated() and AugmentedMatrix, are not
+  registered since they would never be found again.
+*/
+class ImportRegistry
+  {
+public:
+
+  //! get an importer from source to target. Collective.
+  static Teuchos::RCP<const Epetra_Import> GetImport(
+    const Epetra_BlockMap &target, const Epetra_BlockMap &source);
+
+  //! remove all importers
+  static void Clear();
+
+  //! number of importers that are currently kept
+  static int Size();
+
+  //! number of times an existing importer was returned
+  static long long NumHits();
+  };
+
+  }
+
+#endif
@@ -3,12 +3,24 @@
 #include "HYMLS_config.h"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "Epetra_Map.h"
 #include "Epetra_MultiVector.h"
 #include "Epetra_Vector.h"
 #include "Epetra_CrsMatrix.h"
 #include "Epetra_Import.h"
+#include "Epetra_Operator.h"
 
 #include "Teuchos_RCP.hpp"
 
@@ -16,9 +28,12 @@
 #include "EpetraExt_VectorIn.h"
 
 #include "HYMLS_Tools.hpp"
+#include "HYMLS_Exception.hpp"
 #include "HYMLS_Macros.hpp"
 #include "HYMLS_CartesianPartitioner.hpp"
 #include "HYMLS_SkewCartesianPartitioner.hpp"
+#include "HYMLS_BinaryIO.hpp"
+#include "HYMLS_MatrixUtils.hpp"
 
 #include "GaleriExt_Cross2DN.h"
 #include "Galeri_CrsMatrices.h"
@@ -50,6 +65,10 @@ Teuchos::RCP<Epetra_CrsMatrix> read_matrix(std::string datadir,
     {
     suffix="2.mtx";
     }
+  else if (file_format=="Binary")
+    {
+    suffix=".bin";
+    }
   else
     {
     HYMLS::Tools::Error("File format '"+file_format+"' not supported",__FILE__,__LINE__);
@@ -72,6 +91,10 @@ Teuchos::RCP<Epetra_CrsMatrix> read_matrix(std::string datadir,
 #endif
     K=Teuchos::rcp(Kptr, true);
     }
+  else if (file_format=="Binary")
+    {
+    K=HYMLS::BinaryIO::ReadMatrix(filename,*map);
+    }
   else
     {
     HYMLS::Tools::Error("File format '"+file_format+"' not supported",__FILE__,__LINE__);
@@ -79,30 +102,38 @@ Teuchos::RCP<Epetra_CrsMatrix> read_matrix(std::string datadir,
   return K;
   }
 
-Teuchos::RCP<Epetra_Vector> read_vector(std::string name,std::string datadir,
-  std::string file_format,Teuchos::RCP<Epetra_Map> map)
+namespace
+  {
+// extension of a vector file in the given format
+std::string vector_suffix(std::string const &file_format)
   {
-  if (map==Teuchos::null)
-    {
-    HYMLS::Tools::Error("map must have been allocated before this function",
-        __FILE__,__LINE__);
-    }
-  
-  std::string suffix;
   if (file_format=="MatrixMarket")
     {
-    suffix=".mtx";
+    return ".mtx";
     }
   else if (file_format=="MatrixMarket (2)")
     {
-    suffix="2.mtx";
+    return "2.mtx";
     }
-  else
+  else if (file_format=="Binary")
     {
-    HYMLS::Tools::Error("File format '"+file_format+"' not supported",__FILE__,__LINE__);
+    return ".bin";
     }
+  HYMLS::Tools::Error("File format '"+file_format+"' not supported",__FILE__,__LINE__);
+  return "";
+  }
+  }
 
-  std::string filename = datadir+"/"+name+suffix;
+Teuchos::RCP<Epetra_Vector> read_vector(std::string name,std::string datadir,
+  std::string file_format,Teuchos::RCP<Epetra_Map> map)
+  {
+  if (map==Teuchos::null)
+    {
+    HYMLS::Tools::Error("map must have been allocated before this function",
+        __FILE__,__LINE__);
+    }
+  
+  std::string filename = datadir+"/"+name+vector_suffix(file_format);
   
   HYMLS::Tools::Out("... read vector from file '"+filename+"'");
   HYMLS::Tools::Out("    file format: "+file_format);
@@ -126,6 +157,10 @@ Teuchos::RCP<Epetra_Vector> read_vector(std::string name,std::string datadir,
     CHECK_ZERO(v->Import(*vptr,import,Insert));
     delete vptr;
     }
+  else if (file_format=="Binary")
+    {
+    v=HYMLS::BinaryIO::ReadVector(filename,*map);
+    }
   else
     {
     HYMLS::Tools::Error("File format '"+file_format+"' not supported",__FILE__,__LINE__);
@@ -133,6 +168,25 @@ Teuchos::RCP<Epetra_Vector> read_vector(std::string name,std::string datadir,
   return v;
   }
 
+void write_vector(std::string name, std::string datadir,
+  std::string file_format, const Epetra_Vector& v)
+  {
+  std::string filename = datadir+"/"+name+vector_suffix(file_format);
+
+  HYMLS::Tools::Out("... write vector to file '"+filename+"'");
+
+  if (file_format=="Binary")
+    {
+    // the binary format is ordered by GID, every process writes its own part
+    BinaryIO::WriteVector(filename, v);
+    }
+  else
+    {
+    // the same ordering that read_vector assumes
+    MatrixUtils::Dump(v, filename, true, MatrixUtils::MATRIXMARKET);
+    }
+  }
+
 /////////////////////////////////////////////////////////////////////////////////////////
 
 #if 0
@@ -187,7 +241,9 @@ Teuchos::RCP<Epetra_Map> create_map(const Epetra_Comm& comm,
   {
   std::string partMethod = params->sublist("Preconditioner").get("Partitioner", "Cartesian");
   Teuchos::RCP<HYMLS::BasePartitioner> part = Teuchos::null;
-  if (partMethod == "Cartesian")
+  // The test problems are defined on a grid, so with a graph partitioner
+  // we start from the Cartesian distribution
+  if (partMethod == "Cartesian" || partMethod == "Graph")
     {
     part = Teuchos::rcp(new HYMLS::CartesianPartitioner(
         Teuchos::null, params, comm));
@@ -221,6 +277,9 @@ Teuchos::RCP<Epetra_Vector> create_testvector(
     int ny = probl_params.get("ny", nx);
     int dim = probl_params.get("Dimension", -1);
     int dof = probl_params.get("Degrees of Freedom", -1);
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for (int i = 0; i < matrix.NumMyRows(); i++)
       {
       hymls_gidx grid = matrix.GRID64(i);
@@ -236,6 +295,9 @@ Teuchos::RCP<Epetra_Vector> create_testvector(
     }
 
   // Remove boundary conditions
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
   for (int i = 0; i < matrix.NumMyRows(); i++)
     {
     int len;
@@ -369,10 +431,14 @@ Teuchos::RCP<Epetra_MultiVector> create_nullspace(
     nullSpace = Teuchos::rcp(new Epetra_MultiVector(map, dof));
     CHECK_ZERO(nullSpace->PutScalar(0.0));
 
+    double value = 1.0 / sqrt(nullSpace->GlobalLength64() / dof);
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for (int lid = 0; lid < nullSpace->MyLength(); lid++)
       {
       hymls_gidx gid = nullSpace->Map().GID64(lid);
-      (*nullSpace)[gid % dof][lid] = 1.0 / sqrt(nullSpace->GlobalLength64() / dof);
+      (*nullSpace)[gid % dof][lid] = value;
       }
     }
   else if (nullSpaceType == "Constant P")
@@ -386,6 +452,9 @@ Teuchos::RCP<Epetra_MultiVector> create_nullspace(
 
     nullSpace = Teuchos::rcp(new Epetra_Vector(map));
     CHECK_ZERO(nullSpace->PutScalar(0.0));
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for (int lid = 0; lid < nullSpace->MyLength(); lid++)
       {
       if (nullSpace->Map().GID64(lid) % dof == pvar)
@@ -408,6 +477,9 @@ Teuchos::RCP<Epetra_MultiVector> create_nullspace(
     int ny = probl_params.get("ny", nx);
     int nz = probl_params.get("nz", dim > 2 ? nx : 1);
     int stokes_b = eqn == "Stokes-B";
+#ifdef HYMLS_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for (int lid = 0; lid < nullSpace->MyLength(); lid++)
       {
       hymls_gidx gid = nullSpace->Map().GID64(lid);
@@ -448,6 +520,211 @@ int MakeSystemConsistent(const Epetra_CrsMatrix& A,
   {
   return 0;
   }
+
+namespace
+  {
+// Move a request to the subdirectory "failed" of dir, or remove it if
+// that is not possible. A request that can be neither moved nor removed
+// is added to ignored, so it is not picked up again at every poll.
+void move_to_failed(std::string const &dir, std::string const &request,
+  std::string const &rhsSuffix, std::set<std::string> &ignored)
+  {
+  std::string failedDir = dir + "/failed";
+  std::string file = dir + "/" + request + rhsSuffix;
+  mkdir(failedDir.c_str(), 0755);
+  if (std::rename(file.c_str(), (failedDir+"/"+request+rhsSuffix).c_str()) == 0)
+    return;
+
+  HYMLS::Tools::Warning("could not move request '"+request+"' to "+failedDir+
+    ", removing it", __FILE__, __LINE__);
+  if (std::remove(file.c_str()) == 0)
+    return;
+
+  HYMLS::Tools::Warning("could not remove request '"+request+
+    "', it is ignored from now on", __FILE__, __LINE__);
+  ignored.insert(request);
+  }
+  }
+
+int run_service(const Epetra_Operator& solver, Teuchos::RCP<Epetra_Map> map,
+  Teuchos::ParameterList& serviceList, double rhs_scaling)
+  {
+  HYMLS_PROF("MainUtils", "run_service");
+  const Epetra_Comm& comm = map->Comm();
+
+  std::string dir = serviceList.get("Directory", ".");
+  std::string file_format = serviceList.get("File Format", "MatrixMarket");
+  int maxBatchSize = serviceList.get("Maximum Batch Size", 16);
+  double pollInterval = serviceList.get("Poll Interval", 1.0);
+
+  std::string rhsSuffix = ".rhs" + vector_suffix(file_format);
+  std::string stopFile = dir + "/stop";
+
+  HYMLS::Tools::Out("Waiting for right-hand sides '*"+rhsSuffix+"' in "+dir);
+  HYMLS::Tools::Out("Create a file named 'stop' there to end the service");
+
+  // requests that failed but could not be moved away, only used on the
+  // root process
+  std::set<std::string> ignored;
+
+  int numSolved = 0;
+  int numFailed = 0;
+  while (true)
+    {
+    // the root process looks for new requests and tells the others
+    std::string names;
+    int stop = 0;
+    if (comm.MyPID() == 0)
+      {
+      std::vector<std::string> requests;
+      DIR *dp = opendir(dir.c_str());
+      if (dp == NULL)
+        {
+        HYMLS::Tools::Warning("could not open directory "+dir, __FILE__, __LINE__);
+        stop = 1;
+        }
+      struct dirent *entry;
+      while (dp != NULL && (entry = readdir(dp)) != NULL)
+        {
+        std::string file = entry->d_name;
+        if (file.size() > rhsSuffix.size() &&
+          file.compare(file.size() - rhsSuffix.size(), rhsSuffix.size(), rhsSuffix) == 0)
+          {
+          std::string request = file.substr(0, file.size() - rhsSuffix.size());
+          if (!ignored.count(request))
+            requests.push_back(request);
+          }
+        }
+      if (dp != NULL)
+        closedir(dp);
+
+      // oldest names first if the clients number their requests
+      std::sort(requests.begin(), requests.end());
+      if ((int)requests.size() > maxBatchSize)
+        requests.resize(maxBatchSize);
+      for (std::string const &request: requests)
+        names += request + "\n";
+
+      std::ifstream ifs(stopFile.c_str());
+      if (requests.empty() && ifs.good())
+        stop = 1;
+      }
+
+    int len = names.size();
+    CHECK_ZERO(comm.Broadcast(&len, 1, 0));
+    CHECK_ZERO(comm.Broadcast(&stop, 1, 0));
+    if (stop)
+      break;
+
+    if (len == 0)
+      {
+      std::this_thread::sleep_for(std::chrono::duration<double>(pollInterval));
+      continue;
+      }
+
+    std::vector<char> buffer(names.begin(), names.end());
+    buffer.resize(len);
+    CHECK_ZERO(comm.Broadcast(&buffer[0], len, 0));
+
+    std::vector<std::string> requests;
+    std::istringstream ss(std::string(buffer.begin(), buffer.end()));
+    for (std::string request; std::getline(ss, request);)
+      requests.push_back(request);
+
+    // read the requests one at a time, so a malformed one can be moved
+    // to the subdirectory "failed" without stopping the service
+    std::vector<std::string> valid;
+    std::vector<Teuchos::RCP<Epetra_Vector> > rhs;
+    for (std::string const &request: requests)
+      {
+      Teuchos::RCP<Epetra_Vector> b;
+      int failed = 0;
+      try
+        {
+        b = read_vector(request+".rhs", dir, file_format, map);
+        }
+      catch (HYMLS::Exception &e)
+        {
+        HYMLS::Tools::Warning("could not read request '"+request+"':\n"+e.what(),
+          __FILE__, __LINE__);
+        failed = 1;
+        }
+      int anyFailed;
+      CHECK_ZERO(comm.MaxAll(&failed, &anyFailed, 1));
+      if (!anyFailed)
+        {
+        valid.push_back(request);
+        rhs.push_back(b);
+        }
+      else
+        {
+        numFailed++;
+        if (comm.MyPID() == 0)
+          move_to_failed(dir, request, rhsSuffix, ignored);
+        }
+      }
+    comm.Barrier();
+    requests = valid;
+    if (requests.empty())
+      continue;
+
+    // solve all pending right-hand sides at once
+    int k = requests.size();
+    Epetra_MultiVector B(*map, k);
+    Epetra_MultiVector X(*map, k);
+    for (int j = 0; j < k; j++)
+      {
+      CHECK_ZERO(B(j)->Update(rhs_scaling, *rhs[j], 0.0));
+      }
+
+    HYMLS::Tools::Out("Solve "+Teuchos::toString(k)+" right-hand sides");
+    HYMLS::Tools::StartTiming("main: Service Solve");
+    int ierr = solver.ApplyInverse(B, X);
+    HYMLS::Tools::StopTiming("main: Service Solve",true);
+
+    // a failed solve does not produce solutions, the requests are moved
+    // to "failed" like the ones that cannot be read
+    int failed = ierr != 0;
+    int anyFailed;
+    CHECK_ZERO(comm.MaxAll(&failed, &anyFailed, 1));
+    if (anyFailed)
+      {
+      HYMLS::Tools::Warning("solver returned "+Teuchos::toString(ierr)+
+        ", moving the requests to "+dir+"/failed", __FILE__, __LINE__);
+      if (comm.MyPID() == 0)
+        for (std::string const &request: requests)
+          move_to_failed(dir, request, rhsSuffix, ignored);
+      comm.Barrier();
+      numFailed += k;
+      continue;
+      }
+
+    // The solution is written to a temporary file which is renamed once it
+    // is complete, so clients never see partial files.
+    for (int j = 0; j < k; j++)
+      write_vector(requests[j]+".part", dir, file_format, *X(j));
+    comm.Barrier();
+    if (comm.MyPID() == 0)
+      {
+      for (int j = 0; j < k; j++)
+        {
+        std::string base = dir + "/" + requests[j];
+        std::rename((base+".part"+vector_suffix(file_format)).c_str(),
+          (base+".sol"+vector_suffix(file_format)).c_str());
+        std::remove((base+rhsSuffix).c_str());
+        }
+      }
+    comm.Barrier();
+    numSolved += k;
+    }
+
+  if (comm.MyPID() == 0)
+    std::remove(stopFile.c_str());
+
+  HYMLS::Tools::Out("Service solved "+Teuchos::toString(numSolved)+" right-hand sides, "+
+    Teuchos::toString(numFailed)+" requests failed");
+  return 0;
+  }
                                                                                              
 
 }//MainUtils
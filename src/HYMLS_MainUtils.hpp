@@ -12,6 +12,7 @@ class Epetra_Map;
 class Epetra_CrsMatrix;
 class Epetra_Vector;
 class Epetra_MultiVector;
+class Epetra_Operator;
 
 namespace Teuchos {
 class ParameterList;
@@ -30,6 +31,12 @@ Teuchos::RCP<Epetra_Vector> read_vector(std::string name,
   std::string file_format,
   Teuchos::RCP<Epetra_Map> map);
 
+// write a vector in the ordering that read_vector expects
+void write_vector(std::string name,
+  std::string datadir,
+  std::string file_format,
+  const Epetra_Vector& v);
+
 Teuchos::RCP<Epetra_Map> create_map(const Epetra_Comm& comm,
   Teuchos::RCP<Teuchos::ParameterList> const &params);
 
@@ -52,6 +59,21 @@ int MakeSystemConsistent(const Epetra_CrsMatrix& A,
   Epetra_MultiVector& b,
   Teuchos::ParameterList& driverList);
 
+// Solve right-hand sides that clients put in a directory until a file
+// named "stop" appears there. A request "name" is the vector file
+// "name.rhs.mtx" ("name.rhs.bin" for "File Format"="Binary"), which
+// should be created under a different name and then renamed, so it is
+// complete when it is found. All requests that are present are solved
+// at once, up to "Maximum Batch Size", after which the solutions are
+// written to "name.sol.mtx" and the requests are removed. The rhs is
+// multiplied by rhs_scaling before solving. Requests that cannot be
+// read, and the whole batch if the solver returns an error, are moved to
+// the subdirectory "failed" and the service continues.
+int run_service(const Epetra_Operator& solver,
+  Teuchos::RCP<Epetra_Map> map,
+  Teuchos::ParameterList& serviceList,
+  double rhs_scaling = 1.0);
+
   }
   }
 
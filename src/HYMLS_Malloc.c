@@ -5,6 +5,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+
+// Memory tracking allocator for HYMLS_MEMORY_PROFILING.
+//
+// The sizes of the allocations are kept in a side table so that the
+// layout of the allocations is not changed. The side table is split into
+// shards which are each protected by their own spin lock, so threads only
+// contend when they access the same shard. Usage changes are accumulated
+// per thread and only added to the global counters once they exceed
+// FLUSH_THRESHOLD bytes, which keeps the atomic operations out of the
+// common path. The global counters are therefore accurate up to
+// FLUSH_THRESHOLD bytes per thread.
+//
+// Apart from the total and maximum usage, a separate maximum is kept for
+// the current profiling region, see start_memory_region().
+
+#define NUM_SHARDS 64
+#define FLUSH_THRESHOLD 65536
+
+#define TLS __thread __attribute__((tls_model("initial-exec")))
 
 static char tmpbuf[32768];
 static size_t tmppos = 0;
@@ -15,35 +35,39 @@ typedef struct ptr_size_
     size_t size;
 } ptr_size;
 
-static ptr_size *ptrbuf = NULL;
-static ptr_size *ptrbuf_end = NULL;
-static size_t ptrbuf_size = 1;
-static size_t total_size = 0;
-static size_t max_total_size = 0;
-
-static void dummy_add_ptr(void *ptr, size_t size)
+typedef struct ptr_table_
 {
-}
+    atomic_int lock;
+    ptr_size *buf;
+    size_t size;
+    size_t used;
+    size_t live;
+} ptr_table;
 
-static int dummy_del_ptr(void *ptr)
-{
-    return -1;
-}
+// marks a removed entry so that probing continues past it
+#define TOMBSTONE ((void *)1)
+
+static ptr_table tables[NUM_SHARDS];
 
-static void (*add_ptr)(void *ptr, size_t size) = dummy_add_ptr;
-static int (*del_ptr)(void *ptr) = dummy_del_ptr;
+static atomic_llong total_size = 0;
+static atomic_llong max_total_size = 0;
+static atomic_llong region_max_size = 0;
 
-#define _printf(fmt, ...) {                                \
-        void (*old_add_ptr)(void *ptr, size_t size) = add_ptr;  \
-        int (*old_del_ptr)(void *ptr) = del_ptr;                \
-        add_ptr = dummy_add_ptr;                                \
-        del_ptr = dummy_del_ptr;                                \
+// usage change of this thread that was not yet added to total_size
+static TLS long long thread_delta = 0;
+
+// set while we are inside the tracking code, allocations done in there
+// are not tracked
+static TLS int in_hook = 0;
+
+#define _printf(fmt, ...) {                                     \
+        int old_in_hook = in_hook;                              \
+        in_hook = 1;                                            \
                                                                 \
         fprintf(stderr, fmt, ##__VA_ARGS__);                    \
         fflush(stderr);                                         \
                                                                 \
-        add_ptr = old_add_ptr;                                  \
-        del_ptr = old_del_ptr;                                  \
+        in_hook = old_in_hook;                                  \
     }
 
 static void* dummy_malloc(size_t size)
@@ -94,7 +118,12 @@ static void dummy_free(void *ptr)
 {
 }
 
-static int malloc_initialized = 0;
+static int is_tmpbuf_ptr(void *ptr)
+{
+    return (char *)ptr >= tmpbuf && (char *)ptr < tmpbuf + sizeof(tmpbuf);
+}
+
+static atomic_int malloc_initialized = 0;
 
 static void* (*real_malloc)(size_t size) = dummy_malloc;
 static void* (*real_calloc)(size_t nmemb, size_t size) = dummy_calloc;
@@ -108,126 +137,238 @@ static void* (*real_aligned_alloc)(size_t alignment, size_t size) = dummy_aligne
 static size_t(*real_malloc_usable_size)(void *ptr) = NULL;
 static void* (*real_pvalloc)(size_t size) = NULL;
 
-static void* (*temp_malloc)(size_t size) = NULL;
-static void* (*temp_calloc)(size_t nmemb, size_t size) = NULL;
-static void* (*temp_realloc)(void *ptr, size_t size) = NULL;
-static void* (*temp_memalign)(size_t alignment, size_t size) = NULL;
-static void* (*temp_valloc)(size_t size) = NULL;
-static int   (*temp_posix_memalign)(void** memptr, size_t alignment,
-                                    size_t size) = NULL;
-static void  (*temp_free)(void *ptr) = NULL;
-static void* (*temp_aligned_alloc)(size_t alignment, size_t size) = NULL;
-static size_t(*temp_malloc_usable_size)(void *ptr) = NULL;
-static void* (*temp_pvalloc)(size_t size) = NULL;
-
-static int real_add_ptr_hash(void *ptr, size_t size)
-{
-    ptr_size *ptrbuf_iter = ptrbuf + ((size_t)ptr % ptrbuf_size);
-    for (; ptrbuf_iter != ptrbuf_end; ++ptrbuf_iter)
+static void lock_table(ptr_table *table)
+{
+    while (atomic_exchange_explicit(&table->lock, 1, memory_order_acquire))
+        while (atomic_load_explicit(&table->lock, memory_order_relaxed));
+}
+
+static void unlock_table(ptr_table *table)
+{
+    atomic_store_explicit(&table->lock, 0, memory_order_release);
+}
+
+static size_t hash_ptr(void *ptr)
+{
+    size_t h = (size_t)ptr >> 4;
+    h ^= h >> 17;
+    h *= (size_t)0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+static ptr_table *get_table(size_t hash)
+{
+    return tables + (hash % NUM_SHARDS);
+}
+
+// Insert without growing, the table must have a free slot
+static size_t table_insert(ptr_table *table, size_t hash, void *ptr, size_t size)
+{
+    size_t mask = table->size - 1;
+    size_t i = (hash / NUM_SHARDS) & mask;
+    ptr_size *tombstone = NULL;
+    for (;; i = (i + 1) & mask)
     {
-        if (ptrbuf_iter->ptr == ptr)
+        ptr_size *entry = table->buf + i;
+        if (entry->ptr == ptr)
         {
-            if (ptrbuf_iter->size == size)
-                return 1;
-            else
-                _printf("Pointer of size %zu reallocated but not freed %p\n", size, ptr);
+            // Allocated twice without being freed in between, which
+            // means that a free was not intercepted
+            size_t old_size = entry->size;
+            entry->size = size;
+            return old_size;
         }
-
-        if (ptrbuf_iter->ptr == NULL)
+        if (entry->ptr == TOMBSTONE && !tombstone)
+            tombstone = entry;
+        if (entry->ptr == NULL)
         {
-            ptrbuf_iter->ptr = ptr;
-            ptrbuf_iter->size = size;
+            if (tombstone)
+                entry = tombstone;
+            else
+                table->used++;
+            entry->ptr = ptr;
+            entry->size = size;
+            table->live++;
             return 0;
         }
     }
-    return -1;
 }
 
-static void ptrbuf_realloc()
+static void table_grow(ptr_table *table)
 {
-    ptrbuf_size *= 2;
-    if (ptrbuf == NULL)
-        ptrbuf_size = 20;
+    ptr_size *old_buf = table->buf;
+    size_t old_size = table->size;
+
+    // Rehashing also removes the tombstones, so only grow if there are
+    // many live entries
+    size_t new_size = old_size ? old_size : 64;
+    while (table->live * 4 > new_size)
+        new_size *= 2;
+
+    int old_in_hook = in_hook;
+    in_hook = 1;
+    table->buf = (ptr_size *)real_calloc(new_size, sizeof(ptr_size));
+    in_hook = old_in_hook;
+
+    if (!table->buf)
+    {
+        _printf("Could not allocate the memory tracking table\n");
+        exit(1);
+    }
 
-    ptr_size *tmp_ptrbuf = ptrbuf;
+    table->size = new_size;
+    table->used = 0;
+    table->live = 0;
 
-    // Protect calloc call since apparently this can in turn call memalign
-    void (*old_add_ptr)(void *ptr, size_t size) = add_ptr;
-    int (*old_del_ptr)(void *ptr) = del_ptr;
-    add_ptr = dummy_add_ptr;
-    del_ptr = dummy_del_ptr;
+    size_t i;
+    for (i = 0; i < old_size; ++i)
+    {
+        void *ptr = old_buf[i].ptr;
+        if (ptr && ptr != TOMBSTONE)
+            table_insert(table, hash_ptr(ptr), ptr, old_buf[i].size);
+    }
 
-    ptrbuf = (ptr_size *)real_calloc(ptrbuf_size, sizeof(ptr_size));
+    if (old_buf)
+        real_free(old_buf);
+}
 
-    add_ptr = old_add_ptr;
-    del_ptr = old_del_ptr;
+// Returns the size of the entry or -1 if the pointer is unknown
+static long long table_remove(ptr_table *table, size_t hash, void *ptr)
+{
+    if (!table->size)
+        return -1;
 
-    if (tmp_ptrbuf)
+    size_t mask = table->size - 1;
+    size_t i = (hash / NUM_SHARDS) & mask;
+    for (;; i = (i + 1) & mask)
     {
-        ptr_size *ptrbuf_iter = tmp_ptrbuf;
-        for (; ptrbuf_iter != ptrbuf_end; ++ptrbuf_iter)
+        ptr_size *entry = table->buf + i;
+        if (entry->ptr == NULL)
+            return -1;
+        if (entry->ptr == ptr)
         {
-            if (ptrbuf_iter->ptr)
-            {
-                if (real_add_ptr_hash(ptrbuf_iter->ptr, ptrbuf_iter->size) == -1)
-                    ptrbuf_realloc();
-            }
+            size_t size = entry->size;
+            entry->ptr = TOMBSTONE;
+            entry->size = 0;
+            table->live--;
+            return (long long)size;
         }
-        real_free(tmp_ptrbuf);
     }
-    ptrbuf_end = ptrbuf + ptrbuf_size;
 }
 
-static void real_add_ptr(void *ptr, size_t size)
+static void update_max(atomic_llong *max, long long value)
 {
-    int ret = real_add_ptr_hash(ptr, size);
+    long long old = atomic_load_explicit(max, memory_order_relaxed);
+    while (value > old &&
+           !atomic_compare_exchange_weak_explicit(max, &old, value,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
 
-    if (ret == 0)
+static void flush_usage()
+{
+    long long delta = thread_delta;
+    thread_delta = 0;
+
+    long long total = atomic_fetch_add_explicit(&total_size, delta, memory_order_relaxed) + delta;
+    if (delta > 0)
     {
-        total_size += size;
-        max_total_size = total_size > max_total_size ? total_size : max_total_size;
+        update_max(&max_total_size, total);
+        update_max(&region_max_size, total);
     }
+}
+
+static void update_usage(long long delta)
+{
+    thread_delta += delta;
+    if (thread_delta > FLUSH_THRESHOLD || thread_delta < -FLUSH_THRESHOLD)
+        flush_usage();
+}
 
-    if (ret >= 0)
+static void add_ptr(void *ptr, size_t size)
+{
+    if (!ptr || in_hook || !malloc_initialized)
         return;
 
-    ptrbuf_realloc();
+    size_t hash = hash_ptr(ptr);
+    ptr_table *table = get_table(hash);
+
+    lock_table(table);
+    if ((table->used + 1) * 2 > table->size)
+        table_grow(table);
+    size_t old_size = table_insert(table, hash, ptr, size);
+    unlock_table(table);
 
-    real_add_ptr(ptr, size);
+    update_usage((long long)size - (long long)old_size);
 }
 
-static int real_del_ptr(void *ptr)
+static long long del_ptr(void *ptr)
 {
-    if (!ptr) return -1;
+    if (!ptr || in_hook)
+        return -1;
 
-    ptr_size *ptrbuf_iter = ptrbuf + ((size_t)ptr % ptrbuf_size);
-    for (; ptrbuf_iter != ptrbuf_end; ++ptrbuf_iter)
-        if (ptrbuf_iter->ptr == ptr)
-        {
-            total_size -= ptrbuf_iter->size;
-            ptrbuf_iter->ptr = NULL;
-            ptrbuf_iter->size = 0;
-            return 0;
-        }
-    return -1;
+    size_t hash = hash_ptr(ptr);
+    ptr_table *table = get_table(hash);
+
+    lock_table(table);
+    long long size = table_remove(table, hash, ptr);
+    unlock_table(table);
+
+    if (size > 0)
+        update_usage(-size);
+    return size;
 }
 
 size_t get_memory_usage()
 {
-    return total_size;
+    flush_usage();
+    long long total = atomic_load_explicit(&total_size, memory_order_relaxed);
+    return total > 0 ? (size_t)total : 0;
 }
 
 size_t get_max_memory_usage()
 {
-    return max_total_size;
+    flush_usage();
+    return (size_t)atomic_load_explicit(&max_total_size, memory_order_relaxed);
 }
 
-static void hookfns()
+size_t get_region_max_memory_usage()
+{
+    flush_usage();
+    return (size_t)atomic_load_explicit(&region_max_size, memory_order_relaxed);
+}
+
+// Start a new profiling region. The maximum of the enclosing region is
+// returned and should be passed to stop_memory_region() when the region
+// ends, so regions can be nested.
+size_t start_memory_region()
 {
-    malloc_initialized = 1;
+    flush_usage();
+    long long total = atomic_load_explicit(&total_size, memory_order_relaxed);
+    return (size_t)atomic_exchange_explicit(&region_max_size, total, memory_order_relaxed);
+}
 
-    add_ptr = dummy_add_ptr;
-    del_ptr = dummy_del_ptr;
+void stop_memory_region(size_t outer_max)
+{
+    flush_usage();
+    update_max(&region_max_size, (long long)outer_max);
+}
+
+static void hookfns()
+{
+    int old_in_hook = in_hook;
+    in_hook = 1;
+
+    void* (*temp_malloc)(size_t size);
+    void* (*temp_calloc)(size_t nmemb, size_t size);
+    void* (*temp_realloc)(void *ptr, size_t size);
+    void* (*temp_memalign)(size_t alignment, size_t size);
+    void* (*temp_valloc)(size_t size);
+    int   (*temp_posix_memalign)(void** memptr, size_t alignment, size_t size);
+    void  (*temp_free)(void *ptr);
+    void* (*temp_aligned_alloc)(size_t alignment, size_t size);
+    size_t(*temp_malloc_usable_size)(void *ptr);
+    void* (*temp_pvalloc)(size_t size);
 
     temp_malloc             = (void* (*)(size_t)) dlsym(RTLD_NEXT, "malloc");
     temp_calloc             = (void* (*)(size_t, size_t)) dlsym(RTLD_NEXT, "calloc");
@@ -259,14 +400,20 @@ static void hookfns()
     real_malloc_usable_size = temp_malloc_usable_size;
     real_pvalloc            = temp_pvalloc;
 
-    add_ptr = (void (*)(void *, size_t))real_add_ptr;
-    del_ptr = (int (*)(void *))real_del_ptr;
+    in_hook = old_in_hook;
+
+    atomic_store(&malloc_initialized, 1);
 }
 
+// The first allocation happens before any threads are started, so there
+// is no need to protect the initialization.
+#define INITIALIZE_HOOKS                        \
+    if (!malloc_initialized && !in_hook)        \
+        hookfns();
+
 void* malloc(size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
     void *new_ptr = real_malloc(size);
     add_ptr(new_ptr, size);
@@ -275,8 +422,7 @@ void* malloc(size_t size)
 
 void* calloc(size_t nmemb, size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
     void *new_ptr = real_calloc(nmemb, size);
     add_ptr(new_ptr, nmemb * size);
@@ -285,28 +431,45 @@ void* calloc(size_t nmemb, size_t size)
 
 void* realloc(void *ptr, size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
-    del_ptr(ptr);
+    if (is_tmpbuf_ptr(ptr))
+    {
+        // Allocated before the hooks were set, the size is unknown so we
+        // copy as much as there is left in the buffer
+        void *new_ptr = malloc(size);
+        size_t available = tmpbuf + sizeof(tmpbuf) - (char *)ptr;
+        memcpy(new_ptr, ptr, size < available ? size : available);
+        return new_ptr;
+    }
+
+    // The entry is removed before the call, because once realloc has
+    // moved the block another thread may get the old address from malloc
+    // and add it to the table. If the call fails the old block is still
+    // there, so its entry is added back.
+    long long old_size = del_ptr(ptr);
     void *new_ptr = real_realloc(ptr, size);
-    add_ptr(new_ptr, size);
+    if (new_ptr)
+        add_ptr(new_ptr, size);
+    else if (size > 0 && old_size >= 0)
+        add_ptr(ptr, (size_t)old_size);
     return new_ptr;
 }
 
 void free(void *ptr)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
-    if (del_ptr(ptr) == 0)
-        real_free(ptr);
+    if (!ptr || is_tmpbuf_ptr(ptr))
+        return;
+
+    del_ptr(ptr);
+    real_free(ptr);
 }
 
 void* memalign(size_t alignment, size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
     void *new_ptr = real_memalign(alignment, size);
     add_ptr(new_ptr, size);
@@ -315,27 +478,26 @@ void* memalign(size_t alignment, size_t size)
 
 int posix_memalign(void** memptr, size_t alignment, size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
     int ret = real_posix_memalign(memptr, alignment, size);
-    add_ptr(*memptr, size);
+    if (ret == 0)
+        add_ptr(*memptr, size);
     return ret;
 }
 
 void* valloc(size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
-    _printf("valloc not implemented: %zu\n", size);
-    return real_valloc(size);
+    void *new_ptr = real_valloc(size);
+    add_ptr(new_ptr, size);
+    return new_ptr;
 }
 
 void* aligned_alloc(size_t alignment, size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
     void *new_ptr = real_aligned_alloc(alignment, size);
     add_ptr(new_ptr, size);
@@ -344,18 +506,18 @@ void* aligned_alloc(size_t alignment, size_t size)
 
 size_t malloc_usable_size(void *ptr)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
-    _printf("malloc_usable_size not implemented\n");
+    if (is_tmpbuf_ptr(ptr))
+        return 0;
     return real_malloc_usable_size(ptr);
 }
 
 void* pvalloc(size_t size)
 {
-    if (!malloc_initialized)
-        hookfns();
+    INITIALIZE_HOOKS;
 
-    _printf("pvalloc not implemented: %zu\n", size);
-    return real_pvalloc(size);
+    void *new_ptr = real_pvalloc(size);
+    add_ptr(new_ptr, size);
+    return new_ptr;
 }
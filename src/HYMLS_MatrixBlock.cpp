@@ -15,6 +15,9 @@
 #include "HYMLS_HierarchicalMap.hpp"
 #include "HYMLS_SparseDirectSolver.hpp"
 #include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_CoreLending.hpp"
+#include "HYMLS_ImportRegistry.hpp"
+#include "HYMLS_MpiProgress.hpp"
 
 #include "Ifpack_DenseContainer.h"
 #include "Ifpack_Amesos.h"
@@ -22,10 +25,6 @@
 #undef HAVE_MPI
 #include "Ifpack_SparseContainer.h"
 
-#ifdef HYMLS_USE_MKL
-#include <mkl.h>
-#endif
-
 namespace HYMLS {
 
 MatrixBlock::MatrixBlock(
@@ -50,25 +49,6 @@ MatrixBlock::MatrixBlock(
 
   Teuchos::RCP<const HierarchicalMap> colObject = hid_->Spawn(colStrategy);
   domainMap_ = colObject->GetMap();
-
-  /*
-  int active_ranks=HYMLS::ProcTopo->getNumActive(myLevel_);
-  if (active_ranks==comm_->NumProc())
-    {
-    Tools::out() << "ALL MPI RANKS ACTIVE"<<std::endl;
-    }
-  else
-    {
-    Tools::out() << "NUMBER OF ACTIVE RANKS: "<<active_ranks<<std::endl;
-    }
-  */
-  /*
-  int ranks_on_node=HYMLS::ProcTopo->numActiveProcsOnNode(myLevel_);
-  int total_ranks_on_node=HYMLS::ProcTopo->numActiveProcsOnNode(0);
-  // figure out how many threads we can use here
-  numThreadsSD_=std::max(1,(int)(total_ranks_on_node/ranks_on_node));
-  */
-
   }
 
 int MatrixBlock::Compute(Teuchos::RCP<const Epetra_CrsMatrix> matrix,
@@ -80,7 +60,7 @@ int MatrixBlock::Compute(Teuchos::RCP<const Epetra_CrsMatrix> matrix,
   if (colMap_ == Teuchos::null)
     colMap_ = MatrixUtils::CreateColMap(*extendedMatrix, *domainMap_, *domainMap_);
   if (import_ == Teuchos::null)
-    import_ = Teuchos::rcp(new Epetra_Import(*rowMap_, matrix->RowMap()));
+    import_ = ImportRegistry::GetImport(*rowMap_, matrix->RowMap());
 
   if (block_ != Teuchos::null)
     {
@@ -97,6 +77,83 @@ int MatrixBlock::Compute(Teuchos::RCP<const Epetra_CrsMatrix> matrix,
     CHECK_ZERO(block_->FillComplete(*domainMap_, *rangeMap_));
     }
 
+  return ComputeSubBlocks(extendedMatrix);
+  }
+
+int MatrixBlock::ComputeLocal(const Epetra_Map &map,
+  Teuchos::RCP<const Epetra_CrsMatrix> extendedMatrix)
+  {
+  HYMLS_LPROF(label_, "ComputeLocal");
+
+  if (colMap_ == Teuchos::null)
+    colMap_ = MatrixUtils::CreateColMap(*extendedMatrix, *domainMap_, *domainMap_);
+  if (import_ == Teuchos::null)
+    import_ = ImportRegistry::GetImport(*rowMap_, map);
+
+  if (block_ != Teuchos::null)
+    {
+    CHECK_ZERO(block_->PutScalar(0.0));
+    }
+  else
+    {
+    int MaxNumEntriesPerRow = extendedMatrix->MaxNumEntries();
+    block_ = Teuchos::rcp(new Epetra_CrsMatrix(Copy, *rowMap_,
+        *colMap_, MaxNumEntriesPerRow));
+    }
+
+  // copy the rows, leaving out the columns that are not in the block
+  const Epetra_Map &extendedRowMap = extendedMatrix->RowMap();
+  const Epetra_Map &extendedColMap = extendedMatrix->ColMap();
+  int maxLen = extendedMatrix->MaxNumEntries();
+  Teuchos::Array<int> blockIndices(maxLen);
+  Teuchos::Array<double> blockValues(maxLen);
+  for (int i = 0; i < block_->NumMyRows(); i++)
+    {
+    hymls_gidx gid = block_->GRID64(i);
+    int lid = extendedRowMap.LID(gid);
+    if (lid < 0)
+      Tools::Error("row " + Teuchos::toString(gid) +
+        " is not in the overlapping matrix", __FILE__, __LINE__);
+
+    int len;
+    int *indices;
+    double *values;
+    CHECK_ZERO(extendedMatrix->ExtractMyRowView(lid, len, values, indices));
+
+    int blockLen = 0;
+    for (int j = 0; j < len; j++)
+      {
+      int lcid = block_->LCID(extendedColMap.GID64(indices[j]));
+      if (lcid >= 0)
+        {
+        blockIndices[blockLen] = lcid;
+        blockValues[blockLen] = values[j];
+        blockLen++;
+        }
+      }
+
+    if (block_->Filled())
+      {
+      CHECK_NONNEG(block_->ReplaceMyValues(i, blockLen,
+          blockValues.getRawPtr(), blockIndices.getRawPtr()));
+      }
+    else
+      {
+      CHECK_ZERO(block_->InsertMyValues(i, blockLen,
+          blockValues.getRawPtr(), blockIndices.getRawPtr()));
+      }
+    }
+
+  if (!block_->Filled())
+    CHECK_ZERO(block_->FillComplete(*domainMap_, *rangeMap_));
+
+  return ComputeSubBlocks(extendedMatrix);
+  }
+
+int MatrixBlock::ComputeSubBlocks(Teuchos::RCP<const Epetra_CrsMatrix> extendedMatrix)
+  {
+  HYMLS_LPROF3(label_, "ComputeSubBlocks");
+
   if (subBlocks_.size())
     {
     for (int sd = 0; sd < hid_->NumMySubdomains(); sd++)
@@ -242,6 +299,7 @@ int MatrixBlock::ComputeSubdomainSolvers(Teuchos::RCP<const Epetra_CrsMatrix> ex
           }
 
         CHECK_ZERO(subdomainSolvers_[sd]->Compute(*extendedMatrix));
+        MpiProgress::Poke();
 
 #ifdef HYMLS_TESTING
         } TEUCHOS_STANDARD_CATCH_STATEMENTS(true, std::cerr, status);
@@ -318,18 +376,10 @@ int MatrixBlock::ApplyInverse(const Epetra_MultiVector& B, Epetra_MultiVector& X
 
   HYMLS_LPROF3(label_, "ApplyInverse");
 
-  // Force threading for the subdomain solvers when possible
-  if (numThreads_ > 0)
-    {
-    //TODO - get #threads dynamically from processor topology
-    //      (see ProcTopo sketch above)
-#ifdef HYMLS_USE_MKL
-    mkl_set_num_threads(numThreads_);
-#endif
-#ifdef HYMLS_USE_OPENMP
-    omp_set_num_threads(numThreads_);
-#endif
-    }
+  // Force threading for the subdomain solvers when possible. The number
+  // of threads may include the cores of idle processes on this node (see
+  // CoreLending), so it is reset when we are done.
+  ThreadGuard threads(numThreads_);
 
   // assume that all block solvers have the same number of vectors...
   if (subdomainSolvers_.size() > 0)
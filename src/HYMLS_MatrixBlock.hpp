@@ -49,6 +49,14 @@ public:
   int Compute(Teuchos::RCP<const Epetra_CrsMatrix> matrix,
   Teuchos::RCP<const Epetra_CrsMatrix> extendedMatrix);
 
+  //! Compute the actual block from the rows of the extendedMatrix on
+  //! this process only, without communication. All rows of the block
+  //! have to be present in the extendedMatrix. The map is the
+  //! distribution of the vectors the blocks are applied to, which is
+  //! needed for the Importer().
+  int ComputeLocal(const Epetra_Map &map,
+  Teuchos::RCP<const Epetra_CrsMatrix> extendedMatrix);
+
   //! Initialize the subdomain solvers for the A11 block
   int InitializeSubdomainSolvers(std::string const &solverType,
   Teuchos::RCP<Teuchos::ParameterList>, int numThreads);
@@ -134,7 +142,7 @@ protected:
   Teuchos::RCP<const Epetra_Map> colMap_;
 
   //! Importer for the block
-  Teuchos::RCP<Epetra_Import> import_;
+  Teuchos::RCP<const Epetra_Import> import_;
 
   //! The actual block
   Teuchos::RCP<Epetra_CrsMatrix> block_;
@@ -165,6 +173,9 @@ protected:
 
   //! Level only used for debugging and timing
   int myLevel_;
+
+  //! Extract the subdomain blocks from the extendedMatrix
+  int ComputeSubBlocks(Teuchos::RCP<const Epetra_CrsMatrix> extendedMatrix);
   };
   }
 
@@ -36,6 +36,7 @@ extern "C" void phist_Dmvec_random(void* v, int* iflag);
 #endif
 
 #include "HYMLS_Tools.hpp"
+#include "HYMLS_DumpWriter.hpp"
 
 #include "Teuchos_StandardCatchMacros.hpp"
 #ifdef HAVE_HDF5
@@ -576,6 +577,10 @@ void MatrixUtils::Dump(const Epetra_CrsMatrix& A, const std::string& filename,
       {
       CHECK_ZERO(EpetraExt::RowMatrixToMatrixMarketFile(filename.c_str(), A));
       }
+    else if (how == BINARY)
+      {
+      DumpWriter::Write(A, filename);
+      }
     else if (how == GATHER)
       {
       Teuchos::RCP<std::ostream> ofs = Teuchos::rcp(new Teuchos::oblackholestream());
@@ -645,6 +650,10 @@ void MatrixUtils::Dump(const Epetra_MultiVector& x, const std::string& filename,
       {
       EpetraExt::MultiVectorToMatrixMarketFile(filename.c_str(), x);
       }
+    else if (how == BINARY)
+      {
+      DumpWriter::Write(x, filename);
+      }
     else if (how == GATHER)
       {
       Teuchos::RCP<std::ostream> ofs = Teuchos::rcp(new Teuchos::oblackholestream());
@@ -26,6 +26,14 @@
 #define REINDEX_BY_DEFAULT false
 #endif
 
+// binary dumps are written in the background and are much cheaper
+// than text files, use hymls_dump2mtx to convert them:
+#ifdef HYMLS_BINARY_DUMPS
+#define PRINT_METHOD_BY_DEFAULT BINARY
+#else
+#define PRINT_METHOD_BY_DEFAULT MATRIXMARKET
+#endif
+
 class Epetra_BlockMap;
 class Epetra_Operator;
 class Epetra_Map;
@@ -67,7 +75,8 @@ class MatrixUtils
   typedef enum {
   MATRIXMARKET, // use EpetraExt ToMatrixMarketFile functions (fails for overlapping objects)
   GATHER,       // collect to root and dump in ascii file (may require lots of memory on one proc)
-  HDF5          // not implemented, probably the best thing to do as it is portable
+  HDF5,         // not implemented, probably the best thing to do as it is portable
+  BINARY        // local binary file per proc written in the background (see DumpWriter)
   } PrintMethod;
 
     //! create an optimal column map for extracting A(rowMap,colMap), given a distributed
@@ -125,7 +134,7 @@ class MatrixUtils
     //! read into MATLAB etc., but this is only meant for debugging etc.)
     static void Dump(const Epetra_CrsMatrix& A, const std::string& filename,
            bool reindex=REINDEX_BY_DEFAULT,
-           PrintMethod how=MATRIXMARKET);
+           PrintMethod how=PRINT_METHOD_BY_DEFAULT);
     
     //! dump CrsMatrix in binary file (HDF5 format), which is parallel,   
     //! space efficient and preserves the data distribution. If the code  
@@ -142,7 +151,7 @@ class MatrixUtils
     //! read into MATLAB etc., but this is only meant for debugging etc.)
     static void Dump(const Epetra_MultiVector& x, const std::string& filename, bool 
         reindex=REINDEX_BY_DEFAULT,
-        PrintMethod how=MATRIXMARKET);
+        PrintMethod how=PRINT_METHOD_BY_DEFAULT);
 
     //! dump Vector to file (the vector is gathered so it can be easily
     //! read into MATLAB etc., but this is only meant for debugging etc.)
@@ -0,0 +1,61 @@
+#include "HYMLS_MpiProgress.hpp"
+
+#include "HYMLS_config.h"
+
+#include <mpi.h>
+
+#include <atomic>
+#include <limits>
+
+#ifdef HYMLS_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace HYMLS
+  {
+
+namespace
+  {
+thread_local double progressInterval = -1.0;
+thread_local double lastPoke = 0.0;
+std::atomic<long long> numPokes(0);
+  }
+
+void MpiProgress::SetInterval(double seconds)
+  {
+  progressInterval = seconds;
+  lastPoke = -std::numeric_limits<double>::infinity();
+  }
+
+double MpiProgress::Interval()
+  {
+  return progressInterval;
+  }
+
+void MpiProgress::Poke()
+  {
+  if (progressInterval < 0.0)
+    return;
+
+#ifdef HYMLS_USE_OPENMP
+  if (omp_get_thread_num() != 0)
+    return;
+#endif
+
+  double now = MPI_Wtime();
+  if (now - lastPoke < progressInterval)
+    return;
+
+  int flag;
+  MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+
+  lastPoke = now;
+  numPokes++;
+  }
+
+long long MpiProgress::NumPokes()
+  {
+  return numPokes;
+  }
+
+  }
@@ -0,0 +1,47 @@
+#ifndef HYMLS_MPI_PROGRESS_H
+#define HYMLS_MPI_PROGRESS_H
+
+#include "HYMLS_config.h"
+
+namespace HYMLS {
+
+/*! Many MPI libraries only advance nonblocking messages (for instance the
+  rendezvous protocol of large messages) when the process calls into MPI.
+  During long local phases, such as the factorization of the subdomain
+  matrices, messages that other processes posted therefore wait until the
+  phase is over. Poke() can be called from such loops. It calls
+  MPI_Iprobe, which lets the library make progress, at most once every
+  Interval() seconds.
+
+  The interval is set by the "MPI Progress Interval" parameter of the
+  preconditioner at the start of its Compute(). A negative interval
+  disables it, which is the default. The interval and the time of the
+  last call are kept per thread, so a preconditioner that is computed in
+  another thread does not interfere. Only the master thread of an OpenMP
+  team calls into MPI, so Poke() may also be used in OpenMP parallel
+  regions if MPI was initialized with at least MPI_THREAD_FUNNELED.
+*/
+class MpiProgress
+  {
+public:
+
+  //! set the minimum time in seconds between two calls into MPI for
+  //! the calling thread. A negative value disables Poke(). The next
+  //! Poke() always calls into MPI.
+  static void SetInterval(double seconds);
+
+  //! minimum time in seconds between two calls into MPI for the calling
+  //! thread
+  static double Interval();
+
+  //! let MPI make progress if more than Interval() seconds have passed
+  //! since the last time
+  static void Poke();
+
+  //! number of times Poke() called into MPI in all threads
+  static long long NumPokes();
+  };
+
+  }
+
+#endif
@@ -0,0 +1,323 @@
+#include "HYMLS_NodeGather.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_HyperCube.hpp"
+
+#include "Epetra_MpiComm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+
+namespace HYMLS
+  {
+
+NodeGather::NodeGather(const Epetra_BlockMap &map)
+  :
+  label_("NodeGather"),
+  comm_(MPI_COMM_NULL),
+  nodeComm_(MPI_COMM_NULL),
+  myPID_(map.Comm().MyPID()),
+  isLeader_(false),
+  myLength_(map.NumMyElements()),
+  nodeLength_(0),
+  numVectors_(0)
+  {
+  HYMLS_PROF2(label_, "Constructor");
+
+  const Epetra_MpiComm *mpiComm = dynamic_cast<const Epetra_MpiComm *>(&map.Comm());
+  if (mpiComm == NULL)
+    {
+    Tools::Error("NodeGather requires an Epetra_MpiComm", __FILE__, __LINE__);
+    }
+
+  // use our own communicator so our messages can not be confused with
+  // those of Epetra
+  CHECK_ZERO(MPI_Comm_dup(mpiComm->Comm(), &comm_));
+
+  topology_ = Teuchos::rcp(new HyperCube(Teuchos::rcp(new Epetra_MpiComm(comm_))));
+  nodeComm_ = topology_->NodeComm();
+
+  int nodeRank, nodeSize;
+  CHECK_ZERO(MPI_Comm_rank(nodeComm_, &nodeRank));
+  CHECK_ZERO(MPI_Comm_size(nodeComm_, &nodeSize));
+  isLeader_ = nodeRank == 0;
+
+  Teuchos::Array<long long> myGIDs(myLength_);
+  for (int i = 0; i < myLength_; i++)
+    myGIDs[i] = map.GID64(i);
+
+  // first stage: collect the lengths and GIDs of this node on the leader
+  Teuchos::Array<int> nodeOffsets;
+  Teuchos::Array<long long> nodeGIDs;
+  if (isLeader_)
+    {
+    nodeLengths_.resize(nodeSize);
+    nodeOffsets.resize(nodeSize);
+    }
+  CHECK_ZERO(MPI_Gather(&myLength_, 1, MPI_INT,
+      nodeLengths_.getRawPtr(), 1, MPI_INT, 0, nodeComm_));
+  if (isLeader_)
+    {
+    for (int m = 0; m < nodeSize; m++)
+      {
+      nodeOffsets[m] = nodeLength_;
+      nodeLength_ += nodeLengths_[m];
+      }
+    nodeGIDs.resize(nodeLength_);
+    }
+  CHECK_ZERO(MPI_Gatherv(myGIDs.getRawPtr(), myLength_, MPI_LONG_LONG,
+      nodeGIDs.getRawPtr(), nodeLengths_.getRawPtr(), nodeOffsets.getRawPtr(),
+      MPI_LONG_LONG, 0, nodeComm_));
+
+  // second stage: tell process 0 who the leaders are
+  int numProc;
+  CHECK_ZERO(MPI_Comm_size(comm_, &numProc));
+  int myInfo[2] = {isLeader_ ? nodeLength_ : -1, isLeader_ ? nodeSize : 0};
+  Teuchos::Array<int> info(myPID_ == 0 ? 2 * numProc : 0);
+  CHECK_ZERO(MPI_Gather(myInfo, 2, MPI_INT, info.getRawPtr(), 2, MPI_INT, 0, comm_));
+
+  Teuchos::Array<long long> allGIDs;
+  if (myPID_ == 0)
+    {
+    segmentLengths_ = nodeLengths_;
+    allGIDs = nodeGIDs;
+    for (int p = 1; p < numProc; p++)
+      {
+      if (info[2 * p] < 0)
+        continue;
+
+      leaderPIDs_.append(p);
+      leaderLengths_.append(info[2 * p]);
+
+      Teuchos::Array<int> lengths(info[2 * p + 1]);
+      Teuchos::Array<long long> gids(info[2 * p]);
+      CHECK_ZERO(MPI_Recv(lengths.getRawPtr(), lengths.size(), MPI_INT,
+          p, 0, comm_, MPI_STATUS_IGNORE));
+      CHECK_ZERO(MPI_Recv(gids.getRawPtr(), gids.size(), MPI_LONG_LONG,
+          p, 1, comm_, MPI_STATUS_IGNORE));
+      segmentLengths_.insert(segmentLengths_.end(), lengths.begin(), lengths.end());
+      allGIDs.insert(allGIDs.end(), gids.begin(), gids.end());
+      }
+    }
+  else if (isLeader_)
+    {
+    CHECK_ZERO(MPI_Send(nodeLengths_.getRawPtr(), nodeSize, MPI_INT,
+        0, 0, comm_));
+    CHECK_ZERO(MPI_Send(nodeGIDs.getRawPtr(), nodeLength_, MPI_LONG_LONG,
+        0, 1, comm_));
+    }
+
+  // the GIDs on process 0 are sorted, so a linear map stays linear
+  Teuchos::Array<hymls_gidx> rootGIDs(allGIDs.size());
+  for (int i = 0; i < allGIDs.size(); i++)
+    rootGIDs[i] = (hymls_gidx)allGIDs[i];
+  std::sort(rootGIDs.begin(), rootGIDs.end());
+
+  rootMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, rootGIDs.size(),
+      rootGIDs.getRawPtr(), (hymls_gidx)map.IndexBase64(), map.Comm()));
+
+  rootLIDs_.resize(allGIDs.size());
+  for (int i = 0; i < allGIDs.size(); i++)
+    rootLIDs_[i] = rootMap_->LID((hymls_gidx)allGIDs[i]);
+  }
+
+NodeGather::~NodeGather()
+  {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (finalized)
+    return;
+
+  FreeRequests();
+  topology_ = Teuchos::null;
+  MPI_Comm_free(&comm_);
+  }
+
+int NodeGather::NumNodes() const
+  {
+  return topology_->NumNodes();
+  }
+
+void NodeGather::FreeRequests() const
+  {
+  for (int i = 0; i < nodeGatherRequests_.size(); i++)
+    MPI_Request_free(&nodeGatherRequests_[i]);
+  for (int i = 0; i < leaderGatherRequests_.size(); i++)
+    MPI_Request_free(&leaderGatherRequests_[i]);
+  for (int i = 0; i < leaderScatterRequests_.size(); i++)
+    MPI_Request_free(&leaderScatterRequests_[i]);
+  for (int i = 0; i < nodeScatterRequests_.size(); i++)
+    MPI_Request_free(&nodeScatterRequests_[i]);
+
+  nodeGatherRequests_.resize(0);
+  leaderGatherRequests_.resize(0);
+  leaderScatterRequests_.resize(0);
+  nodeScatterRequests_.resize(0);
+  numVectors_ = 0;
+  }
+
+int NodeGather::CreateRequests(int numVectors) const
+  {
+  HYMLS_PROF3(label_, "CreateRequests");
+
+  FreeRequests();
+  numVectors_ = numVectors;
+
+  // The buffer contains a segment for every process of which we
+  // receive the entries, each of which is stored by vector
+  int length = myLength_;
+  if (myPID_ == 0)
+    length = rootLIDs_.size();
+  else if (isLeader_)
+    length = nodeLength_;
+  buffer_.resize(length * numVectors);
+  double *buffer = buffer_.getRawPtr();
+
+  MPI_Request request;
+  if (!isLeader_)
+    {
+    CHECK_ZERO(MPI_Send_init(buffer, myLength_ * numVectors, MPI_DOUBLE,
+        0, 0, nodeComm_, &request));
+    nodeGatherRequests_.append(request);
+    CHECK_ZERO(MPI_Recv_init(buffer, myLength_ * numVectors, MPI_DOUBLE,
+        0, 1, nodeComm_, &request));
+    nodeScatterRequests_.append(request);
+    return 0;
+    }
+
+  int offset = nodeLengths_[0] * numVectors;
+  for (int m = 1; m < nodeLengths_.size(); m++)
+    {
+    int count = nodeLengths_[m] * numVectors;
+    CHECK_ZERO(MPI_Recv_init(buffer + offset, count, MPI_DOUBLE,
+        m, 0, nodeComm_, &request));
+    nodeGatherRequests_.append(request);
+    CHECK_ZERO(MPI_Send_init(buffer + offset, count, MPI_DOUBLE,
+        m, 1, nodeComm_, &request));
+    nodeScatterRequests_.append(request);
+    offset += count;
+    }
+
+  if (myPID_ != 0)
+    {
+    CHECK_ZERO(MPI_Send_init(buffer, nodeLength_ * numVectors, MPI_DOUBLE,
+        0, 2, comm_, &request));
+    leaderGatherRequests_.append(request);
+    CHECK_ZERO(MPI_Recv_init(buffer, nodeLength_ * numVectors, MPI_DOUBLE,
+        0, 3, comm_, &request));
+    leaderScatterRequests_.append(request);
+    return 0;
+    }
+
+  for (int l = 0; l < leaderPIDs_.size(); l++)
+    {
+    int count = leaderLengths_[l] * numVectors;
+    CHECK_ZERO(MPI_Recv_init(buffer + offset, count, MPI_DOUBLE,
+        leaderPIDs_[l], 2, comm_, &request));
+    leaderGatherRequests_.append(request);
+    CHECK_ZERO(MPI_Send_init(buffer + offset, count, MPI_DOUBLE,
+        leaderPIDs_[l], 3, comm_, &request));
+    leaderScatterRequests_.append(request);
+    offset += count;
+    }
+  return 0;
+  }
+
+int NodeGather::Gather(const Epetra_MultiVector &source,
+  Epetra_MultiVector &target) const
+  {
+  HYMLS_PROF3(label_, "Gather");
+
+  int numVectors = source.NumVectors();
+  if (source.MyLength() != myLength_ || target.NumVectors() != numVectors)
+    {
+    Tools::Error("incompatible vectors", __FILE__, __LINE__);
+    }
+
+  if (numVectors != numVectors_)
+    CHECK_ZERO(CreateRequests(numVectors));
+
+  double *buffer = buffer_.getRawPtr();
+  for (int k = 0; k < numVectors; k++)
+    for (int i = 0; i < myLength_; i++)
+      buffer[k * myLength_ + i] = source[k][i];
+
+  CHECK_ZERO(MPI_Startall(nodeGatherRequests_.size(), nodeGatherRequests_.getRawPtr()));
+  CHECK_ZERO(MPI_Waitall(nodeGatherRequests_.size(), nodeGatherRequests_.getRawPtr(),
+      MPI_STATUSES_IGNORE));
+
+  if (!isLeader_)
+    return 0;
+
+  CHECK_ZERO(MPI_Startall(leaderGatherRequests_.size(), leaderGatherRequests_.getRawPtr()));
+  CHECK_ZERO(MPI_Waitall(leaderGatherRequests_.size(), leaderGatherRequests_.getRawPtr(),
+      MPI_STATUSES_IGNORE));
+
+  if (myPID_ != 0)
+    return 0;
+
+  int pos = 0;
+  for (int s = 0; s < segmentLengths_.size(); s++)
+    {
+    int length = segmentLengths_[s];
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < length; i++)
+        target[k][rootLIDs_[pos + i]] = buffer[pos * numVectors + k * length + i];
+    pos += length;
+    }
+  return 0;
+  }
+
+int NodeGather::Scatter(const Epetra_MultiVector &source,
+  Epetra_MultiVector &target) const
+  {
+  HYMLS_PROF3(label_, "Scatter");
+
+  int numVectors = source.NumVectors();
+  if (target.MyLength() != myLength_ || target.NumVectors() != numVectors)
+    {
+    Tools::Error("incompatible vectors", __FILE__, __LINE__);
+    }
+
+  if (numVectors != numVectors_)
+    CHECK_ZERO(CreateRequests(numVectors));
+
+  double *buffer = buffer_.getRawPtr();
+  if (myPID_ == 0)
+    {
+    int pos = 0;
+    for (int s = 0; s < segmentLengths_.size(); s++)
+      {
+      int length = segmentLengths_[s];
+      for (int k = 0; k < numVectors; k++)
+        for (int i = 0; i < length; i++)
+          buffer[pos * numVectors + k * length + i] = source[k][rootLIDs_[pos + i]];
+      pos += length;
+      }
+    }
+
+  CHECK_ZERO(MPI_Startall(leaderScatterRequests_.size(), leaderScatterRequests_.getRawPtr()));
+  CHECK_ZERO(MPI_Waitall(leaderScatterRequests_.size(), leaderScatterRequests_.getRawPtr(),
+      MPI_STATUSES_IGNORE));
+
+  CHECK_ZERO(MPI_Startall(nodeScatterRequests_.size(), nodeScatterRequests_.getRawPtr()));
+  CHECK_ZERO(MPI_Waitall(nodeScatterRequests_.size(), nodeScatterRequests_.getRawPtr(),
+      MPI_STATUSES_IGNORE));
+
+  for (int k = 0; k < numVectors; k++)
+    for (int i = 0; i < myLength_; i++)
+      target[k][i] = buffer[k * myLength_ + i];
+  return 0;
+  }
+
+  }
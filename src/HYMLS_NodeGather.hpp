@@ -0,0 +1,127 @@
+#ifndef HYMLS_NODE_GATHER_H
+#define HYMLS_NODE_GATHER_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <mpi.h>
+
+#include <string>
+
+// forward declarations
+class Epetra_BlockMap;
+class Epetra_Map;
+class Epetra_MultiVector;
+
+namespace HYMLS {
+
+class HyperCube;
+
+/*! Gathers the entries of a distributed vector on process 0 and scatters
+  them back in two stages, instead of letting every process send its part
+  to process 0 directly.
+
+  In the first stage, every process sends its entries to the leader of its
+  compute node (the process on that node with the lowest rank). In the
+  second stage, the node leaders send the entries of their node to
+  process 0. The scatter does the same in reverse. The messages are sent
+  with persistent MPI requests, which are created once for every number of
+  vectors and reused for every Gather() and Scatter().
+
+  The compute nodes are determined by a HyperCube on the communicator of
+  the map. The map must be a one-to-one map on an Epetra_MpiComm.
+*/
+class NodeGather
+  {
+public:
+
+  //! Constructor. Collective on the communicator of the map.
+  NodeGather(const Epetra_BlockMap &map);
+
+  //! destructor
+  virtual ~NodeGather();
+
+  //! map with the same GIDs as the original map, which are all owned by
+  //! process 0
+  const Epetra_Map &RootMap() const {return *rootMap_;}
+
+  //! Copy the entries of source, which has the original map, into target,
+  //! which has the RootMap(). Collective.
+  int Gather(const Epetra_MultiVector &source, Epetra_MultiVector &target) const;
+
+  //! Copy the entries of source, which has the RootMap(), into target,
+  //! which has the original map. Collective.
+  int Scatter(const Epetra_MultiVector &source, Epetra_MultiVector &target) const;
+
+  //! true if this process sends the entries of its node to process 0
+  bool IsLeader() const {return isLeader_;}
+
+  //! number of compute nodes
+  int NumNodes() const;
+
+protected:
+
+  //! create the persistent requests for numVectors vectors
+  int CreateRequests(int numVectors) const;
+
+  //! free the persistent requests
+  void FreeRequests() const;
+
+  //! label
+  std::string label_;
+
+  //! node topology, this also owns the node communicator
+  Teuchos::RCP<HyperCube> topology_;
+
+  //! communicator of the map
+  MPI_Comm comm_;
+
+  //! communicator with the processes on this node
+  MPI_Comm nodeComm_;
+
+  //! rank in comm_
+  int myPID_;
+
+  //! true if this process is rank 0 on nodeComm_
+  bool isLeader_;
+
+  //! number of local entries
+  int myLength_;
+
+  //! number of entries of every process on this node (leader only)
+  Teuchos::Array<int> nodeLengths_;
+
+  //! number of entries on this node (leader only)
+  int nodeLength_;
+
+  //! ranks and number of entries of the other node leaders (process 0 only)
+  Teuchos::Array<int> leaderPIDs_, leaderLengths_;
+
+  //! number of entries of every process in the order in which they
+  //! are received (process 0 only)
+  Teuchos::Array<int> segmentLengths_;
+
+  //! LID in rootMap_ of every received entry (process 0 only)
+  Teuchos::Array<int> rootLIDs_;
+
+  //! map with all entries on process 0
+  Teuchos::RCP<Epetra_Map> rootMap_;
+
+  //! number of vectors the requests were created for, 0 if there are none
+  mutable int numVectors_;
+
+  //! buffer with the entries of this node (of all nodes on process 0)
+  mutable Teuchos::Array<double> buffer_;
+
+  //! persistent requests for the first and second stage of the gather
+  mutable Teuchos::Array<MPI_Request> nodeGatherRequests_, leaderGatherRequests_;
+
+  //! persistent requests for the first and second stage of the scatter
+  mutable Teuchos::Array<MPI_Request> leaderScatterRequests_, nodeScatterRequests_;
+  };
+
+  }
+
+#endif
@@ -10,14 +10,23 @@
 #include "HYMLS_SeparatorGroup.hpp"
 #include "HYMLS_CartesianPartitioner.hpp"
 #include "HYMLS_SkewCartesianPartitioner.hpp"
+#include "HYMLS_GraphPartitioner.hpp"
+#include "HYMLS_CacheUtils.hpp"
+
+#include "Epetra_Map.h"
+#include "Epetra_CrsGraph.h"
+#include "Epetra_Export.h"
 
 #include "Teuchos_ParameterList.hpp"
 #include "Teuchos_Array.hpp"
 #include "Teuchos_toString.hpp"
+#include "Teuchos_XMLParameterListHelpers.hpp"
 
 #include <algorithm>
-
-class Epetra_Map;
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 namespace HYMLS {
 
@@ -31,16 +40,36 @@ namespace HYMLS {
 OverlappingPartitioner::OverlappingPartitioner(
   Teuchos::RCP<const Epetra_Map> map,
   Teuchos::RCP<Teuchos::ParameterList> params, int level,
-  Teuchos::RCP<const Epetra_Map> overlappingMap)
+  Teuchos::RCP<const Epetra_Map> overlappingMap,
+  Teuchos::RCP<const Epetra_CrsGraph> graph, bool repartition)
   :
   HierarchicalMap(map, overlappingMap, 0, "OverlappingPartitioner", level),
-  PLA("Problem")
+  PLA("Problem"), graph_(graph), repartition_(repartition),
+  loadedFromCache_(false)
   {
   HYMLS_PROF2(Label(),"Constructor");
 
   setParameterList(params);
 
-  Teuchos::RCP<const BasePartitioner> partitioner = Partition();
+  // This fills in the defaults of the partitioning parameters, so the
+  // cache key is the same whether or not this was done before
+  Teuchos::RCP<BasePartitioner> partitioner = CreatePartitioner();
+
+  // The partitioning is deterministic, so we can reuse the result of
+  // an earlier run with the same input
+  std::uint64_t cacheKey = 0;
+  if (!cachePrefix_.empty())
+    {
+    cacheKey = CacheKey();
+    if (LoadCache(cacheKey))
+      {
+      loadedFromCache_ = true;
+      HYMLS_DEBVAR(*this);
+      return;
+      }
+    }
+
+  CHECK_ZERO(partitioner->Partition(repartition_));
 
   // Set the parameters for the next level
   nextLevelParams_ = Teuchos::rcp(new Teuchos::ParameterList(*getMyParamList()));
@@ -73,6 +102,10 @@ OverlappingPartitioner::OverlappingPartitioner(
   Reset(partitioner->NumLocalParts());
 
   CHECK_ZERO(DetectSeparators(partitioner));
+
+  if (!cachePrefix_.empty())
+    CHECK_ZERO(SaveCache(cacheKey));
+
   HYMLS_DEBVAR(*this);
   return;
   }
@@ -91,11 +124,20 @@ void OverlappingPartitioner::setParameterList(
 
   partitioningMethod_ = PL("Preconditioner").get(
       "Partitioner", "Cartesian");
+  cachePrefix_ = PL("Preconditioner").get("Partition Cache", "");
   }
 
 Teuchos::RCP<const BasePartitioner> OverlappingPartitioner::Partition()
   {
   HYMLS_PROF2(Label(), "Partition");
+  Teuchos::RCP<BasePartitioner> partitioner = CreatePartitioner();
+  CHECK_ZERO(partitioner->Partition(repartition_));
+  return partitioner;
+  }
+
+Teuchos::RCP<BasePartitioner> OverlappingPartitioner::CreatePartitioner()
+  {
+  HYMLS_PROF3(Label(), "CreatePartitioner");
   Teuchos::RCP<BasePartitioner> partitioner = Teuchos::null;
   if (partitioningMethod_ == "Cartesian")
     {
@@ -107,14 +149,17 @@ Teuchos::RCP<const BasePartitioner> OverlappingPartitioner::Partition()
     partitioner = Teuchos::rcp(new
       SkewCartesianPartitioner(GetMap(), getMyNonconstParamList(), Comm(), myLevel_));
     }
+  else if (partitioningMethod_ == "Graph")
+    {
+    partitioner = Teuchos::rcp(new
+      GraphPartitioner(GetMap(), graph_, getMyNonconstParamList(), Comm(), myLevel_));
+    }
   else
     {
-    Tools::Error("Up to now we only support Cartesian partitioning",
+    Tools::Error("Up to now we only support Cartesian and graph partitioning",
       __FILE__, __LINE__);
     }
 
-  CHECK_ZERO(partitioner->Partition(false));
-
   return partitioner;
   }
 
@@ -152,11 +197,240 @@ Teuchos::RCP<const OverlappingPartitioner> OverlappingPartitioner::SpawnNextLeve
   {
   HYMLS_PROF2(Label(), "SpawnNextLevel");
 
+  Teuchos::RCP<const Epetra_CrsGraph> graph = Teuchos::null;
+  if (partitioningMethod_ == "Graph")
+    graph = CreateNextLevelGraph(map, overlappingMap);
+
+  // If the next level lives on fewer processes, it was agglomerated and
+  // its map does not follow our processor partitioning anymore
+  bool repartition = map->Comm().NumProc() != Comm().NumProc();
+
   Teuchos::RCP<const OverlappingPartitioner> newLevel;
   newLevel = Teuchos::rcp(new OverlappingPartitioner(
-      map, nextLevelParams_, Level()+1, overlappingMap));
+      map, nextLevelParams_, Level()+1, overlappingMap, graph, repartition));
   return newLevel;
   }
 
+Teuchos::RCP<const Epetra_CrsGraph> OverlappingPartitioner::CreateNextLevelGraph(
+  Teuchos::RCP<const Epetra_Map> map,
+  Teuchos::RCP<const Epetra_Map> overlappingMap) const
+  {
+  HYMLS_PROF3(Label(), "CreateNextLevelGraph");
+
+  if (overlappingMap == Teuchos::null)
+    overlappingMap = map;
+
+  // The retained nodes of the separators around a subdomain are coupled
+  // in the Schur complement, so they are coupled in the graph as well.
+  Epetra_CrsGraph overlappingGraph(Copy, *overlappingMap, 0);
+  for (int sd = 0; sd < NumMySubdomains(); sd++)
+    {
+    Teuchos::Array<hymls_gidx> gids;
+    for (SeparatorGroup const &group: GetSeparatorGroups(sd))
+      for (hymls_gidx gid: group.nodes())
+        if (overlappingMap->MyGID(gid))
+          gids.append(gid);
+
+    std::sort(gids.begin(), gids.end());
+    gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+
+    for (hymls_gidx gid: gids)
+      CHECK_NONNEG(overlappingGraph.InsertGlobalIndices(
+          gid, gids.size(), gids.getRawPtr()));
+    }
+  CHECK_ZERO(overlappingGraph.FillComplete(*map, *map));
+
+  Teuchos::RCP<Epetra_CrsGraph> graph = Teuchos::rcp(
+    new Epetra_CrsGraph(Copy, *map, 0));
+  Epetra_Export exporter(*overlappingMap, *map);
+  CHECK_ZERO(graph->Export(overlappingGraph, exporter, Insert));
+  CHECK_ZERO(graph->FillComplete());
+
+  return graph;
+  }
+
+namespace
+  {
+Teuchos::Array<hymls_gidx> MyGIDs(const Epetra_Map &map)
+  {
+  Teuchos::Array<hymls_gidx> gids(map.NumMyElements());
+  for (int lid = 0; lid < map.NumMyElements(); lid++)
+    gids[lid] = map.GID64(lid);
+  return gids;
+  }
+
+const char cacheMagic[8] = {'H', 'Y', 'M', 'L', 'S', 'P', 'C', '1'};
+  }
+
+std::uint64_t OverlappingPartitioner::CacheKey() const
+  {
+  HYMLS_PROF3(Label(), "CacheKey");
+
+  std::uint64_t hash = CacheUtils::HashSeed;
+
+  int level = Level();
+  int numProc = Comm().NumProc();
+  CacheUtils::HashBytes(hash, &level, sizeof(level));
+  CacheUtils::HashBytes(hash, &numProc, sizeof(numProc));
+
+  CacheUtils::HashMap(hash, *baseMap_);
+  if (baseOverlappingMap_ != Teuchos::null)
+    CacheUtils::HashMap(hash, *baseOverlappingMap_);
+
+  if (graph_ != Teuchos::null)
+    {
+    for (int i = 0; i < graph_->NumMyRows(); i++)
+      {
+      int len;
+      int *indices;
+      CHECK_ZERO(graph_->ExtractMyRowView(i, len, indices));
+      hymls_gidx row = graph_->RowMap().GID64(i);
+      CacheUtils::HashBytes(hash, &row, sizeof(row));
+      for (int j = 0; j < len; j++)
+        {
+        hymls_gidx col = graph_->ColMap().GID64(indices[j]);
+        CacheUtils::HashBytes(hash, &col, sizeof(col));
+        }
+      }
+    }
+
+  CacheUtils::HashParameters(hash, PL("Problem"));
+  CacheUtils::HashParameters(hash, PL("Preconditioner"),
+    CacheUtils::IsPartitioningParameter);
+
+  return hash;
+  }
+
+std::string OverlappingPartitioner::CacheFile() const
+  {
+  return CacheUtils::FileName(cachePrefix_, Level(), Comm());
+  }
+
+int OverlappingPartitioner::SaveCache(std::uint64_t key) const
+  {
+  HYMLS_PROF2(Label(), "SaveCache");
+
+  std::ofstream os(CacheFile().c_str(), std::ios::binary);
+  if (!os)
+    {
+    Tools::Warning("Could not write partition cache " + CacheFile(),
+      __FILE__, __LINE__);
+    return 0;
+    }
+
+  os.write(cacheMagic, sizeof(cacheMagic));
+  CacheUtils::Write(os, key);
+
+  CacheUtils::Write(os, MyGIDs(*baseMap_));
+  CacheUtils::Write(os, (int)(baseOverlappingMap_ != Teuchos::null));
+  if (baseOverlappingMap_ != Teuchos::null)
+    CacheUtils::Write(os, MyGIDs(*baseOverlappingMap_));
+
+  std::ostringstream params;
+  Teuchos::writeParameterListToXmlOStream(*nextLevelParams_, params);
+  std::string str = params.str();
+  CacheUtils::Write(os, Teuchos::Array<char>(str.begin(), str.end()));
+
+  CacheUtils::Write(os, NumMySubdomains());
+  for (int sd = 0; sd < NumMySubdomains(); sd++)
+    {
+    CacheUtils::Write(os, GetInteriorGroup(sd).nodes());
+    CacheUtils::Write(os, (int)GetSeparatorGroups(sd).size());
+    for (SeparatorGroup const &group: GetSeparatorGroups(sd))
+      {
+      CacheUtils::Write(os, group.type());
+      CacheUtils::Write(os, group.nodes());
+      }
+    }
+
+  if (!os)
+    {
+    Tools::Warning("Could not write partition cache " + CacheFile(),
+      __FILE__, __LINE__);
+    }
+  return 0;
+  }
+
+bool OverlappingPartitioner::LoadCache(std::uint64_t key)
+  {
+  HYMLS_PROF2(Label(), "LoadCache");
+
+  std::ifstream is(CacheFile().c_str(), std::ios::binary);
+
+  char magic[sizeof(cacheMagic)];
+  std::uint64_t fileKey = 0;
+  bool ok = is && is.read(magic, sizeof(magic)) &&
+    std::equal(magic, magic + sizeof(magic), cacheMagic) &&
+    CacheUtils::Read(is, fileKey) && fileKey == key;
+
+  Teuchos::Array<hymls_gidx> gids, overlappingGIDs;
+  int hasOverlappingMap = 0;
+  Teuchos::Array<char> xml;
+  int numMySubdomains = 0;
+  Teuchos::Array<InteriorGroup> interiorGroups;
+  Teuchos::Array<Teuchos::Array<SeparatorGroup> > separatorGroups;
+
+  ok = ok && CacheUtils::Read(is, gids) && CacheUtils::Read(is, hasOverlappingMap);
+  if (ok && hasOverlappingMap)
+    ok = CacheUtils::Read(is, overlappingGIDs);
+  ok = ok && CacheUtils::Read(is, xml) &&
+    CacheUtils::Read(is, numMySubdomains) && numMySubdomains >= 0;
+
+  if (ok)
+    {
+    interiorGroups.resize(numMySubdomains);
+    separatorGroups.resize(numMySubdomains);
+    }
+  for (int sd = 0; ok && sd < numMySubdomains; sd++)
+    {
+    // resize() copies one group, so we need new groups here to avoid
+    // sharing the nodes
+    InteriorGroup interior;
+    int numGroups = 0;
+    ok = CacheUtils::Read(is, interior.nodes()) && CacheUtils::Read(is, numGroups);
+    interiorGroups[sd] = interior;
+    for (int i = 0; ok && i < numGroups; i++)
+      {
+      SeparatorGroup group;
+      int type;
+      ok = CacheUtils::Read(is, type) && CacheUtils::Read(is, group.nodes());
+      group.set_type(type);
+      separatorGroups[sd].append(group);
+      }
+    }
+
+  // Only use the cache if it is valid on all processes
+  int myOk = ok ? 1 : 0;
+  int allOk = 0;
+  CHECK_ZERO(Comm().MinAll(&myOk, &allOk, 1));
+  if (!allOk)
+    return false;
+
+  Tools::Out("Read partitioning from cache " + cachePrefix_);
+
+  baseMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, gids.size(),
+      gids.getRawPtr(), (hymls_gidx)baseMap_->IndexBase64(), Comm()));
+  if (hasOverlappingMap)
+    {
+    baseOverlappingMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1,
+        overlappingGIDs.size(), overlappingGIDs.getRawPtr(),
+        (hymls_gidx)baseMap_->IndexBase64(), Comm()));
+    }
+
+  nextLevelParams_ = Teuchos::getParametersFromXmlString(
+    std::string(xml.begin(), xml.end()));
+
+  Reset(numMySubdomains);
+  for (int sd = 0; sd < numMySubdomains; sd++)
+    {
+    AddInteriorGroup(sd, interiorGroups[sd]);
+    for (SeparatorGroup const &group: separatorGroups[sd])
+      AddSeparatorGroup(sd, group);
+    }
+  CHECK_ZERO(FillComplete());
+
+  return true;
+  }
+
 }//namespace
 
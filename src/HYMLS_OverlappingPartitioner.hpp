@@ -9,6 +9,7 @@
 #include "Teuchos_RCP.hpp"
 
 #include <string>
+#include <cstdint>
 
 namespace Teuchos
   {
@@ -17,6 +18,7 @@ template <typename T> class Array;
   }
 
 class Epetra_Map;
+class Epetra_CrsGraph;
 
 namespace HYMLS {
 class BasePartitioner;
@@ -40,11 +42,17 @@ class OverlappingPartitioner: public HierarchicalMap,
 
 public:
 
-  //! constructor
+  //! constructor. The graph of the matrix is only needed by the
+  //! "Graph" partitioner. If repartition is true, the map is always
+  //! redistributed according to the processor partitioning, which is
+  //! needed if it was not created by the partitioner of the previous
+  //! level on the same communicator, e.g. after agglomeration.
   OverlappingPartitioner(
     Teuchos::RCP<const Epetra_Map> map,
     Teuchos::RCP<Teuchos::ParameterList> params, int level=1,
-    Teuchos::RCP<const Epetra_Map> overlappingMap=Teuchos::null);
+    Teuchos::RCP<const Epetra_Map> overlappingMap=Teuchos::null,
+    Teuchos::RCP<const Epetra_CrsGraph> graph=Teuchos::null,
+    bool repartition=false);
 
   //! destructor
   virtual ~OverlappingPartitioner();
@@ -52,6 +60,9 @@ public:
   //! Step 1: non-overlapping partitioning
   Teuchos::RCP<const BasePartitioner> Partition();
 
+  //! true if the partitioning was read from the partition cache
+  bool LoadedFromCache() const {return loadedFromCache_;}
+
   //! this class allows spawning a next level object for the variables
   //! retained in a reduced problem
   //! TODO: unclutter the BaseO.P., RecursiveO.P., and this class
@@ -76,14 +87,58 @@ protected:
 
 private:
 
+  //! create the partitioner, which also sets the default values of the
+  //! partitioning parameters in our parameter list
+  Teuchos::RCP<BasePartitioner> CreatePartitioner();
+
   //! Step 2: construct overlapping maps after partitioning
   //! the result is a HierarchicalMap with three groups per
   //! subdomain: interior, separator and retained.
   int DetectSeparators(Teuchos::RCP<const BasePartitioner> partitioner);
 
+  //! Graph of the next level for the "Graph" partitioner: all retained
+  //! nodes around a subdomain are coupled to each other.
+  Teuchos::RCP<const Epetra_CrsGraph> CreateNextLevelGraph(
+    Teuchos::RCP<const Epetra_Map> map,
+    Teuchos::RCP<const Epetra_Map> overlappingMap) const;
+
   int RemoveBoundarySeparators(Teuchos::Array<hymls_gidx> &interior_nodes,
     Teuchos::Array<Teuchos::Array<hymls_gidx> > &separator_nodes) const;
 
+  //! \name partition cache
+  //!@{
+
+  //! hash of everything the partitioning of this process depends on:
+  //! the maps, the graph, the level, the number of processes and the
+  //! parameters that are read by the partitioner. Other parameters
+  //! are not included since they may be changed by other classes.
+  std::uint64_t CacheKey() const;
+
+  //! name of the cache file of this process
+  std::string CacheFile() const;
+
+  //! Try to read the partitioning from the cache. Returns true if this
+  //! succeeded on all processes. Collective.
+  bool LoadCache(std::uint64_t key);
+
+  //! write the partitioning to the cache
+  int SaveCache(std::uint64_t key) const;
+
+  //!@}
+
+  //! graph of the matrix, used by the "Graph" partitioner
+  Teuchos::RCP<const Epetra_CrsGraph> graph_;
+
+  //! always redistribute the map in Partition()
+  bool repartition_;
+
+  //! prefix of the partition cache files, obtained from user parameter
+  //! "Partition Cache". The cache is disabled if this is empty.
+  std::string cachePrefix_;
+
+  //! the partitioning was read from the partition cache
+  bool loadedFromCache_;
+
   //! Parameterlist for the next level
   Teuchos::RCP<Teuchos::ParameterList> nextLevelParams_;
 
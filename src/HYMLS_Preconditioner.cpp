@@ -12,7 +12,15 @@
 #include "HYMLS_SchurComplement.hpp"
 #include "HYMLS_SchurPreconditioner.hpp"
 #include "HYMLS_MatrixBlock.hpp"
+#include "HYMLS_SharedMemoryImport.hpp"
+#include "HYMLS_CoreLending.hpp"
 #include "HYMLS_CoarseSolver.hpp"
+#include "HYMLS_ImportRegistry.hpp"
+#include "HYMLS_MpiProgress.hpp"
+#include "HYMLS_SubdomainAssembler.hpp"
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+#include "HYMLS_CacheUtils.hpp"
 
 #include "Epetra_Comm.h"
 #include "Epetra_SerialComm.h"
@@ -24,6 +32,7 @@
 #include "Epetra_MultiVector.h"
 #include "Epetra_Vector.h"
 #include "Epetra_CrsMatrix.h"
+#include "Epetra_CrsGraph.h"
 #include "Epetra_FECrsMatrix.h"
 
 #include "EpetraExt_MatrixMatrix.h"
@@ -34,11 +43,14 @@
 #include "HYMLS_Macros.hpp"
 
 #include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
 #include "Teuchos_ParameterList.hpp"
 #include "Teuchos_StandardParameterEntryValidators.hpp"
 #include "Teuchos_Utils.hpp"
 
 #include <fstream>
+#include <limits>
+#include <sstream>
 
 namespace HYMLS {
 
@@ -57,7 +69,9 @@ Preconditioner::Preconditioner(Teuchos::RCP<const Epetra_RowMatrix> K,
     numInitialize_(0), numCompute_(0), numApplyInverse_(0),
     flopsInitialize_(0.0), flopsCompute_(0.0), flopsApplyInverse_(0.0),
     timeInitialize_(0.0), timeCompute_(0.0), timeApplyInverse_(0.0),
-    numThreadsSD_(-1), bgridTransform_(false)
+    numThreadsSD_(-1), bgridTransform_(false),
+    sharedMemoryTransfers_(false), lendIdleCores_(false),
+    progressInterval_(-1.0), computeKey_(0)
   {
   HYMLS_LPROF3(label_,"Constructor");
   serialComm_=Teuchos::rcp(new Epetra_SerialComm());
@@ -75,8 +89,78 @@ Preconditioner::Preconditioner(Teuchos::RCP<const Epetra_RowMatrix> K,
 Preconditioner::~Preconditioner()
   {
   HYMLS_LPROF3(label_,"Destructor");
+
+  // The registry keeps the importers of all levels and their maps and
+  // communicators alive. Other preconditioners that are still around
+  // keep their own references to the importers they use.
+  if (myLevel_ == 1)
+    ImportRegistry::Clear();
+  }
+
+namespace
+  {
+// Hash of the entries of the "Problem" list and of the partitioning
+// entries of the "Preconditioner" list. Entries that are not set in
+// these lists are taken from the lists of an initialized preconditioner,
+// into which its partitioner has written the defaults it used.
+std::uint64_t SetupKey(Teuchos::ParameterList const &probList,
+  Teuchos::ParameterList const &precList,
+  Teuchos::ParameterList const &defaultProbList,
+  Teuchos::ParameterList const &defaultPrecList)
+  {
+  Teuchos::ParameterList probCopy = probList;
+  probCopy.setParametersNotAlreadySet(defaultProbList);
+  Teuchos::ParameterList precCopy = precList;
+  precCopy.setParametersNotAlreadySet(defaultPrecList);
+
+  std::uint64_t hash = CacheUtils::HashSeed;
+  CacheUtils::HashParameters(hash, probCopy);
+  CacheUtils::HashParameters(hash, precCopy,
+    CacheUtils::IsPartitioningParameter);
+  return hash;
   }
+  }
+
+int Preconditioner::ShareSetup(Teuchos::RCP<const Preconditioner> other)
+  {
+  HYMLS_LPROF3(label_, "ShareSetup");
+
+  setup_ = Teuchos::null;
+  if (other == Teuchos::null)
+    return 0;
 
+  if (!other->IsInitialized())
+    Tools::Error("the preconditioner whose setup is shared is not initialized",
+      __FILE__, __LINE__);
+
+  if (other->myLevel_ != myLevel_)
+    Tools::Error("the setup can only be shared on the same level",
+      __FILE__, __LINE__);
+
+  if (hid_ != Teuchos::null && hid_.get() != other->hid_.get())
+    Tools::Error("this preconditioner already has another partitioning",
+      __FILE__, __LINE__);
+
+  if (!other->OperatorRangeMap().SameAs(*rangeMap_))
+    Tools::Error("the matrices do not have the same maps",
+      __FILE__, __LINE__);
+
+  Teuchos::ParameterList const &probList = other->PL("Problem");
+  Teuchos::ParameterList const &precList = other->PL("Preconditioner");
+  if (other->maxLevel_ != maxLevel_ ||
+    SetupKey(probList, precList, probList, precList) !=
+    SetupKey(PL("Problem"), PL("Preconditioner"), probList, precList))
+    Tools::Error("the setup can only be shared between preconditioners with "
+      "the same problem, number of levels and partitioning parameters",
+      __FILE__, __LINE__);
+
+  hid_ = other->hid_;
+  setup_ = other.create_weak();
+  initialized_ = false;
+  computed_ = false;
+
+  return 0;
+  }
 
 // Ifpack_Preconditioner interface
 
@@ -101,7 +185,10 @@ int Preconditioner::SetParameters(Teuchos::ParameterList& List)
   sdSolverType_ = PL().get("Subdomain Solver Type", "Sparse");
   numThreadsSD_ = PL().get("Subdomain Solver Num Threads", numThreadsSD_);
   bgridTransform_ = PL().get("B-Grid Transform", false);
+  sharedMemoryTransfers_ = PL().get("Shared Memory Transfers", false);
+  lendIdleCores_ = PL().get("Lend Idle Cores", false);
   maxLevel_ = PL().get("Number of Levels", 1);
+  progressInterval_ = PL().get("MPI Progress Interval", -1.0);
 
   if (schurPrec_!=Teuchos::null)
     {
@@ -141,12 +228,49 @@ Preconditioner::getValidParameters() const
   Teuchos::RCP<Teuchos::StringToIntegralParameterEntryValidator<int> >
     partValidator = Teuchos::rcp(
       new Teuchos::StringToIntegralParameterEntryValidator<int>(
-        Teuchos::tuple<std::string>("Cartesian", "Skew Cartesian"),"Partitioner"));
+        Teuchos::tuple<std::string>("Cartesian", "Skew Cartesian", "Graph"),"Partitioner"));
 
   VPL().set("Partitioner", "Cartesian",
     "Type of partitioner to be used to define the subdomains",
     partValidator);
 
+  VPL().set("Partition Cache", "",
+    "Prefix of binary files in which the partitioning of every level is stored, "
+    "so that later runs with the same input can read it instead of recomputing it. "
+    "Empty to disable the cache.");
+
+  VPL().set("Number of Subdomains", -1,
+    "Global number of subdomains for the \"Graph\" partitioner. By default the "
+    "subdomains contain about \"Separator Length\" to the power \"Dimension\" nodes");
+
+  VPL().set("Load Balancing", false,
+    "Move subdomains between neighboring processors to balance the estimated factorization cost");
+
+  VPL().set("Agglomeration Threshold", 0,
+    "If the average number of nodes per process on a coarse level is smaller than this, "
+    "the level is moved onto fewer processes. 0 disables agglomeration.");
+
+  VPL().set("Shared Memory Transfers", false,
+    "Use MPI-3 shared memory windows for the processes on the same compute node "
+    "when distributing the right-hand side on coarse levels");
+
+  VPL().set("Lend Idle Cores", false,
+    "Let the threaded subdomain and coarse solvers use the cores of processes "
+    "on the same compute node that are idle on a level");
+
+  VPL().set("Coarse Node Gather", false,
+    "Solve the coarsest problem on a single process and gather the right-hand "
+    "side there through one leader process per compute node");
+
+  VPL().set("Replicated Coarse Solve", false,
+    "Factor the coarsest problem on every process, so that applying it only "
+    "requires gathering the right-hand side on all processes");
+
+  VPL().set("MPI Progress Interval", -1.0,
+    "Minimum time in seconds between two calls into MPI during the subdomain "
+    "factorizations and the assembly of the Schur complement, which lets MPI "
+    "progress pending messages. A negative value disables this");
+
   VPL().set("Fix Pressure Level", true,
     "Put a Dirichlet condition on a single P-node on the coarsest grid");
 
@@ -285,9 +409,16 @@ int Preconditioner::Initialize()
     // - partition domain into small subdomains
     // - find separators
     // - group them according to the needs of our algorithm
+    // the graph partitioner needs the graph of the matrix
+    Teuchos::RCP<const Epetra_CrsGraph> graph = Teuchos::null;
+    Teuchos::RCP<const Epetra_CrsMatrix> Acrs =
+      Teuchos::rcp_dynamic_cast<const Epetra_CrsMatrix>(matrix_);
+    if (Acrs != Teuchos::null)
+      graph = Teuchos::rcp(new Epetra_CrsGraph(Acrs->Graph()));
+
     hid_ = Teuchos::rcp(new
       HYMLS::OverlappingPartitioner(rangeMap_,
-        getMyNonconstParamList(), myLevel_));
+        getMyNonconstParamList(), myLevel_, Teuchos::null, graph));
     }
 
   HYMLS_TEST(Label()+Teuchos::toString(myLevel_),
@@ -302,22 +433,16 @@ int Preconditioner::Initialize()
   // the Compute() phase.
 #endif
 
-  // this is an idea to make the "HyperCube" object
-  // statically available and using it to query things
-  // like "idle CPU cores on node" dynamically
-
-  /*
-    if (HYMLS::ProcTopo==Teuchos::null)
+  // On coarser levels some processes may not have any subdomains. Their
+  // cores can then be used by the subdomain solvers of the other processes
+  // on the same node. This does not change the process layout.
+  int numThreadsSD = numThreadsSD_;
+  if (lendIdleCores_)
     {
-    HYMLS::Tools::Error("static object HYMLS::ProcTopo not constructed!");
+    CoreLending lending(*comm_, hid_->NumMySubdomains() > 0,
+      numThreadsSD_ > 0 ? numThreadsSD_ : CoreLending::MaxThreads());
+    numThreadsSD = lending.NumThreads();
     }
-    int active = num_sd>0 ? 1:0;
-    // this is just for figuring
-    // out how many threads we can
-    // use locally, it does not *change*
-    // the process layout
-    ProcTopo->setActive(myLevel_,active);
-  */
 
   // Obtain a map with overlap between processors from the overlapping
   // partitioner which we need for the A12/A21 subdomain blocks
@@ -331,7 +456,22 @@ int Preconditioner::Initialize()
     }
 #endif
 
-  importer_=Teuchos::rcp(new Epetra_Import(*rowMap_,*rangeMap_));
+  // the preconditioner whose setup we share, if it still exists
+  Teuchos::RCP<const Preconditioner> setup = setup_.is_valid_ptr() ?
+    setup_.create_strong() : Teuchos::null;
+
+  if (setup != Teuchos::null)
+    {
+    importer_ = setup->importer_;
+    sharedImport1_ = sharedMemoryTransfers_ ? setup->sharedImport1_ : Teuchos::null;
+    sharedImport2_ = sharedMemoryTransfers_ ? setup->sharedImport2_ : Teuchos::null;
+    }
+  else
+    {
+    importer_ = ImportRegistry::GetImport(*rowMap_, *rangeMap_);
+    sharedImport1_ = Teuchos::null;
+    sharedImport2_ = Teuchos::null;
+    }
 
   // Construct the matrix blocks we need for the Schur complement
   A11_ = Teuchos::rcp(new MatrixBlock(hid_,
@@ -347,7 +487,7 @@ int Preconditioner::Initialize()
     Teuchos::ParameterList(PL().sublist("Sparse Solver")));
 
   // Initialize the subdomain solvers for the A11 block
-  CHECK_ZERO(A11_->InitializeSubdomainSolvers(sdSolverType_, sd_list, numThreadsSD_));
+  CHECK_ZERO(A11_->InitializeSubdomainSolvers(sdSolverType_, sd_list, numThreadsSD));
 
   HYMLS_DEBUG("Create Schur-complement");
 
@@ -372,9 +512,17 @@ int Preconditioner::Initialize()
     {
     HYMLS_DEBUG("Construct schur-preconditioner");
     Teuchos::RCP<Epetra_Vector> testVector = CreateTestVector();
-    schurPrec_ = Teuchos::rcp(new SchurPreconditioner(Schur_,hid_,
+    Teuchos::RCP<SchurPreconditioner> schurPrec = Teuchos::rcp(new
+      SchurPreconditioner(Schur_,hid_,
         getMyNonconstParamList(), myLevel_, testVector));
 
+    if (setup != Teuchos::null)
+      {
+      CHECK_ZERO(schurPrec->ShareSetup(
+          Teuchos::rcp_dynamic_cast<const SchurPreconditioner>(setup->schurPrec_)));
+      }
+    schurPrec_ = schurPrec;
+
     CHECK_ZERO(schurPrec_->Initialize());
     }
 
@@ -408,31 +556,75 @@ int Preconditioner::Compute()
 
   time_->ResetStartTime();
 
+  MpiProgress::SetInterval(progressInterval_);
+
     {
     HYMLS_LPROF2(label_, "matrix block computation");
 
-    TransformMatrix();
-
     int MaxNumEntriesPerRow = matrix_->MaxNumEntries();
     Teuchos::RCP<const Epetra_CrsMatrix> Acrs = Teuchos::null;
-    Acrs = Teuchos::rcp_dynamic_cast<const Epetra_CrsMatrix>(matrix_);
+    Teuchos::RCP<Epetra_CrsMatrix> reorderedMatrix = Teuchos::null;
 
-    if (Teuchos::is_null(Acrs))
+    if (assembler_ != Teuchos::null)
       {
-      Tools::Error("Currently requires an Epetra_CrsMatrix!",__FILE__,__LINE__);
+      if (bgridTransform_)
+        {
+        Tools::Error("B-grid transformation is not possible with a SubdomainAssembler",
+          __FILE__,__LINE__);
+        }
+
+      // The application assembles the overlapping matrix itself, so the
+      // global matrix is not needed
+      HYMLS_DEBUG("Assemble subdomains");
+      reorderedMatrix =
+        Teuchos::rcp(new Epetra_CrsMatrix(Copy, *rowMap_, MaxNumEntriesPerRow));
+
+      CHECK_ZERO(AssembleSubdomains(*reorderedMatrix));
+      CHECK_ZERO(reorderedMatrix->FillComplete());
+
+      computeKey_ = ComputeKey(*reorderedMatrix);
+
+      // Compute the A12, A21, A22 blocks
+      CHECK_ZERO(A12_->ComputeLocal(*rangeMap_, reorderedMatrix));
+      CHECK_ZERO(A21_->ComputeLocal(*rangeMap_, reorderedMatrix));
+      CHECK_ZERO(A22_->ComputeLocal(*rangeMap_, reorderedMatrix));
       }
+    else
+      {
+      computeKey_ = ComputeKey(*matrix_);
+
+      TransformMatrix();
 
-    HYMLS_DEBUG("Reorder global matrix");
-    Teuchos::RCP<Epetra_CrsMatrix> reorderedMatrix =
-      Teuchos::rcp(new Epetra_CrsMatrix(Copy, *rowMap_, MaxNumEntriesPerRow));
+      MaxNumEntriesPerRow = matrix_->MaxNumEntries();
+      Acrs = Teuchos::rcp_dynamic_cast<const Epetra_CrsMatrix>(matrix_);
 
-    CHECK_ZERO(reorderedMatrix->Import(*Acrs, *importer_, Insert));
-    CHECK_ZERO(reorderedMatrix->FillComplete());
+      if (Teuchos::is_null(Acrs))
+        {
+        Tools::Error("Currently requires an Epetra_CrsMatrix!",__FILE__,__LINE__);
+        }
 
-    // Compute the A12, A21, A22 blocks
-    CHECK_ZERO(A12_->Compute(Acrs, reorderedMatrix));
-    CHECK_ZERO(A21_->Compute(Acrs, reorderedMatrix));
-    CHECK_ZERO(A22_->Compute(Acrs, reorderedMatrix));
+      HYMLS_DEBUG("Reorder global matrix");
+      reorderedMatrix =
+        Teuchos::rcp(new Epetra_CrsMatrix(Copy, *rowMap_, MaxNumEntriesPerRow));
+
+      CHECK_ZERO(reorderedMatrix->Import(*Acrs, *importer_, Insert));
+      CHECK_ZERO(reorderedMatrix->FillComplete());
+
+      // Compute the A12, A21, A22 blocks
+      CHECK_ZERO(A12_->Compute(Acrs, reorderedMatrix));
+      CHECK_ZERO(A21_->Compute(Acrs, reorderedMatrix));
+      CHECK_ZERO(A22_->Compute(Acrs, reorderedMatrix));
+      }
+
+    // On coarse levels the blocks are often on other processes than the
+    // right-hand side, so use shared memory on the compute nodes there.
+    if (sharedMemoryTransfers_ && myLevel_ > 1 && sharedImport1_ == Teuchos::null)
+      {
+      sharedImport1_ = Teuchos::rcp(new SharedMemoryImport(
+          A12_->Importer().TargetMap(), A12_->Importer().SourceMap()));
+      sharedImport2_ = Teuchos::rcp(new SharedMemoryImport(
+          A21_->Importer().TargetMap(), A21_->Importer().SourceMap()));
+      }
 
 #ifdef HYMLS_STORE_MATRICES
     MatrixUtils::Dump(A12_->Block()->RowMap(), "Precond"+Teuchos::toString(myLevel_)+"_Map1.txt");
@@ -444,7 +636,14 @@ int Preconditioner::Compute()
 
     // note: the Compute and ComputeSubdomainSolvers functions both extract the matrix block,
     // so normally we don't need to call Compute() for A11
-    CHECK_ZERO(A11_->Compute(Acrs, reorderedMatrix));
+    if (Acrs != Teuchos::null)
+      {
+      CHECK_ZERO(A11_->Compute(Acrs, reorderedMatrix));
+      }
+    else
+      {
+      CHECK_ZERO(A11_->ComputeLocal(*rangeMap_, reorderedMatrix));
+      }
     MatrixUtils::Dump(*A11_->Block(), "Precond"+Teuchos::toString(myLevel_)+"_A11.txt");
 
 #endif
@@ -499,7 +698,16 @@ int Preconditioner::Compute()
 
   CHECK_ZERO(ComputeBorder());
 
-  CHECK_ZERO(schurPrec_->Compute());
+  Teuchos::RCP<SchurPreconditioner> schurPrec =
+    Teuchos::rcp_dynamic_cast<SchurPreconditioner>(schurPrec_);
+  if (restorePrefix_ != "" && schurPrec != Teuchos::null)
+    {
+    CHECK_ZERO(schurPrec->ComputeFromSchurCache(restorePrefix_, computeKey_));
+    }
+  else
+    {
+    CHECK_ZERO(schurPrec_->Compute());
+    }
 
   computed_ = true;
   timeCompute_ += time_->ElapsedTime();
@@ -514,6 +722,166 @@ int Preconditioner::Compute()
   return 0;
   }
 
+int Preconditioner::SaveSchurCache(std::string const &prefix) const
+  {
+  HYMLS_LPROF(label_, "SaveSchurCache");
+
+  if (!IsComputed())
+    {
+    Tools::Warning("HYMLS::Preconditioner not computed", __FILE__, __LINE__);
+    return -1;
+    }
+
+  // The coarsest level only has a factorization, which is computed
+  // again by ComputeFromSchurCache()
+  Teuchos::RCP<const SchurPreconditioner> schurPrec =
+    Teuchos::rcp_dynamic_cast<const SchurPreconditioner>(schurPrec_);
+  if (schurPrec == Teuchos::null)
+    return 0;
+
+  return schurPrec->SaveSchurCache(prefix, computeKey_);
+  }
+
+int Preconditioner::ComputeFromSchurCache(std::string const &prefix)
+  {
+  HYMLS_LPROF(label_, "ComputeFromSchurCache");
+
+  restorePrefix_ = prefix;
+  int ierr = Compute();
+  restorePrefix_ = "";
+  return ierr;
+  }
+
+int Preconditioner::NumLevelsFromSchurCache() const
+  {
+  Teuchos::RCP<const SchurPreconditioner> schurPrec =
+    Teuchos::rcp_dynamic_cast<const SchurPreconditioner>(schurPrec_);
+  if (schurPrec == Teuchos::null)
+    return 0;
+  return schurPrec->NumLevelsFromSchurCache();
+  }
+
+int Preconditioner::AssembleSubdomains(Epetra_CrsMatrix &A) const
+  {
+  HYMLS_LPROF2(label_, "AssembleSubdomains");
+
+  // separator rows belong to several subdomains, but are only assembled
+  // once
+  Teuchos::Array<bool> assembled(rowMap_->NumMyElements(), false);
+  int numAssembled = 0;
+
+  int ierr = 0;
+  Teuchos::Array<hymls_gidx> rows;
+  for (int sd = 0; sd < hid_->NumMySubdomains() && ierr == 0; sd++)
+    {
+    rows.resize(0);
+    for (hymls_gidx gid: hid_->GetInteriorGroup(sd).nodes())
+      rows.append(gid);
+    for (SeparatorGroup const &group: hid_->GetSeparatorGroups(sd))
+      for (hymls_gidx gid: group.nodes())
+        rows.append(gid);
+
+    int numRows = 0;
+    for (hymls_gidx gid: rows)
+      {
+      int lid = rowMap_->LID(gid);
+      if (lid >= 0 && !assembled[lid])
+        {
+        assembled[lid] = true;
+        rows[numRows++] = gid;
+        }
+      }
+    numAssembled += numRows;
+
+    ierr = assembler_->AssembleSubdomain(sd, rows.getRawPtr(), numRows, A);
+    if (ierr)
+      {
+      Tools::Warning("Error code " + Teuchos::toString(ierr) +
+        " returned from the assembly of subdomain " + Teuchos::toString(sd),
+        __FILE__, __LINE__);
+      }
+    }
+
+  if (ierr == 0 && numAssembled != rowMap_->NumMyElements())
+    {
+    Tools::Warning("not all rows of the overlapping map belong to a subdomain",
+      __FILE__, __LINE__);
+    ierr = -2;
+    }
+
+  // The caller calls the collective FillComplete() next, so either all
+  // processes continue or none of them does. They all return the lowest
+  // error code of any process.
+  int myCode = ierr ? ierr : std::numeric_limits<int>::max();
+  int code = 0;
+  CHECK_ZERO(Comm().MinAll(&myCode, &code, 1));
+  if (code != std::numeric_limits<int>::max())
+    return code;
+
+  return 0;
+  }
+
+std::uint64_t Preconditioner::ComputeKey(const Epetra_RowMatrix &A) const
+  {
+  HYMLS_LPROF3(label_, "ComputeKey");
+
+  std::uint64_t hash = CacheUtils::HashSeed;
+
+  int numProc = Comm().NumProc();
+  CacheUtils::HashBytes(hash, &myLevel_, sizeof(myLevel_));
+  CacheUtils::HashBytes(hash, &numProc, sizeof(numProc));
+
+  const Epetra_Map &rowMap = A.RowMatrixRowMap();
+  const Epetra_Map &colMap = A.RowMatrixColMap();
+  int maxLen = A.MaxNumEntries();
+  Teuchos::Array<int> indices(maxLen);
+  Teuchos::Array<double> values(maxLen);
+  for (int i = 0; i < A.NumMyRows(); i++)
+    {
+    int len;
+    CHECK_ZERO(A.ExtractMyRowCopy(i, maxLen, len,
+        values.getRawPtr(), indices.getRawPtr()));
+    hymls_gidx row = rowMap.GID64(i);
+    CacheUtils::HashBytes(hash, &row, sizeof(row));
+    for (int j = 0; j < len; j++)
+      {
+      hymls_gidx col = colMap.GID64(indices[j]);
+      CacheUtils::HashBytes(hash, &col, sizeof(col));
+      }
+    CacheUtils::HashBytes(hash, values.getRawPtr(), len * sizeof(double));
+    }
+
+  if (testVector_ != Teuchos::null)
+    CacheUtils::HashBytes(hash, testVector_->Values(),
+      testVector_->MyLength() * sizeof(double));
+
+  // Only the parameters that change the numbers, the others are also
+  // used to store defaults and output, so they may differ between runs
+  CacheUtils::HashParameters(hash, PL("Problem"));
+  CacheUtils::HashParameters(hash, PL("Preconditioner"),
+    CacheUtils::IsSchurParameter);
+
+  return hash;
+  }
+
+int Preconditioner::ImportBlocks(const Epetra_MultiVector &B,
+  Epetra_MultiVector &b1, Epetra_MultiVector &b2) const
+  {
+  HYMLS_LPROF3(label_, "ImportBlocks");
+
+  if (sharedImport1_ != Teuchos::null)
+    {
+    CHECK_ZERO(sharedImport1_->Import(B, b1));
+    CHECK_ZERO(sharedImport2_->Import(B, b2));
+    }
+  else
+    {
+    CHECK_ZERO(b1.Import(B, A12_->Importer(), Insert));
+    CHECK_ZERO(b2.Import(B, A21_->Importer(), Insert));
+    }
+  return 0;
+  }
+
 int Preconditioner::ComputeBorder()
   {
   if (!HaveBorder())
@@ -795,7 +1163,7 @@ Teuchos::RCP<Epetra_Vector> Preconditioner::CreateTestVector()
 
   Epetra_Vector tmpVec(*rowMap_);
   Teuchos::RCP<Epetra_Vector> testVector2 = Teuchos::rcp(new Epetra_Vector(map2));
-  Teuchos::RCP<Epetra_Import> import2 = Teuchos::rcp(new Epetra_Import(map2, *rowMap_));
+  Teuchos::RCP<const Epetra_Import> import2 = ImportRegistry::GetImport(map2, *rowMap_);
   CHECK_ZERO(tmpVec.Import(*testVector_,*importer_,Insert));
   CHECK_ZERO(testVector2->Import(tmpVec,*import2,Insert));
 
@@ -968,13 +1336,11 @@ int Preconditioner::ApplyInverse(const Epetra_MultiVector& B, const Epetra_Seria
     CHECK_ZERO(T_->Multiply(true, B, BT));
     Tools::StopTiming("TransformMatix: MV transform 1");
 
-    CHECK_ZERO(b1.Import(BT, import1, Insert));
-    CHECK_ZERO(b2.Import(BT, import2, Insert));
+    CHECK_ZERO(ImportBlocks(BT, b1, b2));
     }
   else
     {
-    CHECK_ZERO(b1.Import(B, import1, Insert));
-    CHECK_ZERO(b2.Import(B, import2, Insert));
+    CHECK_ZERO(ImportBlocks(B, b1, b2));
     }
 
   // We want to compute
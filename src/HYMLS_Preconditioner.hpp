@@ -10,6 +10,7 @@
 
 #include "Teuchos_RCP.hpp"
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 
@@ -33,6 +34,8 @@ class SchurComplement;
 class Epetra_Time;
 class MatrixBlock;
 class OverlappingPartitioner;
+class SharedMemoryImport;
+class SubdomainAssembler;
 
 /*! This class
   - sets parameters for the problem
@@ -90,6 +93,47 @@ public:
   //! to an m-file so that it can be imported to MATLAB.
   void Visualize(std::string mfilename, bool no_recurse=false) const;
 
+  //! \name Schur complement cache
+  //! Assembling the approximate Schur complements takes many subdomain
+  //! solves. They can be written to a cache and read by a later run with
+  //! the same matrix. This is only a cache of the assembled Schur
+  //! matrices, not a checkpoint of the computed preconditioner, which is
+  //! why there is no Save()/Load(): the Amesos and Ifpack solvers can
+  //! not store their numeric factors, so the factorizations of the
+  //! subdomains, the separator blocks and the coarsest level are always
+  //! computed again, and a restart saves the assembly but not the
+  //! factorization time.
+  //!@{
+
+  //! Write the approximate Schur complements of this level and the next
+  //! levels to one binary file per process and level, named
+  //! prefix_L<level>_np<procs>_p<pid>.bin. Collective.
+  int SaveSchurCache(std::string const &prefix) const;
+
+  //! Compute the preconditioner, but read the approximate Schur
+  //! complements from the files written by SaveSchurCache() instead of
+  //! assembling them. A level is only read if its matrix, the parameters
+  //! and the number of processes are the same as when it was saved, and
+  //! the files of all processes are valid. Otherwise it is assembled as
+  //! usual. Collective.
+  int ComputeFromSchurCache(std::string const &prefix);
+
+  //! number of levels whose approximate Schur complement was read from
+  //! the cache in the last Compute()
+  int NumLevelsFromSchurCache() const;
+
+  //!@}
+
+  //! Use the partitioning, maps and importers of another preconditioner
+  //! for a matrix with the same maps, "Problem" parameters, number of
+  //! levels and partitioning parameters instead of building them again
+  //! in Initialize(), which then only duplicates the numerical phases. This
+  //! is passed on to the next levels that other has already computed.
+  //! Only a weak reference to other is kept, the shared objects live as
+  //! long as one of the preconditioners uses them. Call this before
+  //! Initialize(). Collective.
+  int ShareSetup(Teuchos::RCP<const Preconditioner> other);
+
   //!\name Ifpack_Preconditioner interface
 
   //@{
@@ -253,6 +297,30 @@ public:
     initialized_=false;
     }
 
+  //! Drop the partitioning, so the next Initialize() partitions the
+  //! matrix again, for instance when its pattern has changed. This also
+  //! stops sharing the setup of another preconditioner. Initialize() and
+  //! Compute() have to be called again afterwards.
+  void ResetPartitioning()
+    {
+    hid_=Teuchos::null;
+    setup_=Teuchos::null;
+    initialized_=false;
+    computed_=false;
+    }
+
+  //! Let Compute() assemble the rows of every subdomain with the given
+  //! callback instead of importing them from the matrix. The matrix is
+  //! then only used for its maps and for the partitioning, so it may
+  //! for instance just contain the sparsity pattern. This can not be
+  //! combined with the B-grid transformation. Pass Teuchos::null to
+  //! use the matrix again.
+  void SetSubdomainAssembler(Teuchos::RCP<const SubdomainAssembler> assembler)
+    {
+    assembler_=assembler;
+    computed_=false;
+    }
+
 protected:
 
   //! Transform the matrix to an F-matrix when possible
@@ -274,7 +342,7 @@ protected:
   Teuchos::RCP<const Epetra_Map> rowMap_;
 
   //! importer from range to row map
-  Teuchos::RCP<Epetra_Import> importer_;
+  Teuchos::RCP<const Epetra_Import> importer_;
 
   //! our own minimally overlapped and reordered partitioning:
   Teuchos::RCP<const OverlappingPartitioner> hid_;
@@ -386,6 +454,38 @@ protected:
   //! Transform B-grid type matrix into an F-matrix
   bool bgridTransform_;
 
+  //! obtained from user parameter "Shared Memory Transfers": distribute
+  //! the right-hand side over the blocks using shared memory between the
+  //! processes of a compute node on coarse levels
+  bool sharedMemoryTransfers_;
+
+  //! shared memory versions of A12_->Importer() and A21_->Importer()
+  Teuchos::RCP<SharedMemoryImport> sharedImport1_, sharedImport2_;
+
+  //! obtained from user parameter "Lend Idle Cores": use the cores of
+  //! processes without subdomains for the subdomain solvers
+  bool lendIdleCores_;
+
+  //! obtained from user parameter "MPI Progress Interval". It is passed
+  //! to MpiProgress at the start of Compute(), in the thread that
+  //! computes the preconditioner.
+  double progressInterval_;
+
+  //! hash of the matrix and parameters of the last Compute(), which
+  //! identifies the files of SaveSchurCache()
+  std::uint64_t computeKey_;
+
+  //! prefix passed to ComputeFromSchurCache(), empty outside of it
+  std::string restorePrefix_;
+
+  //! weak reference to the preconditioner whose setup is shared, see
+  //! ShareSetup()
+  Teuchos::RCP<const Preconditioner> setup_;
+
+  //! callback that assembles the subdomain rows, see
+  //! SetSubdomainAssembler()
+  Teuchos::RCP<const SubdomainAssembler> assembler_;
+
 #ifdef HYMLS_DEBUGGING
 public:
 #else
@@ -408,6 +508,21 @@ private:
   //! Actually compute the next level border during the Compute phase.
   int ComputeBorder();
 
+  //! Import B into the interior (b1) and separator (b2) parts.
+  int ImportBlocks(const Epetra_MultiVector &B,
+    Epetra_MultiVector &b1, Epetra_MultiVector &b2) const;
+
+  //! hash of the level, the number of processes, the local rows of A,
+  //! the test vector and the parameters that change the approximate
+  //! Schur complement, used for computeKey_
+  std::uint64_t ComputeKey(const Epetra_RowMatrix &A) const;
+
+  //! Insert the rows of all local subdomains into A, which is based on
+  //! rowMap_, using the assembler_. If the assembler fails or does not
+  //! cover all rows on any process, all processes return the same
+  //! error code. Collective.
+  int AssembleSubdomains(Epetra_CrsMatrix &A) const;
+
   };
 
 
@@ -15,6 +15,10 @@
 #include "HYMLS_RestrictedOT.hpp"
 #include "HYMLS_SeparatorGroup.hpp"
 #include "HYMLS_CoarseSolver.hpp"
+#include "HYMLS_AgglomeratedSolver.hpp"
+#include "HYMLS_ImportRegistry.hpp"
+#include "HYMLS_MpiProgress.hpp"
+#include "HYMLS_CacheUtils.hpp"
 
 #include "Epetra_Comm.h"
 #include "Epetra_Map.h"
@@ -37,6 +41,7 @@
 #include "Teuchos_RCP.hpp"
 #include "Teuchos_ParameterList.hpp"
 #include "Teuchos_StandardCatchMacros.hpp"
+#include "Teuchos_toString.hpp"
 
 #include "Ifpack_Container.h"
 #include "Ifpack_DenseContainer.h"
@@ -52,6 +57,7 @@
 #include "HYMLS_HierarchicalMap.hpp"
 #include "HYMLS_OrthogonalTransform.hpp"
 
+#include <cstdint>
 #include <fstream>
 #include <algorithm>
 #include <iostream>
@@ -72,7 +78,7 @@ SchurPreconditioner::SchurPreconditioner(
     SchurComplement_(SC),
     myLevel_(level),
     variant_("Block Diagonal"),
-    denseSwitch_(99), applyDropping_(true),
+    denseSwitch_(99), agglomerationThreshold_(0), applyDropping_(true),
     applyOT_(true),
     hid_(hid), map_(Teuchos::rcp(&(SC->OperatorDomainMap()), false)),
     testVector_(testVector),
@@ -84,7 +90,8 @@ SchurPreconditioner::SchurPreconditioner(
     initialized_(false), computed_(false),
     numInitialize_(0), numCompute_(0), numApplyInverse_(0),
     flopsInitialize_(0.0), flopsCompute_(0.0), flopsApplyInverse_(0.0),
-    timeInitialize_(0.0), timeCompute_(0.0), timeApplyInverse_(0.0)
+    timeInitialize_(0.0), timeCompute_(0.0), timeApplyInverse_(0.0),
+    restoreKey_(0), loadedFromCache_(false)
   {
   HYMLS_LPROF3(label_, "Constructor (1)");
   time_ = Teuchos::rcp(new Epetra_Time(*comm_));
@@ -121,6 +128,25 @@ SchurPreconditioner::~SchurPreconditioner()
   HYMLS_LPROF3(label_, "Destructor");
   }
 
+int SchurPreconditioner::ShareSetup(Teuchos::RCP<const SchurPreconditioner> other)
+  {
+  HYMLS_LPROF3(label_, "ShareSetup");
+
+  setup_ = Teuchos::null;
+  if (other == Teuchos::null)
+    return 0;
+
+  if (other->myLevel_ != myLevel_ || other->hid_.get() != hid_.get())
+    Tools::Error("the setup can only be shared with the same partitioning",
+      __FILE__, __LINE__);
+
+  setup_ = other.create_weak();
+  initialized_ = false;
+  computed_ = false;
+
+  return 0;
+  }
+
 // Ifpack_Preconditioner interface
 
 void SchurPreconditioner::setParameterList(const Teuchos::RCP<Teuchos::ParameterList> &list)
@@ -148,6 +174,7 @@ int SchurPreconditioner::SetParameters(Teuchos::ParameterList &List)
   maxLevel_ = PL().get("Number of Levels", myLevel_);
   variant_ = PL().get("Preconditioner Variant", "Block Diagonal");
   denseSwitch_ = PL().get("Dense Solvers on Level", denseSwitch_);
+  agglomerationThreshold_ = PL().get("Agglomeration Threshold", 0);
   applyDropping_ = PL().get("Apply Dropping", true);
   applyOT_ = PL().get("Apply Orthogonal Transformation", applyDropping_);
 
@@ -190,31 +217,95 @@ int SchurPreconditioner::Initialize()
   reducedSchurSolver_ = Teuchos::null;
   blockSolver_.resize(0);
 
+  // the Schur preconditioner whose setup we share, if it still exists
+  Teuchos::RCP<const SchurPreconditioner> setup = setup_.is_valid_ptr() ?
+    setup_.create_strong() : Teuchos::null;
+  if (setup != Teuchos::null && !setup->IsInitialized())
+    setup = Teuchos::null;
+
+  // the orthogonal transformation depends on the test vector
+  if (setup != Teuchos::null && applyOT_ && setup->applyOT_ &&
+    testVector_ != Teuchos::null && setup->testVector_ != Teuchos::null)
+    {
+    Epetra_Vector diff(*testVector_);
+    CHECK_ZERO(diff.Update(-1.0, *setup->testVector_, 1.0));
+    double normDiff;
+    CHECK_ZERO(diff.NormInf(&normDiff));
+    if (normDiff == 0.0)
+      sparseMatrixOT_ = setup->sparseMatrixOT_;
+    }
+
   CHECK_ZERO(InitializeOT());
 
-  // Initialize Vsum maps that we use to compute the matrix for the
-  // next level.
-  Teuchos::RCP<const HierarchicalMap> localSepObject =
-    hid_->Spawn(HierarchicalMap::LocalSeparators);
-  vsumMap_ = CreateVSumMap(localSepObject);
+  if (setup != Teuchos::null)
+    {
+    vsumMap_ = setup->vsumMap_;
+    overlappingVsumMap_ = setup->overlappingVsumMap_;
+    }
+  else
+    {
+    // Initialize Vsum maps that we use to compute the matrix for the
+    // next level.
+    Teuchos::RCP<const HierarchicalMap> localSepObject =
+      hid_->Spawn(HierarchicalMap::LocalSeparators);
+    vsumMap_ = CreateVSumMap(localSepObject);
 
-  Teuchos::RCP<const HierarchicalMap> sepObject =
-    hid_->Spawn(HierarchicalMap::Separators);
-  overlappingVsumMap_ = CreateVSumMap(sepObject);
+    Teuchos::RCP<const HierarchicalMap> sepObject =
+      hid_->Spawn(HierarchicalMap::Separators);
+    overlappingVsumMap_ = CreateVSumMap(sepObject);
+    }
 
   HYMLS_DEBUG(label_);
   HYMLS_DEBVAR(*vsumMap_);
 
   vsumRhs_ = Teuchos::rcp(new Epetra_MultiVector(*vsumMap_, 1));
   vsumSol_ = Teuchos::rcp(new Epetra_MultiVector(*vsumMap_, 1));
-  vsumImporter_ = Teuchos::rcp(new Epetra_Import(*vsumMap_, *map_));
 
-  if (myLevel_ + 1 < maxLevel_)
+  if (setup != Teuchos::null)
+    {
+    vsumImporter_ = setup->vsumImporter_;
+    vsumLIDs_ = setup->vsumLIDs_;
+    vsumHaloMap_ = setup->vsumHaloMap_;
+    vsumHaloImporter_ = setup->vsumHaloImporter_;
+    vsumHalo_ = Teuchos::null;
+    }
+  else
+    {
+    vsumImporter_ = ImportRegistry::GetImport(*vsumMap_, *map_);
+    CHECK_ZERO(InitializeVsumTransfer());
+    }
+
+  if (myLevel_ + 1 < maxLevel_ && setup != Teuchos::null &&
+    setup->agglomeratedSolver_ == Teuchos::null &&
+    setup->nextLevelHID_ != Teuchos::null)
+    {
+    agglomeratedSolver_ = Teuchos::null;
+    nextLevelHID_ = setup->nextLevelHID_;
+    }
+  else if (myLevel_ + 1 < maxLevel_)
     {
     bool status = true;
+    agglomeratedSolver_ = Teuchos::null;
+    int numActiveProcs = AgglomeratedSolver::NumActiveProcs(
+      *vsumMap_, agglomerationThreshold_);
     try
       {
-      nextLevelHID_ = hid_->SpawnNextLevel(vsumMap_, overlappingVsumMap_);
+      if (numActiveProcs < comm_->NumProc())
+        {
+        // There are too few nodes per process on the next level, so we
+        // move it onto fewer processes. The next level partitioner is only
+        // created on the active processes.
+        agglomeratedSolver_ = Teuchos::rcp(new
+          AgglomeratedSolver(vsumMap_, numActiveProcs, myLevel_ + 1));
+        nextLevelHID_ = Teuchos::null;
+        if (agglomeratedSolver_->IsActive())
+          nextLevelHID_ = hid_->SpawnNextLevel(
+            agglomeratedSolver_->ActiveMap(), Teuchos::null);
+        }
+      else
+        {
+        nextLevelHID_ = hid_->SpawnNextLevel(vsumMap_, overlappingVsumMap_);
+        }
       } TEUCHOS_STANDARD_CATCH_STATEMENTS(true, std::cerr, status);
     if (!status) Tools::Fatal("Failed to create next level ordering", __FILE__, __LINE__);
     }
@@ -266,7 +357,14 @@ int SchurPreconditioner::Compute()
       __FILE__, __LINE__);
     }
 
-  if (!applyDropping_)
+  loadedFromCache_ = restorePrefix_ != "" &&
+    LoadMatrix(restorePrefix_, restoreKey_);
+  if (loadedFromCache_)
+    {
+    Tools::Out("Read approximate Schur complement (level " +
+      Teuchos::toString(myLevel_) + ") from " + restorePrefix_);
+    }
+  else if (!applyDropping_)
     {
     CHECK_ZERO(Assemble());
     }
@@ -400,9 +498,9 @@ int SchurPreconditioner::InitializeOT()
     // separators connected to local subdomains). The separators are unique in this object,
     // so the Map() and OverlappingMap() are the same.
     const Epetra_Map &sepMap = sepObject->Map();
-    Epetra_Import import(sepMap, *map_);
+    Teuchos::RCP<const Epetra_Import> import = ImportRegistry::GetImport(sepMap, *map_);
     Epetra_Vector localTestVector(sepMap);
-    CHECK_ZERO(localTestVector.Import(*testVector_, import, Insert));
+    CHECK_ZERO(localTestVector.Import(*testVector_, *import, Insert));
 
 #ifdef HYMLS_LONG_LONG
     Epetra_LongLongSerialDenseVector inds;
@@ -586,9 +684,36 @@ int SchurPreconditioner::ComputeNextLevel()
       //      object for the reduced problem (this is partially done, but we still
       //      also call the direct solver here since this is probably faster, but
       //      this has to be checked).
-      reducedSchurSolver_ = Teuchos::rcp(new
-        Preconditioner(reducedSchur, nextLevelParams,
-          nextTestVector, myLevel_ + 1, nextLevelHID_));
+      if (agglomeratedSolver_ != Teuchos::null)
+        {
+        agglomeratedSolver_->setParameterList(nextLevelParams);
+        CHECK_ZERO(agglomeratedSolver_->SetNextLevel(nextTestVector, nextLevelHID_));
+        CHECK_ZERO(agglomeratedSolver_->SetMatrix(reducedSchur));
+        reducedSchurSolver_ = agglomeratedSolver_;
+        }
+      else
+        {
+        Teuchos::RCP<Preconditioner> prec = Teuchos::rcp(new
+          Preconditioner(reducedSchur, nextLevelParams,
+            nextTestVector, myLevel_ + 1, nextLevelHID_));
+
+        // keep sharing the setup on the next level if we got our
+        // partitioning from the same preconditioner
+        Teuchos::RCP<const SchurPreconditioner> setup = setup_.is_valid_ptr() ?
+          setup_.create_strong() : Teuchos::null;
+        if (setup != Teuchos::null && setup->nextLevelHID_ == nextLevelHID_)
+          {
+          Teuchos::RCP<const Preconditioner> nextSetup =
+            Teuchos::rcp_dynamic_cast<const Preconditioner>(setup->reducedSchurSolver_);
+          if (nextSetup != Teuchos::null && nextSetup->IsInitialized())
+            CHECK_ZERO(prec->ShareSetup(nextSetup));
+          }
+        reducedSchurSolver_ = prec;
+        }
+      }
+    else if (agglomeratedSolver_ != Teuchos::null)
+      {
+      CHECK_ZERO(agglomeratedSolver_->SetMatrix(reducedSchur));
       }
     else
       {
@@ -614,7 +739,13 @@ int SchurPreconditioner::ComputeNextLevel()
 
   // compute solver for reduced Schur
   HYMLS_DEBUG("compute coarse solver");
-  int ierr = reducedSchurSolver_->Compute();
+  Teuchos::RCP<Preconditioner> nextLevel =
+    Teuchos::rcp_dynamic_cast<Preconditioner>(reducedSchurSolver_);
+  int ierr;
+  if (restorePrefix_ != "" && nextLevel != Teuchos::null)
+    ierr = nextLevel->ComputeFromSchurCache(restorePrefix_);
+  else
+    ierr = reducedSchurSolver_->Compute();
 
   if (ierr != 0)
     {
@@ -801,9 +932,9 @@ int SchurPreconditioner::AssembleTransformAndDrop()
   // separators connected to local subdomains). The separators are unique in this object,
   // so the Map() and OverlappingMap() are the same.
   const Epetra_Map &sepMap = sepObject->OverlappingMap();
-  Epetra_Import import(sepMap, *map_);
+  Teuchos::RCP<const Epetra_Import> import = ImportRegistry::GetImport(sepMap, *map_);
   Epetra_Vector localTestVector(sepMap);
-  CHECK_ZERO(localTestVector.Import(*testVector_, import, Insert));
+  CHECK_ZERO(localTestVector.Import(*testVector_, *import, Insert));
 
   // now for each subdomain construct the SC part A22 and A21*A11\A12 for the
   // surrounding separators, apply orthogonal transforms to each separator
@@ -834,6 +965,7 @@ int SchurPreconditioner::AssembleTransformAndDrop()
       HYMLS_DEBVAR(i);
       CHECK_ZERO(matrix->ReplaceGlobalValues(*indicesArray[i], *SkArray[i]));
       }
+    MpiProgress::Poke();
     }//sd
   CHECK_ZERO(matrix->GlobalAssemble(false, Insert));
 
@@ -861,6 +993,7 @@ int SchurPreconditioner::AssembleTransformAndDrop()
       HYMLS_DEBVAR(i);
       CHECK_ZERO(matrix->SumIntoGlobalValues(*indicesArray[i], *SkArray[i]));
       }
+    MpiProgress::Poke();
     }//sd
   CHECK_ZERO(matrix->GlobalAssemble());
 
@@ -1073,9 +1206,9 @@ int SchurPreconditioner::ApplyInverse(const Epetra_MultiVector &X,
     vsumSol_ = Teuchos::rcp(new Epetra_MultiVector(*vsumMap_, X.NumVectors()));
     }
 
-  CHECK_ZERO(vsumRhs_->Import(Y, *vsumImporter_, Insert));
+  CHECK_ZERO(RestrictVsum(Y, *vsumRhs_));
   CHECK_ZERO(reducedSchurSolver_->ApplyInverse(*vsumRhs_, *vsumSol_));
-  CHECK_ZERO(Y.Export(*vsumSol_, *vsumImporter_, Insert));
+  CHECK_ZERO(ProlongVsum(*vsumSol_, Y));
 
   // transform back
   CHECK_ZERO(ApplyOT(false, Y, &flopsApplyInverse_));
@@ -1437,9 +1570,11 @@ int SchurPreconditioner::UpdateVsumRhs(const Epetra_MultiVector &B, Epetra_Multi
   HYMLS_LPROF3(label_, "Update Vsum RHS");
 
   // update the RHS for the V-sum solve
-  for (int i = 0; i < vsumMap_->NumMyElements(); i++)
+  for (int i = 0; i < vsumLIDs_.size(); i++)
     {
-    int lid = Y.Map().LID(vsumMap_->GID64(i));
+    int lid = vsumLIDs_[i];
+    if (lid < 0)
+      continue;
     for (int k = 0; k < Y.NumVectors(); k++)
       {
       Y[k][lid] = B[k][lid];
@@ -1458,6 +1593,98 @@ int SchurPreconditioner::UpdateVsumRhs(const Epetra_MultiVector &B, Epetra_Multi
   return 0;
   }
 
+int SchurPreconditioner::InitializeVsumTransfer()
+  {
+  HYMLS_LPROF3(label_, "InitializeVsumTransfer");
+
+  int numMyElements = vsumMap_->NumMyElements();
+  vsumLIDs_.resize(numMyElements);
+
+  Teuchos::Array<hymls_gidx> haloGIDs;
+  for (int i = 0; i < numMyElements; i++)
+    {
+    hymls_gidx gid = vsumMap_->GID64(i);
+    vsumLIDs_[i] = map_->LID(gid);
+    if (vsumLIDs_[i] < 0)
+      haloGIDs.append(gid);
+    }
+
+  vsumHaloMap_ = Teuchos::null;
+  vsumHaloImporter_ = Teuchos::null;
+  vsumHalo_ = Teuchos::null;
+
+  // Only communicate if there is a process that needs it
+  int numHalo = haloGIDs.size();
+  int globalNumHalo;
+  CHECK_ZERO(comm_->SumAll(&numHalo, &globalNumHalo, 1));
+  if (globalNumHalo == 0)
+    return 0;
+
+  vsumHaloMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, numHalo,
+      haloGIDs.getRawPtr(), (hymls_gidx)map_->IndexBase64(), *comm_));
+  vsumHaloImporter_ = Teuchos::rcp(new Epetra_Import(*vsumHaloMap_, *map_));
+  return 0;
+  }
+
+int SchurPreconditioner::RestrictVsum(const Epetra_MultiVector &Y,
+  Epetra_MultiVector &vsum) const
+  {
+  HYMLS_LPROF3(label_, "RestrictVsum");
+
+  int numVectors = Y.NumVectors();
+  if (vsumHaloImporter_ != Teuchos::null)
+    {
+    if (vsumHalo_ == Teuchos::null || vsumHalo_->NumVectors() != numVectors)
+      vsumHalo_ = Teuchos::rcp(new Epetra_MultiVector(*vsumHaloMap_, numVectors));
+    CHECK_ZERO(vsumHalo_->Import(Y, *vsumHaloImporter_, Insert));
+    }
+
+  for (int k = 0; k < numVectors; k++)
+    {
+    const double *y = Y[k];
+    double *v = vsum[k];
+    int j = 0;
+    for (int i = 0; i < vsumLIDs_.size(); i++)
+      {
+      int lid = vsumLIDs_[i];
+      v[i] = lid >= 0 ? y[lid] : (*vsumHalo_)[k][j++];
+      }
+    }
+  return 0;
+  }
+
+int SchurPreconditioner::ProlongVsum(const Epetra_MultiVector &vsum,
+  Epetra_MultiVector &Y) const
+  {
+  HYMLS_LPROF3(label_, "ProlongVsum");
+
+  int numVectors = Y.NumVectors();
+  if (vsumHaloImporter_ != Teuchos::null && (vsumHalo_ == Teuchos::null ||
+      vsumHalo_->NumVectors() != numVectors))
+    {
+    vsumHalo_ = Teuchos::rcp(new Epetra_MultiVector(*vsumHaloMap_, numVectors));
+    }
+
+  for (int k = 0; k < numVectors; k++)
+    {
+    const double *v = vsum[k];
+    double *y = Y[k];
+    int j = 0;
+    for (int i = 0; i < vsumLIDs_.size(); i++)
+      {
+      int lid = vsumLIDs_[i];
+      if (lid >= 0)
+        y[lid] = v[i];
+      else
+        (*vsumHalo_)[k][j++] = v[i];
+      }
+    }
+
+  if (vsumHaloImporter_ != Teuchos::null)
+    CHECK_ZERO(Y.Export(*vsumHalo_, *vsumHaloImporter_, Insert));
+  return 0;
+  }
+
 ////////////////////////////////////////////////////
 // implementation of the BorderedOperator interface //
 ////////////////////////////////////////////////////
@@ -1582,7 +1809,7 @@ int SchurPreconditioner::ApplyInverse(const Epetra_MultiVector &X,
       Epetra_MultiVector(*vsumMap_, X.NumVectors()));
     }
 
-  CHECK_ZERO(vsumRhs_->Import(B, *vsumImporter_, Insert));
+  CHECK_ZERO(RestrictVsum(B, *vsumRhs_));
 
   // compute W1'(M11\F1). note zeros in X2
   Epetra_SerialDenseMatrix Tcopy(T);
@@ -1597,7 +1824,7 @@ int SchurPreconditioner::ApplyInverse(const Epetra_MultiVector &X,
   CHECK_ZERO(borderedNextLevel->ApplyInverse(*vsumRhs_, Tcopy, *vsumSol_, S));
 
   // copy into Y
-  CHECK_ZERO(Y.Export(*vsumSol_, *vsumImporter_, Insert));
+  CHECK_ZERO(ProlongVsum(*vsumSol_, Y));
 
   // transform back
   CHECK_ZERO(ApplyOT(false, Y, &flopsApplyInverse_));
@@ -1713,4 +1940,134 @@ int SchurPreconditioner::DumpReordering() const
   return 0;
   }
 
+namespace
+  {
+const char restoreMagic[8] = {'H', 'Y', 'M', 'L', 'S', 'S', 'C', '1'};
+  }
+
+std::string SchurPreconditioner::RestoreFile(std::string const &prefix) const
+  {
+  return CacheUtils::FileName(prefix, myLevel_, Comm());
+  }
+
+int SchurPreconditioner::SaveSchurCache(std::string const &prefix,
+  std::uint64_t key) const
+  {
+  HYMLS_LPROF2(label_, "SaveSchurCache");
+
+  if (isEmpty_ || matrix_ == Teuchos::null)
+    return 0;
+
+  int ierr = 0;
+  std::ofstream os(RestoreFile(prefix).c_str(), std::ios::binary);
+  os.write(restoreMagic, sizeof(restoreMagic));
+  CacheUtils::Write(os, key);
+
+  // the rows with global column indices, so the column map may differ
+  // when they are read
+  CacheUtils::Write(os, (std::int64_t)matrix_->NumMyRows());
+  Teuchos::Array<std::int64_t> cols;
+  Teuchos::Array<double> values;
+  for (int i = 0; i < matrix_->NumMyRows(); i++)
+    {
+    int len;
+    double *vals;
+    int *inds;
+    CHECK_ZERO(matrix_->ExtractMyRowView(i, len, vals, inds));
+    cols.resize(len);
+    values.assign(vals, vals + len);
+    for (int j = 0; j < len; j++)
+      cols[j] = matrix_->GCID64(inds[j]);
+    CacheUtils::Write(os, (std::int64_t)matrix_->GRID64(i));
+    CacheUtils::Write(os, cols);
+    CacheUtils::Write(os, values);
+    }
+
+  if (!os)
+    {
+    Tools::Warning("Could not write " + RestoreFile(prefix), __FILE__, __LINE__);
+    ierr = -1;
+    }
+
+  Teuchos::RCP<const Preconditioner> nextLevel =
+    Teuchos::rcp_dynamic_cast<const Preconditioner>(reducedSchurSolver_);
+  if (nextLevel != Teuchos::null)
+    {
+    CHECK_ZERO(nextLevel->SaveSchurCache(prefix));
+    }
+
+  return ierr;
+  }
+
+int SchurPreconditioner::ComputeFromSchurCache(std::string const &prefix,
+  std::uint64_t key)
+  {
+  HYMLS_LPROF2(label_, "ComputeFromSchurCache");
+
+  restorePrefix_ = prefix;
+  restoreKey_ = key;
+  int ierr = Compute();
+  restorePrefix_ = "";
+  return ierr;
+  }
+
+int SchurPreconditioner::NumLevelsFromSchurCache() const
+  {
+  int numLevels = loadedFromCache_ ? 1 : 0;
+  Teuchos::RCP<const Preconditioner> nextLevel =
+    Teuchos::rcp_dynamic_cast<const Preconditioner>(reducedSchurSolver_);
+  if (nextLevel != Teuchos::null)
+    numLevels += nextLevel->NumLevelsFromSchurCache();
+  return numLevels;
+  }
+
+bool SchurPreconditioner::LoadMatrix(std::string const &prefix, std::uint64_t key)
+  {
+  HYMLS_LPROF2(label_, "LoadMatrix");
+
+  std::ifstream is(RestoreFile(prefix).c_str(), std::ios::binary);
+
+  char magic[sizeof(restoreMagic)];
+  std::uint64_t fileKey = 0;
+  std::int64_t numRows = 0;
+  bool ok = is && is.read(magic, sizeof(magic)) &&
+    std::equal(magic, magic + sizeof(magic), restoreMagic) &&
+    CacheUtils::Read(is, fileKey) && fileKey == key &&
+    CacheUtils::Read(is, numRows) && numRows == map_->NumMyElements();
+
+  int nzest = 0;
+  if (hid_->NumMySubdomains() > 0)
+    nzest = hid_->NumSeparatorElements(0);
+  Teuchos::RCP<Epetra_FECrsMatrix> matrix = Teuchos::rcp(
+    new Epetra_FECrsMatrix(Copy, *map_, nzest));
+
+  Teuchos::Array<std::int64_t> cols;
+  Teuchos::Array<double> values;
+  Teuchos::Array<hymls_gidx> indices;
+  for (std::int64_t i = 0; ok && i < numRows; i++)
+    {
+    std::int64_t row;
+    ok = CacheUtils::Read(is, row) && CacheUtils::Read(is, cols) &&
+      CacheUtils::Read(is, values) && cols.size() == values.size() &&
+      map_->MyGID((hymls_gidx)row);
+    if (ok && cols.size() > 0)
+      {
+      indices.assign(cols.begin(), cols.end());
+      ok = matrix->InsertGlobalValues((hymls_gidx)row, (int)indices.size(),
+        values.getRawPtr(), indices.getRawPtr()) >= 0;
+      }
+    }
+
+  // Only use the files if they are valid on all processes
+  int myOk = ok ? 1 : 0;
+  int allOk = 0;
+  CHECK_ZERO(Comm().MinAll(&myOk, &allOk, 1));
+  if (!allOk)
+    return false;
+
+  CHECK_ZERO(matrix->GlobalAssemble());
+  matrix_ = matrix;
+  return true;
+  }
+
   }// namespace
@@ -12,6 +12,7 @@
 #include "HYMLS_BorderedOperator.hpp"
 #include "HYMLS_PLA.hpp"
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 
@@ -45,6 +46,7 @@ class Epetra_Time;
 class HierarchicalMap;
 class OrthogonalTransform;
 class OverlappingPartitioner;
+class AgglomeratedSolver;
 class SchurComplement;
 
 //! Approximation of the Schur-complement
@@ -90,6 +92,40 @@ public:
   //! write matlab data for visualization
   void Visualize(std::string filename, bool recurse = true) const;
 
+  //! Write the assembled approximate Schur complement of this level to
+  //! one file per process, followed by those of the next levels. The
+  //! key identifies the matrix and parameters it was computed for. Only
+  //! the matrices are stored, not the factorizations, see
+  //! Preconditioner::SaveSchurCache(). Collective.
+  int SaveSchurCache(std::string const &prefix, std::uint64_t key) const;
+
+  //! Compute(), but read the approximate Schur complement from the files
+  //! written by SaveSchurCache() instead of assembling it, also on the
+  //! next levels. If the key or the number of processes does not match,
+  //! it is assembled as usual. The factorizations are always computed.
+  //! Collective.
+  int ComputeFromSchurCache(std::string const &prefix, std::uint64_t key);
+
+  //! number of levels, starting with this one, whose approximate Schur
+  //! complement was read from the cache in the last Compute()
+  int NumLevelsFromSchurCache() const;
+
+  //! Use the Vsum maps and importers, the next level partitioning and,
+  //! if the test vectors are the same, the orthogonal transformation of
+  //! another Schur preconditioner with the same partitioning instead of
+  //! building them in Initialize(). Only a weak reference to other is
+  //! kept. Call this before Initialize().
+  int ShareSetup(Teuchos::RCP<const SchurPreconditioner> other);
+
+  //! map of the Vsum nodes that are passed to the next level
+  Teuchos::RCP<const Epetra_Map> VsumMap() const {return vsumMap_;}
+
+  //! importer for the Vsum nodes
+  Teuchos::RCP<const Epetra_Import> VsumImporter() const {return vsumImporter_;}
+
+  //! partitioning of the next level
+  Teuchos::RCP<const OverlappingPartitioner> NextLevelHID() const {return nextLevelHID_;}
+
   //!\name Ifpack_Preconditioner interface
 
   //@{
@@ -267,6 +303,11 @@ protected:
   //! denseSwitch_.
   int denseSwitch_;
 
+  //! obtained from user parameter "Agglomeration Threshold": if the
+  //! next level has fewer nodes per process, it is moved onto fewer
+  //! processes.
+  int agglomerationThreshold_;
+
   //! switch for applying dropping
   bool applyDropping_;
 
@@ -300,11 +341,33 @@ protected:
   Teuchos::RCP<const Epetra_Map> vsumMap_, overlappingVsumMap_;
 
   //! importer for Vsum nodes
-  Teuchos::RCP<Epetra_Import> vsumImporter_;
+  Teuchos::RCP<const Epetra_Import> vsumImporter_;
+
+  //! local index in map_ of every Vsum node, -1 if it is owned by
+  //! another process
+  Teuchos::Array<int> vsumLIDs_;
+
+  //! map with the Vsum nodes that are owned by another process. This
+  //! is null if all Vsum nodes are local on all processes.
+  Teuchos::RCP<const Epetra_Map> vsumHaloMap_;
+
+  //! importer from map_ into vsumHaloMap_
+  Teuchos::RCP<const Epetra_Import> vsumHaloImporter_;
+
+  //! Vsum nodes that are owned by another process
+  mutable Teuchos::RCP<Epetra_MultiVector> vsumHalo_;
 
   //! partitioner for the next level
   Teuchos::RCP<const OverlappingPartitioner> nextLevelHID_;
 
+  //! solver for the next level if it is agglomerated onto fewer
+  //! processes, this is also stored in reducedSchurSolver_
+  Teuchos::RCP<AgglomeratedSolver> agglomeratedSolver_;
+
+  //! weak reference to the Schur preconditioner whose setup is shared,
+  //! see ShareSetup()
+  Teuchos::RCP<const SchurPreconditioner> setup_;
+
   //! right-hand side and solution for the reduced SC (based on linear map)
   mutable Teuchos::RCP<Epetra_MultiVector> vsumRhs_, vsumSol_;
 
@@ -444,6 +507,16 @@ private:
   //! update Vsum part of the vector before solving reduced SC problem
   int UpdateVsumRhs(const Epetra_MultiVector &B, Epetra_MultiVector &X) const;
 
+  //! create vsumLIDs_ and the import for Vsum nodes of other processes
+  int InitializeVsumTransfer();
+
+  //! copy the Vsum part of Y into vsum. Only the Vsum nodes that are
+  //! owned by another process are communicated.
+  int RestrictVsum(const Epetra_MultiVector &Y, Epetra_MultiVector &vsum) const;
+
+  //! copy vsum into the Vsum part of Y, the reverse of RestrictVsum
+  int ProlongVsum(const Epetra_MultiVector &vsum, Epetra_MultiVector &Y) const;
+
   //!
   //! Compute scaling for a sparse matrix. This is currently unused.
   //!
@@ -462,6 +535,22 @@ private:
   //! Dump a reordering for the Schur-complement (for checking in MATLAB)
   int DumpReordering() const;
 
+  //! name of the cache file of this process
+  std::string RestoreFile(std::string const &prefix) const;
+
+  //! Read matrix_ from the file written by SaveSchurCache(). Returns
+  //! false on all processes if the file can not be used on any of them.
+  bool LoadMatrix(std::string const &prefix, std::uint64_t key);
+
+  //! prefix passed to ComputeFromSchurCache(), empty outside of it
+  std::string restorePrefix_;
+
+  //! key passed to ComputeFromSchurCache()
+  std::uint64_t restoreKey_;
+
+  //! matrix_ was read from the cache in the last Compute()
+  bool loadedFromCache_;
+
   };
 
   }
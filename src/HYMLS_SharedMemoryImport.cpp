@@ -0,0 +1,270 @@
+#include "HYMLS_SharedMemoryImport.hpp"
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_MpiComm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Map.h"
+#include "Epetra_Import.h"
+#include "Epetra_MultiVector.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_toString.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+#define HYMLS_HAVE_MPI_SHARED_MEMORY
+#endif
+
+namespace HYMLS
+  {
+
+SharedMemoryImport::SharedMemoryImport(const Epetra_BlockMap &targetMap,
+  const Epetra_BlockMap &sourceMap)
+  :
+  label_("SharedMemoryImport"),
+  haveNodeComm_(false),
+  useWindow_(false),
+  nodeComm_(MPI_COMM_NULL),
+  win_(MPI_WIN_NULL),
+  winVectors_(0),
+  sourceLength_(sourceMap.NumMyElements())
+  {
+  HYMLS_PROF2(label_, "Constructor");
+
+  const Epetra_Comm &comm = sourceMap.Comm();
+  int myPID = comm.MyPID();
+
+  // rank on the node communicator of every process, -1 if it is on
+  // another node
+  Teuchos::Array<int> nodeRankOfPID(comm.NumProc(), -1);
+  nodeRankOfPID[myPID] = 0;
+
+#ifdef HYMLS_HAVE_MPI_SHARED_MEMORY
+  const Epetra_MpiComm *mpiComm = dynamic_cast<const Epetra_MpiComm *>(&comm);
+  if (mpiComm != NULL)
+    {
+    CHECK_ZERO(MPI_Comm_split_type(mpiComm->Comm(), MPI_COMM_TYPE_SHARED,
+        myPID, MPI_INFO_NULL, &nodeComm_));
+    haveNodeComm_ = true;
+
+    int nodeSize;
+    CHECK_ZERO(MPI_Comm_size(nodeComm_, &nodeSize));
+
+    Teuchos::Array<int> nodePIDs(nodeSize);
+    CHECK_ZERO(MPI_Allgather(&myPID, 1, MPI_INT,
+        nodePIDs.getRawPtr(), 1, MPI_INT, nodeComm_));
+    for (int i = 0; i < nodeSize; i++)
+      nodeRankOfPID[nodePIDs[i]] = i;
+
+    nodeSourceLength_.resize(nodeSize);
+    CHECK_ZERO(MPI_Allgather(&sourceLength_, 1, MPI_INT,
+        nodeSourceLength_.getRawPtr(), 1, MPI_INT, nodeComm_));
+    nodeData_.resize(nodeSize, NULL);
+    }
+#endif
+
+  // find the owners of the entries of the target map
+  int numMyElements = targetMap.NumMyElements();
+  hymls_gidx *myGlobalElements;
+#ifdef HYMLS_LONG_LONG
+  myGlobalElements = targetMap.MyGlobalElements64();
+#else
+  myGlobalElements = targetMap.MyGlobalElements();
+#endif
+
+  Teuchos::Array<int> pids(numMyElements);
+  Teuchos::Array<int> lids(numMyElements);
+  // a positive return value means that not all GIDs are in the source map
+  int ierr = sourceMap.RemoteIDList(numMyElements, myGlobalElements,
+    pids.getRawPtr(), lids.getRawPtr());
+  if (ierr < 0)
+    {
+    Tools::Error("RemoteIDList returned " + Teuchos::toString(ierr),
+      __FILE__, __LINE__);
+    }
+
+  Teuchos::Array<hymls_gidx> haloGIDs;
+  for (int i = 0; i < numMyElements; i++)
+    {
+    if (pids[i] < 0)
+      continue;
+
+    if (pids[i] == myPID)
+      {
+      localTargetLIDs_.append(i);
+      localSourceLIDs_.append(lids[i]);
+      }
+    else if (nodeRankOfPID[pids[i]] >= 0)
+      {
+      sharedTargetLIDs_.append(i);
+      sharedRanks_.append(nodeRankOfPID[pids[i]]);
+      sharedSourceLIDs_.append(lids[i]);
+      }
+    else
+      {
+      haloTargetLIDs_.append(i);
+      haloGIDs.append(myGlobalElements[i]);
+      }
+    }
+
+#ifdef HYMLS_HAVE_MPI_SHARED_MEMORY
+  if (haveNodeComm_)
+    {
+    // Tell the other processes on the node which of their entries we read,
+    // so every process only has to copy those into the window.
+    int nodeSize = nodeSourceLength_.size();
+    Teuchos::Array<int> sendCounts(nodeSize, 0), recvCounts(nodeSize, 0);
+    for (int i = 0; i < sharedRanks_.size(); i++)
+      sendCounts[sharedRanks_[i]]++;
+    CHECK_ZERO(MPI_Alltoall(sendCounts.getRawPtr(), 1, MPI_INT,
+        recvCounts.getRawPtr(), 1, MPI_INT, nodeComm_));
+
+    Teuchos::Array<int> sendDispls(nodeSize + 1, 0), recvDispls(nodeSize + 1, 0);
+    for (int i = 0; i < nodeSize; i++)
+      {
+      sendDispls[i + 1] = sendDispls[i] + sendCounts[i];
+      recvDispls[i + 1] = recvDispls[i] + recvCounts[i];
+      }
+
+    Teuchos::Array<int> sendLIDs(sendDispls[nodeSize] + 1);
+    Teuchos::Array<int> pos(sendDispls.begin(), sendDispls.end() - 1);
+    for (int i = 0; i < sharedRanks_.size(); i++)
+      sendLIDs[pos[sharedRanks_[i]]++] = sharedSourceLIDs_[i];
+
+    Teuchos::Array<int> recvLIDs(recvDispls[nodeSize] + 1);
+    CHECK_ZERO(MPI_Alltoallv(sendLIDs.getRawPtr(), sendCounts.getRawPtr(),
+        sendDispls.getRawPtr(), MPI_INT, recvLIDs.getRawPtr(),
+        recvCounts.getRawPtr(), recvDispls.getRawPtr(), MPI_INT, nodeComm_));
+
+    exportedLIDs_.assign(recvLIDs.begin(), recvLIDs.begin() + recvDispls[nodeSize]);
+    std::sort(exportedLIDs_.begin(), exportedLIDs_.end());
+    exportedLIDs_.erase(std::unique(exportedLIDs_.begin(), exportedLIDs_.end()),
+      exportedLIDs_.end());
+
+    // If no process on the node reads from another one, all data is
+    // local or comes from other nodes and we never need the window.
+    int numShared = sharedTargetLIDs_.size() + exportedLIDs_.size();
+    int maxShared = 0;
+    CHECK_ZERO(MPI_Allreduce(&numShared, &maxShared, 1, MPI_INT, MPI_MAX,
+        nodeComm_));
+    useWindow_ = maxShared > 0;
+    }
+#endif
+
+  haloMap_ = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1, haloGIDs.size(),
+      haloGIDs.getRawPtr(), (hymls_gidx)sourceMap.IndexBase64(), comm));
+  haloImporter_ = Teuchos::rcp(new Epetra_Import(*haloMap_, sourceMap));
+  }
+
+SharedMemoryImport::~SharedMemoryImport()
+  {
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (finalized)
+    return;
+
+  FreeWindow();
+  if (haveNodeComm_)
+    MPI_Comm_free(&nodeComm_);
+  }
+
+void SharedMemoryImport::FreeWindow() const
+  {
+#ifdef HYMLS_HAVE_MPI_SHARED_MEMORY
+  if (winVectors_ > 0)
+    MPI_Win_free(&win_);
+#endif
+  winVectors_ = 0;
+  }
+
+int SharedMemoryImport::AllocateWindow(int numVectors) const
+  {
+#ifdef HYMLS_HAVE_MPI_SHARED_MEMORY
+  if (numVectors <= winVectors_)
+    return 0;
+
+  HYMLS_PROF3(label_, "AllocateWindow");
+
+  FreeWindow();
+
+  double *myData;
+  MPI_Aint size = (MPI_Aint)sourceLength_ * numVectors * sizeof(double);
+  CHECK_ZERO(MPI_Win_allocate_shared(size, sizeof(double), MPI_INFO_NULL,
+      nodeComm_, &myData, &win_));
+  winVectors_ = numVectors;
+
+  for (int i = 0; i < nodeData_.size(); i++)
+    {
+    MPI_Aint segmentSize;
+    int dispUnit;
+    CHECK_ZERO(MPI_Win_shared_query(win_, i, &segmentSize, &dispUnit, &nodeData_[i]));
+    }
+#endif
+  return 0;
+  }
+
+int SharedMemoryImport::Import(const Epetra_MultiVector &source,
+  Epetra_MultiVector &target) const
+  {
+  HYMLS_PROF3(label_, "Import");
+
+  int numVectors = source.NumVectors();
+  if (target.NumVectors() != numVectors)
+    {
+    Tools::Error("source and target have a different number of vectors",
+      __FILE__, __LINE__);
+    }
+
+  // entries from other nodes
+  if (haloVector_ == Teuchos::null || haloVector_->NumVectors() != numVectors)
+    haloVector_ = Teuchos::rcp(new Epetra_MultiVector(*haloMap_, numVectors));
+  CHECK_ZERO(haloVector_->Import(source, *haloImporter_, Insert));
+
+  for (int k = 0; k < numVectors; k++)
+    {
+    for (int i = 0; i < localTargetLIDs_.size(); i++)
+      target[k][localTargetLIDs_[i]] = source[k][localSourceLIDs_[i]];
+    for (int i = 0; i < haloTargetLIDs_.size(); i++)
+      target[k][haloTargetLIDs_[i]] = (*haloVector_)[k][i];
+    }
+
+#ifdef HYMLS_HAVE_MPI_SHARED_MEMORY
+  if (useWindow_)
+    {
+    CHECK_ZERO(AllocateWindow(numVectors));
+
+    // make sure nobody is still reading the previous data
+    CHECK_ZERO(MPI_Win_fence(0, win_));
+
+    int myRank;
+    CHECK_ZERO(MPI_Comm_rank(nodeComm_, &myRank));
+    double *myData = nodeData_[myRank];
+    for (int k = 0; k < numVectors; k++)
+      for (int lid: exportedLIDs_)
+        myData[k * sourceLength_ + lid] = source[k][lid];
+
+    CHECK_ZERO(MPI_Win_fence(0, win_));
+
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < sharedTargetLIDs_.size(); i++)
+        {
+        int rank = sharedRanks_[i];
+        target[k][sharedTargetLIDs_[i]] =
+          nodeData_[rank][k * nodeSourceLength_[rank] + sharedSourceLIDs_[i]];
+        }
+    }
+#endif
+
+  return 0;
+  }
+
+  }
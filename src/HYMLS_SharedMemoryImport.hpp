@@ -0,0 +1,124 @@
+#ifndef HYMLS_SHARED_MEMORY_IMPORT_H
+#define HYMLS_SHARED_MEMORY_IMPORT_H
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+
+#include <mpi.h>
+
+#include <string>
+
+// forward declarations
+class Epetra_Comm;
+class Epetra_BlockMap;
+class Epetra_Map;
+class Epetra_Import;
+class Epetra_MultiVector;
+
+namespace HYMLS {
+
+/*! Replacement for an Epetra_Import with Insert mode that uses an MPI-3
+  shared memory window for the processes on the same compute node.
+
+  Every process copies the entries of its source vector that are needed
+  by other processes into its segment of a window that is shared by all
+  processes of the compute node. The entries that are owned by another
+  process on the same node are then read directly from that segment. If
+  none of the processes on a node need entries of each other, the window
+  and the synchronization that comes with it are skipped. Only the entries that are owned by a process on
+  another compute node are sent with MPI messages, using an Epetra_Import
+  that is restricted to those entries.
+
+  Entries of the target map that are not in the source map are left
+  unchanged, so the reverse of an Epetra_Import with Insert mode (as in
+  Y.Export(X, importer, Insert)) is obtained by swapping the maps.
+
+  If MPI-3 is not available or the maps do not live on an Epetra_MpiComm,
+  all entries of other processes are sent with MPI messages.
+*/
+class SharedMemoryImport
+  {
+public:
+
+  //! Constructor. Vectors on targetMap will be filled with the entries
+  //! of vectors on sourceMap.
+  SharedMemoryImport(const Epetra_BlockMap &targetMap, const Epetra_BlockMap &sourceMap);
+
+  //! destructor
+  virtual ~SharedMemoryImport();
+
+  //! Fill target with the entries of source. Collective on the
+  //! communicator of the maps.
+  int Import(const Epetra_MultiVector &source, Epetra_MultiVector &target) const;
+
+  //! number of entries that are read from other processes on the same node
+  int NumSharedIDs() const {return sharedTargetLIDs_.size();}
+
+  //! number of entries that are received from other compute nodes
+  int NumHaloIDs() const {return haloTargetLIDs_.size();}
+
+protected:
+
+  //! (re)allocate the shared window if it is too small for numVectors
+  //! vectors. Collective on the node communicator.
+  int AllocateWindow(int numVectors) const;
+
+  //! free the shared window
+  void FreeWindow() const;
+
+  //! label
+  std::string label_;
+
+  //! true if we have a communicator with the processes on this node
+  bool haveNodeComm_;
+
+  //! true if any process on this node reads from the window. If not,
+  //! the window is never allocated and Import() does not synchronize.
+  bool useWindow_;
+
+  //! communicator with the processes on this node
+  MPI_Comm nodeComm_;
+
+  //! shared window
+  mutable MPI_Win win_;
+
+  //! number of vectors the window can hold, 0 if it was not allocated
+  mutable int winVectors_;
+
+  //! pointer to the segment of every process on the node
+  mutable Teuchos::Array<double *> nodeData_;
+
+  //! local length of the source vector of every process on the node
+  Teuchos::Array<int> nodeSourceLength_;
+
+  //! local length of the source vector
+  int sourceLength_;
+
+  //! entries that are copied from the source on this process
+  Teuchos::Array<int> localTargetLIDs_, localSourceLIDs_;
+
+  //! entries that are read from another process on this node
+  Teuchos::Array<int> sharedTargetLIDs_, sharedRanks_, sharedSourceLIDs_;
+
+  //! source entries that other processes on this node read, so these
+  //! are the only ones that are copied into the window
+  Teuchos::Array<int> exportedLIDs_;
+
+  //! entries that are received from another node
+  Teuchos::Array<int> haloTargetLIDs_;
+
+  //! map with the entries that are received from another node
+  Teuchos::RCP<Epetra_Map> haloMap_;
+
+  //! import from the source map into haloMap_
+  Teuchos::RCP<Epetra_Import> haloImporter_;
+
+  //! received entries
+  mutable Teuchos::RCP<Epetra_MultiVector> haloVector_;
+  };
+
+  }
+
+#endif
@@ -218,6 +218,53 @@ int SkewCartesianPartitioner::NumLocalParts() const
   return numLocalSubdomains_;
   }
 
+int SkewCartesianPartitioner::GetSubdomainNeighbors(
+  int sd, Teuchos::Array<int> &neighbors) const
+  {
+  neighbors.resize(0);
+
+  int x, y, z;
+  if (GetSubdomainPosition(sd, sx_, sy_, sz_, x, y, z))
+    return 0;
+
+  // The subdomains are rotated, so there are no fixed offsets between
+  // neighboring subdomains. Instead look for pairs of adjacent nodes of
+  // which only one is in sd, in a box around the position of sd that
+  // contains the whole subdomain.
+  const int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                             {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+  const int numNeighbors = nz_ > 1 ? 6 : 4;
+
+  int nparts = NumGlobalParts(sx_, sy_, sz_);
+  int zbegin = nz_ > 1 ? z - sx_ : 0;
+  int zend = nz_ > 1 ? z + 2 * sx_ : 1;
+  for (int k = zbegin; k < zend; k++)
+    for (int j = y - sx_; j < y + 2 * sx_; j++)
+      for (int i = x - sx_; i < x + 2 * sx_; i++)
+        {
+        int xi = i, yj = j, zk = k;
+        if (!WrapPosition(xi, yj, zk) ||
+          GetSubdomainID(sx_, sy_, sz_, xi, yj, zk) != sd)
+          continue;
+
+        for (int d = 0; d < numNeighbors; d++)
+          {
+          int xn = xi + offsets[d][0];
+          int yn = yj + offsets[d][1];
+          int zn = zk + offsets[d][2];
+          if (!WrapPosition(xn, yn, zn))
+            continue;
+
+          int nb = GetSubdomainID(sx_, sy_, sz_, xn, yn, zn);
+          if (nb >= 0 && nb < nparts && nb != sd &&
+            std::find(neighbors.begin(), neighbors.end(), nb) == neighbors.end())
+            neighbors.append(nb);
+          }
+        }
+
+  return 0;
+  }
+
 int SkewCartesianPartitioner::NumGlobalParts(int sx, int sy, int sz) const
   {
   int npx = nx_ / sx;
@@ -319,7 +366,7 @@ int SkewCartesianPartitioner::Partition(bool repart)
 
   CHECK_ZERO(CreatePIDMap());
 
-  if (nprocs_ < comm_->NumProc())
+  if (nprocs_ < comm_->NumProc() || rebalanced_)
     repart = true;
 
   if (comm_->MyPID() >= nprocs_)
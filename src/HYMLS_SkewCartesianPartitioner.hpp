@@ -54,6 +54,10 @@ protected:
   //! Get the subdomain id from the position of a node in the subdomain
   int GetSubdomainID(int sx, int sy, int sz, int x, int y, int z) const;
 
+  //! Get the IDs of the subdomains that contain nodes adjacent to the
+  //! nodes of subdomain sd
+  int GetSubdomainNeighbors(int sd, Teuchos::Array<int> &neighbors) const;
+
   //! creates the map from global to local partition IDs. The implementation
   //! may assume that npx_, sx_ etc. are already set so that operator() works.
   int CreateSubdomainMap();
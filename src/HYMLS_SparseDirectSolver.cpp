@@ -17,6 +17,7 @@
 #include "HYMLS_MatrixUtils.hpp"
 
 #include "Teuchos_StrUtils.hpp"
+#include <atomic>
 #include <cstdarg>
 
 #include <fstream>
@@ -52,8 +53,13 @@ extern "C" {
     T_KLU(klu_common) *Common_;
     };
 
-  static std::ostream* output_stream;
-  static int firstTime=true;
+  // stream for the output of SuiteSparse in this thread, Tools::out()
+  // if it is not set. The preconditioner may be computed by a background
+  // thread, so this cannot be shared between threads.
+  static thread_local std::ostream* output_stream = NULL;
+
+  // only the first invalid solver type is reported
+  static std::atomic<bool> warnedSolverType(false);
 
   int my_printf(const char* fmt, ...)
     {
@@ -65,7 +71,10 @@ extern "C" {
     vsprintf(formatted_string,fmt,argptr);
     va_end(argptr);
 
-    *output_stream << formatted_string;
+    if (output_stream)
+      *output_stream << formatted_string;
+    else
+      Tools::out() << formatted_string;
     return 0;
     }
   }
@@ -89,7 +98,6 @@ SparseDirectSolver::SparseDirectSolver(Epetra_RowMatrix* Matrix_in) :
   {
   HYMLS_PROF3(label_,"Constructor");
 
-  output_stream = &Tools::out();
 #ifdef HAVE_SUITESPARSE
   amd_printf = &my_printf;
 #endif
@@ -196,9 +204,8 @@ int SparseDirectSolver::SetParameters(Teuchos::ParameterList& params)
 #endif
       if ((choice!="AMESOS_KLU" && choice!="KLU"))
         {
-        if (firstTime)
+        if (!warnedSolverType.exchange(true))
           {
-          firstTime=false;
           Tools::Warning("Invalid choice of 'amesos: solver type'. KLU is used as Sparse Solver",__FILE__,__LINE__);
           }
         }
@@ -1202,7 +1209,7 @@ void SparseDirectSolver::DumpSolverStatus(std::string filePrefix,
 
     const_cast<double&>(umf_Control_[UMFPACK_PRL])=old_prl;
 
-    output_stream = &Tools::out();
+    output_stream = NULL;
     umf_fs.close();
     }
 #endif
@@ -0,0 +1,55 @@
+#ifndef HYMLS_SUBDOMAIN_ASSEMBLER_H
+#define HYMLS_SUBDOMAIN_ASSEMBLER_H
+
+#include "HYMLS_config.h"
+
+class Epetra_CrsMatrix;
+
+namespace HYMLS {
+
+/*! Interface for applications that can assemble the rows of their
+  matrix that belong to a subdomain directly, for instance from the
+  local stencils of a finite volume discretization. If it is passed to
+  Preconditioner::SetSubdomainAssembler(), Compute() builds the
+  overlapping matrix of every process from these rows instead of
+  importing them from the global matrix. The interior and separator
+  blocks of the subdomains and the A12, A21 and A22 blocks are then
+  taken from this matrix without any communication.
+
+  \code
+  class MyAssembler : public HYMLS::SubdomainAssembler
+    {
+  public:
+    int AssembleSubdomain(int sd, const hymls_gidx *rows, int numRows,
+      Epetra_CrsMatrix &A) const
+      {
+      for (int i = 0; i < numRows; i++)
+        {
+        // compute the stencil of rows[i] with global column indices
+        CHECK_ZERO(A.InsertGlobalValues(rows[i], len, values, cols));
+        }
+      return 0;
+      }
+    };
+  \endcode
+*/
+class SubdomainAssembler
+  {
+public:
+
+  //! destructor
+  virtual ~SubdomainAssembler() {}
+
+  //! Insert the rows with global indices rows[0], ..., rows[numRows-1],
+  //! which are the interior and separator nodes of local subdomain sd,
+  //! into A using global column indices. The rows have to be complete,
+  //! so they also contain the columns outside of the subdomain.
+  //! Separator nodes are shared by several subdomains, but every row is
+  //! only passed once. Returns 0 on success.
+  virtual int AssembleSubdomain(int sd, const hymls_gidx *rows, int numRows,
+    Epetra_CrsMatrix &A) const = 0;
+  };
+
+  }
+
+#endif
@@ -26,6 +26,8 @@
 #include "EpetraExt_RowMatrixOut.h"
 
 #include <fstream>
+#include <map>
+#include <mutex>
 
 class Epetra_RowMatrix;
 
@@ -53,6 +55,19 @@ int printf (const char *fmt, ...)
 
 namespace HYMLS {
 
+namespace
+  {
+// the timers are also used by the background thread of the
+// DoubleBufferedPreconditioner
+std::mutex timerMutex;
+
+// serializes the warnings of different threads
+std::mutex warningMutex;
+
+// output of the calling thread if it is redirected by a ThreadOutput
+thread_local Teuchos::RCP<Teuchos::FancyOStream> threadStream;
+  }
+
 RCP<const Epetra_Comm> Tools::comm_=null;
 ParameterList Tools::timerList_;
 ParameterList Tools::breakpointList_;
@@ -167,6 +182,11 @@ bool Tools::InitializedIO()
 
 void Tools::Out(std::string msg)
   {
+  if (threadStream != Teuchos::null)
+    {
+    *threadStream << msg << std::endl;
+    return;
+    }
   if (!InitializedIO())
     {
     Warning("Output system not initialized!",__FILE__,__LINE__);
@@ -214,8 +234,13 @@ void Tools::Fatal(std::string msg, const char* file, int line, bool printStack)
 
 void Tools::Warning(std::string msg, const char* file, int line)
   {
-  std::cerr << "HYMLS Warning: "<<msg<<std::endl;
-  std::cerr << "(in "<<file<<", line "<<line<<")"<<std::endl;
+  std::ostringstream ss;
+  ss << "HYMLS Warning: "<<msg<<std::endl;
+  ss << "(in "<<file<<", line "<<line<<")"<<std::endl;
+    {
+    std::lock_guard<std::mutex> lock(warningMutex);
+    std::cerr << ss.str() << std::flush;
+    }
   HYMLS_DEBUG("HYMLS Warning: "<<msg)
     HYMLS_DEBUG("(in "<<file<<", line "<<line<<")");
   }
@@ -230,6 +255,8 @@ void Tools::SignalHandler(int signum)
 
 Teuchos::RCP<Teuchos::FancyOStream> Tools::getOutputStream()
   {
+  if (threadStream != Teuchos::null)
+    return threadStream;
   if (!InitializedIO())
     {
     Teuchos::RCP<Epetra_SerialComm> comm = Teuchos::rcp(new Epetra_SerialComm());
@@ -241,6 +268,8 @@ Teuchos::RCP<Teuchos::FancyOStream> Tools::getOutputStream()
 
 Teuchos::FancyOStream& Tools::out()
   {
+  if (threadStream != Teuchos::null)
+    return *threadStream;
   if (!InitializedIO())
     {
     Teuchos::RCP<Epetra_SerialComm> comm = Teuchos::rcp(new Epetra_SerialComm());
@@ -252,6 +281,8 @@ Teuchos::FancyOStream& Tools::out()
 
 Teuchos::FancyOStream& Tools::deb()
   {
+  if (threadStream != Teuchos::null)
+    return *threadStream;
 #ifdef HYMLS_DEBUGGING
   if (!InitializedIO())
     {
@@ -365,12 +396,15 @@ RCP<Epetra_Time> Tools::StartTiming(std::string const &fname)
   if (InitializedIO())
     {
     T=rcp(new Epetra_Time(*comm_));
+    std::lock_guard<std::mutex> lock(timerMutex);
     if (timerList_.sublist("timer id").isParameter(fname)==false)
       {
       timerCounter_++;
       timerList_.sublist("timer id").set(fname,timerCounter_);
       }  
-    timerList_.sublist("timers").set(fname,T);
+    // only the start time is stored, the timer itself is owned by the
+    // caller, possibly on another thread
+    timerList_.sublist("start time").set(fname,T->WallTime());
     }
     return T;
   }
@@ -391,14 +425,21 @@ void Tools::StopTiming(std::string const &fname, bool print, RCP<Epetra_Time> T)
     }
   traceLevel_--;
 #endif
-  if (T == null)
-    {
-    T=timerList_.sublist("timers").get(fname,T);
-    }
+  std::lock_guard<std::mutex> lock(timerMutex);
+  bool running = T != null;
   double elapsed=0;
-  if (T!=null)
+  if (running)
     {
     elapsed=T->ElapsedTime();
+    }
+  else if (timerList_.sublist("start time").isParameter(fname))
+    {
+    running = true;
+    elapsed = Epetra_Time(*comm_).WallTime() -
+      timerList_.sublist("start time").get(fname,0.0);
+    }
+  if (running)
+    {
     int ncalls=timerList_.sublist("number of calls").get(fname,0);
     double total_time=timerList_.sublist("total time").get(fname,0.0);
     timerList_.sublist("number of calls").set(fname,ncalls+1);
@@ -429,30 +470,47 @@ std::string mem2string(long long mem)
 
 size_t (*getMem)() = NULL;
 size_t (*getMaxMem)() = NULL;
+size_t (*getRegionMaxMem)() = NULL;
+size_t (*startMemRegion)() = NULL;
+void (*stopMemRegion)(size_t) = NULL;
 
-std::tuple<long long, long long> Tools::StartMemory(std::string const &fname)
+void LoadMemoryProfiler()
   {
-  long long memory = -1;
-  long long max_memory = -1;
-#ifdef HYMLS_MEMORY_PROFILING
-  if (!getMem)
-    {
-    getMem = (size_t (*)())dlsym(RTLD_DEFAULT, "get_memory_usage");
-    getMaxMem = (size_t (*)())dlsym(RTLD_DEFAULT, "get_max_memory_usage");
-    }
-  if (!getMem)
+  if (getMem)
+    return;
+
+  getMem = (size_t (*)())dlsym(RTLD_DEFAULT, "get_memory_usage");
+  getMaxMem = (size_t (*)())dlsym(RTLD_DEFAULT, "get_max_memory_usage");
+  getRegionMaxMem = (size_t (*)())dlsym(RTLD_DEFAULT, "get_region_max_memory_usage");
+  startMemRegion = (size_t (*)())dlsym(RTLD_DEFAULT, "start_memory_region");
+  stopMemRegion = (void (*)(size_t))dlsym(RTLD_DEFAULT, "stop_memory_region");
+
+  if (!getMem || !getMaxMem || !getRegionMaxMem || !startMemRegion || !stopMemRegion)
     {
     getMem = [](){ return (size_t)0; };
     getMaxMem = [](){ return (size_t)0; };
+    getRegionMaxMem = [](){ return (size_t)0; };
+    startMemRegion = [](){ return (size_t)0; };
+    stopMemRegion = [](size_t){};
     Tools::Warning("Memory profiler not loaded correctly", __FILE__, __LINE__);
     }
+  }
+
+// The second return value is the maximum memory usage of the enclosing
+// region, which is restored when the region is stopped.
+std::tuple<long long, long long> Tools::StartMemory(std::string const &fname)
+  {
+  long long memory = -1;
+  long long max_memory = -1;
+#ifdef HYMLS_MEMORY_PROFILING
+  LoadMemoryProfiler();
 
   if (InitializedIO())
     {
     memory = getMem();
     memList_.sublist("memory").set(fname, memory);
 
-    max_memory = getMaxMem();
+    max_memory = startMemRegion();
     memList_.sublist("maximum memory").set(fname, max_memory);
     }
 #endif
@@ -476,16 +534,28 @@ void Tools::StopMemory(std::string const &fname, bool print,
   long long local_memory = getMem() - start_memory;
   comm_->SumAll(&local_memory, &memory, 1);
 
+  // peak of this region relative to the usage at the start
   long long max_memory = 0;
-  long long local_max_memory = getMaxMem() - start_max_memory;
+  long long local_peak_memory = getRegionMaxMem();
+  long long local_max_memory = local_peak_memory - start_memory;
   comm_->SumAll(&local_max_memory, &max_memory, 1);
 
+  // high-water mark of the total usage during this region, summed over
+  // the processes
+  long long peak_memory = 0;
+  comm_->SumAll(&local_peak_memory, &peak_memory, 1);
+
+  stopMemRegion(start_max_memory);
+
   long long total_used = memList_.sublist("total used").get(fname, (long long)0);
   memList_.sublist("total used").set(fname, total_used + memory);
 
   long long maximum_used = memList_.sublist("maximum used").get(fname, (long long)0);
   memList_.sublist("maximum used").set(fname, std::max(maximum_used, memory));
 
+  long long peak_used = memList_.sublist("peak used").get(fname, (long long)0);
+  memList_.sublist("peak used").set(fname, std::max(peak_used, peak_memory));
+
   long long max_increase = memList_.sublist("maximum allocated increase").get(fname, (long long)0);
   memList_.sublist("maximum allocated increase").set(fname, std::max(max_increase, max_memory));
 
@@ -546,6 +616,7 @@ std::basic_ostream<charT, traits>& operator<<(std::basic_ostream<charT, traits>&
 
 void Tools::PrintTiming(std::ostream& os)
   {
+  std::lock_guard<std::mutex> lock(timerMutex);
   ParameterList& idList=timerList_.sublist("timer id");
   ParameterList& ncallsList=timerList_.sublist("number of calls");
   ParameterList& elapsedList=timerList_.sublist("total time");
@@ -601,7 +672,7 @@ void Tools::PrintMemUsage(std::ostream& os)
     {
     std::string label = i.first;
     long long total = memList_.sublist("total used").get(label, (long long)0);
-    long long maximum = memList_.sublist("maximum used").get(label, (long long)0);
+    long long maximum = memList_.sublist("peak used").get(label, (long long)0);
     long long increase = memList_.sublist("maximum allocated increase").get(label, (long long)0);
     int ncalls = memList_.sublist("number of calls").get(label, 1);
     os << std::setfill(' ') << std::setw(137-17*4) << std::left << label
@@ -613,6 +684,45 @@ void Tools::PrintMemUsage(std::ostream& os)
        << std::endl;
     }
   
+  // Summary per level of the profiling regions of the recursively
+  // constructed classes, which are labeled "<class>_L<level>: <function>"
+  std::map<int, std::pair<long long, long long> > levelList;
+  for (auto &i: memList_.sublist("total used"))
+    {
+    std::string label = i.first;
+    size_t pos = label.rfind(": ");
+    size_t lpos = pos == std::string::npos ? pos : label.rfind("_L", pos);
+    if (lpos == std::string::npos || lpos + 2 >= pos ||
+      label.find_first_not_of("0123456789", lpos + 2) != pos)
+      continue;
+
+    int level = std::atoi(label.substr(lpos + 2, pos - lpos - 2).c_str());
+    long long maximum = memList_.sublist("maximum used").get(label, (long long)0);
+    long long increase = memList_.sublist("maximum allocated increase").get(label, (long long)0);
+    std::pair<long long, long long> &entry = levelList[level];
+    entry.first = std::max(entry.first, maximum);
+    entry.second = std::max(entry.second, increase);
+    }
+
+  if (levelList.size())
+    {
+    os << std::setfill('=') << std::setw(137) << centered(" MEMORY USAGE PER LEVEL ") << std::endl;
+    os << std::setfill(' ') << std::setw(137-17*2) << std::left << "Level"
+       << std::setfill(' ') << std::setw(17) << std::left << "Peak Usage"
+       << std::setfill(' ') << std::setw(17) << std::left << "Maximum Increase"
+       << std::endl;
+    os << std::setfill('=') << std::setw(137) << "" << std::endl;
+    for (auto &i: levelList)
+      {
+      os << std::setfill(' ') << std::setw(137-17*2) << std::left << i.first
+         << std::setfill(' ') << std::setw(17) << std::left << mem2string(i.second.first)
+         << std::setfill(' ') << std::setw(17) << std::left << mem2string(i.second.second)
+         << std::endl;
+      }
+    }
+
+  LoadMemoryProfiler();
+
   long long max_memory = 0;
   long long local_max_memory = getMaxMem();
   comm_->SumAll(&local_max_memory, &max_memory, 1);
@@ -751,4 +861,22 @@ TimerObject::~TimerObject()
   Tools::StopTiming(s_, print_, T_);
   Tools::StopMemory(s_, print_, memory_used_, memory_allocated_);
   }
+
+ThreadOutput::ThreadOutput()
+  :
+  buffer_(Teuchos::rcp(new std::ostringstream)),
+  previous_(threadStream)
+  {
+  threadStream = Teuchos::rcp(new Teuchos::FancyOStream(buffer_));
+  }
+
+ThreadOutput::~ThreadOutput()
+  {
+  threadStream = previous_;
+  }
+
+std::string ThreadOutput::Str() const
+  {
+  return buffer_->str();
+  }
 }
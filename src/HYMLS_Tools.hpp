@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <string>
 #include <iosfwd>
+#include <sstream>
 
 #include "Teuchos_RCP.hpp"
 #include "Teuchos_FancyOStream.hpp"
@@ -179,6 +180,32 @@ private:
   size_t memory_allocated_;
   };
 
+/*! While this object exists, everything that the thread that created it
+  writes with Tools::Out(), Tools::out() and Tools::deb() goes to a
+  buffer instead of the shared output streams. Threads other than the
+  main one use it, after which the main thread writes the text.
+*/
+class ThreadOutput
+  {
+public:
+
+  //! constructor
+  ThreadOutput();
+
+  //! destructor, restores the previous output of the thread
+  ~ThreadOutput();
+
+  //! everything that was written so far
+  std::string Str() const;
+
+private:
+
+  //!
+  Teuchos::RCP<std::ostringstream> buffer_;
+  //!
+  Teuchos::RCP<Teuchos::FancyOStream> previous_;
+  };
+
   }
 
 #endif
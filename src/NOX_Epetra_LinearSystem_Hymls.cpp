@@ -4,6 +4,7 @@
 
 #include "HYMLS_Solver.hpp"
 #include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_Exception.hpp"
 
 #include "BelosTypes.hpp"
 
@@ -50,7 +51,8 @@ LinearSystemHymls(
  const Teuchos::RCP<NOX::Epetra::Scaling> s):
  LinearSystemAztecOO(printParams, linearSolverParams,
    iReq, cloneVector, s),
- V_(Teuchos::null)
+ V_(Teuchos::null),
+ numPrecReused_(0), numPrecRefreshed_(0), numPrecRecomputed_(0)
 {
   // this is not tested and should not be used.
   std::cerr << "this constructor should not be used"<<std::endl;
@@ -70,7 +72,8 @@ LinearSystemHymls(
  const Teuchos::RCP<NOX::Epetra::Scaling> s):
   LinearSystemAztecOO(printParams, linearSolverParams,
     iReq, iJac, jacobian, cloneVector, s),
-  V_(Teuchos::null)
+  V_(Teuchos::null),
+  numPrecReused_(0), numPrecRefreshed_(0), numPrecRecomputed_(0)
 {  
   // this is not tested and should not be used.
   std::cerr << "this constructor should not be used"<<std::endl;
@@ -92,7 +95,8 @@ LinearSystemHymls(
    LinearSystemAztecOO(printParams, linearSolverParams,
      iReq, iPrec, preconditioner, cloneVector, s),
    massMatrix_(massMatrix),
-   V_(Teuchos::null)
+   V_(Teuchos::null),
+  numPrecReused_(0), numPrecRefreshed_(0), numPrecRecomputed_(0)
 {  
   reset(linearSolverParams);
 }
@@ -112,7 +116,8 @@ LinearSystemHymls(
   LinearSystemAztecOO(printParams, linearSolverParams, 
     iJac, jacobian, iPrec, preconditioner, cloneVector, s),
   massMatrix_(massMatrix),
-  V_(Teuchos::null)
+  V_(Teuchos::null),
+  numPrecReused_(0), numPrecRefreshed_(0), numPrecRecomputed_(0)
 {
   reset(linearSolverParams);
 }
@@ -210,7 +215,89 @@ createPreconditioner(const NOX::Epetra::Vector& x, Teuchos::ParameterList& p,
 bool NOX::Epetra::LinearSystemHymls::
 recomputePreconditioner(const NOX::Epetra::Vector& x, Teuchos::ParameterList& p) const
   {
-  LinearSystemAztecOO::recomputePreconditioner(x,p);
+  int maxIters = p.get("HYMLS Reuse Iteration Threshold", -1);
+  int numIters = hymls_->getNumIter();
+  Teuchos::RCP<HYMLS::Preconditioner> prec =
+    Teuchos::rcp_dynamic_cast<HYMLS::Preconditioner>(precPtr);
+
+  bool recompute = true;
+  if (maxIters > 0 && !Teuchos::is_null(prec) && prec->IsComputed())
+    {
+    if (numIters > 0 && numIters < maxIters)
+      {
+      // the old preconditioner still works well enough, only the
+      // deflation below uses the new Jacobian
+      if (utils.isPrintType(Utils::Details))
+        utils.out() << "HYMLS: reusing the preconditioner ("
+                    << numIters << " iterations)" << std::endl;
+      numPrecReused_++;
+      recompute = false;
+      }
+    else
+      {
+      // the Jacobian has the same pattern, so the partitioning and the
+      // structure of the Schur complements can be kept and only the
+      // numerical part is computed again
+      int ierr = -1;
+      try
+        {
+        ierr = prec->Compute();
+        }
+      catch (HYMLS::Exception &e)
+        {
+        utils.out() << "WARNING: refreshing the HYMLS preconditioner failed:"
+                    << std::endl << e.what() << std::endl;
+        }
+      if (ierr == 0)
+        {
+        if (utils.isPrintType(Utils::Details))
+          utils.out() << "HYMLS: refreshed the preconditioner ("
+                      << numIters << " iterations)" << std::endl;
+        numPrecRefreshed_++;
+        recompute = false;
+        }
+      else
+        {
+        // build the preconditioner again, starting with the partitioning
+        ierr = -1;
+        try
+          {
+          prec->ResetPartitioning();
+          ierr = prec->Initialize();
+          if (ierr == 0)
+            ierr = prec->Compute();
+          }
+        catch (HYMLS::Exception &e)
+          {
+          utils.out() << "ERROR: rebuilding the HYMLS preconditioner failed:"
+                      << std::endl << e.what() << std::endl;
+          }
+        if (ierr != 0)
+          return false;
+
+        if (utils.isPrintType(Utils::Details))
+          utils.out() << "HYMLS: rebuilt the preconditioner ("
+                      << numIters << " iterations)" << std::endl;
+        numPrecRecomputed_++;
+        recompute = false;
+        }
+      }
+    }
+
+  if (recompute)
+    {
+    LinearSystemAztecOO::recomputePreconditioner(x,p);
+    numPrecRecomputed_++;
+    }
+
+  if (outputSolveDetails)
+    {
+    Teuchos::ParameterList& outputList = p.sublist("Output");
+    outputList.set("Number of Preconditioner Reuses", numPrecReused_);
+    outputList.set("Number of Preconditioner Refreshes", numPrecRefreshed_);
+    outputList.set("Number of Preconditioner Recomputations", numPrecRecomputed_);
+    }
+
   // setup deflation in the solver
   if (massMatrix_!=Teuchos::null)
     hymls_->SetMassMatrix(massMatrix_);
@@ -354,9 +441,8 @@ applyJacobianInverse(Teuchos::ParameterList &p,
     Teuchos::ParameterList& outputList = p.sublist("Output");
     int prevLinIters = 
       outputList.get("Total Number of Linear Iterations", 0);
-    int curLinIters = 0;
+    int curLinIters = hymls_->getNumIter();
     double achievedTol = -1.0;
- //   curLinIters = hymls_->getNumIters();
  //   for ( int i=0; i<numrhs; i++) {
  //     double actRes = actual_resids[i]/rhs_norm[i];
  //     utils.out()<<"Problem "<<i<<" : \t"<< actRes <<std::endl;
@@ -127,7 +127,24 @@ protected:
                                     Teuchos::ParameterList& linearSolverParams,
                                     bool recomputeGraph) const;
 
-  //! overloaded to include setup of deflation
+  /*! \brief overloaded to include setup of deflation and the reuse policy.
+
+      NOX only calls this function if the "Preconditioner Reuse Policy" in
+      the "Linear Solver" list is "Recompute"; with "Rebuild" the
+      preconditioner is created again every time and with "Reuse" it is
+      never updated, so the policy below has no effect in those cases.
+
+      If "HYMLS Reuse Iteration Threshold" in the "Linear Solver" list is
+      positive, the preconditioner is kept as long as the last solve needed
+      fewer iterations than that. Otherwise a computed HYMLS::Preconditioner
+      is refreshed by calling its Compute() on the updated Jacobian, which
+      keeps the partitioning and the structure of the Schur complements from
+      the last Initialize(). If that fails, the preconditioner is rebuilt
+      completely: the matrix is partitioned again and Initialize() and
+      Compute() are called. If the preconditioner is not a
+      HYMLS::Preconditioner, it is recomputed by LinearSystemAztecOO as
+      usual. The default (-1) always does the latter.
+  */
   virtual bool recomputePreconditioner(const NOX::Epetra::Vector& x, 
                              Teuchos::ParameterList& linearSolverParams) const;
 
@@ -145,6 +162,10 @@ Teuchos::RCP<const Epetra_CrsMatrix> massMatrix_;
 
 //! border for the solver
 Teuchos::RCP<const Epetra_MultiVector> V_;
+
+//! number of times the preconditioner was kept, refreshed or recomputed
+//! by recomputePreconditioner
+mutable int numPrecReused_, numPrecRefreshed_, numPrecRecomputed_;
   
 //@}
 
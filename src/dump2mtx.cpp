@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HYMLS_config.h"
+
+#include "HYMLS_DumpWriter.hpp"
+
+// Convert the binary files that HYMLS::DumpWriter writes on every process
+// into a single MatrixMarket coordinate file. The columns of a vector
+// become columns of the matrix. Entries are written with their original
+// GIDs (starting at 1 instead of the index base), so unlike
+// MatrixUtils::Dump with reindex=true, gaps in the maps remain visible.
+//
+// usage: hymls_dump2mtx filename output.mtx
+//
+// where filename is the name that was passed to MatrixUtils::Dump, the
+// files that are read are filename.<pid>.hbd.
+
+namespace
+  {
+
+int usage(const char *name)
+  {
+  std::cerr << "usage: " << name << " filename output.mtx" << std::endl;
+  return 1;
+  }
+
+struct DumpFile
+  {
+  std::int64_t version, type, gidSize, myPID, numProc, indexBase;
+  std::int64_t numGlobalRows, numGlobalCols, numMyRows, numMyCols;
+  std::vector<long long> rowGIDs, colGIDs;
+  std::vector<int> rowPtr, colInd;
+  std::vector<double> values;
+  };
+
+template<typename T>
+bool read(std::istream &is, T *data, std::size_t n)
+  {
+  if (n == 0)
+    return true;
+  return (bool)is.read(reinterpret_cast<char *>(data), n * sizeof(T));
+  }
+
+bool read_gids(std::istream &is, std::vector<long long> &gids,
+  std::int64_t n, std::int64_t gidSize)
+  {
+  gids.resize(n);
+  if (gidSize == sizeof(long long))
+    return read(is, gids.data(), n);
+
+  std::vector<int> ints(n);
+  if (!read(is, ints.data(), n))
+    return false;
+  gids.assign(ints.begin(), ints.end());
+  return true;
+  }
+
+bool read_file(const std::string &filename, DumpFile &file)
+  {
+  std::ifstream is(filename.c_str(), std::ios::binary);
+  char magic[8];
+  if (!is || !read(is, magic, 8) || std::strncmp(magic, "HYMLSDMP", 8) != 0)
+    {
+    std::cerr << filename << " is not a HYMLS dump" << std::endl;
+    return false;
+    }
+
+  std::int64_t header[10];
+  if (!read(is, header, 10))
+    return false;
+  file.version = header[0];
+  file.type = header[1];
+  file.gidSize = header[2];
+  file.myPID = header[3];
+  file.numProc = header[4];
+  file.indexBase = header[5];
+  file.numGlobalRows = header[6];
+  file.numGlobalCols = header[7];
+  file.numMyRows = header[8];
+  file.numMyCols = header[9];
+
+  if (file.version != 1 || (file.gidSize != sizeof(int) &&
+      file.gidSize != sizeof(long long)))
+    {
+    std::cerr << filename << " has an unsupported format" << std::endl;
+    return false;
+    }
+
+  bool ok = read_gids(is, file.rowGIDs, file.numMyRows, file.gidSize);
+  if (file.type == HYMLS::DumpWriter::Matrix)
+    {
+    ok = ok && read_gids(is, file.colGIDs, file.numMyCols, file.gidSize);
+    file.rowPtr.resize(file.numMyRows + 1);
+    ok = ok && read(is, file.rowPtr.data(), file.rowPtr.size());
+    int nnz = ok ? file.rowPtr.back() : 0;
+    file.colInd.resize(nnz);
+    file.values.resize(nnz);
+    ok = ok && read(is, file.colInd.data(), nnz);
+    ok = ok && read(is, file.values.data(), nnz);
+    }
+  else
+    {
+    file.values.resize(file.numMyRows * file.numMyCols);
+    ok = ok && read(is, file.values.data(), file.values.size());
+    }
+
+  if (!ok)
+    std::cerr << "unexpected end of file " << filename << std::endl;
+  return ok;
+  }
+
+int convert_matrix(const std::vector<DumpFile> &files, std::ostream &os)
+  {
+  const DumpFile &first = files[0];
+  long long numRows = first.numGlobalRows;
+  long long numCols = first.numGlobalCols;
+  long long nnz = 0;
+  for (DumpFile const &file: files)
+    {
+    nnz += file.values.size();
+    for (long long gid: file.rowGIDs)
+      numRows = std::max(numRows, gid - file.indexBase + 1);
+    for (long long gid: file.colGIDs)
+      numCols = std::max(numCols, gid - file.indexBase + 1);
+    }
+
+  os << "%%MatrixMarket matrix coordinate real general" << std::endl;
+  os << numRows << " " << numCols << " " << nnz << std::endl;
+  os << std::scientific << std::setprecision(16);
+  for (DumpFile const &file: files)
+    {
+    for (std::int64_t i = 0; i < file.numMyRows; i++)
+      {
+      long long row = file.rowGIDs[i] - file.indexBase + 1;
+      for (int k = file.rowPtr[i]; k < file.rowPtr[i + 1]; k++)
+        os << row << " " << file.colGIDs[file.colInd[k]] - file.indexBase + 1
+           << " " << file.values[k] << "\n";
+      }
+    }
+  return 0;
+  }
+
+int convert_vector(const std::vector<DumpFile> &files, std::ostream &os)
+  {
+  // sort by GID, overlapping entries are written once
+  std::int64_t numVectors = files[0].numMyCols;
+  long long numRows = files[0].numGlobalRows;
+  std::map<long long, std::pair<const DumpFile *, std::int64_t> > rows;
+  for (DumpFile const &file: files)
+    for (std::int64_t i = 0; i < file.numMyRows; i++)
+      {
+      long long row = file.rowGIDs[i] - file.indexBase + 1;
+      numRows = std::max(numRows, row);
+      rows.insert(std::make_pair(row, std::make_pair(&file, i)));
+      }
+
+  os << "%%MatrixMarket matrix coordinate real general" << std::endl;
+  os << numRows << " " << numVectors << " "
+     << (long long)rows.size() * numVectors << std::endl;
+  os << std::scientific << std::setprecision(16);
+  for (std::int64_t k = 0; k < numVectors; k++)
+    for (auto const &row: rows)
+      {
+      const DumpFile &file = *row.second.first;
+      os << row.first << " " << k + 1 << " "
+         << file.values[k * file.numMyRows + row.second.second] << "\n";
+      }
+  return 0;
+  }
+
+  }
+
+int main(int argc, char* argv[])
+  {
+  if (argc != 3)
+    return usage(argv[0]);
+
+  std::string filename = argv[1];
+  std::string outfile = argv[2];
+
+  std::vector<DumpFile> files(1);
+  if (!read_file(HYMLS::DumpWriter::FileName(filename, 0), files[0]))
+    return 1;
+
+  files.resize(files[0].numProc);
+  for (int pid = 1; pid < files[0].numProc; pid++)
+    {
+    if (!read_file(HYMLS::DumpWriter::FileName(filename, pid), files[pid]))
+      return 1;
+    if (files[pid].type != files[0].type)
+      {
+      std::cerr << "the files of " << filename << " do not belong together" << std::endl;
+      return 1;
+      }
+    }
+
+  std::ofstream os(outfile.c_str());
+  if (!os)
+    {
+    std::cerr << "could not open " << outfile << std::endl;
+    return 1;
+    }
+
+  int ierr;
+  if (files[0].type == HYMLS::DumpWriter::Matrix)
+    ierr = convert_matrix(files, os);
+  else
+    ierr = convert_vector(files, os);
+
+  std::cout << "converted " << files.size() << " files to " << outfile << std::endl;
+  return ierr;
+  }
@@ -41,6 +41,7 @@
 #include "HYMLS_Tools.hpp"
 #include "HYMLS_Preconditioner.hpp"
 #include "HYMLS_Solver.hpp"
+#include "HYMLS_AutoTuner.hpp"
 #include "HYMLS_MatrixUtils.hpp"
 
 
@@ -135,10 +136,17 @@ bool status=true;
     double perturbation = driverList.get("Diagonal Perturbation",0.0);
     double diag_shift = driverList.get("Diagonal Shift",0.0);
     double diag_shift_i = driverList.get("Diagonal Shift (imag)",0.0);
+    bool autotune = driverList.get("Autotune Parameters",false);
     
     std::string galeriLabel=driverList.get("Galeri Label","");
     Teuchos::ParameterList galeriList;
     if (driverList.isSublist("Galeri")) galeriList = driverList.sublist("Galeri");
+
+    // keep the preconditioner and solve right-hand sides from a directory
+    bool service = driverList.get("Service Mode",false);
+    Teuchos::ParameterList serviceList;
+    if (driverList.isSublist("Service")) serviceList = driverList.sublist("Service");
+    if (service) store_solution = false;
  
     // copy here rather than reference because the driver list will be removed 
     // alltogether...   
@@ -324,6 +332,24 @@ HYMLS::MatrixUtils::Dump(*map,"MainMatrixMap.txt");
 
   testvector = HYMLS::MainUtils::create_testvector(probl_params_cpy, *K);
 
+  if (autotune)
+    {
+    // run trial setups and solves to select the preconditioner parameters,
+    // the settings are in the "Autotuner" sublist
+    HYMLS::Tools::Out("Autotune Preconditioner");
+    HYMLS::AutoTuner tuner(K, params, testvector);
+
+    Epetra_MultiVector x_tune(*map,numRhs);
+    Epetra_MultiVector b_tune(*map,numRhs);
+    CHECK_ZERO(HYMLS::MatrixUtils::Random(x_tune));
+    CHECK_ZERO(K->Multiply(false,x_tune,b_tune));
+    if (tuner.Tune(b_tune)==0)
+      {
+      params->setParameters(*tuner.BestParameters());
+      }
+    }
+  params->remove("Autotuner",false);
+
   HYMLS::Tools::Out("Create Preconditioner");
 
   HYMLS::Tools::StartMemory("main: Initialize Preconditioner");
@@ -379,6 +405,15 @@ for (int f=0;f<numComputes;f++)
     CHECK_ZERO(solver->SetupDeflation());
     }
   
+  if (service)
+    {
+    HYMLS::Tools::Out("Enter service mode");
+    // the Stokes-C matrix was scaled by -1 above
+    double rhs_scaling = eqn=="Stokes-C" ? -1.0 : 1.0;
+    CHECK_ZERO(HYMLS::MainUtils::run_service(*solver, map, serviceList, rhs_scaling));
+    break;
+    }
+
   for (int s=0;s<numSolves;s++)
     {
     if (read_problem==false || have_rhs==false)
@@ -0,0 +1,214 @@
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+#include <mpi.h>
+
+#include "HYMLS_config.h"
+
+#include "Teuchos_Array.hpp"
+
+#include "HYMLS_BinaryIO.hpp"
+
+// Convert a MatrixMarket file to the binary format of HYMLS::BinaryIO,
+// which hymls_main reads with "File Format" = "Binary". Sparse matrices
+// in coordinate format become matrices, dense arrays with a single
+// column become vectors. For symmetric and skew-symmetric matrices the
+// other triangle is added. Complex and pattern files are rejected. This
+// runs on a single process.
+//
+// usage: hymls_mtx2bin input.mtx output.bin [number of chunks]
+//
+// If a number of chunks is given, the rows are divided into that many
+// chunks with about the same number of nonzeros. These are used when the
+// file is read with the same number of processes.
+
+namespace
+  {
+
+int usage(const char *name)
+  {
+  std::cerr << "usage: " << name << " input.mtx output.bin [number of chunks]" << std::endl;
+  return 1;
+  }
+
+// read the next line that is not a comment
+bool next_line(std::istream &is, std::string &line)
+  {
+  while (std::getline(is, line))
+    {
+    if (!line.empty() && line[0] != '%')
+      return true;
+    }
+  return false;
+  }
+
+// How the entries of the other triangle of a coordinate file are
+// obtained from the ones that are stored
+enum Symmetry {General, Symmetric, SkewSymmetric};
+
+int convert_matrix(std::istream &is, const std::string &outfile,
+  Symmetry symmetry, int numChunks)
+  {
+  std::string line;
+  long long numRows, numCols, numEntries;
+  if (!next_line(is, line))
+    return 1;
+  std::istringstream(line) >> numRows >> numCols >> numEntries;
+
+  Teuchos::Array<long long> rows, cols;
+  Teuchos::Array<double> vals;
+  for (long long k = 0; k < numEntries; k++)
+    {
+    long long i, j;
+    double v;
+    if (!(is >> i >> j >> v))
+      {
+      std::cerr << "unexpected end of file" << std::endl;
+      return 1;
+      }
+    rows.append(i - 1);
+    cols.append(j - 1);
+    vals.append(v);
+    if (symmetry != General && i != j)
+      {
+      rows.append(j - 1);
+      cols.append(i - 1);
+      vals.append(symmetry == SkewSymmetric ? -v : v);
+      }
+    }
+
+  // sort the entries by row (counting sort, keeps the column order)
+  long long nnz = rows.size();
+  Teuchos::Array<long long> rowPtr(numRows + 1, 0);
+  for (long long k = 0; k < nnz; k++)
+    rowPtr[rows[k] + 1]++;
+  for (long long i = 0; i < numRows; i++)
+    rowPtr[i + 1] += rowPtr[i];
+
+  Teuchos::Array<long long> pos(rowPtr.begin(), rowPtr.end() - 1);
+  Teuchos::Array<long long> colInd(nnz);
+  Teuchos::Array<double> values(nnz);
+  for (long long k = 0; k < nnz; k++)
+    {
+    long long p = pos[rows[k]]++;
+    colInd[p] = cols[k];
+    values[p] = vals[k];
+    }
+
+  Teuchos::Array<long long> chunks;
+  if (numChunks > 0)
+    chunks = HYMLS::BinaryIO::BalancedChunks(rowPtr, numChunks);
+
+  std::cout << "writing a " << numRows << "x" << numCols << " matrix with "
+            << nnz << " nonzeros to " << outfile << std::endl;
+  return HYMLS::BinaryIO::WriteMatrix(outfile, numRows, numCols,
+    rowPtr, colInd, values, chunks) == 0 ? 0 : 1;
+  }
+
+int convert_vector(std::istream &is, const std::string &outfile, int numChunks)
+  {
+  std::string line;
+  long long numRows, numCols;
+  if (!next_line(is, line))
+    return 1;
+  std::istringstream(line) >> numRows >> numCols;
+  if (numCols != 1)
+    {
+    std::cerr << "only arrays with a single column are supported" << std::endl;
+    return 1;
+    }
+
+  Teuchos::Array<double> values(numRows);
+  for (long long i = 0; i < numRows; i++)
+    {
+    if (!(is >> values[i]))
+      {
+      std::cerr << "unexpected end of file" << std::endl;
+      return 1;
+      }
+    }
+
+  // equal chunks, there are no nonzeros to balance
+  Teuchos::Array<long long> chunks;
+  if (numChunks > 0)
+    {
+    Teuchos::Array<long long> rowPtr(numRows + 1);
+    for (long long i = 0; i <= numRows; i++)
+      rowPtr[i] = i;
+    chunks = HYMLS::BinaryIO::BalancedChunks(rowPtr, numChunks);
+    }
+
+  std::cout << "writing a vector of length " << numRows << " to " << outfile << std::endl;
+  return HYMLS::BinaryIO::WriteVector(outfile, values, chunks) == 0 ? 0 : 1;
+  }
+
+  }
+
+int main(int argc, char* argv[])
+  {
+  MPI_Init(&argc, &argv);
+
+  if (argc < 3 || argc > 4)
+    {
+    MPI_Finalize();
+    return usage(argv[0]);
+    }
+
+  std::string infile = argv[1];
+  std::string outfile = argv[2];
+  int numChunks = argc > 3 ? std::atoi(argv[3]) : 0;
+
+  std::ifstream is(infile.c_str());
+  std::string banner;
+  if (!is || !std::getline(is, banner))
+    {
+    std::cerr << "could not read " << infile << std::endl;
+    MPI_Finalize();
+    return 1;
+    }
+
+  // %%MatrixMarket object format field symmetry
+  std::transform(banner.begin(), banner.end(), banner.begin(), ::tolower);
+  std::string header, object, format, field, symmetry;
+  std::istringstream(banner) >> header >> object >> format >> field >> symmetry;
+  if (header != "%%matrixmarket" || object != "matrix" ||
+    (field != "real" && field != "integer"))
+    {
+    std::cerr << infile << " is not a real MatrixMarket matrix, "
+              << "complex and pattern files are not supported" << std::endl;
+    MPI_Finalize();
+    return 1;
+    }
+
+  int ierr = 1;
+  if (format == "coordinate")
+    {
+    // real hermitian matrices are symmetric
+    if (symmetry == "general")
+      ierr = convert_matrix(is, outfile, General, numChunks);
+    else if (symmetry == "symmetric" || symmetry == "hermitian")
+      ierr = convert_matrix(is, outfile, Symmetric, numChunks);
+    else if (symmetry == "skew-symmetric")
+      ierr = convert_matrix(is, outfile, SkewSymmetric, numChunks);
+    else
+      std::cerr << "unknown symmetry '" << symmetry << "'" << std::endl;
+    }
+  else if (format == "array")
+    {
+    if (symmetry == "general")
+      ierr = convert_vector(is, outfile, numChunks);
+    else
+      std::cerr << "only general arrays are supported" << std::endl;
+    }
+  else
+    {
+    std::cerr << "unknown format '" << format << "'" << std::endl;
+    }
+
+  MPI_Finalize();
+  return ierr;
+  }
@@ -0,0 +1,299 @@
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include <mpi.h>
+
+#include "HYMLS_config.h"
+
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_ParameterList.hpp"
+#include "Teuchos_XMLParameterListHelpers.hpp"
+#include "Teuchos_StandardCatchMacros.hpp"
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_Tools.hpp"
+#include "HYMLS_CartesianPartitioner.hpp"
+#include "HYMLS_HierarchicalMap.hpp"
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+
+#include "HYMLS_FakeComm.hpp"
+
+/*
+  Setup scalability benchmark. This driver runs the steps that the
+  OverlappingPartitioner performs on every level of the preconditioner
+  (CreatePIDMap, Partition, DetectSeparators, FillComplete and spawning the
+  next level) as they would run on a single process of a very large run.
+  The communicator is a FakeComm that pretends to be process "Process ID"
+  out of "Number of Processes", so the cost of everything that scales with
+  the global number of processes or subdomains shows up in the timing and
+  memory reports while only one process is actually used.
+
+  Communication between processes can not be simulated, so
+  - the overlapping map is constructed locally and passed to FillComplete,
+    which therefore skips the Import that determines the separator nodes
+    owned by other processes.
+  - levels on which the partitioner would move nodes to other processes
+    (typically the coarse levels with fewer subdomains than processes) are
+    not simulated. The benchmark stops at the first such level.
+
+  USAGE: setup_benchmark <parameter_filename>
+
+  The parameter file contains the usual "Problem" and "Preconditioner"
+  sublists and a "Benchmark" sublist with the "Number of Processes" and the
+  "Process ID" to simulate (-1 for a process in the middle of the domain).
+*/
+
+//! partitioner that times CreatePIDMap and that does not move any nodes
+class BenchmarkPartitioner : public HYMLS::CartesianPartitioner
+  {
+public:
+  BenchmarkPartitioner(Teuchos::RCP<const Epetra_Map> map,
+    Teuchos::RCP<Teuchos::ParameterList> const &params,
+    Epetra_Comm const &comm, int level)
+    :
+    CartesianPartitioner(map, params, comm, level),
+    repartitioned_(false)
+    {}
+
+  //! number of processes the subdomains are distributed over
+  int NumProcs() const {return nprocs_;}
+
+  //! true if Partition() tried to move nodes to other processes
+  bool Repartitioned() const {return repartitioned_;}
+
+  //! true if the node belongs to one of the subdomains of this process
+  bool MyGID(hymls_gidx gid) const
+    {
+    return SubdomainMap().MyGID((*this)(gid));
+    }
+
+protected:
+
+  int CreatePIDMap()
+    {
+    HYMLS::TimerObject timer("SetupBenchmark_L" +
+      Teuchos::toString(myLevel_) + ": CreatePIDMap", true);
+    return CartesianPartitioner::CreatePIDMap();
+    }
+
+  Teuchos::RCP<const Epetra_Map> RepartitionMap(
+    Teuchos::RCP<const Epetra_Map> baseMap) const
+    {
+    // this would require actual communication
+    repartitioned_ = true;
+    return baseMap;
+    }
+
+  mutable bool repartitioned_;
+  };
+
+//! HierarchicalMap that allows us to insert the groups ourselves
+class BenchmarkHierarchicalMap : public HYMLS::HierarchicalMap
+  {
+public:
+  BenchmarkHierarchicalMap(Teuchos::RCP<const Epetra_Map> map,
+    Teuchos::RCP<const Epetra_Map> overlappingMap, int level)
+    :
+    HierarchicalMap(map, overlappingMap, 0, "OverlappingPartitioner", level)
+    {}
+
+  //! same as OverlappingPartitioner::DetectSeparators without the FillComplete
+  int DetectSeparators(HYMLS::BasePartitioner const &partitioner)
+    {
+    CHECK_ZERO(Reset(partitioner.NumLocalParts()));
+    for (int sd = 0; sd < partitioner.NumLocalParts(); sd++)
+      {
+      HYMLS::InteriorGroup interior_group;
+      Teuchos::Array<HYMLS::SeparatorGroup> separator_groups;
+
+      CHECK_ZERO(partitioner.GetGroups(sd, interior_group, separator_groups));
+
+      interior_group.sort();
+      CHECK_ZERO(AddInteriorGroup(sd, interior_group));
+
+      for (auto &group: separator_groups)
+        {
+        group.sort();
+        CHECK_ZERO(AddSeparatorGroup(sd, group));
+        }
+      }
+    return 0;
+    }
+
+  int FillComplete()
+    {
+    return HYMLS::HierarchicalMap::FillComplete();
+    }
+  };
+
+//! Create the map of nodes in the local subdomains of the partitioner. If
+//! overlapping is false, only the nodes that are owned by this process
+//! are included.
+Teuchos::RCP<const Epetra_Map> CreateLocalMap(
+  BenchmarkPartitioner const &partitioner, bool overlapping)
+  {
+  Teuchos::Array<hymls_gidx> gids;
+  for (int sd = 0; sd < partitioner.NumLocalParts(); sd++)
+    {
+    HYMLS::InteriorGroup interior_group;
+    Teuchos::Array<HYMLS::SeparatorGroup> separator_groups;
+    CHECK_ZERO(partitioner.GetGroups(sd, interior_group, separator_groups));
+
+    for (hymls_gidx gid: interior_group.nodes())
+      if (overlapping || partitioner.MyGID(gid))
+        gids.append(gid);
+
+    for (auto const &group: separator_groups)
+      for (hymls_gidx gid: group.nodes())
+        if (overlapping || partitioner.MyGID(gid))
+          gids.append(gid);
+    }
+
+  std::sort(gids.begin(), gids.end());
+  gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+
+  return Teuchos::rcp(new Epetra_Map((hymls_gidx)(-1), gids.size(),
+      gids.getRawPtr(), (hymls_gidx)0, partitioner.Map().Comm()));
+  }
+
+//! Same as SchurPreconditioner::CreateVSumMap: retain the first node of
+//! every separator group for the next level.
+Teuchos::RCP<const Epetra_Map> CreateVSumMap(HYMLS::HierarchicalMap const &sepObject)
+  {
+  Teuchos::Array<hymls_gidx> gids;
+  for (int sd = 0; sd < sepObject.NumMySubdomains(); sd++)
+    for (HYMLS::SeparatorGroup const &group: sepObject.GetSeparatorGroups(sd))
+      if (group.length() > 0)
+        gids.append(group[0]);
+
+  return Teuchos::rcp(new Epetra_Map((hymls_gidx)(-1), gids.size(),
+      gids.getRawPtr(), (hymls_gidx)0, sepObject.Comm()));
+  }
+
+int main(int argc, char* argv[])
+  {
+  MPI_Init(&argc, &argv);
+
+  bool status = true;
+
+  // everything is done on one process, the timings and memory usage
+  // reported by HYMLS::Tools are those of the simulated process
+  Teuchos::RCP<const Epetra_MpiComm> comm = Teuchos::rcp(
+    new Epetra_MpiComm(MPI_COMM_SELF));
+
+  HYMLS::Tools::InitializeIO(comm);
+
+  try {
+
+  if (argc < 2)
+    {
+    HYMLS::Tools::Out("USAGE: setup_benchmark <parameter_filename>");
+    MPI_Finalize();
+    return 0;
+    }
+
+  Teuchos::RCP<Teuchos::ParameterList> params =
+    Teuchos::getParametersFromXmlFile(argv[1]);
+
+  Teuchos::ParameterList &benchList = params->sublist("Benchmark");
+  int nprocs = benchList.get("Number of Processes", 32768);
+  int pid = benchList.get("Process ID", -1);
+  params->remove("Benchmark");
+
+  if (pid < 0)
+    pid = nprocs / 2;
+
+  int numLevels = params->sublist("Preconditioner").get("Number of Levels", 1);
+
+  Teuchos::RCP<FakeComm> fakeComm = Teuchos::rcp(new FakeComm);
+  fakeComm->SetNumProc(nprocs);
+  fakeComm->SetMyPID(pid);
+
+  HYMLS::Tools::Out("Simulating process " + Teuchos::toString(pid) +
+    " of " + Teuchos::toString(nprocs));
+
+  // Initial cartesian map and overlapping map of the simulated process
+  Teuchos::RCP<const Epetra_Map> map;
+  Teuchos::RCP<const Epetra_Map> overlappingMap;
+    {
+    BenchmarkPartitioner partitioner(Teuchos::null, params, *fakeComm, -1);
+    CHECK_ZERO(partitioner.Partition(false));
+    if (partitioner.NumProcs() != nprocs)
+      HYMLS::Tools::Error("The domain can not be divided over " +
+        Teuchos::toString(nprocs) + " processes without repartitioning",
+        __FILE__, __LINE__);
+
+    map = CreateLocalMap(partitioner, false);
+    overlappingMap = CreateLocalMap(partitioner, true);
+    }
+
+  // keep all levels alive, like the preconditioner does
+  Teuchos::Array<Teuchos::RCP<const HYMLS::HierarchicalMap> > levels;
+
+  Teuchos::RCP<Teuchos::ParameterList> levelParams = params;
+  for (int level = 0; level < numLevels; level++)
+    {
+    std::string label = "SetupBenchmark_L" + Teuchos::toString(level) + ": ";
+
+    Teuchos::RCP<BenchmarkPartitioner> partitioner = Teuchos::rcp(
+      new BenchmarkPartitioner(map, levelParams, *fakeComm, level));
+      {
+      HYMLS::TimerObject timer(label + "Partition", true);
+      CHECK_ZERO(partitioner->Partition(false));
+      }
+
+    if (partitioner->Repartitioned())
+      {
+      HYMLS::Tools::Out("Level " + Teuchos::toString(level) +
+        " requires repartitioning onto " + Teuchos::toString(partitioner->NumProcs()) +
+        " processes, which can not be simulated");
+      break;
+      }
+
+    HYMLS::Tools::Out("Level " + Teuchos::toString(level) + ": " +
+      Teuchos::toString(partitioner->NumLocalParts()) + " local subdomains, " +
+      Teuchos::toString(map->NumMyElements()) + " local nodes, " +
+      Teuchos::toString(overlappingMap->NumMyElements()) + " overlapping nodes");
+
+    Teuchos::RCP<BenchmarkHierarchicalMap> hid = Teuchos::rcp(
+      new BenchmarkHierarchicalMap(partitioner->GetMap(), overlappingMap, level));
+      {
+      HYMLS::TimerObject timer(label + "DetectSeparators", true);
+      CHECK_ZERO(hid->DetectSeparators(*partitioner));
+      }
+      {
+      HYMLS::TimerObject timer(label + "FillComplete", true);
+      CHECK_ZERO(hid->FillComplete());
+      }
+    levels.append(hid);
+
+    if (level + 1 == numLevels)
+      break;
+
+      {
+      HYMLS::TimerObject timer(label + "SpawnNextLevel", true);
+      map = CreateVSumMap(*hid->Spawn(HYMLS::HierarchicalMap::LocalSeparators));
+      overlappingMap = CreateVSumMap(*hid->Spawn(HYMLS::HierarchicalMap::Separators));
+
+      levelParams = Teuchos::rcp(new Teuchos::ParameterList(*levelParams));
+      partitioner->SetNextLevelParameters(*levelParams);
+      }
+    }
+
+  } TEUCHOS_STANDARD_CATCH_STATEMENTS(true, std::cerr, status);
+
+  if (!status)
+    HYMLS::Tools::Fatal("Caught an exception", __FILE__, __LINE__);
+
+  HYMLS::Tools::PrintTiming(HYMLS::Tools::out());
+  HYMLS::Tools::PrintMemUsage(HYMLS::Tools::out());
+
+  MPI_Finalize();
+  return 0;
+  }
@@ -0,0 +1,122 @@
+#include "GaleriExt_RowAssembly.h"
+#include "HYMLS_Macros.hpp"
+
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Vector.h"
+
+#include "HYMLS_UnitTests.hpp"
+
+#include <vector>
+
+TEUCHOS_UNIT_TEST(GaleriExt, AssembleRows)
+{
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+
+  const int n = 100;
+  Teuchos::RCP<Epetra_Map> map = HYMLS::UnitTests::create_random_map(Comm, n, 1);
+
+  // tridiagonal matrix with row i in the diagonal, the last row is empty
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(
+    GaleriExt::Matrices::AssembleRows<hymls_gidx>(map.get(), 3,
+      [&](hymls_gidx row, GaleriExt::Matrices::RowEntries<hymls_gidx>& Entries)
+  {
+    if (row == n - 1)
+      return;
+    for (hymls_gidx col = row - 1; col <= row + 1; col++)
+    {
+      if (col < 0 || col >= n)
+        continue;
+      Entries.Append(col, col == row ? (double)row : -1.0);
+    }
+  }));
+
+  TEST_ASSERT(A->Filled());
+  TEST_ASSERT(A->StorageOptimized());
+  TEST_EQUALITY(A->NumGlobalNonzeros64(), (long long)(3 * n - 4));
+
+  for (int i = 0; i < A->NumMyRows(); i++)
+  {
+    hymls_gidx row = A->GRID64(i);
+    int len;
+    double *vals;
+    int *inds;
+    CHECK_ZERO(A->ExtractMyRowView(i, len, vals, inds));
+    TEST_EQUALITY(A->Graph().NumAllocatedMyIndices(i), len);
+    for (int j = 0; j < len; j++)
+    {
+      hymls_gidx col = A->GCID64(inds[j]);
+      TEST_EQUALITY(vals[j], col == row ? (double)row : -1.0);
+    }
+  }
+}
+
+TEUCHOS_UNIT_TEST(GaleriExt, AssembleRowsDuplicates)
+{
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+
+  const int n = 100;
+  Teuchos::RCP<Epetra_Map> map = HYMLS::UnitTests::create_random_map(Comm, n, 1);
+
+  // the same periodic tridiagonal stencil, in descending order and with
+  // the diagonal split in two entries that have to be added
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(
+    GaleriExt::Matrices::AssembleRows<hymls_gidx>(map.get(), 4,
+      [&](hymls_gidx row, GaleriExt::Matrices::RowEntries<hymls_gidx>& Entries)
+  {
+    Entries.Append((row + 1) % n, -1.0);
+    Entries.Append(row, 1.0);
+    Entries.Append((row + n - 1) % n, -1.0);
+    Entries.Append(row, 1.0);
+  }));
+
+  TEST_ASSERT(A->Filled());
+  TEST_EQUALITY(A->NumGlobalNonzeros64(), (long long)(3 * n));
+
+  Epetra_Vector x(A->OperatorDomainMap());
+  Epetra_Vector y(A->OperatorRangeMap());
+  CHECK_ZERO(x.PutScalar(1.0));
+  CHECK_ZERO(A->Multiply(false, x, y));
+  double norm;
+  CHECK_ZERO(y.NormInf(&norm));
+  TEST_FLOATING_EQUALITY(norm + 1.0, 1.0, 1e-14);
+
+  for (int i = 0; i < A->NumMyRows(); i++)
+  {
+    int len;
+    double *vals;
+    int *inds;
+    CHECK_ZERO(A->ExtractMyRowView(i, len, vals, inds));
+    TEST_EQUALITY(len, 3);
+    for (int j = 1; j < len; j++)
+      TEST_COMPARE(inds[j - 1], <, inds[j]);
+  }
+}
+
+TEUCHOS_UNIT_TEST(GaleriExt, AssembleRowsTooManyEntries)
+{
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+
+  const int n = 100;
+  const int MaxNumEntries = 3;
+  Teuchos::RCP<Epetra_Map> map = HYMLS::UnitTests::create_random_map(Comm, n, 1);
+
+  // pentadiagonal stencil that does not fit in the space for a
+  // tridiagonal one. The entries that do not fit should not be stored
+  std::vector<int> numStored(map->NumMyElements(), 0);
+  TEST_THROW(GaleriExt::Matrices::AssembleRows<hymls_gidx>(map.get(), MaxNumEntries,
+      [&](hymls_gidx row, GaleriExt::Matrices::RowEntries<hymls_gidx>& Entries)
+  {
+    for (hymls_gidx col = row - 2; col <= row + 2; col++)
+      Entries.Append(col, 1.0);
+    TEUCHOS_ASSERT_EQUALITY(Entries.Capacity(), MaxNumEntries);
+    int j = 0;
+    for (; j < Entries.Capacity(); j++)
+      if (Entries.Index(j) != row - 2 + j)
+        break;
+    numStored[map->LID(row)] = j;
+  }), const char*);
+
+  TEST_COMPARE_ARRAYS(numStored, std::vector<int>(map->NumMyElements(), MaxNumEntries));
+}
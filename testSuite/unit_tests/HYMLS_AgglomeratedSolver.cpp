@@ -0,0 +1,46 @@
+#include "HYMLS_AgglomeratedSolver.hpp"
+
+#include <Teuchos_RCP.hpp>
+
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+
+#include <algorithm>
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(AgglomeratedSolver, NumActiveProcs)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  int nprocs = comm.NumProc();
+
+  Epetra_Map map(100 * nprocs, 0, comm);
+  TEST_EQUALITY(HYMLS::AgglomeratedSolver::NumActiveProcs(map, 0), nprocs);
+  TEST_EQUALITY(HYMLS::AgglomeratedSolver::NumActiveProcs(map, 50), nprocs);
+  TEST_EQUALITY(HYMLS::AgglomeratedSolver::NumActiveProcs(map, 200), std::max(nprocs / 2, 1));
+  TEST_EQUALITY(HYMLS::AgglomeratedSolver::NumActiveProcs(map, 1000000), 1);
+  }
+
+TEUCHOS_UNIT_TEST(AgglomeratedSolver, ActiveMap)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  int nprocs = comm.NumProc();
+  int numActive = std::max(nprocs / 2, 1);
+
+  Teuchos::RCP<Epetra_Map> map = Teuchos::rcp(new Epetra_Map(20 * nprocs, 0, comm));
+  HYMLS::AgglomeratedSolver solver(map, numActive, 2);
+
+  int isActive = solver.IsActive() ? 1 : 0;
+  int numActiveFound;
+  comm.SumAll(&isActive, &numActiveFound, 1);
+  TEST_EQUALITY(numActiveFound, numActive);
+
+  // all rows end up on the active processes
+  if (solver.IsActive())
+    {
+    TEST_EQUALITY(solver.ActiveMap()->NumGlobalElements64(), map->NumGlobalElements64());
+    TEST_EQUALITY(solver.ActiveMap()->Comm().NumProc(), numActive);
+    }
+  }
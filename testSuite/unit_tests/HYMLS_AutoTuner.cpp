@@ -0,0 +1,85 @@
+#include "HYMLS_AutoTuner.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_Array.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+#include <Epetra_CrsMatrix.h>
+
+#include "HYMLS_Macros.hpp"
+#include "HYMLS_MatrixUtils.hpp"
+#include "HYMLS_CartesianPartitioner.hpp"
+
+#include "HYMLS_UnitTests.hpp"
+
+#include <limits>
+
+TEUCHOS_UNIT_TEST(AutoTuner, SetCandidate)
+  {
+  Teuchos::ParameterList params;
+  Teuchos::ParameterList &precList = params.sublist("Preconditioner");
+  precList.set("Separator Length (x)", 4);
+  precList.set("Separator Length (z)", 1);
+
+  HYMLS::AutoTuner::SetCandidate(params, "Separator Length", "8");
+  TEST_EQUALITY(precList.get("Separator Length", 0), 8);
+  TEST_EQUALITY(precList.get("Separator Length (x)", 0), 8);
+  TEST_EQUALITY(precList.get("Separator Length (z)", 0), 1);
+  TEST_EQUALITY(precList.isParameter("Separator Length (y)"), false);
+
+  HYMLS::AutoTuner::SetCandidate(params, "Subdomain Solver Type", "Dense");
+  TEST_EQUALITY(precList.get("Subdomain Solver Type", ""), "Dense");
+  }
+
+TEUCHOS_UNIT_TEST(AutoTuner, Tune)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::ParameterList &problemList = params->sublist("Problem");
+  problemList.set("Degrees of Freedom", 1);
+  problemList.set("Dimension", 2);
+  problemList.set("nx", 32);
+  problemList.set("ny", 32);
+
+  Teuchos::ParameterList &precList = params->sublist("Preconditioner");
+  precList.set("Separator Length", 4);
+  precList.set("Number of Levels", 1);
+
+  Teuchos::ParameterList &tunerList = params->sublist("Autotuner");
+  tunerList.set("Separator Length Candidates", Teuchos::Array<int>(Teuchos::tuple<int>(4, 8)));
+  tunerList.set("Output File", "");
+
+  HYMLS::CartesianPartitioner part(Teuchos::null, params, comm);
+  CHECK_ZERO(part.Partition(true));
+
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(new Epetra_CrsMatrix(Copy, part.Map(), 1));
+  for (int i = 0; i < A->NumMyRows(); i++)
+    {
+    hymls_gidx gid = A->GRID64(i);
+    double val = 1.0 + i % 3;
+    CHECK_ZERO(A->InsertGlobalValues(gid, 1, &val, &gid));
+    }
+  CHECK_ZERO(A->FillComplete());
+
+  Epetra_MultiVector b(A->RowMap(), 1);
+  CHECK_ZERO(HYMLS::MatrixUtils::Random(b));
+
+  HYMLS::AutoTuner tuner(A, params);
+  TEST_EQUALITY(tuner.Tune(b), 0);
+
+  // the initial Separator Length is one of the candidates, so it is
+  // taken from the cache
+  TEST_EQUALITY(tuner.NumTrials(), 2);
+  TEST_INEQUALITY(tuner.BestCost(), std::numeric_limits<double>::infinity());
+
+  Teuchos::RCP<const Teuchos::ParameterList> best = tuner.BestParameters();
+  TEST_EQUALITY(best->isSublist("Autotuner"), false);
+
+  int sepx = best->sublist("Preconditioner").get<int>("Separator Length");
+  TEST_EQUALITY(sepx == 4 || sepx == 8, true);
+  }
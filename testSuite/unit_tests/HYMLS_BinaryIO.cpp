@@ -0,0 +1,139 @@
+#include "HYMLS_BinaryIO.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_Array.hpp>
+#include <Teuchos_toString.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_CrsMatrix.h>
+#include <Epetra_Vector.h>
+
+#include "HYMLS_Macros.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(BinaryIO, Matrix)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  // tridiagonal matrix with A(i,j) = 10 * i + j
+  long long n = 20;
+  Teuchos::Array<long long> rowPtr(1, 0), colInd;
+  Teuchos::Array<double> values;
+  for (long long i = 0; i < n; i++)
+    {
+    for (long long j = std::max(i - 1, 0LL); j < std::min(i + 2, n); j++)
+      {
+      colInd.append(j);
+      values.append(10 * i + j);
+      }
+    rowPtr.append(colInd.size());
+    }
+
+  std::string filename = "binary_io_test_" + Teuchos::toString(comm.NumProc()) + ".bin";
+
+  // once with chunks for every process and once without
+  for (int numChunks = 0; numChunks <= comm.NumProc(); numChunks += comm.NumProc())
+    {
+    if (comm.MyPID() == 0)
+      {
+      Teuchos::Array<long long> chunks;
+      if (numChunks > 0)
+        chunks = HYMLS::BinaryIO::BalancedChunks(rowPtr, numChunks);
+      TEST_EQUALITY(HYMLS::BinaryIO::WriteMatrix(filename, n, n,
+          rowPtr, colInd, values, chunks), 0);
+      }
+    comm.Barrier();
+
+    // a map that is not linear
+    Teuchos::Array<hymls_gidx> gids;
+    for (hymls_gidx i = comm.MyPID(); i < n; i += comm.NumProc())
+      gids.append(i);
+    Epetra_Map map((hymls_gidx)n, gids.size(), gids.getRawPtr(), (hymls_gidx)0, comm);
+
+    Teuchos::RCP<Epetra_CrsMatrix> A = HYMLS::BinaryIO::ReadMatrix(filename, map);
+    TEST_EQUALITY(A->NumGlobalNonzeros64(), colInd.size());
+    for (int i = 0; i < A->NumMyRows(); i++)
+      {
+      int len;
+      double *vals;
+      int *inds;
+      CHECK_ZERO(A->ExtractMyRowView(i, len, vals, inds));
+      hymls_gidx row = A->GRID64(i);
+      TEST_EQUALITY(len, (row == 0 || row == n - 1) ? 2 : 3);
+      for (int j = 0; j < len; j++)
+        TEST_EQUALITY(vals[j], 10 * row + A->GCID64(inds[j]));
+      }
+
+    comm.Barrier();
+    if (comm.MyPID() == 0)
+      std::remove(filename.c_str());
+    }
+  }
+
+TEUCHOS_UNIT_TEST(BinaryIO, Vector)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  int n = 15;
+  Teuchos::Array<double> values(n);
+  for (int i = 0; i < n; i++)
+    values[i] = 2.0 * i;
+
+  std::string filename = "binary_io_test_vec_" + Teuchos::toString(comm.NumProc()) + ".bin";
+  if (comm.MyPID() == 0)
+    {
+    TEST_EQUALITY(HYMLS::BinaryIO::WriteVector(filename, values), 0);
+    }
+  comm.Barrier();
+
+  Epetra_Map map((hymls_gidx)n, 0, comm);
+  Teuchos::RCP<Epetra_Vector> v = HYMLS::BinaryIO::ReadVector(filename, map);
+  for (int i = 0; i < v->MyLength(); i++)
+    TEST_EQUALITY((*v)[i], 2.0 * map.GID64(i));
+
+  comm.Barrier();
+  if (comm.MyPID() == 0)
+    std::remove(filename.c_str());
+  }
+
+TEUCHOS_UNIT_TEST(BinaryIO, DistributedVector)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  hymls_gidx n = 15;
+
+  // a map that is not linear, with index base 1
+  Teuchos::Array<hymls_gidx> gids;
+  for (hymls_gidx i = comm.MyPID(); i < n; i += comm.NumProc())
+    gids.append(i + 1);
+  Epetra_Map map(n, gids.size(), gids.getRawPtr(), (hymls_gidx)1, comm);
+
+  Epetra_Vector v(map);
+  for (int i = 0; i < v.MyLength(); i++)
+    v[i] = 2.0 * map.GID64(i);
+
+  std::string filename = "binary_io_test_dvec_" + Teuchos::toString(comm.NumProc()) + ".bin";
+  TEST_EQUALITY(HYMLS::BinaryIO::WriteVector(filename, v), 0);
+
+  // read it back with a linear map and with the original one
+  Epetra_Map linearMap(n, (hymls_gidx)1, comm);
+  Teuchos::RCP<Epetra_Vector> w = HYMLS::BinaryIO::ReadVector(filename, linearMap);
+  for (int i = 0; i < w->MyLength(); i++)
+    TEST_EQUALITY((*w)[i], 2.0 * linearMap.GID64(i));
+
+  w = HYMLS::BinaryIO::ReadVector(filename, map);
+  for (int i = 0; i < w->MyLength(); i++)
+    TEST_EQUALITY((*w)[i], v[i]);
+
+  comm.Barrier();
+  if (comm.MyPID() == 0)
+    std::remove(filename.c_str());
+  }
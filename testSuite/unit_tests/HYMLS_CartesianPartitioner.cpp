@@ -13,6 +13,9 @@
 #include "HYMLS_InteriorGroup.hpp"
 #include "HYMLS_SeparatorGroup.hpp"
 
+#include <algorithm>
+#include <vector>
+
 TEUCHOS_UNIT_TEST(CartesianPartitioner, Partition2D)
   {
   Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
@@ -186,3 +189,78 @@ TEUCHOS_UNIT_TEST(CartesianPartitioner, GID64)
   TEST_EQUALITY(interior_group.nodes().back(), last);
   }
 #endif
+
+class TestableCartesianPartitioner : public HYMLS::CartesianPartitioner
+  {
+public:
+  TestableCartesianPartitioner(Teuchos::RCP<Teuchos::ParameterList> const &params,
+    Epetra_Comm const &comm)
+    :
+    HYMLS::CartesianPartitioner(Teuchos::null, params, comm)
+    {}
+
+  using HYMLS::CartesianPartitioner::CreatePIDMap;
+  using HYMLS::CartesianPartitioner::SubdomainCost;
+  using HYMLS::CartesianPartitioner::PID;
+  };
+
+TEUCHOS_UNIT_TEST(CartesianPartitioner, LoadBalancing)
+  {
+  int nprocs = 4;
+  Teuchos::RCP<FakeComm> comm = Teuchos::rcp(new FakeComm);
+  comm->SetNumProc(nprocs);
+  DISABLE_OUTPUT;
+
+  // 4x4 subdomains of which the last row and column are small
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(
+    new Teuchos::ParameterList);
+  params->sublist("Problem").set("nx", 20);
+  params->sublist("Problem").set("ny", 20);
+  params->sublist("Problem").set("nz", 1);
+  params->sublist("Problem").set("Dimension", 2);
+  params->sublist("Problem").set("Degrees of Freedom", 1);
+  params->sublist("Preconditioner").set("Separator Length", 6);
+
+  Teuchos::RCP<Teuchos::ParameterList> balancedParams = Teuchos::rcp(
+    new Teuchos::ParameterList(*params));
+  balancedParams->sublist("Preconditioner").set("Load Balancing", true);
+
+  TestableCartesianPartitioner part(params, *comm);
+  TEST_EQUALITY(part.CreatePIDMap(), 0);
+
+  std::vector<TestableCartesianPartitioner> balancedParts;
+  for (int pid = 0; pid < nprocs; pid++)
+    {
+    comm->SetMyPID(pid);
+    balancedParts.emplace_back(balancedParams, *comm);
+    TEST_EQUALITY(balancedParts.back().CreatePIDMap(), 0);
+    }
+
+  ENABLE_OUTPUT;
+
+  std::vector<double> load(nprocs, 0.0);
+  std::vector<double> balancedLoad(nprocs, 0.0);
+  std::vector<int> count(nprocs, 0);
+  for (int sd = 0; sd < 16; sd++)
+    {
+    int x = (sd % 4) * 6;
+    int y = (sd / 4) * 6;
+    int pid = balancedParts[0].PID(x, y, 0);
+
+    load[part.PID(x, y, 0)] += part.SubdomainCost(sd);
+    balancedLoad[pid] += balancedParts[0].SubdomainCost(sd);
+    count[pid]++;
+
+    // All processes compute the same distribution
+    for (int i = 1; i < nprocs; i++)
+      TEST_EQUALITY(balancedParts[i].PID(x, y, 0), pid);
+    }
+
+  // Every process keeps at least one subdomain
+  for (int i = 0; i < nprocs; i++)
+    TEST_INEQUALITY(count[i], 0);
+
+  double maxLoad = *std::max_element(load.begin(), load.end());
+  double maxBalancedLoad = *std::max_element(balancedLoad.begin(), balancedLoad.end());
+  TEST_COMPARE(maxBalancedLoad, <, maxLoad);
+  }
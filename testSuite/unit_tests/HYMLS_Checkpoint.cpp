@@ -0,0 +1,181 @@
+#include "HYMLS_Checkpoint.hpp"
+
+#include "HYMLS_HierarchicalMap.hpp"
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+#include "HYMLS_Macros.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_Array.hpp>
+#include <Teuchos_toString.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_CrsMatrix.h>
+#include <Epetra_MultiVector.h>
+#include <Epetra_SerialDenseMatrix.h>
+
+#include <cstdio>
+
+#include "HYMLS_UnitTests.hpp"
+
+#ifdef HAVE_HDF5
+
+namespace
+  {
+class TestableHierarchicalMap : public HYMLS::HierarchicalMap
+  {
+public:
+  TestableHierarchicalMap(Teuchos::RCP<const Epetra_Map> baseMap)
+    :
+    HierarchicalMap(baseMap)
+    {}
+
+  // two subdomains per process, the first half of the nodes is interior
+  // and the rest is one separator group
+  void Partition()
+    {
+    const Epetra_Map &map = *GetMap();
+    Reset(2);
+    for (int sd = 0; sd < 2; sd++)
+      {
+      HYMLS::InteriorGroup interior;
+      HYMLS::SeparatorGroup sep;
+      sep.set_type(sd + 1);
+      for (int lid = sd; lid < map.NumMyElements(); lid += 2)
+        {
+        if (lid < map.NumMyElements() / 2)
+          interior.append(map.GID64(lid));
+        else
+          sep.append(map.GID64(lid));
+        }
+      AddInteriorGroup(sd, interior);
+      AddSeparatorGroup(sd, sep);
+      }
+    FillComplete();
+    }
+  };
+  }
+
+TEUCHOS_UNIT_TEST(Checkpoint, MatrixAndVectors)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  hymls_gidx n = 30;
+  std::string filename = "checkpoint_test_" + Teuchos::toString(comm.NumProc()) + ".h5";
+
+  Epetra_Map map(n, 0, comm);
+  Epetra_CrsMatrix A(Copy, map, 3);
+  for (int i = 0; i < map.NumMyElements(); i++)
+    {
+    hymls_gidx row = map.GID64(i);
+    for (hymls_gidx col = row - 1; col <= row + 1; col++)
+      {
+      if (col < 0 || col >= n)
+        continue;
+      double value = 10.0 * row + col;
+      CHECK_ZERO(A.InsertGlobalValues(row, 1, &value, &col));
+      }
+    }
+  CHECK_ZERO(A.FillComplete());
+
+  Epetra_MultiVector x(map, 2);
+  CHECK_ZERO(x.Random());
+
+  Epetra_SerialDenseMatrix C(2, 3);
+  for (int j = 0; j < 3; j++)
+    for (int i = 0; i < 2; i++)
+      C(i, j) = i + 10 * j;
+
+    {
+    HYMLS::Checkpoint checkpoint(comm, filename, true);
+    checkpoint.Write("A", A);
+    checkpoint.Write("x", x);
+    checkpoint.Write("C", C);
+    checkpoint.Write("Continuation", "Parameter", 0.5);
+    }
+
+  // read with a different distribution
+  Teuchos::Array<hymls_gidx> gids;
+  for (hymls_gidx i = comm.NumProc() - 1 - comm.MyPID(); i < n; i += comm.NumProc())
+    gids.append(i);
+  Epetra_Map otherMap(n, gids.size(), gids.getRawPtr(), 0, comm);
+
+  HYMLS::Checkpoint checkpoint(comm, filename);
+  TEST_ASSERT(checkpoint.IsContained("A"));
+
+  Teuchos::RCP<Epetra_CrsMatrix> B = checkpoint.ReadMatrix("A", otherMap);
+  TEST_EQUALITY(B->NumGlobalNonzeros64(), A.NumGlobalNonzeros64());
+  for (int i = 0; i < B->NumMyRows(); i++)
+    {
+    int len;
+    double *vals;
+    int *inds;
+    CHECK_ZERO(B->ExtractMyRowView(i, len, vals, inds));
+    for (int j = 0; j < len; j++)
+      TEST_EQUALITY(vals[j], 10.0 * B->GRID64(i) + B->GCID64(inds[j]));
+    }
+
+  Teuchos::RCP<Epetra_MultiVector> y = checkpoint.ReadMultiVector("x", map);
+  TEST_EQUALITY(y->NumVectors(), 2);
+  for (int k = 0; k < 2; k++)
+    for (int i = 0; i < map.NumMyElements(); i++)
+      TEST_EQUALITY((*y)[k][i], x[k][i]);
+
+  Teuchos::RCP<Epetra_SerialDenseMatrix> D = checkpoint.ReadSerialDenseMatrix("C");
+  TEST_EQUALITY(D->M(), 2);
+  TEST_EQUALITY(D->N(), 3);
+  for (int j = 0; j < 3; j++)
+    for (int i = 0; i < 2; i++)
+      TEST_EQUALITY((*D)(i, j), C(i, j));
+
+  TEST_EQUALITY(checkpoint.ReadScalar("Continuation", "Parameter"), 0.5);
+
+  comm.Barrier();
+  if (comm.MyPID() == 0)
+    std::remove(filename.c_str());
+  }
+
+TEUCHOS_UNIT_TEST(Checkpoint, HierarchicalMap)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  std::string filename = "checkpoint_hid_test_" + Teuchos::toString(comm->NumProc()) + ".h5";
+
+  Teuchos::RCP<Epetra_Map> map = Teuchos::rcp(new Epetra_Map((hymls_gidx)40, 0, *comm));
+  TestableHierarchicalMap hmap(map);
+  hmap.Partition();
+
+    {
+    HYMLS::Checkpoint checkpoint(*comm, filename, true);
+    checkpoint.Write("Partition", hmap);
+    }
+
+  TestableHierarchicalMap restored(map);
+  HYMLS::Checkpoint checkpoint(*comm, filename);
+  TEST_EQUALITY(checkpoint.Read("Partition", restored), 0);
+
+  TEST_EQUALITY(restored.NumMySubdomains(), hmap.NumMySubdomains());
+  for (int sd = 0; sd < hmap.NumMySubdomains(); sd++)
+    {
+    TEST_COMPARE_ARRAYS(restored.GetInteriorGroup(sd).nodes(),
+      hmap.GetInteriorGroup(sd).nodes());
+    TEST_EQUALITY(restored.NumSeparatorGroups(sd), hmap.NumSeparatorGroups(sd));
+    for (int grp = 0; grp < hmap.NumSeparatorGroups(sd); grp++)
+      {
+      TEST_EQUALITY(restored.GetSeparatorGroups(sd)[grp].type(),
+        hmap.GetSeparatorGroups(sd)[grp].type());
+      TEST_COMPARE_ARRAYS(restored.GetSeparatorGroups(sd)[grp].nodes(),
+        hmap.GetSeparatorGroups(sd)[grp].nodes());
+      }
+    }
+  TEST_ASSERT(restored.GetOverlappingMap()->SameAs(*hmap.GetOverlappingMap()));
+
+  comm->Barrier();
+  if (comm->MyPID() == 0)
+    std::remove(filename.c_str());
+  }
+
+#endif
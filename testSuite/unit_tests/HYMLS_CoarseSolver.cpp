@@ -74,6 +74,77 @@ TEUCHOS_UNIT_TEST(CoarseSolver, ApplyInverse)
   TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(*X, *X_EX), <, 1e-10);
   }
 
+TEUCHOS_UNIT_TEST(CoarseSolver, ReplicatedApplyInverse)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  params->set("Replicated Coarse Solve", true);
+  Teuchos::RCP<HYMLS::CoarseSolver> solver = createCoarseSolver(params, comm);
+  int ierr = solver->Initialize();
+  TEST_EQUALITY(ierr, 0);
+
+  ierr = solver->Compute();
+  TEST_EQUALITY(ierr, 0);
+
+  Epetra_Map const &map = solver->OperatorRangeMap();
+
+  Teuchos::RCP<Epetra_MultiVector> X = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  X->Random();
+
+  Teuchos::RCP<Epetra_MultiVector> X_EX = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  X_EX->Random();
+
+  Teuchos::RCP<Epetra_MultiVector> B = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  ierr = solver->Matrix().Multiply('N', *X_EX, *B);
+  TEST_EQUALITY(ierr, 0);
+
+  ierr = solver->ApplyInverse(*B, *X);
+  TEST_EQUALITY(ierr, 0);
+
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(*X, *X_EX), <, 1e-10);
+  }
+
+TEUCHOS_UNIT_TEST(CoarseSolver, NodeGatherApplyInverse)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  params->set("Coarse Node Gather", true);
+  Teuchos::RCP<HYMLS::CoarseSolver> solver = createCoarseSolver(params, comm);
+  int ierr = solver->Initialize();
+  TEST_EQUALITY(ierr, 0);
+
+  ierr = solver->Compute();
+  TEST_EQUALITY(ierr, 0);
+
+  Epetra_Map const &map = solver->OperatorRangeMap();
+
+  Teuchos::RCP<Epetra_MultiVector> X = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  X->Random();
+
+  Teuchos::RCP<Epetra_MultiVector> X_EX = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  X_EX->Random();
+
+  Teuchos::RCP<Epetra_MultiVector> B = Teuchos::rcp(new Epetra_MultiVector(map, 2));
+  ierr = solver->Matrix().Multiply('N', *X_EX, *B);
+  TEST_EQUALITY(ierr, 0);
+
+  ierr = solver->ApplyInverse(*B, *X);
+  TEST_EQUALITY(ierr, 0);
+
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(*X, *X_EX), <, 1e-10);
+
+  // a second solve reuses the gathered matrix and the node communication
+  X->PutScalar(0.0);
+  ierr = solver->ApplyInverse(*B, *X);
+  TEST_EQUALITY(ierr, 0);
+
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(*X, *X_EX), <, 1e-10);
+  }
+
 TEUCHOS_UNIT_TEST(CoarseSolver, BorderedApplyInverse)
   {
   Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
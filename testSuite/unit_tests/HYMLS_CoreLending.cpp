@@ -0,0 +1,32 @@
+#include "HYMLS_CoreLending.hpp"
+
+#include <Epetra_MpiComm.h>
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(CoreLending, AllActive)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+
+  HYMLS::CoreLending lending(comm, true, 2);
+  TEST_EQUALITY(lending.NumThreads(), 2);
+  TEST_EQUALITY(lending.NumActiveOnNode(), lending.NumProcsOnNode());
+  }
+
+TEUCHOS_UNIT_TEST(CoreLending, SomeIdle)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+
+  bool active = comm.MyPID() % 2 == 0;
+  HYMLS::CoreLending lending(comm, active, 1);
+
+  // all processes on one node, so the total number of threads stays the same
+  int threads = active ? lending.NumThreads() : 0;
+  int totalThreads;
+  comm.SumAll(&threads, &totalThreads, 1);
+  if (lending.NumProcsOnNode() == comm.NumProc())
+    TEST_EQUALITY(totalThreads, comm.NumProc());
+  if (!active)
+    TEST_EQUALITY(lending.NumThreads(), 1);
+  TEST_EQUALITY(lending.NumThreads() >= 1, true);
+  }
@@ -0,0 +1,165 @@
+#include "HYMLS_DoubleBufferedPreconditioner.hpp"
+
+#include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_CartesianPartitioner.hpp"
+#include "HYMLS_Macros.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+#include <Epetra_CrsMatrix.h>
+
+#include <mpi.h>
+
+#include "HYMLS_UnitTests.hpp"
+
+namespace
+  {
+Teuchos::RCP<Epetra_CrsMatrix> createMatrix(
+  Teuchos::RCP<Teuchos::ParameterList> &params,
+  const Epetra_Comm &comm, double shift)
+  {
+  Teuchos::ParameterList &problemList = params->sublist("Problem");
+  problemList.set("Degrees of Freedom", 1);
+  problemList.set("Dimension", 2);
+  problemList.set("nx", 8);
+  problemList.set("ny", 8);
+  problemList.set("nz", 1);
+
+  Teuchos::ParameterList &precList = params->sublist("Preconditioner");
+  precList.set("Separator Length", 4);
+  precList.set("Number of Levels", 0);
+
+  HYMLS::CartesianPartitioner part(Teuchos::null, params, comm);
+  CHECK_ZERO(part.Partition(true));
+
+  // shifted 2D Laplacian
+  int nx = 8;
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(
+    new Epetra_CrsMatrix(Copy, part.Map(), 5));
+  for (int i = 0; i < A->NumMyRows(); i++)
+    {
+    hymls_gidx row = A->GRID64(i);
+    int x = row % nx;
+    int y = row / nx;
+
+    double value = 4.0 + shift;
+    CHECK_ZERO(A->InsertGlobalValues(row, 1, &value, &row));
+
+    value = -1.0;
+    hymls_gidx cols[4] = {row - 1, row + 1, row - nx, row + nx};
+    bool inside[4] = {x > 0, x < nx - 1, y > 0, y < nx - 1};
+    for (int j = 0; j < 4; j++)
+      if (inside[j])
+        CHECK_ZERO(A->InsertGlobalValues(row, 1, &value, &cols[j]));
+    }
+  CHECK_ZERO(A->FillComplete());
+  return A;
+  }
+  }
+
+TEUCHOS_UNIT_TEST(DoubleBufferedPreconditioner, PrepareAndSwap)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<Epetra_CrsMatrix> A = createMatrix(params, comm, 0.0);
+  Teuchos::RCP<Epetra_CrsMatrix> B = createMatrix(params, comm, 1.0);
+
+  HYMLS::DoubleBufferedPreconditioner prec(A, params, Teuchos::null, false);
+  TEST_ASSERT(!prec.Background());
+  TEST_EQUALITY(prec.Compute(), 0);
+  TEST_ASSERT(!prec.IsPreparing());
+
+  const Epetra_Map &map = prec.OperatorRangeMap();
+  Epetra_MultiVector X_EX(map, 2);
+  Epetra_MultiVector AX(map, 2);
+  Epetra_MultiVector BX(map, 2);
+  Epetra_MultiVector X(map, 2);
+  X_EX.Random();
+  CHECK_ZERO(A->Multiply(false, X_EX, AX));
+  CHECK_ZERO(B->Multiply(false, X_EX, BX));
+
+  TEST_EQUALITY(prec.ApplyInverse(AX, X), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+
+  // the old preconditioner is used until Swap()
+  TEST_EQUALITY(prec.Prepare(B), 0);
+  TEST_ASSERT(prec.IsPreparing());
+  TEST_EQUALITY(prec.ApplyInverse(AX, X), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+
+  TEST_EQUALITY(prec.Swap(), 0);
+  TEST_ASSERT(!prec.IsPreparing());
+  TEST_ASSERT(prec.Front()->IsComputed());
+  TEST_EQUALITY(prec.ApplyInverse(BX, X), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+
+  // the prepared matrix is copied, so changing it afterwards does not
+  // change the preconditioner
+  TEST_EQUALITY(prec.Prepare(A), 0);
+  CHECK_ZERO(A->Scale(2.0));
+  TEST_EQUALITY(prec.Swap(), 0);
+  CHECK_ZERO(A->Scale(0.5));
+  TEST_EQUALITY(prec.ApplyInverse(AX, X), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+  }
+
+TEUCHOS_UNIT_TEST(DoubleBufferedPreconditioner, Background)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+#if defined(HYMLS_FUNCTION_TRACING) || defined(HYMLS_MEMORY_PROFILING)
+  // the background thread is disabled on purpose in these builds
+  return;
+#endif
+
+  // only unit_tests_threads requests MPI_THREAD_MULTIPLE, and the MPI
+  // library does not have to provide it
+  int provided;
+  MPI_Query_thread(&provided);
+  if (provided != MPI_THREAD_MULTIPLE)
+    {
+    out << "MPI_THREAD_MULTIPLE is not available, skipping the test" << std::endl;
+    return;
+    }
+  TEST_ASSERT(HYMLS::DoubleBufferedPreconditioner::BackgroundSupported());
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<Epetra_CrsMatrix> A = createMatrix(params, comm, 0.0);
+  Teuchos::RCP<Epetra_CrsMatrix> B = createMatrix(params, comm, 1.0);
+
+  HYMLS::DoubleBufferedPreconditioner prec(A, params);
+  TEST_ASSERT(prec.Background());
+  TEST_EQUALITY(prec.Compute(), 0);
+
+  const Epetra_Map &map = prec.OperatorRangeMap();
+  Epetra_MultiVector X_EX(map, 2);
+  Epetra_MultiVector AX(map, 2);
+  Epetra_MultiVector BX(map, 2);
+  Epetra_MultiVector X(map, 2);
+  X_EX.Random();
+  CHECK_ZERO(A->Multiply(false, X_EX, AX));
+  CHECK_ZERO(B->Multiply(false, X_EX, BX));
+
+  // apply the current preconditioner repeatedly while the next one is
+  // computed in the background thread
+  TEST_EQUALITY(prec.Prepare(B), 0);
+  TEST_ASSERT(prec.IsPreparing());
+  for (int i = 0; i < 10; i++)
+    {
+    TEST_EQUALITY(prec.ApplyInverse(AX, X), 0);
+    TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+    }
+
+  TEST_EQUALITY(prec.Swap(), 0);
+  TEST_ASSERT(prec.IsReady());
+  TEST_ASSERT(prec.Front()->IsComputed());
+  TEST_EQUALITY(prec.ApplyInverse(BX, X), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-10);
+  }
@@ -0,0 +1,148 @@
+#include "HYMLS_DumpWriter.hpp"
+
+#include "HYMLS_MatrixUtils.hpp"
+#include "HYMLS_Macros.hpp"
+
+#include <Teuchos_toString.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_CrsMatrix.h>
+#include <Epetra_MultiVector.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "HYMLS_UnitTests.hpp"
+
+namespace
+  {
+std::vector<char> ReadFile(const std::string &filename)
+  {
+  std::ifstream ifs(filename.c_str(), std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(ifs),
+    std::istreambuf_iterator<char>());
+  }
+
+template<typename T>
+T Get(const std::vector<char> &buf, std::size_t &pos)
+  {
+  T value;
+  std::memcpy(&value, &buf[pos], sizeof(T));
+  pos += sizeof(T);
+  return value;
+  }
+  }
+
+TEUCHOS_UNIT_TEST(DumpWriter, Matrix)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+
+  hymls_gidx n = 20;
+  std::string filename = "dump_writer_test_A_" + Teuchos::toString(comm.NumProc());
+
+  Epetra_Map map(n, 0, comm);
+  Epetra_CrsMatrix A(Copy, map, 3);
+  for (int i = 0; i < map.NumMyElements(); i++)
+    {
+    hymls_gidx row = map.GID64(i);
+    for (hymls_gidx col = row - 1; col <= row + 1; col++)
+      {
+      if (col < 0 || col >= n)
+        continue;
+      double value = 10.0 * row + col;
+      CHECK_ZERO(A.InsertGlobalValues(row, 1, &value, &col));
+      }
+    }
+  CHECK_ZERO(A.FillComplete());
+
+  HYMLS::MatrixUtils::Dump(A, filename, false, HYMLS::MatrixUtils::BINARY);
+  HYMLS::DumpWriter::Flush();
+
+  std::string myFile = HYMLS::DumpWriter::FileName(filename, comm.MyPID());
+  std::vector<char> buf = ReadFile(myFile);
+  TEST_ASSERT(buf.size() > 8);
+  TEST_ASSERT(std::strncmp(&buf[0], "HYMLSDMP", 8) == 0);
+
+  std::size_t pos = 8;
+  std::int64_t header[10];
+  for (int i = 0; i < 10; i++)
+    header[i] = Get<std::int64_t>(buf, pos);
+  TEST_EQUALITY(header[1], (std::int64_t)HYMLS::DumpWriter::Matrix);
+  TEST_EQUALITY(header[2], (std::int64_t)sizeof(hymls_gidx));
+  TEST_EQUALITY(header[3], comm.MyPID());
+  TEST_EQUALITY(header[4], comm.NumProc());
+  TEST_EQUALITY(header[6], n);
+  TEST_EQUALITY(header[8], A.NumMyRows());
+  TEST_EQUALITY(header[9], A.NumMyCols());
+
+  std::vector<hymls_gidx> rowGIDs(A.NumMyRows()), colGIDs(A.NumMyCols());
+  for (int i = 0; i < A.NumMyRows(); i++)
+    rowGIDs[i] = Get<hymls_gidx>(buf, pos);
+  for (int i = 0; i < A.NumMyCols(); i++)
+    colGIDs[i] = Get<hymls_gidx>(buf, pos);
+  std::vector<int> rowPtr(A.NumMyRows() + 1);
+  for (int i = 0; i <= A.NumMyRows(); i++)
+    rowPtr[i] = Get<int>(buf, pos);
+  TEST_EQUALITY(rowPtr.back(), A.NumMyNonzeros());
+
+  std::size_t valuePos = pos + rowPtr.back() * sizeof(int);
+  for (int i = 0; i < A.NumMyRows(); i++)
+    {
+    TEST_EQUALITY(rowGIDs[i], A.GRID64(i));
+    for (int k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+      {
+      int lcid = Get<int>(buf, pos);
+      double value = Get<double>(buf, valuePos);
+      TEST_EQUALITY(value, 10.0 * rowGIDs[i] + colGIDs[lcid]);
+      }
+    }
+  TEST_EQUALITY(valuePos, buf.size());
+
+  std::remove(myFile.c_str());
+  }
+
+TEUCHOS_UNIT_TEST(DumpWriter, MultiVector)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+
+  std::string filename = "dump_writer_test_x_" + Teuchos::toString(comm.NumProc());
+
+  Epetra_Map map((hymls_gidx)30, 0, comm);
+  Epetra_MultiVector x(map, 2);
+  CHECK_ZERO(x.Random());
+
+  // a small buffer, so that Write has to wait for the thread
+  std::size_t maxSize = HYMLS::DumpWriter::MaxBufferSize();
+  HYMLS::DumpWriter::SetMaxBufferSize(1);
+
+  long long numWritten = HYMLS::DumpWriter::NumWritten();
+  for (int i = 0; i < 5; i++)
+    HYMLS::DumpWriter::Write(x, filename);
+  HYMLS::DumpWriter::Flush();
+  TEST_EQUALITY(HYMLS::DumpWriter::NumWritten(), numWritten + 5);
+
+  HYMLS::DumpWriter::SetMaxBufferSize(maxSize);
+
+  std::string myFile = HYMLS::DumpWriter::FileName(filename, comm.MyPID());
+  std::vector<char> buf = ReadFile(myFile);
+  TEST_EQUALITY(buf.size(), 8 + 10 * sizeof(std::int64_t)
+    + x.MyLength() * (sizeof(hymls_gidx) + 2 * sizeof(double)));
+
+  std::size_t pos = 8 + 7 * sizeof(std::int64_t);
+  TEST_EQUALITY(Get<std::int64_t>(buf, pos), 2);
+  TEST_EQUALITY(Get<std::int64_t>(buf, pos), x.MyLength());
+  TEST_EQUALITY(Get<std::int64_t>(buf, pos), 2);
+
+  for (int i = 0; i < x.MyLength(); i++)
+    TEST_EQUALITY(Get<hymls_gidx>(buf, pos), map.GID64(i));
+  for (int k = 0; k < 2; k++)
+    for (int i = 0; i < x.MyLength(); i++)
+      TEST_EQUALITY(Get<double>(buf, pos), x[k][i]);
+
+  std::remove(myFile.c_str());
+  }
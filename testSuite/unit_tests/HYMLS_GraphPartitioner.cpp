@@ -0,0 +1,126 @@
+#include "HYMLS_GraphPartitioner.hpp"
+
+#include "HYMLS_InteriorGroup.hpp"
+#include "HYMLS_SeparatorGroup.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_Array.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include "Epetra_MpiComm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsGraph.h"
+
+#include <algorithm>
+#include <set>
+
+#include "HYMLS_UnitTests.hpp"
+
+// 2D Laplace graph on a square grid with a square hole in the middle,
+// which can not be partitioned by the Cartesian partitioner
+TEUCHOS_UNIT_TEST(GraphPartitioner, Hole2D)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  int n = 24;
+  auto active = [n](int i, int j) {
+    return i >= 0 && j >= 0 && i < n && j < n &&
+      !(i >= n / 3 && i < 2 * n / 3 && j >= n / 3 && j < 2 * n / 3);
+  };
+
+  Teuchos::Array<hymls_gidx> gids;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++)
+      if (active(i, j))
+        gids.append(i + j * n);
+
+  // distribute the active nodes in contiguous blocks
+  int numMyElements = gids.size() / comm.NumProc();
+  int first = comm.MyPID() * numMyElements;
+  if (comm.MyPID() == comm.NumProc() - 1)
+    numMyElements = gids.size() - first;
+
+  Teuchos::RCP<Epetra_Map> map = Teuchos::rcp(new Epetra_Map((hymls_gidx)-1,
+      numMyElements, gids.getRawPtr() + first, (hymls_gidx)0, comm));
+
+  Teuchos::RCP<Epetra_CrsGraph> graph = Teuchos::rcp(new Epetra_CrsGraph(Copy, *map, 5));
+  for (int lid = 0; lid < map->NumMyElements(); lid++)
+    {
+    hymls_gidx gid = map->GID64(lid);
+    int i = gid % n;
+    int j = gid / n;
+
+    Teuchos::Array<hymls_gidx> cols;
+    int di[5] = {0, -1, 1, 0, 0};
+    int dj[5] = {0, 0, 0, -1, 1};
+    for (int k = 0; k < 5; k++)
+      if (active(i + di[k], j + dj[k]))
+        cols.append(i + di[k] + (j + dj[k]) * n);
+    CHECK_ZERO(graph->InsertGlobalIndices(gid, cols.size(), cols.getRawPtr()));
+    }
+  CHECK_ZERO(graph->FillComplete());
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList);
+  Teuchos::ParameterList &problemList = params->sublist("Problem");
+  problemList.set("Dimension", 2);
+  problemList.set("Degrees of Freedom", 1);
+
+  Teuchos::ParameterList &precList = params->sublist("Preconditioner");
+  precList.set("Separator Length", 4);
+  precList.set("Coarsening Factor", 2);
+
+  HYMLS::GraphPartitioner part(map, graph, params, comm);
+  CHECK_ZERO(part.Partition());
+
+  // about 16 nodes per subdomain
+  int numGlobalNodes = gids.size();
+  int numGlobalParts = part.NumGlobalParts(0, 0, 0);
+  TEST_EQUALITY(numGlobalParts >= numGlobalNodes / 32, true);
+  TEST_EQUALITY(numGlobalParts <= numGlobalNodes / 8, true);
+  TEST_EQUALITY(part.SubdomainMap().NumGlobalElements(), numGlobalParts);
+
+  for (int lid = 0; lid < map->NumMyElements(); lid++)
+    TEST_EQUALITY(part.SubdomainMap().MyGID(part(map->GID64(lid))), true);
+
+  for (int sd = 0; sd < part.NumLocalParts(); sd++)
+    {
+    HYMLS::InteriorGroup interior_group;
+    Teuchos::Array<HYMLS::SeparatorGroup> separator_groups;
+    CHECK_ZERO(part.GetGroups(sd, interior_group, separator_groups));
+
+    std::set<hymls_gidx> interior(interior_group.nodes().begin(),
+      interior_group.nodes().end());
+
+    std::set<hymls_gidx> separators;
+    for (auto const &group: separator_groups)
+      for (hymls_gidx gid: group.nodes())
+        {
+        // a node is in at most one group
+        TEST_EQUALITY(separators.insert(gid).second, true);
+        TEST_EQUALITY(interior.count(gid), 0);
+        }
+
+    // the interior is only coupled to nodes of the same subdomain
+    for (hymls_gidx gid: interior)
+      {
+      TEST_EQUALITY(part(gid), part.SubdomainMap().GID(sd));
+
+      int row = graph->LRID(gid);
+      int len;
+      int *indices;
+      CHECK_ZERO(graph->ExtractMyRowView(row, len, indices));
+      for (int j = 0; j < len; j++)
+        {
+        hymls_gidx col = graph->ColMap().GID64(indices[j]);
+        TEST_EQUALITY(interior.count(col) + separators.count(col), 1);
+        }
+      }
+    }
+
+  // next level parameters
+  Teuchos::ParameterList nextParams(*params);
+  part.SetNextLevelParameters(nextParams);
+  TEST_EQUALITY(nextParams.sublist("Preconditioner").get("Number of Subdomains", 0),
+    std::max(numGlobalParts / 4, 1));
+  }
@@ -0,0 +1,81 @@
+#include "HYMLS_ImportRegistry.hpp"
+
+#include <Teuchos_RCP.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_Import.h>
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(ImportRegistry, Reuse)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  HYMLS::ImportRegistry::Clear();
+
+  int n = 10 * comm.NumProc();
+  Epetra_Map sourceMap((hymls_gidx)n, 0, comm);
+  Epetra_Map targetMap((hymls_gidx)n, (hymls_gidx)0, comm);
+  Epetra_Map copyMap(targetMap);
+
+  Teuchos::RCP<const Epetra_Import> import1 =
+    HYMLS::ImportRegistry::GetImport(targetMap, sourceMap);
+  long long hits = HYMLS::ImportRegistry::NumHits();
+
+  // A copy of the map shares its data, so we get the same importer
+  Teuchos::RCP<const Epetra_Import> import2 =
+    HYMLS::ImportRegistry::GetImport(copyMap, sourceMap);
+  TEST_EQUALITY(import1.get(), import2.get());
+  TEST_EQUALITY(HYMLS::ImportRegistry::NumHits(), hits + 1);
+
+  // A map that was constructed separately gives a new importer
+  Teuchos::RCP<const Epetra_Import> import3 =
+    HYMLS::ImportRegistry::GetImport(sourceMap, targetMap);
+  TEST_INEQUALITY(import1.get(), import3.get());
+  TEST_EQUALITY(HYMLS::ImportRegistry::Size(), 2);
+
+  HYMLS::ImportRegistry::Clear();
+  }
+
+TEUCHOS_UNIT_TEST(ImportRegistry, UnusedMaps)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  HYMLS::ImportRegistry::Clear();
+
+  int n = 10 * comm.NumProc();
+  Epetra_Map map1((hymls_gidx)n, 0, comm);
+  Epetra_Map map2((hymls_gidx)n, 0, comm);
+
+  Teuchos::RCP<const Epetra_Import> import1 =
+    HYMLS::ImportRegistry::GetImport(map1, map2);
+
+  // Many other importers do not remove the ones whose maps are used
+  for (int i = 0; i < 200; i++)
+    {
+    Epetra_Map map3((hymls_gidx)n, 0, comm);
+    HYMLS::ImportRegistry::GetImport(map3, map2);
+    }
+  long long hits = HYMLS::ImportRegistry::NumHits();
+  TEST_EQUALITY(HYMLS::ImportRegistry::GetImport(map1, map2).get(), import1.get());
+  TEST_EQUALITY(HYMLS::ImportRegistry::NumHits(), hits + 1);
+
+  // The importers of the maps that no longer exist were removed
+  TEST_EQUALITY(HYMLS::ImportRegistry::Size(), 1);
+
+  // An importer whose map is gone is removed, even if it is still used
+  Teuchos::RCP<const Epetra_Import> import2;
+    {
+    Epetra_Map map3((hymls_gidx)n, 0, comm);
+    import2 = HYMLS::ImportRegistry::GetImport(map3, map1);
+    TEST_EQUALITY(HYMLS::ImportRegistry::Size(), 2);
+    }
+  HYMLS::ImportRegistry::GetImport(map1, map2);
+  TEST_EQUALITY(HYMLS::ImportRegistry::Size(), 1);
+  TEST_ASSERT(import2->SourceMap().SameAs(map1));
+
+  HYMLS::ImportRegistry::Clear();
+  }
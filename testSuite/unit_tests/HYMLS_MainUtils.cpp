@@ -0,0 +1,128 @@
+#include "HYMLS_MainUtils.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+#include <Epetra_Vector.h>
+#include <Epetra_Operator.h>
+
+#include "HYMLS_Macros.hpp"
+
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "HYMLS_UnitTests.hpp"
+
+namespace
+  {
+// operator with inverse x/2, or whose inverse fails
+class HalfOperator : public Epetra_Operator
+  {
+  const Epetra_Map &map_;
+  bool fail_;
+public:
+  HalfOperator(const Epetra_Map &map, bool fail = false) : map_(map), fail_(fail) {}
+
+  int SetUseTranspose(bool) {return -1;}
+  int Apply(const Epetra_MultiVector &X, Epetra_MultiVector &Y) const
+    {return Y.Scale(2.0, X);}
+  int ApplyInverse(const Epetra_MultiVector &X, Epetra_MultiVector &Y) const
+    {return fail_ ? -1 : Y.Scale(0.5, X);}
+  double NormInf() const {return 2.0;}
+  const char *Label() const {return "HalfOperator";}
+  bool UseTranspose() const {return false;}
+  bool HasNormInf() const {return true;}
+  const Epetra_Comm &Comm() const {return map_.Comm();}
+  const Epetra_Map &OperatorDomainMap() const {return map_;}
+  const Epetra_Map &OperatorRangeMap() const {return map_;}
+  };
+
+bool FileExists(std::string const &filename)
+  {
+  struct stat st;
+  return stat(filename.c_str(), &st) == 0;
+  }
+  }
+
+TEUCHOS_UNIT_TEST(MainUtils, RunService)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  HYMLS::UnitTests::TemporaryDirectory dir(comm);
+
+  DISABLE_OUTPUT;
+
+  int n = 15;
+  Teuchos::RCP<Epetra_Map> map = HYMLS::UnitTests::create_random_map(comm, n, 1);
+
+  Epetra_Vector b(*map);
+  for (int i = 0; i < b.MyLength(); i++)
+    b[i] = map->GID64(i);
+
+  // a valid request, a malformed one and the stop file, which is only
+  // honoured once there are no more requests
+  HYMLS::MainUtils::write_vector("a.rhs", dir.Path(), "Binary", b);
+  if (comm.MyPID() == 0)
+    {
+    std::ofstream((dir.Path() + "/b.rhs.bin").c_str()) << "garbage";
+    std::ofstream((dir.Path() + "/stop").c_str());
+    }
+  comm.Barrier();
+
+  HalfOperator op(*map);
+  Teuchos::ParameterList serviceList;
+  serviceList.set("Directory", dir.Path());
+  serviceList.set("File Format", std::string("Binary"));
+  serviceList.set("Poll Interval", 0.01);
+  TEST_EQUALITY(HYMLS::MainUtils::run_service(op, map, serviceList, 3.0), 0);
+
+  Teuchos::RCP<Epetra_Vector> x = HYMLS::MainUtils::read_vector(
+    "a.sol", dir.Path(), "Binary", map);
+  for (int i = 0; i < x->MyLength(); i++)
+    TEST_EQUALITY((*x)[i], 1.5 * map->GID64(i));
+
+  TEST_ASSERT(!FileExists(dir.Path() + "/a.rhs.bin"));
+  TEST_ASSERT(!FileExists(dir.Path() + "/b.rhs.bin"));
+  TEST_ASSERT(FileExists(dir.Path() + "/failed/b.rhs.bin"));
+  TEST_ASSERT(!FileExists(dir.Path() + "/b.sol.bin"));
+  TEST_ASSERT(!FileExists(dir.Path() + "/stop"));
+  }
+
+TEUCHOS_UNIT_TEST(MainUtils, RunServiceSolverFails)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  HYMLS::UnitTests::TemporaryDirectory dir(comm);
+
+  DISABLE_OUTPUT;
+
+  int n = 15;
+  Teuchos::RCP<Epetra_Map> map = HYMLS::UnitTests::create_random_map(comm, n, 1);
+
+  Epetra_Vector b(*map);
+  CHECK_ZERO(b.PutScalar(1.0));
+
+  HYMLS::MainUtils::write_vector("a.rhs", dir.Path(), "Binary", b);
+  HYMLS::MainUtils::write_vector("b.rhs", dir.Path(), "Binary", b);
+  if (comm.MyPID() == 0)
+    std::ofstream((dir.Path() + "/stop").c_str());
+  comm.Barrier();
+
+  // no solutions are written, the requests are moved to "failed"
+  HalfOperator op(*map, true);
+  Teuchos::ParameterList serviceList;
+  serviceList.set("Directory", dir.Path());
+  serviceList.set("File Format", std::string("Binary"));
+  serviceList.set("Poll Interval", 0.01);
+  TEST_EQUALITY(HYMLS::MainUtils::run_service(op, map, serviceList, 1.0), 0);
+
+  for (std::string request: {"a", "b"})
+    {
+    TEST_ASSERT(!FileExists(dir.Path() + "/" + request + ".rhs.bin"));
+    TEST_ASSERT(!FileExists(dir.Path() + "/" + request + ".sol.bin"));
+    TEST_ASSERT(FileExists(dir.Path() + "/failed/" + request + ".rhs.bin"));
+    }
+  TEST_ASSERT(!FileExists(dir.Path() + "/stop"));
+  }
@@ -0,0 +1,29 @@
+#include "HYMLS_MpiProgress.hpp"
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(MpiProgress, Poke)
+  {
+  double interval = HYMLS::MpiProgress::Interval();
+
+  // disabled
+  HYMLS::MpiProgress::SetInterval(-1.0);
+  long long numPokes = HYMLS::MpiProgress::NumPokes();
+  HYMLS::MpiProgress::Poke();
+  TEST_EQUALITY(HYMLS::MpiProgress::NumPokes(), numPokes);
+
+  // every call pokes
+  HYMLS::MpiProgress::SetInterval(0.0);
+  HYMLS::MpiProgress::Poke();
+  HYMLS::MpiProgress::Poke();
+  TEST_EQUALITY(HYMLS::MpiProgress::NumPokes(), numPokes + 2);
+
+  // only the first call after setting the interval pokes
+  HYMLS::MpiProgress::SetInterval(1000.0);
+  numPokes = HYMLS::MpiProgress::NumPokes();
+  HYMLS::MpiProgress::Poke();
+  HYMLS::MpiProgress::Poke();
+  TEST_EQUALITY(HYMLS::MpiProgress::NumPokes(), numPokes + 1);
+
+  HYMLS::MpiProgress::SetInterval(interval);
+  }
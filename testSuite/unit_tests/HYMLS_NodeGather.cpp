@@ -0,0 +1,49 @@
+#include "HYMLS_NodeGather.hpp"
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+
+#include "HYMLS_Macros.hpp"
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(NodeGather, GatherScatter)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  // different number of entries on every process, and none on process 1
+  int numMyElements = comm.MyPID() == 1 ? 0 : 3 + comm.MyPID();
+  Epetra_Map map((hymls_gidx)-1, numMyElements, (hymls_gidx)0, comm);
+
+  HYMLS::NodeGather gather(map);
+
+  const Epetra_Map &rootMap = gather.RootMap();
+  TEST_EQUALITY(rootMap.NumGlobalElements64(), map.NumGlobalElements64());
+  TEST_EQUALITY(rootMap.NumMyElements(),
+    comm.MyPID() == 0 ? map.NumGlobalElements() : 0);
+  TEST_EQUALITY(gather.IsLeader() || comm.MyPID() != 0, true);
+
+  for (int numVectors = 1; numVectors < 4; numVectors++)
+    {
+    Epetra_MultiVector source(map, numVectors);
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < map.NumMyElements(); i++)
+        source[k][i] = map.GID64(i) + 1000 * k;
+
+    Epetra_MultiVector root(rootMap, numVectors);
+    CHECK_ZERO(gather.Gather(source, root));
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < rootMap.NumMyElements(); i++)
+        TEST_EQUALITY(root[k][i], rootMap.GID64(i) + 1000 * k);
+
+    CHECK_ZERO(root.Scale(2.0));
+
+    Epetra_MultiVector target(map, numVectors);
+    CHECK_ZERO(gather.Scatter(root, target));
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < map.NumMyElements(); i++)
+        TEST_EQUALITY(target[k][i], 2 * source[k][i]);
+    }
+  }
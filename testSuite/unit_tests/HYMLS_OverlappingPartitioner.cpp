@@ -1261,3 +1261,54 @@ TEUCHOS_UNIT_TEST_INST(OverlappingPartitioner, SkewStokes3D, 1, 8, 8, 8, 4, 4, 4
 TEUCHOS_UNIT_TEST_INST(OverlappingPartitioner, SkewStokes3D, 2, 16, 16, 16, 4, 4, 4);
 TEUCHOS_UNIT_TEST_INST(OverlappingPartitioner, SkewStokes3D, 3, 16, 8, 8, 4, 4, 4);
 TEUCHOS_UNIT_TEST_INST(OverlappingPartitioner, SkewStokes3D, 4, 16, 16, 16, 8, 8, 8);
+
+TEUCHOS_UNIT_TEST(OverlappingPartitioner, PartitionCache)
+  {
+  Teuchos::RCP<Epetra_MpiComm> Comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  HYMLS::UnitTests::TemporaryDirectory dir(*Comm);
+
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> paramList = Teuchos::rcp(new Teuchos::ParameterList);
+  Teuchos::ParameterList &problemList = paramList->sublist("Problem");
+  problemList.set("nx", 16);
+  problemList.set("ny", 16);
+  problemList.set("nz", 1);
+  problemList.set("Dimension", 2);
+  problemList.set("Degrees of Freedom", 1);
+
+  Teuchos::ParameterList &solverList = paramList->sublist("Preconditioner");
+  solverList.set("Separator Length", 4);
+  solverList.set("Coarsening Factor", 2);
+  solverList.set("Partition Cache", dir.Path() + "/partition_cache_test");
+
+  Teuchos::RCP<Epetra_Map> map = Teuchos::rcp(new Epetra_Map(16 * 16, 0, *Comm));
+
+  // the first one writes the cache, the second one reads it, even though
+  // the first one added default values and an unrelated parameter was
+  // added to the list
+  HYMLS::OverlappingPartitioner opart1(map, paramList, 1);
+  solverList.set("Number of Levels", 3);
+  HYMLS::OverlappingPartitioner opart2(map, paramList, 1);
+
+  TEST_EQUALITY(opart1.LoadedFromCache(), false);
+  TEST_EQUALITY(opart2.LoadedFromCache(), true);
+
+  // a different partitioning parameter should not read the cache
+  Teuchos::RCP<Teuchos::ParameterList> otherList =
+    Teuchos::rcp(new Teuchos::ParameterList(*paramList));
+  otherList->sublist("Preconditioner").set("Coarsening Factor", 4);
+  HYMLS::OverlappingPartitioner opart3(map, otherList, 1);
+  TEST_EQUALITY(opart3.LoadedFromCache(), false);
+
+  TEST_EQUALITY(opart1.Map().SameAs(opart2.Map()), true);
+  TEST_EQUALITY(opart1.OverlappingMap().SameAs(opart2.OverlappingMap()), true);
+  TEST_EQUALITY(opart1.NumMySubdomains(), opart2.NumMySubdomains());
+  for (int sd = 0; sd < opart1.NumMySubdomains(); sd++)
+    {
+    TEST_COMPARE_ARRAYS(opart1.GetInteriorGroup(sd).nodes(),
+      opart2.GetInteriorGroup(sd).nodes());
+    TEST_EQUALITY(opart1.NumSeparatorGroups(sd), opart2.NumSeparatorGroups(sd));
+    TEST_EQUALITY(opart1.NumLinkedSeparatorGroups(sd), opart2.NumLinkedSeparatorGroups(sd));
+    }
+  }
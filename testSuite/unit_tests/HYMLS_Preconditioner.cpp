@@ -12,12 +12,18 @@
 #include <Epetra_Import.h>
 #include <Epetra_SerialDenseMatrix.h>
 
+#include <cstdio>
+
 #include "HYMLS_Macros.hpp"
 #include "HYMLS_DenseUtils.hpp"
 #include "HYMLS_MatrixBlock.hpp"
 #include "HYMLS_SchurComplement.hpp"
+#include "HYMLS_SchurPreconditioner.hpp"
+#include "HYMLS_Exception.hpp"
 #include "HYMLS_CartesianPartitioner.hpp"
 #include "HYMLS_SkewCartesianPartitioner.hpp"
+#include "HYMLS_SubdomainAssembler.hpp"
+#include "HYMLS_Solver.hpp"
 
 #include "Galeri_CrsMatrices.h"
 #include "GaleriExt_CrsMatrices.h"
@@ -61,6 +67,16 @@ public:
     {
     return V_;
     }
+
+  Teuchos::RCP<const HYMLS::OverlappingPartitioner> Hid()
+    {
+    return hid_;
+    }
+
+  Teuchos::RCP<const HYMLS::SchurPreconditioner> SchurPrec()
+    {
+    return Teuchos::rcp_dynamic_cast<const HYMLS::SchurPreconditioner>(schurPrec_);
+    }
   };
 
 Teuchos::RCP<TestablePreconditioner> createPreconditioner(
@@ -191,7 +207,7 @@ TEUCHOS_UNIT_TEST(Preconditioner, SetBorderNull)
 
 Teuchos::RCP<TestablePreconditioner> create2DStokesPreconditioner(
   Teuchos::RCP<Teuchos::ParameterList> &params,
-  Teuchos::RCP<Epetra_Comm> const &comm)
+  Teuchos::RCP<Epetra_Comm> const &comm, bool patternOnly = false)
   {
   Teuchos::ParameterList &problemList = params->sublist("Problem");
   problemList.set("nx", 8);
@@ -227,6 +243,8 @@ Teuchos::RCP<TestablePreconditioner> create2DStokesPreconditioner(
 
   Teuchos::RCP<Epetra_CrsMatrix> matrix = Teuchos::rcp(
     GaleriExt::CreateCrsMatrix("Stokes2D", &part->Map(), problemList));
+  if (patternOnly)
+    matrix->PutScalar(0.0);
 
   Teuchos::RCP<TestablePreconditioner> prec =
     Teuchos::rcp(new TestablePreconditioner(matrix, params));
@@ -244,6 +262,320 @@ TEUCHOS_UNIT_TEST(Preconditioner, 2DStokes)
   prec->Compute();
   }
 
+// Solve a 2D Laplace problem on a map that is not ordered by the
+// Cartesian partitioner, with the subdomains found by the graph
+// partitioner on both levels
+TEUCHOS_UNIT_TEST(Preconditioner, GraphPartitioner)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::ParameterList &problemList = params->sublist("Problem");
+  problemList.set("nx", 16);
+  problemList.set("ny", 16);
+  problemList.set("nz", 1);
+  problemList.set("Dimension", 2);
+  problemList.set("Degrees of Freedom", 1);
+
+  Teuchos::ParameterList &precList = params->sublist("Preconditioner");
+  precList.set("Partitioner", "Graph");
+  precList.set("Separator Length", 4);
+  precList.set("Coarsening Factor", 2);
+  precList.set("Number of Levels", 2);
+
+  Teuchos::ParameterList &solverList = params->sublist("Solver");
+  solverList.set("Initial Vector", "Zero");
+  Teuchos::ParameterList &iterList = solverList.sublist("Iterative Solver");
+  iterList.set("Convergence Tolerance", 1e-10);
+  iterList.set("Maximum Iterations", 100);
+
+  Epetra_Map map((hymls_gidx)256, (hymls_gidx)0, *comm);
+  Teuchos::RCP<Epetra_CrsMatrix> matrix = Teuchos::rcp(
+    Galeri::CreateCrsMatrix("Laplace2D", &map, problemList));
+
+  Teuchos::RCP<TestablePreconditioner> prec =
+    Teuchos::rcp(new TestablePreconditioner(matrix, params));
+  TEST_EQUALITY(prec->Initialize(), 0);
+  TEST_EQUALITY(prec->Compute(), 0);
+  TEST_COMPARE(prec->Hid()->NumMySubdomains(), >, 0);
+
+  HYMLS::Solver solver(matrix, prec, params, 2);
+
+  Epetra_MultiVector X_EX(map, 2);
+  X_EX.Random();
+  Epetra_MultiVector B(map, 2);
+  CHECK_ZERO(matrix->Multiply(false, X_EX, B));
+  Epetra_MultiVector X(map, 2);
+  TEST_EQUALITY(solver.ApplyInverse(B, X), 0);
+
+  TEST_COMPARE(solver.getNumIter(), <, 100);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X_EX), <, 1e-6);
+  }
+
+TEUCHOS_UNIT_TEST(Preconditioner, SchurCache)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  HYMLS::UnitTests::TemporaryDirectory dir(*comm);
+  DISABLE_OUTPUT;
+
+  std::string prefix = dir.Path() + "/prec_cache_test";
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec = create2DStokesPreconditioner(params, comm);
+  TEST_EQUALITY(prec->Initialize(), 0);
+  TEST_EQUALITY(prec->Compute(), 0);
+  TEST_EQUALITY(prec->NumLevelsFromSchurCache(), 0);
+  TEST_EQUALITY(prec->SaveSchurCache(prefix), 0);
+
+  // parameters that do not change the Schur complements do not change
+  // the key
+  Teuchos::RCP<Teuchos::ParameterList> params2 = Teuchos::rcp(new Teuchos::ParameterList());
+  params2->sublist("Preconditioner").set("Visualize Solver", false);
+  params2->sublist("Preconditioner").set("Subdomain Solver Num Threads", 1);
+  Teuchos::RCP<TestablePreconditioner> prec2 = create2DStokesPreconditioner(params2, comm);
+  TEST_EQUALITY(prec2->Initialize(), 0);
+  TEST_EQUALITY(prec2->ComputeFromSchurCache(prefix), 0);
+  TEST_ASSERT(prec2->IsComputed());
+
+  // all levels with an approximate Schur complement were read
+  int numLevels = prec2->NumLevelsFromSchurCache();
+  TEST_COMPARE(numLevels, >, 0);
+
+  Epetra_Map const &map = prec->OperatorRangeMap();
+  Epetra_MultiVector B(map, 2);
+  B.Random();
+
+  Epetra_MultiVector X(map, 2);
+  Epetra_MultiVector X2(map, 2);
+  TEST_EQUALITY(prec->ApplyInverse(B, X), 0);
+  TEST_EQUALITY(prec2->ApplyInverse(B, X2), 0);
+
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X2), <, 1e-12);
+
+  // A corrupted file on one process means that the first level is
+  // assembled again on all processes
+  comm->Barrier();
+  if (comm->MyPID() == 0)
+    {
+    std::string filename = prefix + "_L1_np" + Teuchos::toString(comm->NumProc()) +
+      "_p0.bin";
+    FILE *file = std::fopen(filename.c_str(), "r+b");
+    TEST_ASSERT(file != NULL);
+    if (file)
+      {
+      std::fputs("garbage", file);
+      std::fclose(file);
+      }
+    }
+  comm->Barrier();
+
+  Teuchos::RCP<Teuchos::ParameterList> params3 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec3 = create2DStokesPreconditioner(params3, comm);
+  TEST_EQUALITY(prec3->Initialize(), 0);
+  TEST_EQUALITY(prec3->ComputeFromSchurCache(prefix), 0);
+  TEST_COMPARE(prec3->NumLevelsFromSchurCache(), <, numLevels);
+
+  Epetra_MultiVector X3(map, 2);
+  TEST_EQUALITY(prec3->ApplyInverse(B, X3), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X3), <, 1e-12);
+  }
+
+TEUCHOS_UNIT_TEST(Preconditioner, ShareSetup)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec = create2DStokesPreconditioner(params, comm);
+  TEST_EQUALITY(prec->Initialize(), 0);
+  TEST_EQUALITY(prec->Compute(), 0);
+
+  Teuchos::RCP<Teuchos::ParameterList> params2 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec2 = create2DStokesPreconditioner(params2, comm);
+  TEST_EQUALITY(prec2->ShareSetup(prec), 0);
+  TEST_EQUALITY(prec2->Initialize(), 0);
+  TEST_EQUALITY(prec2->Compute(), 0);
+  TEST_ASSERT(prec2->Hid().get() == prec->Hid().get());
+
+  Teuchos::RCP<const HYMLS::SchurPreconditioner> schurPrec = prec->SchurPrec();
+  Teuchos::RCP<const HYMLS::SchurPreconditioner> schurPrec2 = prec2->SchurPrec();
+  TEST_ASSERT(schurPrec != Teuchos::null);
+  TEST_ASSERT(schurPrec2 != Teuchos::null);
+  TEST_ASSERT(schurPrec->VsumMap() != Teuchos::null);
+  TEST_ASSERT(schurPrec2->VsumMap().get() == schurPrec->VsumMap().get());
+  TEST_ASSERT(schurPrec->VsumImporter() != Teuchos::null);
+  TEST_ASSERT(schurPrec2->VsumImporter().get() == schurPrec->VsumImporter().get());
+  TEST_ASSERT(schurPrec->NextLevelHID() != Teuchos::null);
+  TEST_ASSERT(schurPrec2->NextLevelHID().get() == schurPrec->NextLevelHID().get());
+
+  Epetra_Map const &map = prec->OperatorRangeMap();
+  Epetra_MultiVector B(map, 2);
+  B.Random();
+
+  Epetra_MultiVector X(map, 2);
+  Epetra_MultiVector X2(map, 2);
+  TEST_EQUALITY(prec->ApplyInverse(B, X), 0);
+  TEST_EQUALITY(prec2->ApplyInverse(B, X2), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X2), <, 1e-12);
+
+  // the shared setup outlives the preconditioner it came from
+  Teuchos::RCP<const HYMLS::OverlappingPartitioner> hid = prec->Hid();
+  prec = Teuchos::null;
+  TEST_EQUALITY(prec2->Initialize(), 0);
+  TEST_EQUALITY(prec2->Compute(), 0);
+  TEST_ASSERT(prec2->Hid().get() == hid.get());
+  TEST_EQUALITY(prec2->ApplyInverse(B, X2), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X2), <, 1e-12);
+  }
+
+TEUCHOS_UNIT_TEST(Preconditioner, ShareSetupDifferentParameters)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec = create2DStokesPreconditioner(params, comm);
+  TEST_EQUALITY(prec->Initialize(), 0);
+
+  // the same parameters, except for one that does not affect the
+  // partitioning
+  Teuchos::RCP<Teuchos::ParameterList> params2 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec2 = create2DStokesPreconditioner(params2, comm);
+  params2->sublist("Preconditioner").set("Visualize Solver", false);
+  prec2->setParameterList(params2);
+  TEST_EQUALITY(prec2->ShareSetup(prec), 0);
+
+  Teuchos::RCP<Teuchos::ParameterList> params3 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec3 = create2DStokesPreconditioner(params3, comm);
+  params3->sublist("Preconditioner").set("Separator Length", 8);
+  prec3->setParameterList(params3);
+  TEST_THROW(prec3->ShareSetup(prec), HYMLS::Exception);
+
+  Teuchos::RCP<Teuchos::ParameterList> params4 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec4 = create2DStokesPreconditioner(params4, comm);
+  params4->sublist("Preconditioner").set("Number of Levels", 3);
+  prec4->setParameterList(params4);
+  TEST_THROW(prec4->ShareSetup(prec), HYMLS::Exception);
+
+  Teuchos::RCP<Teuchos::ParameterList> params5 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec5 = create2DStokesPreconditioner(params5, comm);
+  params5->sublist("Preconditioner").set("Retain Nodes at Level 2", 2);
+  prec5->setParameterList(params5);
+  TEST_THROW(prec5->ShareSetup(prec), HYMLS::Exception);
+  TEST_ASSERT(prec5->Hid().get() != prec->Hid().get());
+
+  Teuchos::RCP<Teuchos::ParameterList> params6 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec6 = create2DStokesPreconditioner(params6, comm);
+  params6->sublist("Preconditioner").set("Coarsening Factor", 4);
+  prec6->setParameterList(params6);
+  TEST_THROW(prec6->ShareSetup(prec), HYMLS::Exception);
+
+  Teuchos::RCP<Teuchos::ParameterList> params7 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec7 = create2DStokesPreconditioner(params7, comm);
+  params7->sublist("Preconditioner").set("Subdivide Separators", true);
+  prec7->setParameterList(params7);
+  TEST_THROW(prec7->ShareSetup(prec), HYMLS::Exception);
+  }
+
+// Assembles the subdomain rows by copying them from a matrix that is
+// stored completely on every process. If fail is set, the assembly
+// fails on the first process.
+class CopyAssembler: public HYMLS::SubdomainAssembler
+  {
+public:
+  CopyAssembler(Teuchos::RCP<const Epetra_CrsMatrix> A, bool fail = false)
+    :
+    A_(A),
+    fail_(fail),
+    numCalls_(0)
+    {}
+
+  int AssembleSubdomain(int sd, const hymls_gidx *rows, int numRows,
+    Epetra_CrsMatrix &A) const
+    {
+    numCalls_++;
+    if (fail_ && A.Comm().MyPID() == 0)
+      return -3;
+
+    int maxLen = A_->MaxNumEntries();
+    Teuchos::Array<hymls_gidx> indices(maxLen);
+    Teuchos::Array<double> values(maxLen);
+    for (int i = 0; i < numRows; i++)
+      {
+      int len;
+      CHECK_ZERO(A_->ExtractGlobalRowCopy(rows[i], maxLen, len,
+          values.getRawPtr(), indices.getRawPtr()));
+      CHECK_ZERO(A.InsertGlobalValues(rows[i], len,
+          values.getRawPtr(), indices.getRawPtr()));
+      }
+    return 0;
+    }
+
+  int NumCalls() const
+    {
+    return numCalls_;
+    }
+
+protected:
+  Teuchos::RCP<const Epetra_CrsMatrix> A_;
+
+  bool fail_;
+
+  mutable int numCalls_;
+  };
+
+TEUCHOS_UNIT_TEST(Preconditioner, SubdomainAssembler)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec = create2DStokesPreconditioner(params, comm);
+  TEST_EQUALITY(prec->Initialize(), 0);
+  TEST_EQUALITY(prec->Compute(), 0);
+
+  // the same matrix, but all of it on every process
+  Epetra_SerialComm serialComm;
+  Epetra_Map serialMap((hymls_gidx)prec->OperatorRangeMap().NumGlobalElements64(),
+    (hymls_gidx)0, serialComm);
+  Teuchos::RCP<Epetra_CrsMatrix> serialMatrix = Teuchos::rcp(
+    GaleriExt::CreateCrsMatrix("Stokes2D", &serialMap, params->sublist("Problem")));
+
+  Teuchos::RCP<Teuchos::ParameterList> params2 = Teuchos::rcp(new Teuchos::ParameterList());
+  // the matrix only provides the sparsity pattern, the values all come
+  // from the assembler
+  Teuchos::RCP<TestablePreconditioner> prec2 = create2DStokesPreconditioner(params2, comm, true);
+  Teuchos::RCP<CopyAssembler> assembler = Teuchos::rcp(new CopyAssembler(serialMatrix));
+  prec2->SetSubdomainAssembler(assembler);
+  TEST_EQUALITY(prec2->Initialize(), 0);
+  TEST_EQUALITY(prec2->Compute(), 0);
+  TEST_EQUALITY(assembler->NumCalls(), prec2->Hid()->NumMySubdomains());
+
+  Epetra_Map const &map = prec->OperatorRangeMap();
+  Epetra_MultiVector B(map, 2);
+  B.Random();
+
+  Epetra_MultiVector X(map, 2);
+  Epetra_MultiVector X2(map, 2);
+  TEST_EQUALITY(prec->ApplyInverse(B, X), 0);
+  TEST_EQUALITY(prec2->ApplyInverse(B, X2), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X2), <, 1e-12);
+
+  // a second Compute() reuses the blocks
+  TEST_EQUALITY(prec2->Compute(), 0);
+  TEST_EQUALITY(assembler->NumCalls(), 2 * prec2->Hid()->NumMySubdomains());
+  TEST_EQUALITY(prec2->ApplyInverse(B, X2), 0);
+  TEST_COMPARE(HYMLS::UnitTests::NormInfAminusB(X, X2), <, 1e-12);
+
+  // if the assembly fails on one process, Compute() fails on all of them
+  Teuchos::RCP<Teuchos::ParameterList> params3 = Teuchos::rcp(new Teuchos::ParameterList());
+  Teuchos::RCP<TestablePreconditioner> prec3 = create2DStokesPreconditioner(params3, comm, true);
+  prec3->SetSubdomainAssembler(Teuchos::rcp(new CopyAssembler(serialMatrix, true)));
+  TEST_EQUALITY(prec3->Initialize(), 0);
+  TEST_THROW(prec3->Compute(), HYMLS::Exception);
+  }
+
 TEUCHOS_UNIT_TEST(Preconditioner, ApplyInverse)
   {
   Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
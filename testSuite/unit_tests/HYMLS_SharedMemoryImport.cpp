@@ -0,0 +1,56 @@
+#include "HYMLS_SharedMemoryImport.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_Array.hpp>
+
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+
+#include "HYMLS_Macros.hpp"
+
+#include <algorithm>
+
+#include "HYMLS_UnitTests.hpp"
+
+TEUCHOS_UNIT_TEST(SharedMemoryImport, Import)
+  {
+  Epetra_MpiComm comm(MPI_COMM_WORLD);
+  DISABLE_OUTPUT;
+
+  int n = 10 * comm.NumProc();
+  Epetra_Map sourceMap((hymls_gidx)n, 0, comm);
+
+  // overlapping target map with entries of the neighbouring processes
+  // and one entry that is not in the source map
+  Teuchos::Array<hymls_gidx> gids;
+  for (int i = 0; i < std::min(15, n); i++)
+    gids.append((comm.MyPID() * 10 + 5 + i) % n);
+  gids.append(n + comm.MyPID());
+  Epetra_Map targetMap((hymls_gidx)-1, gids.size(), gids.getRawPtr(),
+    (hymls_gidx)0, comm);
+
+  HYMLS::SharedMemoryImport import(targetMap, sourceMap);
+
+  for (int numVectors = 1; numVectors < 4; numVectors++)
+    {
+    Epetra_MultiVector source(sourceMap, numVectors);
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < sourceMap.NumMyElements(); i++)
+        source[k][i] = sourceMap.GID64(i) + 1000 * k;
+
+    Epetra_MultiVector target(targetMap, numVectors);
+    CHECK_ZERO(target.PutScalar(-1.0));
+    CHECK_ZERO(import.Import(source, target));
+
+    for (int k = 0; k < numVectors; k++)
+      for (int i = 0; i < targetMap.NumMyElements(); i++)
+        {
+        hymls_gidx gid = targetMap.GID64(i);
+        if (gid < n)
+          TEST_EQUALITY(target[k][i], gid + 1000 * k);
+        else
+          TEST_EQUALITY(target[k][i], -1.0);
+        }
+    }
+  }
@@ -14,6 +14,9 @@
 #include "HYMLS_InteriorGroup.hpp"
 #include "HYMLS_SeparatorGroup.hpp"
 
+#include <set>
+#include <vector>
+
 class TestableSkewCartesianPartitioner: public HYMLS::SkewCartesianPartitioner
   {
 public:
@@ -38,6 +41,11 @@ public:
     {
     return HYMLS::SkewCartesianPartitioner::GetSubdomainID(sx, sy, sz, x, y, z);
     }
+
+  int GetSubdomainNeighbors(int sd, Teuchos::Array<int> &neighbors) const
+    {
+    return HYMLS::SkewCartesianPartitioner::GetSubdomainNeighbors(sd, neighbors);
+    }
   };
 
 TEUCHOS_UNIT_TEST(SkewCartesianPartitioner, operator)
@@ -908,3 +916,54 @@ TEUCHOS_UNIT_TEST(SkewCartesianPartitioner, operator2D)
   TEST_EQUALITY(part(10, 11, 0), 11);
   TEST_EQUALITY(part(11, 11, 0), 9);
   }
+
+TEUCHOS_UNIT_TEST(SkewCartesianPartitioner, SubdomainNeighbors)
+  {
+  Teuchos::RCP<FakeComm> comm = Teuchos::rcp(new FakeComm);
+  comm->SetNumProc(1);
+  DISABLE_OUTPUT;
+
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(
+    new Teuchos::ParameterList);
+  params->sublist("Problem").set("nx", 12);
+  params->sublist("Problem").set("ny", 12);
+  params->sublist("Problem").set("Degrees of Freedom", 2);
+  params->sublist("Preconditioner").set("Separator Length", 6);
+
+  TestableSkewCartesianPartitioner part(Teuchos::null, params, *comm);
+  part.Partition(false);
+
+  ENABLE_OUTPUT;
+
+  // neighbors from all pairs of adjacent nodes
+  int nparts = part.NumGlobalParts(6, 6, 1);
+  std::vector<std::set<int> > expected(nparts);
+  for (int j = 0; j < 12; j++)
+    for (int i = 0; i < 12; i++)
+      {
+      int sd = part(i, j, 0);
+      if (i + 1 < 12 && part(i + 1, j, 0) != sd)
+        {
+        expected[sd].insert(part(i + 1, j, 0));
+        expected[part(i + 1, j, 0)].insert(sd);
+        }
+      if (j + 1 < 12 && part(i, j + 1, 0) != sd)
+        {
+        expected[sd].insert(part(i, j + 1, 0));
+        expected[part(i, j + 1, 0)].insert(sd);
+        }
+      }
+
+  for (int sd = 0; sd < nparts; sd++)
+    {
+    int x, y, z;
+    if (part.GetSubdomainPosition(sd, 6, 6, 1, x, y, z))
+      continue;
+
+    Teuchos::Array<int> neighbors;
+    TEST_EQUALITY(part.GetSubdomainNeighbors(sd, neighbors), 0);
+    std::set<int> found(neighbors.begin(), neighbors.end());
+    TEST_EQUALITY(found.size(), (size_t)neighbors.size());
+    TEST_ASSERT(found == expected[sd]);
+    }
+  }
@@ -6,6 +6,8 @@
 
 #include "HYMLS_UnitTests.hpp"
 
+#include <thread>
+
 // A class for which we can set the number of processors that are available.
 class SplitBoxComm : public Epetra_SerialComm {
     int numProc_;
@@ -53,3 +55,17 @@ TEUCHOS_UNIT_TEST(Tools, SplitBox)
   TEST_EQUALITY(ny, 5);
   TEST_EQUALITY(nz, 5);
   }
+
+TEUCHOS_UNIT_TEST(Tools, ThreadOutput)
+  {
+  std::string text;
+  std::thread thread([&text]()
+    {
+    HYMLS::ThreadOutput output;
+    HYMLS::Tools::Out("written by a thread");
+    HYMLS::Tools::out() << "to its own buffer" << std::endl;
+    text = output.Str();
+    });
+  thread.join();
+  TEST_EQUALITY(text, "written by a thread\nto its own buffer\n");
+  }
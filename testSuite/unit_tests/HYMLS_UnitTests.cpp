@@ -9,6 +9,12 @@
 #include "HYMLS_DenseUtils.hpp"
 #include "HYMLS_Tools.hpp"
 
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <ftw.h>
+
 namespace HYMLS {
 namespace UnitTests {
 
@@ -29,6 +35,42 @@ void DisableOutput::EnableOutput()
   HYMLS::Tools::InitializeIO(Teuchos::null);
   }
 
+namespace {
+int RemoveEntry(const char *path, const struct stat *, int, struct FTW *)
+  {
+  return std::remove(path);
+  }
+}
+
+TemporaryDirectory::TemporaryDirectory(const Epetra_Comm &comm)
+  :
+  comm_(comm)
+  {
+  const char *tmp = std::getenv("TMPDIR");
+  std::string tmpDir = tmp && *tmp ? tmp : "/tmp";
+  std::string pattern = tmpDir + "/hymls_XXXXXX";
+  std::vector<char> name(pattern.begin(), pattern.end());
+  name.push_back('\0');
+
+  int len = 0;
+  if (comm_.MyPID() == 0 && mkdtemp(name.data()) != NULL)
+    len = pattern.size();
+  comm_.Broadcast(&len, 1, 0);
+  if (len == 0)
+    Tools::Error("could not create a temporary directory in " + tmpDir,
+      __FILE__, __LINE__);
+
+  comm_.Broadcast(name.data(), len, 0);
+  path_ = std::string(name.data(), len);
+  }
+
+TemporaryDirectory::~TemporaryDirectory()
+  {
+  comm_.Barrier();
+  if (comm_.MyPID() == 0)
+    nftw(path_.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+
 // create a Galeri random map with n global IDs and ndof consecutive
 // nodes always on the same partition.
 Teuchos::RCP<Epetra_Map> create_random_map(const Epetra_Comm& comm, int n, int ndof)
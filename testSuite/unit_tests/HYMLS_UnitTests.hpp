@@ -6,6 +6,8 @@
 #include "Teuchos_UnitTestHarness.hpp"
 #include "Teuchos_RCP.hpp"
 
+#include <string>
+
 #define TODO_TEST_EQUALITY( v1, v2 ) \
   TEST_INEQUALITY( v1, v2 )
 
@@ -39,6 +41,22 @@ public:
   void EnableOutput();
   };
 
+//! Directory for the files that are written by a test. It is created by
+//! the first process of comm and removed with everything in it when
+//! this object is destroyed. All processes get the same path.
+class TemporaryDirectory
+  {
+  const Epetra_Comm &comm_;
+  std::string path_;
+
+public:
+  TemporaryDirectory(const Epetra_Comm &comm);
+  ~TemporaryDirectory();
+
+  //! path of the directory without a trailing slash
+  std::string const &Path() const {return path_;}
+  };
+
 #define DISABLE_OUTPUT HYMLS::UnitTests::DisableOutput \
   Error_You_are_trying_to_disable_output_multiple_times_in_one_scope;
 #define ENABLE_OUTPUT \
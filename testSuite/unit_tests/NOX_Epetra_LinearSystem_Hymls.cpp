@@ -0,0 +1,195 @@
+#include "NOX_Epetra_LinearSystem_Hymls.hpp"
+
+#include "HYMLS_Solver.hpp"
+#include "HYMLS_Preconditioner.hpp"
+#include "HYMLS_CartesianPartitioner.hpp"
+#include "HYMLS_SubdomainAssembler.hpp"
+#include "HYMLS_Macros.hpp"
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ParameterList.hpp>
+#include <Teuchos_Array.hpp>
+
+#include <Epetra_SerialComm.h>
+#include <Epetra_MpiComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_Vector.h>
+#include <Epetra_CrsMatrix.h>
+
+#include "NOX_Epetra_Vector.H"
+#include "NOX_Epetra_Interface_Jacobian.H"
+#include "NOX_Epetra_Interface_Preconditioner.H"
+
+#include "Galeri_CrsMatrices.h"
+
+#include "HYMLS_UnitTests.hpp"
+
+namespace
+  {
+// application interface that computes the HYMLS preconditioner and
+// counts how often it is asked to do so
+class TestInterface : public NOX::Epetra::Interface::Jacobian,
+                      public NOX::Epetra::Interface::Preconditioner
+  {
+public:
+  int numCalls;
+
+  TestInterface() : numCalls(0) {}
+
+  bool computeJacobian(const Epetra_Vector &x, Epetra_Operator &Jac)
+    {
+    return true;
+    }
+
+  bool computePreconditioner(const Epetra_Vector &x, Epetra_Operator &M,
+    Teuchos::ParameterList *precParams)
+    {
+    numCalls++;
+    HYMLS::Preconditioner &prec = dynamic_cast<HYMLS::Preconditioner &>(M);
+    if (!prec.IsInitialized())
+      CHECK_ZERO(prec.Initialize());
+    return prec.Compute() == 0;
+    }
+  };
+
+// assembles the subdomains by copying the rows of a matrix that is
+// stored completely on every process, and can be told to fail once so
+// that Compute() fails
+class TestAssembler : public HYMLS::SubdomainAssembler
+  {
+public:
+  mutable bool failNext;
+
+  TestAssembler(Teuchos::RCP<const Epetra_CrsMatrix> A)
+    :
+    failNext(false),
+    A_(A)
+    {}
+
+  int AssembleSubdomain(int sd, const hymls_gidx *rows, int numRows,
+    Epetra_CrsMatrix &A) const
+    {
+    if (failNext)
+      {
+      failNext = false;
+      return -3;
+      }
+
+    int maxLen = A_->MaxNumEntries();
+    Teuchos::Array<hymls_gidx> indices(maxLen);
+    Teuchos::Array<double> values(maxLen);
+    for (int i = 0; i < numRows; i++)
+      {
+      int len;
+      CHECK_ZERO(A_->ExtractGlobalRowCopy(rows[i], maxLen, len,
+          values.getRawPtr(), indices.getRawPtr()));
+      CHECK_ZERO(A.InsertGlobalValues(rows[i], len,
+          values.getRawPtr(), indices.getRawPtr()));
+      }
+    return 0;
+    }
+
+protected:
+  Teuchos::RCP<const Epetra_CrsMatrix> A_;
+  };
+  }
+
+TEUCHOS_UNIT_TEST(LinearSystemHymls, RecomputePreconditioner)
+  {
+  Teuchos::RCP<Epetra_MpiComm> comm = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
+  DISABLE_OUTPUT;
+
+  Teuchos::ParameterList printParams;
+  printParams.set("MyPID", comm->MyPID());
+  printParams.set("Output Information", 0);
+
+  Teuchos::ParameterList lsParams;
+  lsParams.set("Preconditioner", "User Defined");
+  lsParams.set("Preconditioner Reuse Policy", "Recompute");
+  lsParams.set("HYMLS Reuse Iteration Threshold", 1000);
+
+  Teuchos::RCP<Teuchos::ParameterList> params =
+    Teuchos::rcp(&lsParams.sublist("HYMLS"), false);
+  Teuchos::ParameterList &problemList = params->sublist("Problem");
+  problemList.set("nx", 16);
+  problemList.set("ny", 16);
+  problemList.set("nz", 1);
+  problemList.set("Dimension", 2);
+  problemList.set("Degrees of Freedom", 1);
+
+  Teuchos::ParameterList &precList = params->sublist("Preconditioner");
+  precList.set("Separator Length", 4);
+  precList.set("Number of Levels", 1);
+
+  HYMLS::CartesianPartitioner part(Teuchos::null, params, *comm);
+  CHECK_ZERO(part.Partition(true));
+
+  Teuchos::RCP<Epetra_CrsMatrix> matrix = Teuchos::rcp(
+    Galeri::CreateCrsMatrix("Laplace2D", &part.Map(), problemList));
+  Teuchos::RCP<HYMLS::Preconditioner> prec = Teuchos::rcp(
+    new HYMLS::Preconditioner(matrix, params));
+  Teuchos::RCP<TestInterface> iface = Teuchos::rcp(new TestInterface);
+
+  // the same matrix, but all of it on every process
+  Epetra_SerialComm serialComm;
+  Epetra_Map serialMap((hymls_gidx)matrix->NumGlobalRows64(),
+    (hymls_gidx)0, serialComm);
+  Teuchos::RCP<Epetra_CrsMatrix> serialMatrix = Teuchos::rcp(
+    Galeri::CreateCrsMatrix("Laplace2D", &serialMap, problemList));
+  Teuchos::RCP<TestAssembler> assembler = Teuchos::rcp(
+    new TestAssembler(serialMatrix));
+  prec->SetSubdomainAssembler(assembler);
+
+  Epetra_Vector zero(matrix->OperatorRangeMap());
+  NOX::Epetra::Vector x(zero);
+
+  NOX::Epetra::LinearSystemHymls linsys(printParams, lsParams,
+    iface, matrix, iface, prec, x);
+
+  TEST_ASSERT(linsys.createPreconditioner(x, lsParams, false));
+  TEST_EQUALITY(iface->numCalls, 1);
+  TEST_EQUALITY(prec->NumInitialize(), 1);
+  TEST_EQUALITY(prec->NumCompute(), 1);
+  TEST_ASSERT(prec->IsComputed());
+
+  // nothing was solved yet, so the preconditioner is refreshed, which
+  // only calls Compute() again
+  Teuchos::ParameterList &outputList = lsParams.sublist("Output");
+  TEST_ASSERT(linsys.recomputePreconditioner(x, lsParams));
+  TEST_EQUALITY(iface->numCalls, 1);
+  TEST_EQUALITY(prec->NumInitialize(), 1);
+  TEST_EQUALITY(prec->NumCompute(), 2);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Reuses", -1), 0);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Refreshes", -1), 1);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Recomputations", -1), 0);
+
+  // after a solve with fewer iterations than the threshold it is kept
+  NOX::Epetra::Vector b(x);
+  b.random();
+  NOX::Epetra::Vector y(x);
+  linsys.applyJacobianInverse(lsParams, b, y);
+  TEST_COMPARE(linsys.getHymls()->getNumIter(), >, 0);
+
+  TEST_ASSERT(linsys.recomputePreconditioner(x, lsParams));
+  TEST_EQUALITY(iface->numCalls, 1);
+  TEST_EQUALITY(prec->NumInitialize(), 1);
+  TEST_EQUALITY(prec->NumCompute(), 2);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Reuses", -1), 1);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Refreshes", -1), 1);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Recomputations", -1), 0);
+
+  // with a lower threshold it is refreshed again, and if that fails it
+  // is rebuilt starting with the partitioning. The failed Compute() is
+  // not counted.
+  lsParams.set("HYMLS Reuse Iteration Threshold", 1);
+  assembler->failNext = true;
+  TEST_ASSERT(linsys.recomputePreconditioner(x, lsParams));
+  TEST_EQUALITY(iface->numCalls, 1);
+  TEST_EQUALITY(prec->NumInitialize(), 2);
+  TEST_EQUALITY(prec->NumCompute(), 3);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Reuses", -1), 1);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Refreshes", -1), 1);
+  TEST_EQUALITY(outputList.get("Number of Preconditioner Recomputations", -1), 1);
+  TEST_ASSERT(prec->IsComputed());
+  TEST_ASSERT(!assembler->failNext);
+  }
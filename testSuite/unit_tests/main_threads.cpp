@@ -0,0 +1,18 @@
+#include "Teuchos_UnitTestRepository.hpp"
+
+#include <mpi.h>
+
+// The DoubleBufferedPreconditioner only computes in a background thread
+// if MPI supports MPI_THREAD_MULTIPLE, so its tests are run separately
+// with that thread level. The other unit tests use the default level.
+int main(int argc, char* argv[])
+  {
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  Teuchos::UnitTestRepository::setGloballyReduceTestResult(true);
+  int ierr = Teuchos::UnitTestRepository::runUnitTestsFromMain(argc, argv);
+
+  MPI_Finalize();
+  return ierr;
+  }